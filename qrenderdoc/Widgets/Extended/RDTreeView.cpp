@@ -385,17 +385,67 @@ void RDTreeView::fillBranchesRect(QPainter *painter, const QRect &rect, const QM
   style()->drawPrimitive(QStyle::PE_PanelItemViewItem, &opt, painter, this);
 }
 
+void RDTreeView::drawTreeLines(QPainter *painter, const QRect &rect, const QModelIndex &index) const
+{
+  int depth = 0;
+  for(QModelIndex parent = index.parent(); parent.isValid(); parent = parent.parent())
+    depth++;
+
+  // start with the inner-most parent, at the right-most side of the branches
+  QRect branchRect(rect.left() + (depth - 1) * indentation(), rect.top(), indentation(),
+                   rect.height());
+
+  QPen oldPen = painter->pen();
+  for(QModelIndex parent = index.parent(); parent.isValid(); parent = parent.parent())
+  {
+    QColor col = parent.data(TreeLineColorRole).value<QColor>();
+
+    if(col.isValid())
+    {
+      // draw a centred pen vertically down the middle of branchRect
+      painter->setPen(QPen(QBrush(col), parent.data(TreeLineWidthRole).toFloat()));
+
+      QPoint topCentre = QRect(branchRect).center();
+      QPoint bottomCentre = topCentre;
+
+      topCentre.setY(branchRect.top());
+      bottomCentre.setY(branchRect.bottom());
+
+      painter->drawLine(topCentre, bottomCentre);
+    }
+
+    branchRect.moveLeft(branchRect.left() - indentation());
+  }
+  painter->setPen(oldPen);
+}
+
 void RDTreeView::drawBranches(QPainter *painter, const QRect &rect, const QModelIndex &index) const
 {
   if(m_fillBranchRect)
     fillBranchesRect(painter, rect, index);
 
+  if(m_ColoredTreeLines)
+  {
+    // fill in the item's own background behind the lines, since by default it doesn't show up
+    // there
+    QVariant back = index.data(Qt::BackgroundRole);
+    if(back.isValid() && !selectionModel()->isSelected(index))
+      painter->fillRect(rect, back.value<QBrush>());
+  }
+
   if(m_VisibleBranches)
   {
     QTreeView::drawBranches(painter, rect, index);
+
+    // draw after the built-in lines so we paint on top of them
+    if(m_ColoredTreeLines)
+      drawTreeLines(painter, rect, index);
   }
   else
   {
+    if(m_ColoredTreeLines)
+      drawTreeLines(painter, rect, index);
+
     // draw only the expand item, not the branches
     QRect primitive(0, rect.top(), qMin(rect.width(), indentation()), rect.height());
 
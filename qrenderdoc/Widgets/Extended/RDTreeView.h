@@ -74,11 +74,22 @@ public:
   explicit RDTreeView(QWidget *parent = 0);
   virtual ~RDTreeView();
 
+  // roles queried from the model when coloured tree lines are enabled. An item returning a QColor
+  // for TreeLineColorRole gets a vertical line of that colour down the branches of its children,
+  // TreeLineWidthRole gives the line width in pixels.
+  enum
+  {
+    TreeLineColorRole = Qt::UserRole + 20000,
+    TreeLineWidthRole,
+  };
+
   void showBranches() { m_VisibleBranches = true; }
   void hideBranches() { m_VisibleBranches = false; }
   void showGridLines() { m_VisibleGridLines = true; }
   void hideGridLines() { m_VisibleGridLines = false; }
   bool visibleGridLines() { return m_VisibleGridLines; }
+  void setColoredTreeLines(bool colored) { m_ColoredTreeLines = colored; }
+  bool coloredTreeLines() { return m_ColoredTreeLines; }
   void setTooltipElidedItems(bool tool) { m_TooltipElidedItems = tool; }
   bool tooltipElidedItems() { return m_TooltipElidedItems; }
   void setItemVerticalMargin(int vertical) { m_VertMargin = vertical; }
@@ -138,12 +149,14 @@ protected:
   void drawBranches(QPainter *painter, const QRect &rect, const QModelIndex &index) const override;
 
   void fillBranchesRect(QPainter *painter, const QRect &rect, const QModelIndex &index) const;
+  void drawTreeLines(QPainter *painter, const QRect &rect, const QModelIndex &index) const;
   void enableBranchRectFill(bool fill) { m_fillBranchRect = fill; }
   QModelIndex m_currentHoverIndex;
 
 private:
   bool m_VisibleBranches = true;
   bool m_VisibleGridLines = true;
+  bool m_ColoredTreeLines = false;
   bool m_TooltipElidedItems = true;
 
   QMap<uint, RDTreeViewExpansionState> m_Expansions;
@@ -24,6 +24,7 @@
 
 #include "LiveCapture.h"
 #include <QDesktopServices>
+#include <QFileInfo>
 #include <QMenu>
 #include <QMetaProperty>
 #include <QMouseEvent>
@@ -1105,6 +1106,11 @@ void LiveCapture::connectionThreadEntry()
     return;
   }
 
+  // have captures streamed to us while the target writes them, so they can be opened as soon as
+  // they're complete without copying them afterwards. This does nothing for a local target.
+  QString streamFolder = QFileInfo(m_Ctx.TempCaptureFilename(lit("stream"))).absolutePath();
+  m_Connection->SetCaptureStreaming(streamFolder.toUtf8().data());
+
   GUIInvoke::call(this, [this]() {
     uint32_t pid = m_Connection->GetPID();
     QString target = QString::fromUtf8(m_Connection->GetTarget());
@@ -40,28 +40,563 @@
 #include "Widgets/Extended/RDListWidget.h"
 #include "ui_EventBrowser.h"
 
-struct EventItemTag
+enum
+{
+  COL_NAME,
+  COL_EID,
+  COL_DRAW,
+  COL_DURATION,
+  COL_COUNT,
+};
+
+// one entry per visible drawcall, stored flat in EID order. This is built in a single pass when the
+// capture is loaded and is all that's kept per event - rows, text and icons are only produced when
+// the view asks for them.
+struct EventItem
 {
-  EventItemTag() = default;
-  EventItemTag(uint32_t eventId) : EID(eventId), lastEID(eventId) {}
-  EventItemTag(uint32_t eventId, uint32_t lastEventID) : EID(eventId), lastEID(lastEventID) {}
+  const DrawcallDescription *draw = NULL;
   uint32_t EID = 0;
   uint32_t lastEID = 0;
+  uint32_t lastDraw = 0;
+  // the parent item, or -1 for the frame root
+  int parent = -1;
+  int row = 0;
+  int childCount = 0;
+  // one past the last item in this item's subtree
+  int subtreeEnd = 0;
   double duration = -1.0;
-  bool current = false;
   bool find = false;
   bool bookmark = false;
 };
 
-Q_DECLARE_METATYPE(EventItemTag);
-
-enum
+class EventItemModel : public QAbstractItemModel
 {
-  COL_NAME,
-  COL_EID,
-  COL_DRAW,
-  COL_DURATION,
-  COL_COUNT,
+public:
+  EventItemModel(ICaptureContext &ctx, QAbstractItemView *view)
+      : QAbstractItemModel(view), m_Ctx(ctx), m_View(view)
+  {
+    m_Headers << tr("Name") << lit("EID") << lit("Draw #") << QString();
+  }
+
+  void populate()
+  {
+    beginResetModel();
+
+    clearItems();
+
+    // the frame root, and the 'virtual' frame start event at EID 0
+    m_Items.resize(2);
+    m_Items[0].childCount = 1;
+    m_Items[1].parent = 0;
+    m_Items[1].subtreeEnd = 2;
+
+    QPair<uint32_t, uint32_t> last = addDrawcalls(0, m_Ctx.CurDrawcalls());
+
+    m_Items[0].lastEID = last.first;
+    m_Items[0].subtreeEnd = m_Items.count();
+
+    // sort by the last EID, breaking ties towards the deepest item so that selecting an event lands
+    // on the draw itself rather than the markers that end with it.
+    m_EIDLookup.resize(m_Items.count() - 1);
+    for(int i = 1; i < m_Items.count(); i++)
+      m_EIDLookup[i - 1] = i;
+
+    std::sort(m_EIDLookup.begin(), m_EIDLookup.end(), [this](int a, int b) {
+      if(m_Items[a].lastEID != m_Items[b].lastEID)
+        return m_Items[a].lastEID < m_Items[b].lastEID;
+      return a > b;
+    });
+
+    endResetModel();
+  }
+
+  void clear()
+  {
+    beginResetModel();
+    clearItems();
+    endResetModel();
+  }
+
+  int itemForIndex(const QModelIndex &idx) const
+  {
+    return idx.isValid() ? (int)idx.internalId() : -1;
+  }
+  QModelIndex indexForItem(int item, int column = 0) const
+  {
+    if(item < 0 || item >= m_Items.count())
+      return QModelIndex();
+
+    return createIndex(m_Items[item].row, column, quintptr(item));
+  }
+
+  uint32_t eventId(const QModelIndex &idx) const
+  {
+    int item = itemForIndex(idx);
+    return item >= 0 ? m_Items[item].EID : 0;
+  }
+
+  uint32_t lastEventId(const QModelIndex &idx) const
+  {
+    int item = itemForIndex(idx);
+    return item >= 0 ? m_Items[item].lastEID : 0;
+  }
+
+  // returns the item that best represents eventId - the item that ends at it or the first one after
+  int findItem(uint32_t eventId) const
+  {
+    auto it =
+        std::lower_bound(m_EIDLookup.begin(), m_EIDLookup.end(), eventId,
+                         [this](int item, uint32_t eid) { return m_Items[item].lastEID < eid; });
+
+    if(it == m_EIDLookup.end())
+      return -1;
+
+    return *it;
+  }
+
+  // returns the last EID of the next item before or after the given EID with a matching name
+  int findEvent(const QString &filter, uint32_t after, bool forward) const
+  {
+    if(m_Items.count() < 2)
+      return -1;
+
+    // items are in EID order, so we can jump straight to where the search starts. The root is
+    // never searched.
+    if(forward)
+    {
+      auto it = std::upper_bound(
+          m_Items.begin() + 1, m_Items.end(), after,
+          [](uint32_t eid, const EventItem &item) { return eid < item.EID; });
+
+      for(int i = int(it - m_Items.begin()); i < m_Items.count(); i++)
+      {
+        if(text(i).contains(filter, Qt::CaseInsensitive))
+          return (int)m_Items[i].lastEID;
+      }
+    }
+    else
+    {
+      auto it = std::lower_bound(
+          m_Items.begin() + 1, m_Items.end(), after,
+          [](const EventItem &item, uint32_t eid) { return item.EID < eid; });
+
+      for(int i = int(it - m_Items.begin()) - 1; i >= 1; i--)
+      {
+        if(m_Items[i].lastEID < after && text(i).contains(filter, Qt::CaseInsensitive))
+          return (int)m_Items[i].lastEID;
+      }
+    }
+
+    return -1;
+  }
+
+  int setFindFilter(const QString &filter)
+  {
+    int results = 0;
+
+    for(int i = 1; i < m_Items.count(); i++)
+    {
+      m_Items[i].find = !filter.isEmpty() && text(i).contains(filter, Qt::CaseInsensitive);
+
+      if(m_Items[i].find)
+        results++;
+    }
+
+    refreshColumn(COL_NAME, {Qt::DecorationRole});
+
+    return results;
+  }
+
+  void setBookmark(uint32_t eventId, bool bookmark)
+  {
+    int item = findItem(eventId);
+
+    if(item < 0)
+      return;
+
+    m_Items[item].bookmark = bookmark;
+
+    QModelIndex idx = indexForItem(item, COL_NAME);
+    emit dataChanged(idx, idx, {Qt::DecorationRole});
+  }
+
+  void setCurrentItem(int item)
+  {
+    int prev = m_Current;
+    m_Current = item;
+
+    for(int i : {prev, item})
+    {
+      QModelIndex idx = indexForItem(i, COL_NAME);
+      if(idx.isValid())
+        emit dataChanged(idx, idx, {Qt::DecorationRole});
+    }
+  }
+
+  void setTimes(const rdcarray<CounterResult> &results)
+  {
+    QHash<uint32_t, double> durations;
+    durations.reserve(results.count());
+    for(const CounterResult &r : results)
+      durations[r.eventId] = r.value.d;
+
+    // leaf items look up their own duration, parents take the sum of their children. Children are
+    // always after their parent, so walking backwards completes each subtree before its parent.
+    for(EventItem &item : m_Items)
+      item.duration = item.childCount > 0 ? 0.0 : durations.value(item.EID, -1.0);
+
+    for(int i = m_Items.count() - 1; i > 0; i--)
+    {
+      if(m_Items[i].duration > 0.0)
+        m_Items[m_Items[i].parent].duration += m_Items[i].duration;
+    }
+
+    m_HasTimes = true;
+
+    refreshColumn(COL_DURATION, {Qt::DisplayRole});
+  }
+
+  void setTimeUnit(TimeUnit unit)
+  {
+    m_TimeUnit = unit;
+    m_Headers[COL_DURATION] = tr("Duration (%1)").arg(UnitSuffix(unit));
+
+    emit headerDataChanged(Qt::Horizontal, COL_DURATION, COL_DURATION);
+
+    if(m_HasTimes)
+      refreshColumn(COL_DURATION, {Qt::DisplayRole});
+  }
+
+  QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override
+  {
+    if(row < 0 || column < 0 || row >= rowCount(parent) || column >= columnCount())
+      return QModelIndex();
+
+    if(!parent.isValid())
+      return createIndex(row, column, quintptr(0));
+
+    return createIndex(row, column, quintptr(childItem(itemForIndex(parent), row)));
+  }
+
+  QModelIndex parent(const QModelIndex &index) const override
+  {
+    if(!index.isValid())
+      return QModelIndex();
+
+    return indexForItem(m_Items[itemForIndex(index)].parent);
+  }
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override
+  {
+    if(!parent.isValid())
+      return m_Items.isEmpty() ? 0 : 1;
+
+    return m_Items[itemForIndex(parent)].childCount;
+  }
+
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override { return COL_COUNT; }
+  Qt::ItemFlags flags(const QModelIndex &index) const override
+  {
+    if(!index.isValid())
+      return 0;
+
+    return QAbstractItemModel::flags(index);
+  }
+
+  QVariant headerData(int section, Qt::Orientation orientation, int role) const override
+  {
+    if(orientation == Qt::Horizontal && role == Qt::DisplayRole && section >= 0 &&
+       section < COL_COUNT)
+      return m_Headers[section];
+
+    return QVariant();
+  }
+
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override
+  {
+    if(!index.isValid())
+      return QVariant();
+
+    int i = itemForIndex(index);
+    const EventItem &item = m_Items[i];
+    int col = index.column();
+
+    if(role == Qt::DisplayRole)
+    {
+      // the frame root only has a name
+      if(i == 0 && col != COL_NAME && col != COL_DURATION)
+        return QString();
+
+      uint32_t drawId = item.draw ? item.draw->drawcallId : 0;
+
+      switch(col)
+      {
+        case COL_NAME: return name(i);
+        case COL_EID:
+          if(item.childCount > 0 && item.lastEID > item.EID)
+            return QFormatStr("%1-%2").arg(item.EID).arg(item.lastEID);
+          return QString::number(item.EID);
+        case COL_DRAW:
+          if(item.childCount > 0 && item.lastEID > item.EID)
+            return QFormatStr("%1-%2").arg(drawId).arg(item.lastDraw);
+          return QString::number(drawId);
+        case COL_DURATION:
+          if(!m_HasTimes)
+            return item.draw ? lit("---") : QString();
+          return durationText(item.duration);
+        default: break;
+      }
+    }
+    else if(role == Qt::DecorationRole && col == COL_NAME)
+    {
+      if(i == m_Current)
+        return Icons::flag_green();
+      else if(item.bookmark)
+        return Icons::asterisk_orange();
+      else if(item.find)
+        return Icons::find();
+    }
+    else if(role == Qt::TextAlignmentRole && col == COL_DURATION)
+    {
+      return QVariant(Qt::AlignRight | Qt::AlignCenter);
+    }
+    else if(role == Qt::BackgroundRole || role == Qt::ForegroundRole)
+    {
+      QColor color = markerColor(item);
+
+      if(color.isValid() && m_Ctx.Config().EventBrowser_ColorEventRow)
+      {
+        if(role == Qt::ForegroundRole)
+          return QBrush(contrastingColor(color, m_View->palette().color(QPalette::Text)));
+
+        // the row colour only applies when not selected
+        if(!m_View->selectionModel()->isSelected(index))
+          return QBrush(color);
+      }
+    }
+    else if(role == RDTreeView::TreeLineColorRole)
+    {
+      QColor color = markerColor(item);
+
+      if(color.isValid())
+        return color;
+    }
+    else if(role == RDTreeView::TreeLineWidthRole)
+    {
+      return 3.0f;
+    }
+
+    return QVariant();
+  }
+
+private:
+  ICaptureContext &m_Ctx;
+  QAbstractItemView *m_View;
+
+  QStringList m_Headers;
+  TimeUnit m_TimeUnit = TimeUnit::Count;
+  bool m_HasTimes = false;
+  int m_Current = -1;
+
+  QVector<EventItem> m_Items;
+  // item indices sorted by last EID, for locating an event without walking the tree
+  QVector<int> m_EIDLookup;
+
+  // children and names are only listed/formatted once the view asks for them
+  mutable QHash<int, QVector<int>> m_Children;
+  mutable QHash<int, QVariant> m_Names;
+
+  void clearItems()
+  {
+    m_Items.clear();
+    m_EIDLookup.clear();
+    m_Children.clear();
+    m_Names.clear();
+    m_Current = -1;
+    m_HasTimes = false;
+  }
+
+  bool shouldHide(const DrawcallDescription &drawcall) const
+  {
+    if(drawcall.flags & DrawFlags::PushMarker)
+    {
+      if(m_Ctx.Config().EventBrowser_HideEmpty)
+      {
+        if(drawcall.children.isEmpty())
+          return true;
+
+        bool allhidden = true;
+
+        for(const DrawcallDescription &child : drawcall.children)
+        {
+          if(shouldHide(child))
+            continue;
+
+          allhidden = false;
+          break;
+        }
+
+        if(allhidden)
+          return true;
+      }
+
+      if(m_Ctx.Config().EventBrowser_HideAPICalls)
+      {
+        if(drawcall.children.isEmpty())
+          return false;
+
+        bool onlyapi = true;
+
+        for(const DrawcallDescription &child : drawcall.children)
+        {
+          if(shouldHide(child))
+            continue;
+
+          if(!(child.flags & DrawFlags::APICalls))
+          {
+            onlyapi = false;
+            break;
+          }
+        }
+
+        if(onlyapi)
+          return true;
+      }
+    }
+
+    return false;
+  }
+
+  QPair<uint32_t, uint32_t> addDrawcalls(int parent, const rdcarray<DrawcallDescription> &draws)
+  {
+    uint32_t lastEID = 0, lastDraw = 0;
+
+    for(int32_t i = 0; i < draws.count(); i++)
+    {
+      const DrawcallDescription &d = draws[i];
+
+      if(shouldHide(d))
+        continue;
+
+      int idx = m_Items.count();
+
+      EventItem item;
+      item.draw = &d;
+      item.EID = d.eventId;
+      item.parent = parent;
+      item.row = m_Items[parent].childCount++;
+      m_Items.push_back(item);
+
+      QPair<uint32_t, uint32_t> last = addDrawcalls(idx, d.children);
+      lastEID = last.first;
+      lastDraw = last.second;
+
+      if(lastEID == 0)
+      {
+        lastEID = d.eventId;
+        lastDraw = d.drawcallId;
+
+        if((d.flags & DrawFlags::SetMarker) && i + 1 < draws.count())
+          lastEID = draws[i + 1].eventId;
+      }
+
+      m_Items[idx].lastEID = lastEID;
+      m_Items[idx].lastDraw = lastDraw;
+      m_Items[idx].subtreeEnd = m_Items.count();
+    }
+
+    return qMakePair(lastEID, lastDraw);
+  }
+
+  int childItem(int parent, int row) const
+  {
+    auto it = m_Children.find(parent);
+    if(it == m_Children.end())
+    {
+      // list the children by hopping over each child's subtree
+      QVector<int> children;
+      children.reserve(m_Items[parent].childCount);
+      for(int c = parent + 1; c < m_Items[parent].subtreeEnd; c = m_Items[c].subtreeEnd)
+        children.push_back(c);
+
+      it = m_Children.insert(parent, children);
+    }
+
+    return it.value()[row];
+  }
+
+  QString text(int item) const
+  {
+    if(item == 0)
+      return QFormatStr("Frame #%1").arg(m_Ctx.FrameInfo().frameNumber);
+    if(m_Items[item].draw == NULL)
+      return tr("Frame Start");
+
+    return m_Items[item].draw->name;
+  }
+
+  QVariant name(int item) const
+  {
+    auto it = m_Names.find(item);
+    if(it != m_Names.end())
+      return it.value();
+
+    QVariant name = text(item);
+
+    RichResourceTextInitialise(name);
+
+    m_Names[item] = name;
+
+    return name;
+  }
+
+  QString durationText(double duration) const
+  {
+    if(duration < 0.0)
+      return QString();
+
+    double secs = duration;
+
+    if(m_TimeUnit == TimeUnit::Milliseconds)
+      secs *= 1000.0;
+    else if(m_TimeUnit == TimeUnit::Microseconds)
+      secs *= 1000000.0;
+    else if(m_TimeUnit == TimeUnit::Nanoseconds)
+      secs *= 1000000000.0;
+
+    return Formatter::Format(secs);
+  }
+
+  QColor markerColor(const EventItem &item) const
+  {
+    const DrawcallDescription *d = item.draw;
+
+    // if alpha isn't 0, assume the colour is valid
+    if(d && m_Ctx.Config().EventBrowser_ApplyColors &&
+       (d->flags & (DrawFlags::PushMarker | DrawFlags::SetMarker)) && d->markerColor[3] > 0.0f)
+    {
+      return QColor::fromRgb(
+          qRgb(d->markerColor[0] * 255.0f, d->markerColor[1] * 255.0f, d->markerColor[2] * 255.0f));
+    }
+
+    return QColor();
+  }
+
+  void refreshColumn(int column, const QVector<int> &roles)
+  {
+    if(m_Items.isEmpty())
+      return;
+
+    // only rows the view has already fetched need to be notified, the rest are computed on demand
+    emit dataChanged(index(0, column), index(0, column), roles);
+
+    for(auto it = m_Children.begin(); it != m_Children.end(); ++it)
+    {
+      QModelIndex parent = indexForItem(it.key());
+      emit dataChanged(index(0, column, parent), index(it.value().count() - 1, column, parent),
+                       roles);
+    }
+  }
 };
 
 static bool textEditControl(QWidget *sender)
@@ -90,8 +625,10 @@ EventBrowser::EventBrowser(ICaptureContext &ctx, QWidget *parent)
   ui->find->setFont(Formatter::PreferredFont());
   ui->events->setFont(Formatter::PreferredFont());
 
-  ui->events->setColumns(
-      {tr("Name"), lit("EID"), lit("Draw #"), lit("Duration - replaced in UpdateDurationColumn")});
+  m_Model = new EventItemModel(m_Ctx, ui->events);
+  ui->events->setModel(m_Model);
+  ui->events->setItemDelegate(new RichTextViewDelegate(ui->events));
+  ui->events->setColoredTreeLines(true);
 
   ui->events->setHeader(new RDHeaderView(Qt::Horizontal, this));
   ui->events->header()->setStretchLastSection(true);
@@ -103,8 +640,6 @@ EventBrowser::EventBrowser(ICaptureContext &ctx, QWidget *parent)
   ui->events->header()->setSectionResizeMode(COL_DRAW, QHeaderView::Interactive);
   ui->events->header()->setSectionResizeMode(COL_DURATION, QHeaderView::Interactive);
 
-  ui->events->setColumnAlignment(COL_DURATION, Qt::AlignRight | Qt::AlignCenter);
-
   ui->events->header()->setMinimumSectionSize(40);
 
   ui->events->header()->setSectionsMovable(true);
@@ -134,7 +669,9 @@ EventBrowser::EventBrowser(ICaptureContext &ctx, QWidget *parent)
 
   QObject::connect(ui->closeFind, &QToolButton::clicked, this, &EventBrowser::on_HideFindJump);
   QObject::connect(ui->closeJump, &QToolButton::clicked, this, &EventBrowser::on_HideFindJump);
-  QObject::connect(ui->events, &RDTreeWidget::keyPress, this, &EventBrowser::events_keyPress);
+  QObject::connect(ui->events, &RDTreeView::keyPress, this, &EventBrowser::events_keyPress);
+  QObject::connect(ui->events->selectionModel(), &QItemSelectionModel::currentChanged, this,
+                   &EventBrowser::events_currentChanged);
   ui->jumpStrip->hide();
   ui->findStrip->hide();
   ui->bookmarkStrip->hide();
@@ -182,7 +719,7 @@ EventBrowser::EventBrowser(ICaptureContext &ctx, QWidget *parent)
                                         [this](QWidget *) { on_HideFindJump(); });
 
   ui->events->setContextMenuPolicy(Qt::CustomContextMenu);
-  QObject::connect(ui->events, &RDTreeWidget::customContextMenuRequested, this,
+  QObject::connect(ui->events, &RDTreeView::customContextMenuRequested, this,
                    &EventBrowser::events_contextMenu);
 
   ui->events->header()->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -238,21 +775,9 @@ EventBrowser::~EventBrowser()
 
 void EventBrowser::OnCaptureLoaded()
 {
-  RDTreeWidgetItem *frame = new RDTreeWidgetItem(
-      {QFormatStr("Frame #%1").arg(m_Ctx.FrameInfo().frameNumber), QString(), QString(), QString()});
-
-  RDTreeWidgetItem *framestart =
-      new RDTreeWidgetItem({tr("Frame Start"), lit("0"), lit("0"), QString()});
-  framestart->setTag(QVariant::fromValue(EventItemTag(0, 0)));
+  m_Model->populate();
 
-  frame->addChild(framestart);
-
-  QPair<uint32_t, uint32_t> lastEIDDraw = AddDrawcalls(frame, m_Ctx.CurDrawcalls());
-  frame->setTag(QVariant::fromValue(EventItemTag(0, lastEIDDraw.first)));
-
-  ui->events->addTopLevelItem(frame);
-
-  ui->events->expandItem(frame);
+  ui->events->expand(m_Model->index(0, 0));
 
   clearBookmarks();
   repopulateBookmarks();
@@ -270,7 +795,7 @@ void EventBrowser::OnCaptureClosed()
 {
   clearBookmarks();
 
-  ui->events->clear();
+  m_Model->clear();
 
   ui->find->setEnabled(false);
   ui->gotoEID->setEnabled(false);
@@ -288,186 +813,6 @@ void EventBrowser::OnEventChanged(uint32_t eventId)
   highlightBookmarks();
 }
 
-bool EventBrowser::ShouldHide(const DrawcallDescription &drawcall)
-{
-  if(drawcall.flags & DrawFlags::PushMarker)
-  {
-    if(m_Ctx.Config().EventBrowser_HideEmpty)
-    {
-      if(drawcall.children.isEmpty())
-        return true;
-
-      bool allhidden = true;
-
-      for(const DrawcallDescription &child : drawcall.children)
-      {
-        if(ShouldHide(child))
-          continue;
-
-        allhidden = false;
-        break;
-      }
-
-      if(allhidden)
-        return true;
-    }
-
-    if(m_Ctx.Config().EventBrowser_HideAPICalls)
-    {
-      if(drawcall.children.isEmpty())
-        return false;
-
-      bool onlyapi = true;
-
-      for(const DrawcallDescription &child : drawcall.children)
-      {
-        if(ShouldHide(child))
-          continue;
-
-        if(!(child.flags & DrawFlags::APICalls))
-        {
-          onlyapi = false;
-          break;
-        }
-      }
-
-      if(onlyapi)
-        return true;
-    }
-  }
-
-  return false;
-}
-
-QPair<uint32_t, uint32_t> EventBrowser::AddDrawcalls(RDTreeWidgetItem *parent,
-                                                     const rdcarray<DrawcallDescription> &draws)
-{
-  uint lastEID = 0, lastDraw = 0;
-
-  for(int32_t i = 0; i < draws.count(); i++)
-  {
-    const DrawcallDescription &d = draws[i];
-
-    if(ShouldHide(d))
-      continue;
-
-    QVariant name = QString(d.name);
-
-    RichResourceTextInitialise(name);
-
-    RDTreeWidgetItem *child = new RDTreeWidgetItem(
-        {name, QString::number(d.eventId), QString::number(d.drawcallId), lit("---")});
-
-    QPair<uint32_t, uint32_t> last = AddDrawcalls(child, d.children);
-    lastEID = last.first;
-    lastDraw = last.second;
-
-    if(lastEID > d.eventId)
-    {
-      child->setText(COL_EID, QFormatStr("%1-%2").arg(d.eventId).arg(lastEID));
-      child->setText(COL_DRAW, QFormatStr("%1-%2").arg(d.drawcallId).arg(lastDraw));
-    }
-
-    if(lastEID == 0)
-    {
-      lastEID = d.eventId;
-      lastDraw = d.drawcallId;
-
-      if((draws[i].flags & DrawFlags::SetMarker) && i + 1 < draws.count())
-        lastEID = draws[i + 1].eventId;
-    }
-
-    child->setTag(QVariant::fromValue(EventItemTag(draws[i].eventId, lastEID)));
-
-    if(m_Ctx.Config().EventBrowser_ApplyColors)
-    {
-      // if alpha isn't 0, assume the colour is valid
-      if((d.flags & (DrawFlags::PushMarker | DrawFlags::SetMarker)) && d.markerColor[3] > 0.0f)
-      {
-        QColor col = QColor::fromRgb(
-            qRgb(d.markerColor[0] * 255.0f, d.markerColor[1] * 255.0f, d.markerColor[2] * 255.0f));
-
-        child->setTreeColor(col, 3.0f);
-
-        if(m_Ctx.Config().EventBrowser_ColorEventRow)
-        {
-          QColor textCol = ui->events->palette().color(QPalette::Text);
-
-          child->setBackgroundColor(col);
-          child->setForegroundColor(contrastingColor(col, textCol));
-        }
-      }
-    }
-
-    parent->addChild(child);
-  }
-
-  return qMakePair(lastEID, lastDraw);
-}
-
-void EventBrowser::SetDrawcallTimes(RDTreeWidgetItem *node, const rdcarray<CounterResult> &results)
-{
-  if(node == NULL)
-    return;
-
-  // parent nodes take the value of the sum of their children
-  double duration = 0.0;
-
-  // look up leaf nodes in the dictionary
-  if(node->childCount() == 0)
-  {
-    uint32_t eid = node->tag().value<EventItemTag>().EID;
-
-    duration = -1.0;
-
-    for(const CounterResult &r : results)
-    {
-      if(r.eventId == eid)
-        duration = r.value.d;
-    }
-
-    double secs = duration;
-
-    if(m_TimeUnit == TimeUnit::Milliseconds)
-      secs *= 1000.0;
-    else if(m_TimeUnit == TimeUnit::Microseconds)
-      secs *= 1000000.0;
-    else if(m_TimeUnit == TimeUnit::Nanoseconds)
-      secs *= 1000000000.0;
-
-    node->setText(COL_DURATION, duration < 0.0f ? QString() : Formatter::Format(secs));
-    EventItemTag tag = node->tag().value<EventItemTag>();
-    tag.duration = duration;
-    node->setTag(QVariant::fromValue(tag));
-
-    return;
-  }
-
-  for(int i = 0; i < node->childCount(); i++)
-  {
-    SetDrawcallTimes(node->child(i), results);
-
-    double nd = node->child(i)->tag().value<EventItemTag>().duration;
-
-    if(nd > 0.0)
-      duration += nd;
-  }
-
-  double secs = duration;
-
-  if(m_TimeUnit == TimeUnit::Milliseconds)
-    secs *= 1000.0;
-  else if(m_TimeUnit == TimeUnit::Microseconds)
-    secs *= 1000000.0;
-  else if(m_TimeUnit == TimeUnit::Nanoseconds)
-    secs *= 1000000000.0;
-
-  node->setText(COL_DURATION, duration < 0.0f ? QString() : Formatter::Format(secs));
-  EventItemTag tag = node->tag().value<EventItemTag>();
-  tag.duration = duration;
-  node->setTag(QVariant::fromValue(tag));
-}
-
 void EventBrowser::on_find_clicked()
 {
   ui->jumpStrip->hide();
@@ -484,10 +829,10 @@ void EventBrowser::on_gotoEID_clicked()
 
 void EventBrowser::on_bookmark_clicked()
 {
-  RDTreeWidgetItem *n = ui->events->currentItem();
+  QModelIndex idx = ui->events->currentIndex();
 
-  if(n)
-    toggleBookmark(n->tag().value<EventItemTag>().lastEID);
+  if(idx.isValid())
+    toggleBookmark(m_Model->lastEventId(idx));
 }
 
 void EventBrowser::on_timeDraws_clicked()
@@ -500,44 +845,33 @@ void EventBrowser::on_timeDraws_clicked()
 
     m_Times = r->FetchCounters({GPUCounter::EventGPUDuration});
 
-    GUIInvoke::call(this, [this]() {
-      SetDrawcallTimes(ui->events->topLevelItem(0), m_Times);
-      ui->events->update();
-    });
+    GUIInvoke::call(this, [this]() { m_Model->setTimes(m_Times); });
   });
 }
 
-void EventBrowser::on_events_currentItemChanged(RDTreeWidgetItem *current, RDTreeWidgetItem *previous)
+void EventBrowser::events_currentChanged(const QModelIndex &current, const QModelIndex &previous)
 {
-  if(previous)
-  {
-    EventItemTag tag = previous->tag().value<EventItemTag>();
-    tag.current = false;
-    previous->setTag(QVariant::fromValue(tag));
-    RefreshIcon(previous, tag);
-  }
-
-  if(!current)
+  if(!current.isValid())
     return;
 
-  EventItemTag tag = current->tag().value<EventItemTag>();
-  tag.current = true;
-  current->setTag(QVariant::fromValue(tag));
-  RefreshIcon(current, tag);
+  m_Model->setCurrentItem(m_Model->itemForIndex(current));
+
+  uint32_t EID = m_Model->eventId(current);
+  uint32_t lastEID = m_Model->lastEventId(current);
 
-  m_Ctx.SetEventID({this}, tag.EID, tag.lastEID);
+  m_Ctx.SetEventID({this}, EID, lastEID);
 
-  const DrawcallDescription *draw = m_Ctx.GetDrawcall(tag.lastEID);
+  const DrawcallDescription *draw = m_Ctx.GetDrawcall(lastEID);
 
   ui->stepPrev->setEnabled(draw && draw->previous);
   ui->stepNext->setEnabled(draw && draw->next);
 
   // special case for the first draw in the frame
-  if(tag.lastEID == 0)
+  if(lastEID == 0)
     ui->stepNext->setEnabled(true);
 
   // special case for the first 'virtual' draw at EID 0
-  if(m_Ctx.GetFirstDrawcall() && tag.lastEID == m_Ctx.GetFirstDrawcall()->eventId)
+  if(m_Ctx.GetFirstDrawcall() && lastEID == m_Ctx.GetFirstDrawcall()->eventId)
     ui->stepPrev->setEnabled(true);
 
   highlightBookmarks();
@@ -742,7 +1076,8 @@ void EventBrowser::on_colSelect_clicked()
   {
     int logIdx = ui->events->header()->logicalIndex(visIdx);
 
-    QListWidgetItem *item = new QListWidgetItem(ui->events->headerText(logIdx), &list);
+    QListWidgetItem *item = new QListWidgetItem(
+        m_Model->headerData(logIdx, Qt::Horizontal, Qt::DisplayRole).toString(), &list);
 
     item->setData(Qt::UserRole, logIdx);
 
@@ -907,7 +1242,7 @@ QVariant EventBrowser::persistData()
       ui->events->header()->hideSection(i);
 
     // name is just informative
-    col[lit("name")] = ui->events->headerText(i);
+    col[lit("name")] = m_Model->headerData(i, Qt::Horizontal, Qt::DisplayRole).toString();
     col[lit("index")] = ui->events->header()->visualIndex(i);
     col[lit("hidden")] = hidden;
     col[lit("size")] = size;
@@ -984,7 +1319,7 @@ void EventBrowser::events_keyPress(QKeyEvent *event)
 
 void EventBrowser::events_contextMenu(const QPoint &pos)
 {
-  RDTreeWidgetItem *item = ui->events->itemAt(pos);
+  QModelIndex idx = ui->events->indexAt(pos);
 
   QMenu contextMenu(this);
 
@@ -1002,14 +1337,14 @@ void EventBrowser::events_contextMenu(const QPoint &pos)
   collapseAll.setIcon(Icons::arrow_in());
   selectCols.setIcon(Icons::timeline_marker());
 
-  expandAll.setEnabled(item && item->childCount() > 0);
-  collapseAll.setEnabled(item && item->childCount() > 0);
+  expandAll.setEnabled(idx.isValid() && m_Model->rowCount(idx.sibling(idx.row(), 0)) > 0);
+  collapseAll.setEnabled(expandAll.isEnabled());
 
   QObject::connect(&expandAll, &QAction::triggered,
-                   [this, item]() { ui->events->expandAllItems(item); });
+                   [this, idx]() { ExpandAll(idx.sibling(idx.row(), 0)); });
 
   QObject::connect(&collapseAll, &QAction::triggered,
-                   [this, item]() { ui->events->collapseAllItems(item); });
+                   [this, idx]() { CollapseAll(idx.sibling(idx.row(), 0)); });
 
   QObject::connect(&selectCols, &QAction::triggered, this, &EventBrowser::on_colSelect_clicked);
 
@@ -1066,16 +1401,7 @@ void EventBrowser::repopulateBookmarks()
 
       highlightBookmarks();
 
-      RDTreeWidgetItem *found = NULL;
-      FindEventNode(found, ui->events->topLevelItem(0), EID);
-
-      if(found)
-      {
-        EventItemTag tag = found->tag().value<EventItemTag>();
-        tag.bookmark = true;
-        found->setTag(QVariant::fromValue(tag));
-        RefreshIcon(found, tag);
-      }
+      m_Model->setBookmark(EID, true);
 
       m_BookmarkStripLayout->removeItem(m_BookmarkSpacer);
       m_BookmarkStripLayout->addWidget(but);
@@ -1091,16 +1417,7 @@ void EventBrowser::repopulateBookmarks()
       delete m_BookmarkButtons[EID];
       m_BookmarkButtons.remove(EID);
 
-      RDTreeWidgetItem *found = NULL;
-      FindEventNode(found, ui->events->topLevelItem(0), EID);
-
-      if(found)
-      {
-        EventItemTag tag = found->tag().value<EventItemTag>();
-        tag.bookmark = false;
-        found->setTag(QVariant::fromValue(tag));
-        RefreshIcon(found, tag);
-      }
+      m_Model->setBookmark(EID, false);
     }
   }
 
@@ -1138,70 +1455,46 @@ void EventBrowser::highlightBookmarks()
   }
 }
 
-bool EventBrowser::hasBookmark(RDTreeWidgetItem *node)
-{
-  if(node)
-    return hasBookmark(node->tag().value<EventItemTag>().EID);
-
-  return false;
-}
-
 bool EventBrowser::hasBookmark(uint32_t EID)
 {
   return m_Ctx.GetBookmarks().contains(EventBookmark(EID));
 }
 
-void EventBrowser::RefreshIcon(RDTreeWidgetItem *item, EventItemTag tag)
-{
-  if(tag.current)
-    item->setIcon(COL_NAME, Icons::flag_green());
-  else if(tag.bookmark)
-    item->setIcon(COL_NAME, Icons::asterisk_orange());
-  else if(tag.find)
-    item->setIcon(COL_NAME, Icons::find());
-  else
-    item->setIcon(COL_NAME, QIcon());
-}
-
-bool EventBrowser::FindEventNode(RDTreeWidgetItem *&found, RDTreeWidgetItem *parent, uint32_t eventId)
+void EventBrowser::ExpandNode(const QModelIndex &idx)
 {
-  // do a reverse search to find the last match (in case of 'set' markers that
-  // inherit the event of the next real draw).
-  for(int i = parent->childCount() - 1; i >= 0; i--)
+  QModelIndex node = idx;
+  while(node.isValid())
   {
-    RDTreeWidgetItem *n = parent->child(i);
-
-    uint nEID = n->tag().value<EventItemTag>().lastEID;
-    uint fEID = found ? found->tag().value<EventItemTag>().lastEID : 0;
+    ui->events->expand(node);
+    node = node.parent();
+  }
 
-    if(nEID >= eventId && (found == NULL || nEID <= fEID))
-      found = n;
+  if(idx.isValid())
+    ui->events->scrollTo(idx);
+}
 
-    if(nEID == eventId && n->childCount() == 0)
-      return true;
+void EventBrowser::ExpandAll(const QModelIndex &idx)
+{
+  ui->events->expand(idx);
 
-    if(n->childCount() > 0)
-    {
-      bool exact = FindEventNode(found, n, eventId);
-      if(exact)
-        return true;
-    }
+  for(int r = 0; r < m_Model->rowCount(idx); r++)
+  {
+    QModelIndex child = m_Model->index(r, 0, idx);
+    if(m_Model->rowCount(child) > 0)
+      ExpandAll(child);
   }
-
-  return false;
 }
 
-void EventBrowser::ExpandNode(RDTreeWidgetItem *node)
+void EventBrowser::CollapseAll(const QModelIndex &idx)
 {
-  RDTreeWidgetItem *n = node;
-  while(node != NULL)
+  ui->events->collapse(idx);
+
+  for(int r = 0; r < m_Model->rowCount(idx); r++)
   {
-    ui->events->expandItem(node);
-    node = node->parent();
+    QModelIndex child = m_Model->index(r, 0, idx);
+    if(m_Model->rowCount(child) > 0)
+      CollapseAll(child);
   }
-
-  if(n)
-    ui->events->scrollToItem(n);
 }
 
 bool EventBrowser::SelectEvent(uint32_t eventId)
@@ -1209,12 +1502,10 @@ bool EventBrowser::SelectEvent(uint32_t eventId)
   if(!m_Ctx.IsCaptureLoaded())
     return false;
 
-  RDTreeWidgetItem *found = NULL;
-  FindEventNode(found, ui->events->topLevelItem(0), eventId);
-  if(found != NULL)
+  QModelIndex found = m_Model->indexForItem(m_Model->findItem(eventId));
+  if(found.isValid())
   {
-    ui->events->setCurrentItem(found);
-    ui->events->setSelectedItem(found);
+    ui->events->setCurrentIndex(found);
 
     ExpandNode(found);
     return true;
@@ -1223,116 +1514,14 @@ bool EventBrowser::SelectEvent(uint32_t eventId)
   return false;
 }
 
-void EventBrowser::ClearFindIcons(RDTreeWidgetItem *parent)
-{
-  for(int i = 0; i < parent->childCount(); i++)
-  {
-    RDTreeWidgetItem *n = parent->child(i);
-
-    EventItemTag tag = n->tag().value<EventItemTag>();
-    tag.find = false;
-    n->setTag(QVariant::fromValue(tag));
-    RefreshIcon(n, tag);
-
-    if(n->childCount() > 0)
-      ClearFindIcons(n);
-  }
-}
-
 void EventBrowser::ClearFindIcons()
 {
-  if(m_Ctx.IsCaptureLoaded())
-    ClearFindIcons(ui->events->topLevelItem(0));
-}
-
-int EventBrowser::SetFindIcons(RDTreeWidgetItem *parent, QString filter)
-{
-  int results = 0;
-
-  for(int i = 0; i < parent->childCount(); i++)
-  {
-    RDTreeWidgetItem *n = parent->child(i);
-
-    if(n->text(COL_NAME).contains(filter, Qt::CaseInsensitive))
-    {
-      EventItemTag tag = n->tag().value<EventItemTag>();
-      tag.find = true;
-      n->setTag(QVariant::fromValue(tag));
-      RefreshIcon(n, tag);
-      results++;
-    }
-
-    if(n->childCount() > 0)
-    {
-      results += SetFindIcons(n, filter);
-    }
-  }
-
-  return results;
+  m_Model->setFindFilter(QString());
 }
 
 int EventBrowser::SetFindIcons(QString filter)
 {
-  if(filter.isEmpty())
-    return 0;
-
-  return SetFindIcons(ui->events->topLevelItem(0), filter);
-}
-
-RDTreeWidgetItem *EventBrowser::FindNode(RDTreeWidgetItem *parent, QString filter, uint32_t after)
-{
-  for(int i = 0; i < parent->childCount(); i++)
-  {
-    RDTreeWidgetItem *n = parent->child(i);
-
-    uint eid = n->tag().value<EventItemTag>().lastEID;
-
-    if(eid > after && n->text(COL_NAME).contains(filter, Qt::CaseInsensitive))
-      return n;
-
-    if(n->childCount() > 0)
-    {
-      RDTreeWidgetItem *found = FindNode(n, filter, after);
-
-      if(found != NULL)
-        return found;
-    }
-  }
-
-  return NULL;
-}
-
-int EventBrowser::FindEvent(RDTreeWidgetItem *parent, QString filter, uint32_t after, bool forward)
-{
-  if(parent == NULL)
-    return -1;
-
-  for(int i = forward ? 0 : parent->childCount() - 1; i >= 0 && i < parent->childCount();
-      i += forward ? 1 : -1)
-  {
-    auto n = parent->child(i);
-
-    uint eid = n->tag().value<EventItemTag>().lastEID;
-
-    bool matchesAfter = (forward && eid > after) || (!forward && eid < after);
-
-    if(matchesAfter)
-    {
-      QString name = n->text(COL_NAME);
-      if(name.contains(filter, Qt::CaseInsensitive))
-        return (int)eid;
-    }
-
-    if(n->childCount() > 0)
-    {
-      int found = FindEvent(n, filter, after, forward);
-
-      if(found > 0)
-        return found;
-    }
-  }
-
-  return -1;
+  return m_Model->setFindFilter(filter);
 }
 
 int EventBrowser::FindEvent(QString filter, uint32_t after, bool forward)
@@ -1340,7 +1529,7 @@ int EventBrowser::FindEvent(QString filter, uint32_t after, bool forward)
   if(!m_Ctx.IsCaptureLoaded())
     return 0;
 
-  return FindEvent(ui->events->topLevelItem(0), filter, after, forward);
+  return m_Model->findEvent(filter, after, forward);
 }
 
 void EventBrowser::Find(bool forward)
@@ -1350,9 +1539,9 @@ void EventBrowser::Find(bool forward)
 
   uint32_t curEID = m_Ctx.CurSelectedEvent();
 
-  RDTreeWidgetItem *node = ui->events->selectedItem();
-  if(node)
-    curEID = node->tag().value<EventItemTag>().lastEID;
+  QModelIndex idx = ui->events->currentIndex();
+  if(idx.isValid())
+    curEID = m_Model->lastEventId(idx);
 
   int eid = FindEvent(ui->findEvent->text(), curEID, forward);
   if(eid >= 0)
@@ -1382,8 +1571,5 @@ void EventBrowser::UpdateDurationColumn()
 
   m_TimeUnit = m_Ctx.Config().EventBrowser_TimeUnit;
 
-  ui->events->setHeaderText(COL_DURATION, tr("Duration (%1)").arg(UnitSuffix(m_TimeUnit)));
-
-  if(!m_Times.empty())
-    SetDrawcallTimes(ui->events->topLevelItem(0), m_Times);
+  m_Model->setTimeUnit(m_TimeUnit);
 }
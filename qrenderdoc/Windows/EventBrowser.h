@@ -33,13 +33,13 @@ namespace Ui
 class EventBrowser;
 }
 
+class QModelIndex;
 class QSpacerItem;
 class QToolButton;
-class RDTreeWidgetItem;
 class QTimer;
 class QTextStream;
 class FlowLayout;
-struct EventItemTag;
+class EventItemModel;
 
 class EventBrowser : public QFrame, public IEventBrowser, public ICaptureViewer
 {
@@ -75,7 +75,6 @@ private slots:
   void on_findEvent_returnPressed();
   void on_findEvent_keyPress(QKeyEvent *event);
   void on_findEvent_textEdited(const QString &arg1);
-  void on_events_currentItemChanged(RDTreeWidgetItem *current, RDTreeWidgetItem *previous);
   void on_findNext_clicked();
   void on_findPrev_clicked();
   void on_stepNext_clicked();
@@ -87,6 +86,7 @@ private slots:
   void findHighlight_timeout();
   void events_keyPress(QKeyEvent *event);
   void events_contextMenu(const QPoint &pos);
+  void events_currentChanged(const QModelIndex &current, const QModelIndex &previous);
 
 public slots:
   void clearBookmarks();
@@ -95,28 +95,18 @@ public slots:
   void jumpToBookmark(int idx);
 
 private:
-  bool ShouldHide(const DrawcallDescription &drawcall);
-  QPair<uint32_t, uint32_t> AddDrawcalls(RDTreeWidgetItem *parent,
-                                         const rdcarray<DrawcallDescription> &draws);
-  void SetDrawcallTimes(RDTreeWidgetItem *node, const rdcarray<CounterResult> &results);
+  void ExpandNode(const QModelIndex &idx);
+  void ExpandAll(const QModelIndex &idx);
+  void CollapseAll(const QModelIndex &idx);
 
-  void ExpandNode(RDTreeWidgetItem *node);
-
-  bool FindEventNode(RDTreeWidgetItem *&found, RDTreeWidgetItem *parent, uint32_t eventId);
   bool SelectEvent(uint32_t eventId);
 
-  void ClearFindIcons(RDTreeWidgetItem *parent);
   void ClearFindIcons();
-
-  int SetFindIcons(RDTreeWidgetItem *parent, QString filter);
   int SetFindIcons(QString filter);
 
   void repopulateBookmarks();
   void highlightBookmarks();
-  bool hasBookmark(RDTreeWidgetItem *node);
 
-  RDTreeWidgetItem *FindNode(RDTreeWidgetItem *parent, QString filter, uint32_t after);
-  int FindEvent(RDTreeWidgetItem *parent, QString filter, uint32_t after, bool forward);
   int FindEvent(QString filter, uint32_t after, bool forward);
   void Find(bool forward);
 
@@ -139,7 +129,7 @@ private:
   QSpacerItem *m_BookmarkSpacer;
   QMap<uint32_t, QToolButton *> m_BookmarkButtons;
 
-  void RefreshIcon(RDTreeWidgetItem *item, EventItemTag tag);
+  EventItemModel *m_Model;
 
   Ui::EventBrowser *ui;
   ICaptureContext &m_Ctx;
@@ -27,6 +27,7 @@
 #include <QPainter>
 #include <QScrollBar>
 #include <QWheelEvent>
+#include <QtMath>
 #include "Code/QRDUtils.h"
 #include "Code/Resources.h"
 
@@ -47,6 +48,75 @@ QMargins uniformMargins(int m)
   return QMargins(m, m, m, m);
 }
 
+enum
+{
+  ReadUsage,
+  WriteUsage,
+  ReadWriteUsage,
+  ClearUsage,
+  BarrierUsage,
+
+  HistoryPassed,
+  HistoryFailed,
+
+  UsageCount,
+};
+
+// builds a flat binary tree where each node holds the maximum of its children, with the values
+// themselves as the leaves.
+static QVector<uint32_t> makeMaxTree(const QVector<uint32_t> &values)
+{
+  int size = 1;
+  while(size < values.count())
+    size *= 2;
+
+  QVector<uint32_t> tree(size * 2, 0);
+
+  for(int i = 0; i < values.count(); i++)
+    tree[size + i] = values[i];
+
+  for(int i = size - 1; i > 0; i--)
+    tree[i] = qMax(tree[i * 2], tree[i * 2 + 1]);
+
+  return tree;
+}
+
+// returns the first index at or after start with a value of at least threshold, or an index past
+// the end of the values if there is none.
+static int nextAtLeast(const QVector<uint32_t> &tree, int start, uint32_t threshold)
+{
+  int size = tree.count() / 2;
+
+  if(start >= size)
+    return size;
+
+  int i = start + size;
+
+  // move right through the tree until we reach a subtree containing a large enough value. If we're
+  // a right child, climb first so we don't revisit anything to the left of where we started.
+  while(tree[i] < threshold)
+  {
+    while(i & 1)
+      i >>= 1;
+
+    // we ran off the right of the root
+    if(i == 0)
+      return size;
+
+    i++;
+  }
+
+  // then descend to the left-most leaf in that subtree that's large enough
+  while(i < size)
+  {
+    i *= 2;
+    if(tree[i] < threshold)
+      i++;
+  }
+
+  return i - size;
+}
+
 class PipRanges
 {
 public:
@@ -137,13 +207,39 @@ void TimelineBar::HighlightResourceUsage(ResourceId id)
   m_UsageEvents.clear();
   m_UsageTarget = m_Ctx.GetResourceName(id);
 
+  // the usage of a resource never changes within a capture, so only fetch it once. The entry is
+  // added empty while the fetch is in flight, so highlighting again doesn't fetch it twice.
+  auto it = m_UsageCache.find(id);
+  if(it != m_UsageCache.end())
+  {
+    m_UsageEvents = it.value();
+    updatePips();
+    viewport()->update();
+    return;
+  }
+
+  m_UsageCache[id] = QList<EventUsage>();
+
+  updatePips();
+
   m_Ctx.Replay().AsyncInvoke([this, id](IReplayController *r) {
     rdcarray<EventUsage> usage = r->GetUsage(id);
 
-    GUIInvoke::call(this, [this, usage]() {
+    GUIInvoke::call(this, [this, id, usage]() {
+      QList<EventUsage> events;
       for(const EventUsage &u : usage)
-        m_UsageEvents << u;
-      qSort(m_UsageEvents);
+        events << u;
+      qSort(events);
+
+      m_UsageCache[id] = events;
+
+      // the highlighted resource may have changed while this was in flight
+      if(m_ID == id)
+      {
+        m_UsageEvents = events;
+        updatePips();
+      }
+
       viewport()->update();
     });
   });
@@ -166,6 +262,8 @@ void TimelineBar::HighlightHistory(ResourceId id, const rdcarray<PixelModificati
     qSort(m_HistoryEvents);
   }
 
+  updatePips();
+
   viewport()->update();
 }
 
@@ -177,10 +275,13 @@ void TimelineBar::OnCaptureClosed()
   m_HistoryTarget = m_UsageTarget = QString();
   m_HistoryEvents.clear();
   m_UsageEvents.clear();
+  m_UsageCache.clear();
+  updatePips();
 
   m_Draws.clear();
   m_RootDraws.clear();
   m_RootMarkers.clear();
+  m_RootSpans.clear();
 
   layout();
 }
@@ -189,7 +290,7 @@ void TimelineBar::OnCaptureLoaded()
 {
   setWindowTitle(tr("Timeline - Frame #%1").arg(m_Ctx.FrameInfo().frameNumber));
 
-  processDraws(m_RootMarkers, m_RootDraws, m_Ctx.CurDrawcalls());
+  processDraws(m_RootMarkers, m_RootDraws, m_RootSpans, m_Ctx.CurDrawcalls());
 
   m_zoom = 1.0;
   m_pan = 0.0;
@@ -299,7 +400,7 @@ void TimelineBar::mousePressEvent(QMouseEvent *e)
 
   if((e->modifiers() & Qt::AltModifier) == 0)
   {
-    Marker *marker = findMarker(m_RootMarkers, m_markerRect, m_lastPos);
+    Marker *marker = findMarker(m_RootMarkers, m_RootSpans, m_markerRect, m_lastPos);
     if(marker)
     {
       marker->expanded = !marker->expanded;
@@ -355,12 +456,7 @@ void TimelineBar::mousePressEvent(QMouseEvent *e)
     if(!m_Draws.isEmpty() && m_dataArea.contains(m_lastPos))
     {
       uint32_t eid = eventAt(x);
-      auto it = std::find_if(m_Draws.begin(), m_Draws.end(), [eid](uint32_t d) {
-        if(d >= eid)
-          return true;
-
-        return false;
-      });
+      auto it = std::lower_bound(m_Draws.begin(), m_Draws.end(), eid);
 
       if(it == m_Draws.end())
         m_Ctx.SetEventID({}, m_Draws.back(), m_Draws.back());
@@ -393,7 +489,7 @@ void TimelineBar::mouseMoveEvent(QMouseEvent *e)
             !m_highlightingRect.contains(e->localPos()))
     {
       uint32_t eid = eventAt(x);
-      if(m_Draws.contains(eid) && eid != m_Ctx.CurEvent())
+      if(std::binary_search(m_Draws.begin(), m_Draws.end(), eid) && eid != m_Ctx.CurEvent())
         m_Ctx.SetEventID({}, eid, eid);
     }
   }
@@ -404,7 +500,7 @@ void TimelineBar::mouseMoveEvent(QMouseEvent *e)
 
   m_lastPos = e->localPos();
 
-  Marker *marker = findMarker(m_RootMarkers, m_markerRect, m_lastPos);
+  Marker *marker = findMarker(m_RootMarkers, m_RootSpans, m_markerRect, m_lastPos);
   if(marker)
     setCursor(Qt::PointingHandCursor);
   else
@@ -555,9 +651,16 @@ void TimelineBar::paintEvent(QPaintEvent *e)
   QRectF labelRect = eidAxisRect;
   labelRect.setWidth(m_eidAxisLabelWidth);
 
-  // iterate through the EIDs from 0, starting from possible a negative offset if the user has
-  // panned to the right.
-  for(uint32_t i = 0; i <= maxEID; i += m_eidAxisLabelStep)
+  // iterate through the EIDs starting from the first label that could be visible, since at high
+  // zoom levels most of them will be off the left of the screen.
+  uint32_t firstLabel = 0;
+  {
+    qreal firstEID = fractionalEventAt(m_eidAxisRect.left() - m_eidAxisLabelWidth);
+    if(firstEID > 0.0)
+      firstLabel = qMin(maxEID, uint32_t(firstEID)) / m_eidAxisLabelStep * m_eidAxisLabelStep;
+  }
+
+  for(uint32_t i = firstLabel; i <= maxEID; i += m_eidAxisLabelStep)
   {
     labelRect.moveLeft(offsetOf(i) - labelRect.width() / 2 + m_eidWidth / 2);
 
@@ -579,7 +682,7 @@ void TimelineBar::paintEvent(QPaintEvent *e)
 
   {
     QPen pen = p.pen();
-    paintMarkers(p, m_RootMarkers, m_RootDraws, m_markerRect);
+    paintMarkers(p, m_RootMarkers, m_RootDraws, m_RootSpans, m_markerRect);
     p.setPen(pen);
   }
 
@@ -660,20 +763,6 @@ void TimelineBar::paintEvent(QPaintEvent *e)
         QPolygonF({QPoint(0, triHeight), QPoint(triRadius * 2, triHeight), QPoint(triRadius, 0)}));
     triangle.closeSubpath();
 
-    enum
-    {
-      ReadUsage,
-      WriteUsage,
-      ReadWriteUsage,
-      ClearUsage,
-      BarrierUsage,
-
-      HistoryPassed,
-      HistoryFailed,
-
-      UsageCount,
-    };
-
     // colors taken from http://mkweb.bcgsc.ca/colorblind/ to be distinct for people with color
     // blindness
 
@@ -766,55 +855,22 @@ void TimelineBar::paintEvent(QPaintEvent *e)
     qreal leftClip = -triRadius * 2.0;
     qreal rightClip = pipsRect.width() + triRadius * 10.0;
 
-    if(!m_HistoryEvents.isEmpty())
+    for(int i = 0; i < UsageCount && i < m_Pips.count(); i++)
     {
-      for(const PixelModification &mod : m_HistoryEvents)
-      {
-        qreal pos = offsetOf(mod.eventId) + m_eidWidth / 2 - triRadius;
-
-        if(pos < leftClip || pos > rightClip)
-          continue;
+      const QVector<uint32_t> &eids = m_Pips[i];
 
-        if(mod.Passed())
-          pipranges[HistoryPassed].push(pos, triRadius);
-        else
-          pipranges[HistoryFailed].push(pos, triRadius);
-      }
-    }
-    else
-    {
-      for(const EventUsage &use : m_UsageEvents)
+      // start from the first pip inside the left clip, and skip any that would land within a pixel
+      // of the previous one as they'd be merged into the same range anyway.
+      for(int e = firstEventAt(eids, leftClip - m_eidWidth / 2 + triRadius); e < eids.count();)
       {
-        qreal pos = offsetOf(use.eventId) + m_eidWidth / 2 - triRadius;
+        qreal pos = offsetOf(eids[e]) + m_eidWidth / 2 - triRadius;
 
-        if(pos < leftClip || pos > rightClip)
-          continue;
+        if(pos > rightClip)
+          break;
 
-        if(((int)use.usage >= (int)ResourceUsage::VS_RWResource &&
-            (int)use.usage <= (int)ResourceUsage::All_RWResource) ||
-           use.usage == ResourceUsage::GenMips || use.usage == ResourceUsage::Copy ||
-           use.usage == ResourceUsage::Resolve)
-        {
-          pipranges[ReadWriteUsage].push(pos, triRadius);
-        }
-        else if(use.usage == ResourceUsage::StreamOut || use.usage == ResourceUsage::ResolveDst ||
-                use.usage == ResourceUsage::ColorTarget ||
-                use.usage == ResourceUsage::DepthStencilTarget || use.usage == ResourceUsage::CopyDst)
-        {
-          pipranges[WriteUsage].push(pos, triRadius);
-        }
-        else if(use.usage == ResourceUsage::Clear)
-        {
-          pipranges[ClearUsage].push(pos, triRadius);
-        }
-        else if(use.usage == ResourceUsage::Barrier)
-        {
-          pipranges[BarrierUsage].push(pos, triRadius);
-        }
-        else
-        {
-          pipranges[ReadUsage].push(pos, triRadius);
-        }
+        pipranges[i].push(pos, triRadius);
+
+        e = qMax(e + 1, firstEventAt(eids, offsetOf(eids[e]) + 1.0));
       }
     }
 
@@ -840,12 +896,17 @@ void TimelineBar::paintEvent(QPaintEvent *e)
   }
 }
 
-TimelineBar::Marker *TimelineBar::findMarker(QVector<Marker> &markers, QRectF markerRect, QPointF pos)
+TimelineBar::Marker *TimelineBar::findMarker(QVector<Marker> &markers,
+                                             const QVector<uint32_t> &spans, QRectF markerRect,
+                                             QPointF pos)
 {
   QFontMetrics fm(Formatter::PreferredFont());
 
-  for(Marker &m : markers)
+  for(int i = nextVisibleMarker(markers, spans, firstVisibleMarker(markers)); i < markers.count();
+      i = nextVisibleMarker(markers, spans, i + 1))
   {
+    Marker &m = markers[i];
+
     QRectF r = markerRect;
     r.setLeft(qMax(m_markerRect.left() + borderWidth * 2, offsetOf(m.eidStart)));
     r.setRight(qMin(m_markerRect.right() - borderWidth, offsetOf(m.eidEnd + 1)));
@@ -865,7 +926,7 @@ TimelineBar::Marker *TimelineBar::findMarker(QVector<Marker> &markers, QRectF ma
       childRect.setTop(r.bottom() + borderWidth * 2);
       childRect.setBottom(markerRect.bottom());
 
-      Marker *res = findMarker(m.children, childRect, pos);
+      Marker *res = findMarker(m.children, m.childSpans, childRect, pos);
 
       if(res)
         return res;
@@ -876,7 +937,8 @@ TimelineBar::Marker *TimelineBar::findMarker(QVector<Marker> &markers, QRectF ma
 }
 
 void TimelineBar::paintMarkers(QPainter &p, const QVector<Marker> &markers,
-                               const QVector<uint32_t> &draws, QRectF markerRect)
+                               const QVector<uint32_t> &draws, const QVector<uint32_t> &spans,
+                               QRectF markerRect)
 {
   if(markers.isEmpty() && draws.isEmpty())
     return;
@@ -891,8 +953,11 @@ void TimelineBar::paintMarkers(QPainter &p, const QVector<Marker> &markers,
   // store a reference of what a completely elided string looks like
   QString tooshort = fm.elidedText(lit("asd"), Qt::ElideRight, fm.height());
 
-  for(const Marker &m : markers)
+  for(int i = nextVisibleMarker(markers, spans, firstVisibleMarker(markers)); i < markers.count();
+      i = nextVisibleMarker(markers, spans, i + 1))
   {
+    const Marker &m = markers[i];
+
     QRectF r = markerRect;
     r.setLeft(qMax(m_dataArea.left() + borderWidth * 3, offsetOf(m.eidStart)));
     r.setRight(qMin(m_dataArea.right() - borderWidth, offsetOf(m.eidEnd + 1)));
@@ -943,14 +1008,13 @@ void TimelineBar::paintMarkers(QPainter &p, const QVector<Marker> &markers,
       childRect.setTop(r.bottom() + borderWidth * 2);
       childRect.setBottom(markerRect.bottom());
 
-      paintMarkers(p, m.children, m.draws, childRect);
+      paintMarkers(p, m.children, m.draws, m.childSpans, childRect);
     }
   }
 
   p.setRenderHint(QPainter::Antialiasing);
 
-  for(uint32_t d : draws)
-  {
+  auto paintDraw = [&](uint32_t d) {
     QRectF r = markerRect;
     r.setLeft(qMax(m_dataArea.left() + borderWidth * 3, offsetOf(d)));
     r.setRight(qMin(m_dataArea.right() - borderWidth, offsetOf(d + 1)));
@@ -962,8 +1026,26 @@ void TimelineBar::paintMarkers(QPainter &p, const QVector<Marker> &markers,
     p.setPen(QPen(palette().brush(QPalette::Text), 1.0));
     p.fillPath(path, d == m_Ctx.CurEvent() ? Qt::green : Qt::blue);
     p.drawPath(path);
+  };
+
+  // only draw from the first visible draw, and skip any draws that would land within a pixel of the
+  // previous one so the cost depends on the width of the view, not on the number of draws.
+  for(int i = qMax(0, firstEventAt(draws, m_dataArea.left()) - 1); i < draws.count();)
+  {
+    qreal x = offsetOf(draws[i]);
+
+    if(x > m_dataArea.right())
+      break;
+
+    paintDraw(draws[i]);
+
+    i = qMax(i + 1, firstEventAt(draws, x + 1.0));
   }
 
+  // make sure the current draw is always shown, even if it was skipped above
+  if(std::binary_search(draws.begin(), draws.end(), m_Ctx.CurEvent()))
+    paintDraw(m_Ctx.CurEvent());
+
   p.setRenderHint(QPainter::Antialiasing, false);
 }
 
@@ -986,6 +1068,105 @@ uint32_t TimelineBar::eventAt(qreal x)
   return qMin(maxEID, uint32_t(steps * m_eidAxisLabelStep));
 }
 
+qreal TimelineBar::fractionalEventAt(qreal x)
+{
+  if(m_eidAxisLabelWidth <= 0.0)
+    return 0.0;
+
+  // the unclamped inverse of offsetOf()
+  return (x - m_pan - m_eidAxisRect.left()) * m_eidAxisLabelStep / m_eidAxisLabelWidth;
+}
+
+int TimelineBar::firstEventAt(const QVector<uint32_t> &eids, qreal x)
+{
+  qreal eid = fractionalEventAt(x);
+
+  if(eid <= 0.0)
+    return 0;
+
+  if(eid >= qreal(UINT32_MAX))
+    return eids.count();
+
+  return std::lower_bound(eids.begin(), eids.end(), uint32_t(qCeil(eid))) - eids.begin();
+}
+
+int TimelineBar::firstVisibleMarker(const QVector<Marker> &markers)
+{
+  // markers are sorted and don't overlap, so skip all those ending before the left of the view
+  qreal left = m_dataArea.left();
+
+  return std::lower_bound(markers.begin(), markers.end(), left,
+                          [this](const Marker &m, qreal x) { return offsetOf(m.eidEnd + 1) <= x; }) -
+         markers.begin();
+}
+
+int TimelineBar::nextVisibleMarker(const QVector<Marker> &markers, const QVector<uint32_t> &spans,
+                                   int idx)
+{
+  // markers covering fewer EIDs than this are too narrow to ever be drawn, so use the span tree to
+  // jump over them
+  uint32_t minSpan = 0;
+  if(m_eidAxisLabelWidth > 0.0)
+    minSpan = uint32_t(qMin(borderWidth * 2.0 * m_eidAxisLabelStep / m_eidAxisLabelWidth,
+                            qreal(UINT32_MAX)));
+
+  idx = qMin(nextAtLeast(spans, idx, minSpan), markers.count());
+
+  // stop once we're past the right of the view
+  if(idx < markers.count() && offsetOf(markers[idx].eidStart) > m_dataArea.right())
+    return markers.count();
+
+  return idx;
+}
+
+void TimelineBar::updatePips()
+{
+  m_Pips.clear();
+  m_Pips.resize(UsageCount);
+
+  if(!m_HistoryEvents.isEmpty())
+  {
+    for(const PixelModification &mod : m_HistoryEvents)
+    {
+      if(mod.Passed())
+        m_Pips[HistoryPassed].push_back(mod.eventId);
+      else
+        m_Pips[HistoryFailed].push_back(mod.eventId);
+    }
+  }
+  else
+  {
+    for(const EventUsage &use : m_UsageEvents)
+    {
+      if(((int)use.usage >= (int)ResourceUsage::VS_RWResource &&
+          (int)use.usage <= (int)ResourceUsage::All_RWResource) ||
+         use.usage == ResourceUsage::GenMips || use.usage == ResourceUsage::Copy ||
+         use.usage == ResourceUsage::Resolve)
+      {
+        m_Pips[ReadWriteUsage].push_back(use.eventId);
+      }
+      else if(use.usage == ResourceUsage::StreamOut || use.usage == ResourceUsage::ResolveDst ||
+              use.usage == ResourceUsage::ColorTarget ||
+              use.usage == ResourceUsage::DepthStencilTarget || use.usage == ResourceUsage::CopyDst)
+      {
+        m_Pips[WriteUsage].push_back(use.eventId);
+      }
+      else if(use.usage == ResourceUsage::Clear)
+      {
+        m_Pips[ClearUsage].push_back(use.eventId);
+      }
+      else if(use.usage == ResourceUsage::Barrier)
+      {
+        m_Pips[BarrierUsage].push_back(use.eventId);
+      }
+      else
+      {
+        m_Pips[ReadUsage].push_back(use.eventId);
+      }
+    }
+  }
+}
+
 qreal TimelineBar::offsetOf(uint32_t eid)
 {
   int steps = eid / m_eidAxisLabelStep;
@@ -997,6 +1178,7 @@ qreal TimelineBar::offsetOf(uint32_t eid)
 }
 
 uint32_t TimelineBar::processDraws(QVector<Marker> &markers, QVector<uint32_t> &draws,
+                                   QVector<uint32_t> &spans,
                                    const rdcarray<DrawcallDescription> &curDraws)
 {
   uint32_t maxEID = 0;
@@ -1010,7 +1192,7 @@ uint32_t TimelineBar::processDraws(QVector<Marker> &markers, QVector<uint32_t> &
 
       m.name = d.name;
       m.eidStart = d.eventId;
-      m.eidEnd = processDraws(m.children, m.draws, d.children);
+      m.eidEnd = processDraws(m.children, m.draws, m.childSpans, d.children);
 
       maxEID = qMax(maxEID, m.eidEnd);
 
@@ -1036,5 +1218,12 @@ uint32_t TimelineBar::processDraws(QVector<Marker> &markers, QVector<uint32_t> &
     maxEID = qMax(maxEID, d.eventId);
   }
 
+  QVector<uint32_t> markerSpans;
+  markerSpans.reserve(markers.count());
+  for(const Marker &m : markers)
+    markerSpans.push_back(m.eidEnd + 1 - m.eidStart);
+
+  spans = makeMaxTree(markerSpans);
+
   return maxEID;
 }
@@ -69,10 +69,14 @@ private:
 
     QVector<Marker> children;
     QVector<uint32_t> draws;
+
+    // max-tree over the EID span of each child, to skip past markers too small to be visible
+    QVector<uint32_t> childSpans;
   };
 
   QVector<Marker> m_RootMarkers;
   QVector<uint32_t> m_RootDraws;
+  QVector<uint32_t> m_RootSpans;
   QVector<uint32_t> m_Draws;
 
   ResourceId m_ID;
@@ -81,6 +85,10 @@ private:
 
   QString m_UsageTarget;
   QList<EventUsage> m_UsageEvents;
+  QMap<ResourceId, QList<EventUsage>> m_UsageCache;
+
+  // sorted EIDs of the highlighted usage or history events, split by the type of pip drawn
+  QVector<QVector<uint32_t>> m_Pips;
 
   const qreal margin = 2.0;
   const qreal borderWidth = 1.0;
@@ -107,10 +115,16 @@ private:
   void layout();
 
   uint32_t eventAt(qreal x);
+  qreal fractionalEventAt(qreal x);
   qreal offsetOf(uint32_t eid);
+  int firstEventAt(const QVector<uint32_t> &eids, qreal x);
+  int firstVisibleMarker(const QVector<Marker> &markers);
+  int nextVisibleMarker(const QVector<Marker> &markers, const QVector<uint32_t> &spans, int idx);
+  void updatePips();
   uint32_t processDraws(QVector<Marker> &markers, QVector<uint32_t> &draws,
-                        const rdcarray<DrawcallDescription> &curDraws);
+                        QVector<uint32_t> &spans, const rdcarray<DrawcallDescription> &curDraws);
   void paintMarkers(QPainter &p, const QVector<Marker> &markers, const QVector<uint32_t> &draws,
-                    QRectF markerRect);
-  Marker *findMarker(QVector<Marker> &markers, QRectF markerRect, QPointF pos);
+                    const QVector<uint32_t> &spans, QRectF markerRect);
+  Marker *findMarker(QVector<Marker> &markers, const QVector<uint32_t> &spans, QRectF markerRect,
+                     QPointF pos);
 };
@@ -199,6 +199,20 @@ Default - enabled
 ``False`` - API debugging is displayed as normal.
 )");
   bool debugOutputMute;
+
+  DOCUMENT(R"(Write capture files on a background thread, so the application can continue rendering
+while the capture is compressed and written to disk. The frame is serialised into memory first, and
+this is the number of megabytes of capture data that can be waiting to be written before the
+application is made to wait.
+
+Captures are only listed, and sent to any target control connection, once they have been completely
+written.
+
+Default - 0
+
+``0`` - Captures are written to disk before the application continues.
+)");
+  uint32_t backgroundWriteMemoryMB;
 };
 
 DECLARE_REFLECTION_STRUCT(CaptureOptions);
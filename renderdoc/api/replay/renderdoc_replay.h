@@ -891,6 +891,42 @@ capture's API.
 )");
   virtual const PipeState &GetPipelineState() = 0;
 
+  DOCUMENT(R"(Enable or disable lazy fetching of large Vulkan descriptor arrays.
+
+When enabled, any descriptor binding with more array elements than the threshold will have its
+:data:`VKDescriptorBinding.binds` list left empty in the pipeline state returned by
+:meth:`GetVulkanPipelineState`, while :data:`VKDescriptorBinding.descriptorCount` is still set. The
+elements can then be fetched a page at a time with :meth:`GetVulkanDescriptorBindings`.
+
+This avoids the cost of filling out very large descriptor arrays on every event change when they
+aren't needed. The pipeline state is refreshed for the current event.
+
+:param int maxElements: The maximum number of array elements a binding can have and still be filled
+  out in the pipeline state. ``0`` disables lazy fetching, which is the default.
+)");
+  virtual void SetLazyDescriptorThreshold(uint32_t maxElements) = 0;
+
+  DOCUMENT(R"(Retrieve a range of array elements from a Vulkan descriptor binding at the current
+event.
+
+This is primarily useful with :meth:`SetLazyDescriptorThreshold` to fetch the contents of large
+descriptor arrays on demand, but works for any binding.
+
+:param bool compute: ``True`` to look up the descriptor sets bound to the compute pipeline,
+  ``False`` for the graphics pipeline.
+:param int set: The index of the descriptor set.
+:param int binding: The binding within the descriptor set.
+:param int firstElement: The first array element to return.
+:param int count: The maximum number of array elements to return. Fewer will be returned if the
+  binding doesn't have that many elements after ``firstElement``.
+:return: The binding elements in the requested range.
+:rtype: ``list`` of :class:`VKBindingElement`
+)");
+  virtual rdcarray<VKPipe::BindingElement> GetVulkanDescriptorBindings(bool compute, uint32_t set,
+                                                                       uint32_t binding,
+                                                                       uint32_t firstElement,
+                                                                       uint32_t count) = 0;
+
   DOCUMENT(R"(Retrieve the list of possible disassembly targets for :meth:`DisassembleShader`. The
 values are implementation dependent but will always include a default target first which is the
 native disassembly of the shader. Further options may be available for additional diassembly views
@@ -1323,6 +1359,20 @@ target control connection.
 )");
   virtual void DeleteCapture(uint32_t captureId) = 0;
 
+  DOCUMENT(R"(Ask the target to stream captures to the local machine while they are being written,
+instead of them being copied with :meth:`CopyCapture` once they're complete.
+
+A streamed capture is saved into the given folder, and by the time the
+:attr:`TargetControlMessageType.NewCapture` message arrives it refers to the local copy. The copy on
+the remote machine will be deleted when the target closes.
+
+This has no effect on targets running on the local machine, or on targets too old to support it.
+
+:param str localFolder: The absolute path of a folder on the local system to save streamed captures
+  into, or an empty string to stop streaming.
+)");
+  virtual void SetCaptureStreaming(const char *localFolder) = 0;
+
   DOCUMENT(R"(Query to see if a message has been received from the remote system.
 
 The details of the types of messages that can be received are listed under
@@ -1545,10 +1595,15 @@ This function will block until the copy is fully complete, or an error has occur
 This is primarily useful for when a capture is only stored locally and must be replayed remotely, as
 the capture must be available on the machine where the replay happens.
 
+The remote system keeps uploaded captures in a cache identified by their contents. If an identical
+capture is already cached nothing is transferred, and an upload that was interrupted resumes from
+where it stopped.
+
 :param str filename: The path to the file on the local system.
 :param ProgressCallback progress: A callback that will be repeatedly called with an updated progress
   value for the copy. Can be ``None`` if no progress is desired.
-:return: The path on the remote system where the capture was saved temporarily.
+:return: The path on the remote system where the capture was saved, or an empty string if the copy
+  failed.
 :rtype: ``str``
 )");
   virtual rdcstr CopyCaptureToRemote(const char *filename, RENDERDOC_ProgressCallback progress) = 0;
@@ -1557,6 +1612,9 @@ the capture must be available on the machine where the replay happens.
 
 This function will block until the copy is fully complete, or an error has occurred.
 
+If the local path already contains the start of the same file, for example from an earlier copy that
+was interrupted, only the remainder is transferred.
+
 :param str remotepath: The remote path where the file should be copied from.
 :param str localpath: The local path where the file should be saved.
 :param ProgressCallback progress: A callback that will be repeatedly called with an updated progress
@@ -1659,6 +1717,27 @@ file.
 )");
   virtual bool CopyFileTo(const char *filename) = 0;
 
+  DOCUMENT(R"(Sets how the frame capture data is compressed when this file is next converted to
+the native ``rdc`` format with :meth:`Convert`.
+
+By default it is compressed with :data:`SectionFlags.ZstdCompressed` at the default level, which is
+a good trade-off while capturing. For archiving, a higher compression level with
+:data:`SectionFlags.ZstdLongWindow` gives a better ratio, and a dictionary helps with many small
+repetitive chunks.
+
+Other sections keep their existing compression.
+
+:param SectionFlags flags: The compression flags for the frame capture section.
+:param int compressionLevel: The zstd level to compress at, only used with
+  :data:`SectionFlags.ZstdCompressed`. ``0`` selects the default level, negative levels are faster
+  with a lower ratio and higher levels up to ``22`` are slower with a higher ratio.
+:param bytes compressionDictionary: An optional dictionary to compress against with
+  :data:`SectionFlags.ZstdCompressed`, such as one trained with ``zstd --train`` on typical chunk
+  data. The dictionary is stored in the section and :data:`SectionFlags.ZstdDictionary` is set.
+)");
+  virtual void SetConvertCompression(SectionFlags flags, int32_t compressionLevel,
+                                     const bytebuf &compressionDictionary) = 0;
+
   DOCUMENT(R"(Converts the currently loaded file to a given format and saves it to disk.
 
 This allows converting a native RDC to another representation, or vice-versa converting another
@@ -2247,6 +2326,11 @@ extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_SetColors(FloatVector darkC
                                                                FloatVector lightChecker,
                                                                bool darkTheme);
 
+DOCUMENT("Internal function for extracting thumbnails from many captures in parallel.");
+extern "C" RENDERDOC_API void RENDERDOC_CC
+RENDERDOC_GetCaptureThumbnails(const rdcarray<rdcstr> &filenames, FileType type, uint32_t maxsize,
+                               rdcarray<Thumbnail> &thumbnails);
+
 DOCUMENT("Internal function for fetching friendly android names.");
 extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_GetAndroidFriendlyName(const rdcstr &device,
                                                                             rdcstr &friendly);
@@ -2279,3 +2363,6 @@ extern "C" RENDERDOC_API AndroidFlags RENDERDOC_CC RENDERDOC_MakeDebuggablePacka
 DOCUMENT("Internal function that runs unit tests.");
 extern "C" RENDERDOC_API int RENDERDOC_CC RENDERDOC_RunUnitTests(const rdcstr &command,
                                                                  const rdcarray<rdcstr> &args);
+
+DOCUMENT("Internal function that runs serialisation benchmarks and outputs the results as JSON.");
+extern "C" RENDERDOC_API int RENDERDOC_CC RENDERDOC_RunBenchmarks(const rdcarray<rdcstr> &args);
@@ -900,6 +900,7 @@ std::string DoStringise(const SectionType &el)
     STRINGISE_ENUM_CLASS_NAMED(ResourceRenames, "renderdoc/ui/resrenames");
     STRINGISE_ENUM_CLASS_NAMED(AMDRGPProfile, "amd/rgp/profile");
     STRINGISE_ENUM_CLASS_NAMED(ExtendedThumbnail, "renderdoc/internal/exthumb");
+    STRINGISE_ENUM_CLASS_NAMED(BlobStore, "renderdoc/internal/blobs");
   }
   END_ENUM_STRINGISE();
 }
@@ -945,6 +946,8 @@ std::string DoStringise(const SectionFlags &el)
     STRINGISE_BITFIELD_CLASS_BIT_NAMED(ASCIIStored, "Stored as ASCII");
     STRINGISE_BITFIELD_CLASS_BIT_NAMED(LZ4Compressed, "Compressed with LZ4");
     STRINGISE_BITFIELD_CLASS_BIT_NAMED(ZstdCompressed, "Compressed with Zstd");
+    STRINGISE_BITFIELD_CLASS_BIT_NAMED(ZstdLongWindow, "Zstd long window");
+    STRINGISE_BITFIELD_CLASS_BIT_NAMED(ZstdDictionary, "Zstd dictionary");
   }
   END_BITFIELD_STRINGISE();
 }
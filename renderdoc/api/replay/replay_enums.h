@@ -83,6 +83,14 @@ version of RenderDoc that addes a new section type. They should be considered eq
   lossless.
 
   The name for this section will be "renderdoc/internal/exthumb".
+
+.. data:: BlobStore
+
+  This section contains large byte buffers from the frame capture, stored once by content. The frame
+  capture refers to these instead of containing duplicate copies of the same data, and they are
+  expanded transparently when it is read.
+
+  The name for this section will be "renderdoc/internal/blobs".
 )");
 enum class SectionType : uint32_t
 {
@@ -95,6 +103,7 @@ enum class SectionType : uint32_t
   ResourceRenames,
   AMDRGPProfile,
   ExtendedThumbnail,
+  BlobStore,
   Count,
 };
 
@@ -3433,6 +3442,17 @@ DOCUMENT(R"(A set of flags describing the properties of a section in a renderdoc
 .. data:: ZstdCompressed
 
   This section is compressed with Zstd on disk.
+
+.. data:: ZstdLongWindow
+
+  This section is compressed with Zstd on disk in large blocks with long distance matching. This
+  gives a better compression ratio for large sections at the cost of compression speed, and is
+  intended for archiving captures. Only valid with :data:`ZstdCompressed`.
+
+.. data:: ZstdDictionary
+
+  This section is compressed with Zstd on disk against a dictionary, which is stored at the start of
+  the section. Only valid with :data:`ZstdCompressed`.
 )");
 enum class SectionFlags : uint32_t
 {
@@ -3440,6 +3460,8 @@ enum class SectionFlags : uint32_t
   ASCIIStored = 0x1,
   LZ4Compressed = 0x2,
   ZstdCompressed = 0x4,
+  ZstdLongWindow = 0x8,
+  ZstdDictionary = 0x10,
 };
 
 BITMASK_OPERATORS(SectionFlags);
@@ -25,6 +25,8 @@
 #pragma once
 
 #include <stdint.h>
+#include <algorithm>
+#include <functional>
 #include "stringise.h"
 
 DOCUMENT(R"(The basic irreducible type of an object. Every other more complex type is built on these.
@@ -859,7 +861,25 @@ struct StructuredBufferList : public rdcarray<bytebuf *>
 
 DECLARE_REFLECTION_STRUCT(StructuredBufferList);
 
-DOCUMENT("Contains the structured information in a file. Owns the buffers and chunks.");
+// documented below in SDFile, as there's no good way to document a callback on its own.
+typedef std::function<bool(const SDChunk *)> SDChunkPredicate;
+
+DOCUMENT(R"(Contains the structured information in a file. Owns the buffers and chunks.
+
+The ``Find`` functions use an index that is built the first time one of them is called. If the
+chunks are modified after that, :meth:`InvalidateIndex` must be called. The index is not
+thread-safe to build, so the first query should not be made from several threads at once.
+
+.. function:: SDChunkPredicate()
+
+  Not an actual member function - the signature for any ``SDChunkPredicate`` callbacks.
+
+  Called by :meth:`FilterChunks` to decide which chunks to return.
+
+  :param SDChunk chunk: The chunk to test.
+  :return: Whether or not the chunk should be included in the results.
+  :rtype: ``bool``
+)");
 struct SDFile
 {
   SDFile() {}
@@ -886,9 +906,250 @@ struct SDFile
     chunks.swap(other.chunks);
     buffers.swap(other.buffers);
     std::swap(version, other.version);
+
+    InvalidateIndex();
+    other.InvalidateIndex();
+  }
+
+  DOCUMENT(R"(Find all chunks with a given name.
+
+:param str name: The name of the chunks to find.
+:return: The indices in :data:`chunks` of the matching chunks, in order.
+:rtype: ``list`` of ``int``
+)");
+  inline rdcarray<uint32_t> FindChunks(const rdcstr &name) const
+  {
+    BuildIndex();
+
+    auto it = std::lower_bound(m_NameIndex.begin(), m_NameIndex.end(), name,
+                               [](const rdcpair<rdcstr, rdcarray<uint32_t>> &a, const rdcstr &b) {
+                                 return strcmp(a.first.c_str(), b.c_str()) < 0;
+                               });
+
+    if(it != m_NameIndex.end() && !strcmp(it->first.c_str(), name.c_str()))
+      return it->second;
+
+    return rdcarray<uint32_t>();
+  }
+
+  DOCUMENT(R"(Find all chunks that reference a given resource anywhere in their parameters.
+
+:param ResourceId id: The resource to look for.
+:return: The indices in :data:`chunks` of the matching chunks, in order.
+:rtype: ``list`` of ``int``
+)");
+  inline rdcarray<uint32_t> FindChunksReferencing(ResourceId id) const
+  {
+    BuildIndex();
+
+    auto it = std::lower_bound(
+        m_ResourceIndex.begin(), m_ResourceIndex.end(), id,
+        [](const rdcpair<ResourceId, rdcarray<uint32_t>> &a, ResourceId b) { return a.first < b; });
+
+    if(it != m_ResourceIndex.end() && it->first == id)
+      return it->second;
+
+    return rdcarray<uint32_t>();
+  }
+
+  DOCUMENT(R"(Find all chunks with a given name where a parameter has a given value.
+
+Integer, enum and boolean values compare equal if their numeric values match regardless of the
+exact type, so a value created in python with :func:`makeSDObject` can be used.
+
+:param str name: The name of the chunks to search.
+:param str path: The parameter to compare, with ``.`` separating the names of nested members. An
+  array element can be selected by its index, e.g. ``pViewports.0.width``.
+:param SDObject value: The value to compare against.
+:return: The indices in :data:`chunks` of the matching chunks, in order.
+:rtype: ``list`` of ``int``
+)");
+  inline rdcarray<uint32_t> FindChunksWithValue(const rdcstr &name, const rdcstr &path,
+                                                const SDObject *value) const
+  {
+    rdcarray<uint32_t> ret;
+
+    if(!value)
+      return ret;
+
+    for(uint32_t idx : FindChunks(name))
+    {
+      const SDObject *member = FindMember(chunks[idx], path);
+
+      if(member && ValueMatches(*member, *value))
+        ret.push_back(idx);
+    }
+
+    return ret;
+  }
+
+  DOCUMENT(R"(Find all chunks that pass a predicate.
+
+:param SDChunkPredicate predicate: The predicate to test each chunk with.
+:param str name: If not empty, only chunks with this name are tested.
+:return: The indices in :data:`chunks` of the matching chunks, in order.
+:rtype: ``list`` of ``int``
+)");
+  inline rdcarray<uint32_t> FilterChunks(SDChunkPredicate predicate, const rdcstr &name = "") const
+  {
+    rdcarray<uint32_t> ret;
+
+    if(!predicate)
+      return ret;
+
+    if(name.empty())
+    {
+      for(size_t i = 0; i < chunks.size(); i++)
+        if(predicate(chunks[i]))
+          ret.push_back((uint32_t)i);
+    }
+    else
+    {
+      for(uint32_t idx : FindChunks(name))
+        if(predicate(chunks[idx]))
+          ret.push_back(idx);
+    }
+
+    return ret;
+  }
+
+  DOCUMENT(R"(Discard the index used by the ``Find`` functions. It will be rebuilt on the next query.
+
+This must be called after modifying :data:`chunks`.
+)");
+  inline void InvalidateIndex()
+  {
+    m_Indexed = false;
+    m_NameIndex.clear();
+    m_ResourceIndex.clear();
   }
 
 protected:
   SDFile(const SDFile &) = delete;
   SDFile &operator=(const SDFile &) = delete;
+
+private:
+  inline void BuildIndex() const
+  {
+    if(m_Indexed)
+      return;
+
+    m_Indexed = true;
+
+    rdcarray<rdcpair<rdcstr, uint32_t>> names;
+    rdcarray<rdcpair<ResourceId, uint32_t>> resources;
+
+    names.reserve(chunks.size());
+
+    for(size_t i = 0; i < chunks.size(); i++)
+    {
+      names.push_back(make_rdcpair(chunks[i]->name, (uint32_t)i));
+      AddResources(chunks[i], (uint32_t)i, resources);
+    }
+
+    // sorting the pairs keeps the chunk indices in order within each name or resource
+    // compare with c_str() since an empty rdcstr has no storage
+    std::sort(names.begin(), names.end(),
+              [](const rdcpair<rdcstr, uint32_t> &a, const rdcpair<rdcstr, uint32_t> &b) {
+                int cmp = strcmp(a.first.c_str(), b.first.c_str());
+                return cmp != 0 ? cmp < 0 : a.second < b.second;
+              });
+    std::sort(resources.begin(), resources.end());
+
+    for(const rdcpair<rdcstr, uint32_t> &n : names)
+    {
+      if(m_NameIndex.empty() || strcmp(m_NameIndex.back().first.c_str(), n.first.c_str()))
+        m_NameIndex.push_back(make_rdcpair(n.first, rdcarray<uint32_t>()));
+      m_NameIndex.back().second.push_back(n.second);
+    }
+
+    for(const rdcpair<ResourceId, uint32_t> &r : resources)
+    {
+      if(m_ResourceIndex.empty() || m_ResourceIndex.back().first != r.first)
+        m_ResourceIndex.push_back(make_rdcpair(r.first, rdcarray<uint32_t>()));
+
+      // a chunk can reference the same resource more than once
+      rdcarray<uint32_t> &idxs = m_ResourceIndex.back().second;
+      if(idxs.empty() || idxs.back() != r.second)
+        idxs.push_back(r.second);
+    }
+  }
+
+  static void AddResources(const SDObject *obj, uint32_t chunkIdx,
+                           rdcarray<rdcpair<ResourceId, uint32_t>> &resources)
+  {
+    if(obj->type.basetype == SDBasic::Resource)
+    {
+      if(obj->data.basic.id != ResourceId())
+        resources.push_back(make_rdcpair(obj->data.basic.id, chunkIdx));
+      return;
+    }
+
+    for(const SDObject *child : obj->data.children)
+      AddResources(child, chunkIdx, resources);
+  }
+
+  static const SDObject *FindMember(const SDObject *obj, const rdcstr &path)
+  {
+    const char *c = path.c_str();
+
+    while(obj && *c)
+    {
+      const char *end = strchr(c, '.');
+      rdcstr childName = std::string(c, end ? end : c + strlen(c));
+
+      const SDObject *child = obj->FindChild(childName.c_str());
+
+      // allow array elements to be selected by index
+      if(!child && obj->type.basetype == SDBasic::Array && !childName.empty() &&
+         childName[0] >= '0' && childName[0] <= '9')
+        child = obj->GetChild((size_t)atoi(childName.c_str()));
+
+      obj = child;
+      c = end ? end + 1 : c + strlen(c);
+    }
+
+    return obj;
+  }
+
+  static bool ValueMatches(const SDObject &a, const SDObject &b)
+  {
+    auto isInteger = [](SDBasic t) {
+      return t == SDBasic::UnsignedInteger || t == SDBasic::SignedInteger || t == SDBasic::Enum ||
+             t == SDBasic::Boolean || t == SDBasic::Character;
+    };
+
+    SDBasic at = a.type.basetype, bt = b.type.basetype;
+
+    if(isInteger(at) && isInteger(bt))
+    {
+      // booleans and characters only store their low bytes
+      uint64_t av = at == SDBasic::Boolean ? (uint64_t)a.data.basic.b
+                                           : at == SDBasic::Character ? (uint64_t)a.data.basic.c
+                                                                      : a.data.basic.u;
+      uint64_t bv = bt == SDBasic::Boolean ? (uint64_t)b.data.basic.b
+                                           : bt == SDBasic::Character ? (uint64_t)b.data.basic.c
+                                                                      : b.data.basic.u;
+      return av == bv;
+    }
+
+    if(at == SDBasic::Float && (bt == SDBasic::Float || isInteger(bt)))
+      return a.data.basic.d == (bt == SDBasic::Float ? b.data.basic.d : (double)b.data.basic.i);
+
+    if(at != bt)
+      return false;
+
+    if(at == SDBasic::String)
+      return !strcmp(a.data.str.c_str(), b.data.str.c_str());
+    if(at == SDBasic::Resource)
+      return a.data.basic.id == b.data.basic.id;
+    if(at == SDBasic::Null)
+      return true;
+
+    return false;
+  }
+
+  mutable bool m_Indexed = false;
+  mutable rdcarray<rdcpair<rdcstr, rdcarray<uint32_t>>> m_NameIndex;
+  mutable rdcarray<rdcpair<ResourceId, rdcarray<uint32_t>>> m_ResourceIndex;
 };
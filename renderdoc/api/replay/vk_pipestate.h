@@ -235,6 +235,10 @@ If this binding is empty/non-existant this value will be ``0``.
 
   DOCUMENT(R"(A list of :class:`VKBindingElement` with the binding elements.
 If :data:`descriptorCount` is 1 then this isn't an array, and this list has only one element.
+
+If lazy descriptor fetching is enabled with :meth:`ReplayController.SetLazyDescriptorThreshold` and
+this binding is larger than the threshold, this list is empty and the elements can be fetched with
+:meth:`ReplayController.GetVulkanDescriptorBindings`.
 )");
   rdcarray<BindingElement> binds;
 };
@@ -239,10 +239,19 @@ uint32_t CalcNumMips(int w, int h, int d)
   return mipLevels;
 }
 
+static volatile int64_t alignedAllocCount = 0;
+
+uint64_t GetAlignedBufferAllocCount()
+{
+  return (uint64_t)alignedAllocCount;
+}
+
 byte *AllocAlignedBuffer(uint64_t size, uint64_t alignment)
 {
   byte *rawAlloc = NULL;
 
+  Atomic::Inc64(&alignedAllocCount);
+
 #if defined(__EXCEPTIONS) || defined(_CPPUNWIND)
   try
 #endif
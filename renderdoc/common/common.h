@@ -160,6 +160,8 @@ uint32_t CalcNumMips(int Width, int Height, int Depth);
 
 byte *AllocAlignedBuffer(uint64_t size, uint64_t alignment = 64);
 void FreeAlignedBuffer(byte *buf);
+// total number of AllocAlignedBuffer calls made so far, used to measure allocation churn
+uint64_t GetAlignedBufferAllocCount();
 
 uint32_t Log2Floor(uint32_t value);
 #if ENABLED(RDOC_X64)
@@ -0,0 +1,222 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "sha256.h"
+#include <string.h>
+#include "common/common.h"
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t rotr(uint32_t x, uint32_t n)
+{
+  return (x >> n) | (x << (32 - n));
+}
+
+SHA256::SHA256()
+{
+  Reset();
+}
+
+void SHA256::Reset()
+{
+  m_State[0] = 0x6a09e667;
+  m_State[1] = 0xbb67ae85;
+  m_State[2] = 0x3c6ef372;
+  m_State[3] = 0xa54ff53a;
+  m_State[4] = 0x510e527f;
+  m_State[5] = 0x9b05688c;
+  m_State[6] = 0x1f83d9ab;
+  m_State[7] = 0x5be0cd19;
+  m_Length = 0;
+  m_BlockUsed = 0;
+}
+
+void SHA256::Transform(const uint8_t *block)
+{
+  uint32_t w[64];
+
+  for(int i = 0; i < 16; i++)
+    w[i] = (uint32_t(block[i * 4 + 0]) << 24) | (uint32_t(block[i * 4 + 1]) << 16) |
+           (uint32_t(block[i * 4 + 2]) << 8) | uint32_t(block[i * 4 + 3]);
+
+  for(int i = 16; i < 64; i++)
+  {
+    uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  uint32_t a = m_State[0], b = m_State[1], c = m_State[2], d = m_State[3];
+  uint32_t e = m_State[4], f = m_State[5], g = m_State[6], h = m_State[7];
+
+  for(int i = 0; i < 64; i++)
+  {
+    uint32_t S1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+    uint32_t ch = (e & f) ^ (~e & g);
+    uint32_t t1 = h + S1 + ch + K[i] + w[i];
+    uint32_t S0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+    uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+    uint32_t t2 = S0 + maj;
+
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+
+  m_State[0] += a;
+  m_State[1] += b;
+  m_State[2] += c;
+  m_State[3] += d;
+  m_State[4] += e;
+  m_State[5] += f;
+  m_State[6] += g;
+  m_State[7] += h;
+}
+
+void SHA256::Update(const void *data, size_t length)
+{
+  const uint8_t *bytes = (const uint8_t *)data;
+
+  m_Length += length;
+
+  // top up a partially filled block first
+  if(m_BlockUsed > 0)
+  {
+    size_t len = RDCMIN(length, sizeof(m_Block) - m_BlockUsed);
+    memcpy(m_Block + m_BlockUsed, bytes, len);
+    m_BlockUsed += len;
+    bytes += len;
+    length -= len;
+
+    if(m_BlockUsed < sizeof(m_Block))
+      return;
+
+    Transform(m_Block);
+    m_BlockUsed = 0;
+  }
+
+  // whole blocks can be hashed straight from the source
+  for(; length >= sizeof(m_Block); bytes += sizeof(m_Block), length -= sizeof(m_Block))
+    Transform(bytes);
+
+  memcpy(m_Block, bytes, length);
+  m_BlockUsed = length;
+}
+
+std::string SHA256::Finish()
+{
+  uint64_t bits = m_Length * 8;
+
+  // pad with a 1 bit then zeroes, leaving 8 bytes at the end of the last block for the length
+  uint8_t pad[64 + 8] = {0x80};
+  size_t padLength = (m_BlockUsed < 56 ? 56 : 120) - m_BlockUsed;
+
+  uint8_t lengthBytes[8];
+  for(int i = 0; i < 8; i++)
+    lengthBytes[i] = uint8_t(bits >> (56 - i * 8));
+
+  Update(pad, padLength);
+  Update(lengthBytes, sizeof(lengthBytes));
+
+  RDCASSERT(m_BlockUsed == 0);
+
+  static const char hex[] = "0123456789abcdef";
+
+  std::string ret;
+  ret.reserve(64);
+
+  for(int i = 0; i < 8; i++)
+  {
+    for(int b = 28; b >= 0; b -= 4)
+      ret.push_back(hex[(m_State[i] >> b) & 0xf]);
+  }
+
+  return ret;
+}
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+static std::string sha256(const std::string &str)
+{
+  SHA256 hash;
+  hash.Update(str.data(), str.size());
+  return hash.Finish();
+}
+
+TEST_CASE("Test SHA-256", "[sha256]")
+{
+  SECTION("Known vectors")
+  {
+    CHECK(sha256("") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    CHECK(sha256("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    CHECK(sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    CHECK(sha256(std::string(1000000, 'a')) ==
+          "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+  };
+
+  SECTION("Split updates give the same hash")
+  {
+    std::string data;
+    for(int i = 0; i < 1000; i++)
+      data.push_back(char(i * 7));
+
+    std::string expected = sha256(data);
+
+    for(size_t split : {1, 55, 56, 63, 64, 65, 128, 999})
+    {
+      SHA256 hash;
+      hash.Update(data.data(), split);
+      hash.Update(data.data() + split, data.size() - split);
+      CHECK(hash.Finish() == expected);
+    }
+
+    SHA256 hash;
+    for(char c : data)
+      hash.Update(&c, 1);
+    CHECK(hash.Finish() == expected);
+
+    hash.Reset();
+    hash.Update(data.data(), data.size());
+    CHECK(hash.Finish() == expected);
+  };
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
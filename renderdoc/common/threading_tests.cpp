@@ -23,6 +23,7 @@
  ******************************************************************************/
 
 #include "common/threading.h"
+#include "common/wrapped_pool.h"
 #include "os/os_specific.h"
 
 #if ENABLED(ENABLE_UNIT_TESTS)
@@ -71,4 +72,166 @@ TEST_CASE("Test spin lock", "[threading]")
   CHECK(finalValue == value);
 }
 
+struct PooledTestObject
+{
+  uint32_t thread;
+  uint32_t index;
+
+  ALLOCATE_WITH_WRAPPED_POOL(PooledTestObject, 1024);
+};
+
+struct SmallPooledTestObject
+{
+  uint32_t thread;
+  uint32_t index;
+
+  ALLOCATE_WITH_WRAPPED_POOL(SmallPooledTestObject, 16);
+};
+
+struct ChurnPooledTestObject
+{
+  uint32_t thread;
+  uint32_t index;
+
+  static int32_t NumAdditionalPools() { return m_Pool.m_AdditionalPoolCount; }
+  ALLOCATE_WITH_WRAPPED_POOL(ChurnPooledTestObject, 1024);
+};
+
+WRAPPED_POOL_INST(PooledTestObject);
+WRAPPED_POOL_INST(SmallPooledTestObject);
+WRAPPED_POOL_INST(ChurnPooledTestObject);
+
+template <typename T>
+static void TestWrappedPool(int numThreads, uint32_t perThread)
+{
+  std::vector<Threading::ThreadHandle> threads;
+  std::vector<std::vector<T *>> objects;
+  volatile int32_t errors = 0;
+
+  threads.resize(numThreads);
+  objects.resize(numThreads);
+
+  for(int i = 0; i < numThreads; i++)
+  {
+    threads[i] = Threading::CreateThread([&objects, &errors, perThread, i]() {
+      std::vector<T *> &objs = objects[i];
+
+      // churn through allocations to exercise the caches, then keep a set alive
+      for(int pass = 0; pass < 4; pass++)
+      {
+        for(uint32_t c = 0; c < perThread; c++)
+        {
+          T *obj = new T;
+          obj->thread = i;
+          obj->index = c;
+          objs.push_back(obj);
+        }
+
+        for(uint32_t c = 0; c < perThread; c++)
+        {
+          if(objs[c]->thread != (uint32_t)i || objs[c]->index != c || !T::IsAlloc(objs[c]))
+            Atomic::Inc32(&errors);
+        }
+
+        if(pass < 3)
+        {
+          for(T *obj : objs)
+            delete obj;
+          objs.clear();
+        }
+      }
+    });
+  }
+
+  for(Threading::ThreadHandle t : threads)
+  {
+    Threading::JoinThread(t);
+    Threading::CloseThread(t);
+  }
+
+  CHECK(errors == 0);
+
+  // no object should have been handed out twice
+  std::vector<T *> all;
+  for(std::vector<T *> &objs : objects)
+    all.insert(all.end(), objs.begin(), objs.end());
+
+  std::sort(all.begin(), all.end());
+
+  CHECK(all.size() == size_t(numThreads) * perThread);
+  CHECK((std::unique(all.begin(), all.end()) == all.end()));
+
+  T local;
+  CHECK_FALSE(T::IsAlloc(&local));
+
+  for(std::vector<T *> &objs : objects)
+    for(T *obj : objs)
+      delete obj;
+}
+
+TEST_CASE("Test wrapped pool", "[threading]")
+{
+  SECTION("Multi-threaded allocations with per-thread caches")
+  {
+    // enough that we need several additional pools
+    TestWrappedPool<PooledTestObject>(8, 1000);
+  };
+
+  SECTION("Multi-threaded allocations without caches")
+  {
+    TestWrappedPool<SmallPooledTestObject>(8, 20);
+  };
+
+  SECTION("Slots cached by exited threads are reclaimed")
+  {
+    // each thread exits with some slots still in its cache. Between them they cache more slots than
+    // the pool holds, which must be taken back rather than creating additional pools.
+    for(uint32_t t = 0; t < 100; t++)
+    {
+      Threading::ThreadHandle thread = Threading::CreateThread([]() {
+        std::vector<ChurnPooledTestObject *> objs;
+        for(uint32_t c = 0; c < 64; c++)
+          objs.push_back(new ChurnPooledTestObject);
+        for(ChurnPooledTestObject *obj : objs)
+          delete obj;
+      });
+      Threading::JoinThread(thread);
+      Threading::CloseThread(thread);
+    }
+
+    std::vector<ChurnPooledTestObject *> objs;
+    for(size_t c = 0; c < ChurnPooledTestObject::PoolType::AllocCount; c++)
+      objs.push_back(new ChurnPooledTestObject);
+
+    CHECK(ChurnPooledTestObject::NumAdditionalPools() == 0);
+
+    for(ChurnPooledTestObject *obj : objs)
+      delete obj;
+  };
+
+  SECTION("Additional pools keep growing")
+  {
+    // far more additional pools than fit in the first lookup table
+    std::vector<SmallPooledTestObject *> objs;
+    for(uint32_t c = 0; c < 16 * 300; c++)
+    {
+      SmallPooledTestObject *obj = new SmallPooledTestObject;
+      obj->index = c;
+      objs.push_back(obj);
+    }
+
+    bool valid = true;
+    for(uint32_t c = 0; c < objs.size(); c++)
+      valid &= SmallPooledTestObject::IsAlloc(objs[c]) && objs[c]->index == c;
+    CHECK(valid);
+
+    std::vector<SmallPooledTestObject *> sorted = objs;
+    std::sort(sorted.begin(), sorted.end());
+    CHECK((std::unique(sorted.begin(), sorted.end()) == sorted.end()));
+
+    for(SmallPooledTestObject *obj : objs)
+      delete obj;
+  };
+}
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
\ No newline at end of file
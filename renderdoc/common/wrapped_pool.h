@@ -49,100 +49,104 @@ public:
 };
 
 // allocate each class in its own pool so we can identify the type by the pointer
+//
+// Each pool keeps its free slots in a lock-free stack, and each thread keeps a small cache of free
+// slots that it allocates from and frees into, only going to the shared stacks in batches. The lock
+// is only taken when every pool is exhausted, to reclaim slots sitting in other threads' caches or
+// failing that to create a new additional pool. Additional pools are found from a pointer with a
+// hash of its address, so IsAlloc/Deallocate don't need to scan them.
 template <typename WrapType, int PoolCount = 8192, int MaxPoolByteSize = 1024 * 1024, bool DebugClear = true>
 class WrappingPool
 {
 public:
   void *Allocate()
   {
-    SCOPED_LOCK(m_Lock);
-
-    // try and allocate from immediate pool
-    void *ret = m_ImmediatePool.Allocate();
-    if(ret != NULL)
-      return ret;
+    void *ret = NULL;
 
-    // fall back to additional pools, if there are any
-    for(size_t i = 0; i < m_AdditionalPools.size(); i++)
+    if(CacheBatch == 0)
     {
-      ret = m_AdditionalPools[i]->Allocate();
-      if(ret != NULL)
-        return ret;
-    }
-
-// warn when we need to allocate an additional pool
-#if ENABLED(INCLUDE_TYPE_NAMES)
-    RDCWARN("Ran out of free slots in %s pool!", GetTypeName<WrapType>::Name());
-#else
-    RDCWARN("Ran out of free slots in pool 0x%p!", &m_ImmediatePool.items[0]);
-#endif
+      // small pools don't use per-thread caches, since a few slots cached on one thread would leave
+      // other threads creating additional pools.
+      while(ret == NULL)
+      {
+        ret = m_ImmediatePool.Pop();
 
-    // allocate a new additional pool and use that to allocate from
-    m_AdditionalPools.push_back(new ItemPool());
+        int32_t numPools = GetAdditionalPoolCount();
+        PoolTable *table = numPools > 0 ? GetPoolTable() : NULL;
+        for(int32_t i = numPools - 1; ret == NULL && i >= 0; i--)
+          ret = table->pools[i]->Pop();
 
-#if ENABLED(INCLUDE_TYPE_NAMES)
-    RDCDEBUG("WrappingPool[%d]<%s>: %p -> %p", (uint32_t)m_AdditionalPools.size() - 1,
-             GetTypeName<WrapType>::Name(), &m_AdditionalPools.back()->items[0],
-             &m_AdditionalPools.back()->items[AllocCount - 1]);
-#endif
+        if(ret == NULL)
+          AddPool(numPools);
+      }
+    }
+    else
+    {
+      ThreadCache *cache = GetThreadCache();
 
-    return m_AdditionalPools.back()->Allocate();
-  }
+      Threading::ScopedSpinLock lock(cache->lock);
 
-  bool IsAlloc(const void *p)
-  {
-    // we can check the immediate pool without locking
-    if(m_ImmediatePool.IsAlloc(p))
-      return true;
+      if(cache->count == 0)
+        Refill(cache);
 
-    // if we have additional pools, lock and check them.
-    // TODO: Check for additional pools in a lock-free manner,
-    // to prevent the cost of locking if there are no more pools.
-    {
-      SCOPED_LOCK(m_Lock);
-
-      for(size_t i = 0; i < m_AdditionalPools.size(); i++)
-        if(m_AdditionalPools[i]->IsAlloc(p))
-          return true;
+      ret = cache->items[--cache->count];
     }
 
-    return false;
+#if ENABLED(RDOC_DEVEL)
+    memset(ret, 0xb0, AllocByteSize);
+#endif
+
+    return ret;
   }
 
+  bool IsAlloc(const void *p) { return FindPool(p) != NULL; }
+
   void Deallocate(void *p)
   {
     if(p == NULL)
       return;
 
-    SCOPED_LOCK(m_Lock);
+    ItemPool *pool = FindPool(p);
 
-    // try immediate pool
-    if(m_ImmediatePool.IsAlloc(p))
+    if(pool == NULL)
+    {
+// this is an error - deleting an object that we don't recognise
+#if ENABLED(INCLUDE_TYPE_NAMES)
+      RDCERR("Resource being deleted through wrong pool - 0x%p not a member of %s", p,
+             GetTypeName<WrapType>::Name());
+#else
+      RDCERR("Resource being deleted through wrong pool - 0x%p not a member of 0x%p", p,
+             &m_ImmediatePool.items[0]);
+#endif
+      return;
+    }
+
+#if ENABLED(RDOC_DEVEL)
+    if(DebugClear)
+      memset(p, 0xfe, AllocByteSize);
+#endif
+
+    if(CacheBatch == 0)
     {
-      m_ImmediatePool.Deallocate(p);
+      pool->Push(p);
       return;
     }
-    else if(!m_AdditionalPools.empty())
+
+    ThreadCache *cache = GetThreadCache();
+
+    Threading::ScopedSpinLock lock(cache->lock);
+
+    // if the cache is full, give a batch back to be used by other threads
+    if(cache->count == CacheSize)
     {
-      // fall back and try additional pools
-      for(size_t i = 0; i < m_AdditionalPools.size(); i++)
+      for(int i = 0; i < CacheBatch; i++)
       {
-        if(m_AdditionalPools[i]->IsAlloc(p))
-        {
-          m_AdditionalPools[i]->Deallocate(p);
-          return;
-        }
+        void *item = cache->items[--cache->count];
+        FindPool(item)->Push(item);
       }
     }
 
-// this is an error - deleting an object that we don't recognise
-#if ENABLED(INCLUDE_TYPE_NAMES)
-    RDCERR("Resource being deleted through wrong pool - 0x%p not a member of %s", p,
-           GetTypeName<WrapType>::Name());
-#else
-    RDCERR("Resource being deleted through wrong pool - 0x%p not a member of 0x%p", p,
-           &m_ImmediatePool.items[0]);
-#endif
+    cache->items[cache->count++] = p;
   }
 
   static const size_t AllocCount = PoolCount;
@@ -150,8 +154,21 @@ public:
   static const size_t AllocByteSize;
 
 private:
+  // how many slots a thread moves to or from the shared free lists at once, and the most it holds
+  static const int CacheBatch = PoolCount < 1024 ? 0 : 16;
+  static const int CacheSize = CacheBatch * 2;
+
+  // how many additional pools the first pool table holds. Each new table doubles the capacity.
+  static const int32_t InitialPoolTableSize = 64;
+  static const int32_t MaxPoolTables = 24;
+
   WrappingPool()
   {
+    m_CacheSlot = Threading::AllocateTLSSlot();
+
+    // each additional pool spans at most two 'chunks' of this size, which we use as hash keys.
+    m_ChunkShift = Log2Floor(uint32_t(AllocCount * AllocByteSize)) + 1;
+
 #if ENABLED(INCLUDE_TYPE_NAMES)
     // hack - print in kB because float printing relies on statics that might not be initialised
     // yet in loading order. Ugly :(
@@ -162,78 +179,313 @@ private:
   }
   ~WrappingPool()
   {
-    for(size_t i = 0; i < m_AdditionalPools.size(); i++)
-      delete m_AdditionalPools[i];
+    for(int32_t i = 0; i < m_AdditionalPoolCount; i++)
+      delete m_PoolTables[m_PoolTableIndex]->pools[i];
 
-    m_AdditionalPools.clear();
-  }
+    m_AdditionalPoolCount = 0;
 
-  Threading::CriticalSection m_Lock;
+    for(int32_t i = 0; i < MaxPoolTables; i++)
+      delete m_PoolTables[i];
+
+    for(size_t i = 0; i < m_Caches.size(); i++)
+      delete m_Caches[i];
+
+    m_Caches.clear();
+  }
 
   struct ItemPool
   {
     ItemPool()
     {
       items = (WrapType *)(new uint8_t[AllocCount * AllocByteSize]);
-      freeStack = new int[AllocCount];
-      for(int i = 0; i < (int)AllocCount; ++i)
+      next = new int32_t[AllocCount];
+      for(int32_t i = 0; i < (int32_t)AllocCount; ++i)
       {
-        freeStack[i] = i;
+        next[i] = i + 1 < (int32_t)AllocCount ? i + 1 : -1;
       }
-      freeStackHead = AllocCount;
+      head = Pack(0, 0);
     }
     ~ItemPool()
     {
       delete[](uint8_t *) items;
-      delete[] freeStack;
+      delete[] next;
+    }
+
+    // the head of the free list is packed with a counter that's incremented on every change, so a
+    // thread that read a stale head will always fail its compare-exchange.
+    static int64_t Pack(int32_t idx, uint32_t tag)
+    {
+      return int64_t((uint64_t(tag) << 32) | uint32_t(idx));
     }
-    void *Allocate()
+    static int32_t Index(int64_t h) { return int32_t(uint32_t(h & 0xffffffff)); }
+    static uint32_t Tag(int64_t h) { return uint32_t(uint64_t(h) >> 32); }
+    void *Pop()
     {
-      if(freeStackHead == 0)
+      int64_t oldHead = Atomic::CmpExch64(&head, 0, 0);
+
+      for(;;)
       {
-        return NULL;
-      }
-      --freeStackHead;
-      void *ret = items + freeStack[freeStackHead];
+        int32_t idx = Index(oldHead);
 
-#if ENABLED(RDOC_DEVEL)
-      memset(ret, 0xb0, AllocByteSize);
-#endif
+        if(idx < 0)
+          return NULL;
+
+        int64_t prev = Atomic::CmpExch64(&head, oldHead, Pack(next[idx], Tag(oldHead) + 1));
+
+        if(prev == oldHead)
+          return items + idx;
 
-      return ret;
+        oldHead = prev;
+      }
     }
 
-    void Deallocate(void *p)
+    void Push(void *p)
     {
       RDCASSERT(IsAlloc(p));
 
-#if ENABLED(RDOC_DEVEL)
-      if(!IsAlloc(p))
+      int32_t idx = (int32_t)((WrapType *)p - &items[0]);
+
+      int64_t oldHead = Atomic::CmpExch64(&head, 0, 0);
+
+      for(;;)
       {
-        RDCERR("Resource being deleted through wrong pool - 0x%p not a memory of 0x%p", p, &items[0]);
-        return;
-      }
-#endif
+        next[idx] = Index(oldHead);
 
-      int idx = (int)((WrapType *)p - &items[0]);
+        int64_t prev = Atomic::CmpExch64(&head, oldHead, Pack(idx, Tag(oldHead) + 1));
 
-      freeStack[freeStackHead] = idx;
-      ++freeStackHead;
+        if(prev == oldHead)
+          return;
 
-#if ENABLED(RDOC_DEVEL)
-      if(DebugClear)
-        memset(p, 0xfe, AllocByteSize);
-#endif
+        oldHead = prev;
+      }
     }
 
     bool IsAlloc(const void *p) const { return p >= &items[0] && p < &items[PoolCount]; }
     WrapType *items;
-    int *freeStack;
-    int freeStackHead;
+    int32_t *next;
+    volatile int64_t head;
+  };
+
+  struct ThreadCache
+  {
+    void *items[CacheSize > 0 ? CacheSize : 1];
+    int count = 0;
+    // held by the owning thread while it uses the cache, so that another thread can safely take the
+    // cached slots back. That only happens when the pools run dry so it's almost never contended.
+    Threading::SpinLock lock;
+  };
+
+  // the additional pools, and an open-addressed hash table from each chunk that a pool overlaps to
+  // its index + 1. When it's full a table with double the capacity replaces it, but old tables are
+  // kept until destruction since other threads may still be reading them.
+  struct PoolTable
+  {
+    PoolTable(int32_t cap) : capacity(cap), lookupSize(uint32_t(cap) * 4)
+    {
+      pools = new ItemPool *[capacity]();
+      lookup = new int32_t[lookupSize]();
+    }
+    ~PoolTable()
+    {
+      delete[] pools;
+      delete[] lookup;
+    }
+
+    uint32_t GetLookupSlot(uintptr_t chunk) const
+    {
+      return (uint32_t(chunk ^ (chunk >> 16)) * 0x9E3779B1U) & (lookupSize - 1);
+    }
+
+    void Register(int32_t poolIdx, ItemPool *pool, uint32_t chunkShift)
+    {
+      pools[poolIdx] = pool;
+
+      // register the pool for each chunk it overlaps. The compare-exchange ensures the pool pointer
+      // above is visible before the lookup entry is.
+      uintptr_t firstChunk = uintptr_t(&pool->items[0]) >> chunkShift;
+      uintptr_t lastChunk = uintptr_t(&pool->items[AllocCount - 1]) >> chunkShift;
+      for(uintptr_t chunk = firstChunk; chunk <= lastChunk; chunk++)
+      {
+        uint32_t slot = GetLookupSlot(chunk);
+        while(Atomic::CmpExch32(&lookup[slot], 0, poolIdx + 1) != 0)
+          slot = (slot + 1) & (lookupSize - 1);
+      }
+    }
+
+    int32_t capacity;
+    uint32_t lookupSize;
+    ItemPool **pools;
+    volatile int32_t *lookup;
   };
 
+  int32_t GetAdditionalPoolCount() { return Atomic::CmpExch32(&m_AdditionalPoolCount, 0, 0); }
+  // only valid once there are additional pools. Tables are published before the count is raised, so
+  // the current table always holds at least as many pools as were counted.
+  PoolTable *GetPoolTable() { return m_PoolTables[Atomic::CmpExch32(&m_PoolTableIndex, 0, 0)]; }
+
+  ItemPool *FindPool(const void *p)
+  {
+    // we can check the immediate pool directly
+    if(m_ImmediatePool.IsAlloc(p))
+      return &m_ImmediatePool;
+
+    if(GetAdditionalPoolCount() == 0)
+      return NULL;
+
+    PoolTable *table = GetPoolTable();
+
+    // probe from this pointer's chunk until we find an empty slot. Entries are never removed, so
+    // any pool containing the pointer will be found before then.
+    for(uint32_t slot = table->GetLookupSlot(uintptr_t(p) >> m_ChunkShift);;
+        slot = (slot + 1) & (table->lookupSize - 1))
+    {
+      int32_t poolIdx = table->lookup[slot];
+
+      if(poolIdx == 0)
+        return NULL;
+
+      ItemPool *pool = table->pools[poolIdx - 1];
+      if(pool->IsAlloc(p))
+        return pool;
+    }
+  }
+
+  ThreadCache *GetThreadCache()
+  {
+    ThreadCache *cache = (ThreadCache *)Threading::GetTLSValue(m_CacheSlot);
+
+    if(cache == NULL)
+    {
+      cache = new ThreadCache();
+      Threading::SetTLSValue(m_CacheSlot, cache);
+
+      // we keep track of caches to reclaim their slots when the pools run dry, since a thread that
+      // exits can't return the slots in its cache.
+      SCOPED_LOCK(m_Lock);
+      m_Caches.push_back(cache);
+    }
+
+    return cache;
+  }
+
+  void Refill(ThreadCache *cache)
+  {
+    while(cache->count == 0)
+    {
+      int32_t numPools = GetAdditionalPoolCount();
+      PoolTable *table = numPools > 0 ? GetPoolTable() : NULL;
+
+      // take a batch from the first pool with any free slots. Newer pools are more likely to have
+      // free slots.
+      for(int32_t i = numPools; cache->count == 0 && i >= 0; i--)
+      {
+        ItemPool *pool = i == 0 ? &m_ImmediatePool : table->pools[i - 1];
+
+        while(cache->count < CacheBatch)
+        {
+          void *item = pool->Pop();
+          if(item == NULL)
+            break;
+
+          cache->items[cache->count++] = item;
+        }
+      }
+
+      // only create a new pool if there were no slots sitting in other caches to take back
+      if(cache->count == 0 && !ReclaimCaches(cache))
+        AddPool(numPools);
+    }
+  }
+
+  // returns the slots held in every other thread's cache to the pools, returning true if there were
+  // any. Caches that are in use right now are skipped.
+  bool ReclaimCaches(ThreadCache *self)
+  {
+    bool ret = false;
+
+    SCOPED_LOCK(m_Lock);
+
+    for(ThreadCache *cache : m_Caches)
+    {
+      if(cache == self || !cache->lock.Trylock())
+        continue;
+
+      ret |= cache->count > 0;
+
+      while(cache->count > 0)
+      {
+        void *item = cache->items[--cache->count];
+        FindPool(item)->Push(item);
+      }
+
+      cache->lock.Unlock();
+    }
+
+    return ret;
+  }
+
+  void AddPool(int32_t numPoolsSeen)
+  {
+    SCOPED_LOCK(m_Lock);
+
+    // another thread might have added a pool while we were waiting, in which case try again
+    if(m_AdditionalPoolCount != numPoolsSeen)
+      return;
+
+// warn when we need to allocate an additional pool
+#if ENABLED(INCLUDE_TYPE_NAMES)
+    RDCWARN("Ran out of free slots in %s pool!", GetTypeName<WrapType>::Name());
+#else
+    RDCWARN("Ran out of free slots in pool 0x%p!", &m_ImmediatePool.items[0]);
+#endif
+
+    int32_t poolIdx = m_AdditionalPoolCount;
+
+    PoolTable *table = m_PoolTables[m_PoolTableIndex];
+
+    if(table == NULL)
+    {
+      table = m_PoolTables[0] = new PoolTable(InitialPoolTableSize);
+    }
+    else if(poolIdx == table->capacity)
+    {
+      RDCASSERT(m_PoolTableIndex + 1 < MaxPoolTables);
+
+      // build a bigger table with all the existing pools, then publish it. Readers that already
+      // have the old table can keep using it, it still holds every pool they could have seen.
+      PoolTable *grown = new PoolTable(table->capacity * 2);
+      for(int32_t i = 0; i < poolIdx; i++)
+        grown->Register(i, table->pools[i], m_ChunkShift);
+
+      m_PoolTables[m_PoolTableIndex + 1] = grown;
+      Atomic::Inc32(&m_PoolTableIndex);
+
+      table = grown;
+    }
+
+    ItemPool *pool = new ItemPool();
+
+#if ENABLED(INCLUDE_TYPE_NAMES)
+    RDCDEBUG("WrappingPool[%d]<%s>: %p -> %p", poolIdx, GetTypeName<WrapType>::Name(),
+             &pool->items[0], &pool->items[AllocCount - 1]);
+#endif
+
+    table->Register(poolIdx, pool, m_ChunkShift);
+
+    Atomic::Inc32(&m_AdditionalPoolCount);
+  }
+
+  Threading::CriticalSection m_Lock;
+
   ItemPool m_ImmediatePool;
-  std::vector<ItemPool *> m_AdditionalPools;
+
+  PoolTable *m_PoolTables[MaxPoolTables] = {};
+  volatile int32_t m_PoolTableIndex = 0;
+  volatile int32_t m_AdditionalPoolCount = 0;
+  uint32_t m_ChunkShift = 0;
+
+  uint64_t m_CacheSlot = 0;
+  std::vector<ThreadCache *> m_Caches;
 
   friend typename FriendMaker<WrapType>::Type;
 };
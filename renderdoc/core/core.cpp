@@ -278,8 +278,11 @@ void RenderDoc::Initialise()
     {
       m_RemoteIdent = port;
 
+      Network::Socket *localSock = Network::CreateLocalServerSocket(port & 0xffff, 4);
+
       m_TargetControlThreadShutdown = false;
-      m_RemoteThread = Threading::CreateThread([sock]() { TargetControlServerThread(sock); });
+      m_RemoteThread = Threading::CreateThread(
+          [sock, localSock]() { TargetControlServerThread(sock, localSock); });
 
       RDCLOG("Listening for target control on %u", port);
     }
@@ -353,6 +356,22 @@ RenderDoc::~RenderDoc()
   for(auto it = m_ShutdownFunctions.begin(); it != m_ShutdownFunctions.end(); ++it)
     (*it)();
 
+  // wait for any captures still being written. The thread holds a reference on our module, so if
+  // we're being destroyed while it runs the process is exiting. On windows it has then already
+  // been terminated and this returns immediately, elsewhere it's still running and finishes first.
+  if(m_CaptureWriteThread)
+  {
+    Threading::JoinThread(m_CaptureWriteThread);
+    Threading::CloseThread(m_CaptureWriteThread);
+    m_CaptureWriteThread = 0;
+  }
+
+  // the thread only exits once everything is written, so anything left means it was terminated.
+  // It can't be written now, and the lock may have been abandoned, so it's just reported.
+  if(!m_PendingCaptureWrites.empty())
+    RDCERR("%u captures weren't finished writing before exit",
+           (uint32_t)m_PendingCaptureWrites.size());
+
   for(size_t i = 0; i < m_Captures.size(); i++)
   {
     if(m_Captures[i].retrieved)
@@ -865,26 +884,46 @@ void RenderDoc::EncodePixelsPNG(const RDCThumb &in, RDCThumb &out)
   out.format = FileType::PNG;
 }
 
-RDCFile *RenderDoc::CreateRDC(RDCDriver driver, uint32_t frameNum, const FramePixels &fp)
+string RenderDoc::GetNewCapturePath(uint32_t frameNum)
 {
-  RDCFile *ret = new RDCFile;
-
-  m_CurrentLogFile = StringFormat::Fmt("%s_frame%u.rdc", m_CaptureFileTemplate.c_str(), frameNum);
+  string path = StringFormat::Fmt("%s_frame%u.rdc", m_CaptureFileTemplate.c_str(), frameNum);
+
+  // make sure we don't stomp another capture if we make multiple captures in the same frame,
+  // including any that are still being written in the background.
+  SCOPED_LOCK(m_CaptureWriteLock);
+  SCOPED_LOCK(m_CaptureLock);
+
+  auto inUse = [this](const string &p) {
+    for(const CaptureData &o : m_Captures)
+      if(o.path == p)
+        return true;
+    for(const PendingCaptureWrite *w : m_PendingCaptureWrites)
+      if(w->path == p)
+        return true;
+    return false;
+  };
 
-  // make sure we don't stomp another capture if we make multiple captures in the same frame.
+  int altnum = 2;
+  while(inUse(path))
   {
-    SCOPED_LOCK(m_CaptureLock);
-    int altnum = 2;
-    while(std::find_if(m_Captures.begin(), m_Captures.end(), [this](const CaptureData &o) {
-            return o.path == m_CurrentLogFile;
-          }) != m_Captures.end())
-    {
-      m_CurrentLogFile =
-          StringFormat::Fmt("%s_frame%u_%d.rdc", m_CaptureFileTemplate.c_str(), frameNum, altnum);
-      altnum++;
-    }
+    path = StringFormat::Fmt("%s_frame%u_%d.rdc", m_CaptureFileTemplate.c_str(), frameNum, altnum);
+    altnum++;
   }
 
+  return path;
+}
+
+RDCFile *RenderDoc::CreateRDC(RDCDriver driver, uint32_t frameNum, const FramePixels &fp)
+{
+  m_CurrentLogFile = GetNewCapturePath(frameNum);
+
+  return CreateRDC(m_CurrentLogFile, driver, fp);
+}
+
+RDCFile *RenderDoc::CreateRDC(const string &path, RDCDriver driver, const FramePixels &fp)
+{
+  RDCFile *ret = new RDCFile;
+
   RDCThumb outRaw, outPng;
   if(fp.data)
   {
@@ -897,14 +936,23 @@ RDCFile *RenderDoc::CreateRDC(RDCDriver driver, uint32_t frameNum, const FramePi
 
   ret->SetData(driver, ToStr(driver).c_str(), OSUtility::GetMachineIdent(), &outPng);
 
-  FileIO::CreateParentDirectory(m_CurrentLogFile);
+  FileIO::CreateParentDirectory(path);
 
-  ret->Create(m_CurrentLogFile.c_str());
+  uint32_t streamId = BeginCaptureStream(path);
+  if(streamId != 0)
+  {
+    ret->SetWriteTee([this, streamId](uint64_t offset, const void *data, uint64_t length) {
+      StreamCaptureData(streamId, offset, data, length);
+    });
+  }
+
+  ret->Create(path.c_str());
 
   if(ret->ErrorCode() != ContainerError::NoError)
   {
-    RDCERR("Error creating RDC at '%s'", m_CurrentLogFile.c_str());
+    RDCERR("Error creating RDC at '%s'", path.c_str());
     SAFE_DELETE(ret);
+    EndCaptureStream(path, false);
   }
 
   SAFE_DELETE_ARRAY(outRaw.pixels);
@@ -913,6 +961,323 @@ RDCFile *RenderDoc::CreateRDC(RDCDriver driver, uint32_t frameNum, const FramePi
   return ret;
 }
 
+void RenderDoc::SetCaptureStreaming(bool enabled)
+{
+  SCOPED_LOCK(m_CaptureStreamLock);
+
+  m_CaptureStreaming = enabled;
+
+  if(!enabled)
+  {
+    m_CaptureStreams.clear();
+    m_CaptureStreamPackets.clear();
+    m_CaptureStreamBytes = 0;
+
+    if(m_CaptureStreamWaiters > 0)
+      m_CaptureStreamDrained.Signal(m_CaptureStreamWaiters);
+  }
+}
+
+bool RenderDoc::NextCaptureStreamPacket(CaptureStreamPacket &packet)
+{
+  SCOPED_LOCK(m_CaptureStreamLock);
+
+  if(m_CaptureStreamPackets.empty())
+    return false;
+
+  // take the data without copying it
+  bytebuf data;
+  data.swap(m_CaptureStreamPackets.front().data);
+
+  packet = m_CaptureStreamPackets.front();
+  packet.data.swap(data);
+  m_CaptureStreamPackets.pop_front();
+
+  m_CaptureStreamBytes -= packet.data.size();
+
+  if(m_CaptureStreamWaiters > 0 && !packet.data.empty())
+    m_CaptureStreamDrained.Signal(m_CaptureStreamWaiters);
+
+  return true;
+}
+
+uint32_t RenderDoc::BeginCaptureStream(const string &path)
+{
+  SCOPED_LOCK(m_CaptureStreamLock);
+
+  if(!m_CaptureStreaming)
+    return 0;
+
+  CaptureStreamPacket packet;
+  packet.type = CaptureStreamPacket::Begin;
+  packet.streamId = m_NextCaptureStreamID++;
+  packet.path = path;
+
+  m_CaptureStreams[packet.streamId] = path;
+  m_CaptureStreamPackets.push_back(packet);
+
+  return packet.streamId;
+}
+
+void RenderDoc::StreamCaptureData(uint32_t streamId, uint64_t offset, const void *data,
+                                  uint64_t length)
+{
+  // sequential writes are gathered into packets up to this size
+  const uint64_t maxPacketSize = 4 * 1024 * 1024;
+
+  // if the client can't keep up, wait for it rather than buffering without limit. Disabling
+  // streaming drops the stream, so this won't wait on a client that has gone away. A client that
+  // is still connected but has stopped reading has its stream dropped after a while, so capture
+  // writing isn't held up indefinitely.
+  for(;;)
+  {
+    {
+      SCOPED_LOCK(m_CaptureStreamLock);
+
+      if(m_CaptureStreams.find(streamId) == m_CaptureStreams.end())
+        return;
+
+      if(m_CaptureStreamBytes <= CaptureStreamMemoryLimit)
+      {
+        m_CaptureStreamBytes += length;
+
+        if(!m_CaptureStreamPackets.empty())
+        {
+          CaptureStreamPacket &last = m_CaptureStreamPackets.back();
+
+          if(last.type == CaptureStreamPacket::Data && last.streamId == streamId &&
+             last.offset + last.data.size() == offset && last.data.size() + length <= maxPacketSize)
+          {
+            last.data.insert(last.data.size(), (const byte *)data, (size_t)length);
+            return;
+          }
+        }
+
+        CaptureStreamPacket packet;
+        packet.type = CaptureStreamPacket::Data;
+        packet.streamId = streamId;
+        packet.offset = offset;
+        m_CaptureStreamPackets.push_back(packet);
+        m_CaptureStreamPackets.back().data.insert(0, (const byte *)data, (size_t)length);
+        return;
+      }
+
+      m_CaptureStreamWaiters++;
+    }
+
+    bool drained = m_CaptureStreamDrained.Wait(CaptureStreamStallTimeoutMS);
+
+    SCOPED_LOCK(m_CaptureStreamLock);
+
+    m_CaptureStreamWaiters--;
+
+    if(!drained)
+    {
+      DropCaptureStream(streamId);
+      return;
+    }
+  }
+}
+
+void RenderDoc::DropCaptureStream(uint32_t streamId)
+{
+  auto it = m_CaptureStreams.find(streamId);
+
+  if(it == m_CaptureStreams.end())
+    return;
+
+  RDCWARN("Capture stream to client stalled, dropping it. %s will be copied once written instead.",
+          it->second.c_str());
+
+  // free whatever of the stream hadn't been sent yet
+  for(auto p = m_CaptureStreamPackets.begin(); p != m_CaptureStreamPackets.end();)
+  {
+    if(p->type == CaptureStreamPacket::Data && p->streamId == streamId)
+    {
+      m_CaptureStreamBytes -= p->data.size();
+      p = m_CaptureStreamPackets.erase(p);
+      continue;
+    }
+
+    ++p;
+  }
+
+  // the client discards a stream that ends unsuccessfully
+  CaptureStreamPacket packet;
+  packet.type = CaptureStreamPacket::End;
+  packet.streamId = streamId;
+  packet.path = it->second;
+  packet.success = false;
+  m_CaptureStreamPackets.push_back(packet);
+
+  m_CaptureStreams.erase(it);
+
+  // other streams waiting on the memory limit may be able to continue now
+  if(m_CaptureStreamWaiters > 0)
+    m_CaptureStreamDrained.Signal(m_CaptureStreamWaiters);
+}
+
+void RenderDoc::EndCaptureStream(const string &path, bool success)
+{
+  // the file is complete on disk, so take its final size to account for any truncation that the
+  // stream didn't see.
+  uint64_t size = 0;
+  if(success)
+  {
+    FILE *f = FileIO::fopen(path.c_str(), "rb");
+    if(f)
+    {
+      FileIO::fseek64(f, 0, SEEK_END);
+      size = FileIO::ftell64(f);
+      FileIO::fclose(f);
+    }
+    else
+    {
+      success = false;
+    }
+  }
+
+  SCOPED_LOCK(m_CaptureStreamLock);
+
+  for(auto it = m_CaptureStreams.begin(); it != m_CaptureStreams.end(); ++it)
+  {
+    if(it->second == path)
+    {
+      CaptureStreamPacket packet;
+      packet.type = CaptureStreamPacket::End;
+      packet.streamId = it->first;
+      packet.path = path;
+      packet.offset = size;
+      packet.success = success;
+      m_CaptureStreamPackets.push_back(packet);
+
+      m_CaptureStreams.erase(it);
+      return;
+    }
+  }
+}
+
+void RenderDoc::QueueCaptureWriting(RDCDriver driver, uint32_t frameNumber, FramePixels &fp,
+                                    StreamWriter *frameData, BlobStore *blobs,
+                                    uint64_t blobsVersion, const SectionProperties &props)
+{
+  PendingCaptureWrite *write = new PendingCaptureWrite;
+  write->driver = driver;
+  write->frameNumber = frameNumber;
+  write->path = GetNewCapturePath(frameNumber);
+  write->props = props;
+  write->frameData = frameData;
+  write->blobs = blobs;
+  write->blobsVersion = blobsVersion;
+
+  // take over the pixel data, so it isn't freed when the caller's FramePixels goes out of scope
+  write->fp = new FramePixels;
+  *write->fp = fp;
+  fp.data = NULL;
+
+  uint64_t size = frameData->GetOffset();
+  if(blobs)
+    size += blobs->GetUniqueBytes();
+  write->size = size;
+
+  RDCLOG("Queueing %llu bytes of capture data to be written to %s", size, write->path.c_str());
+
+  {
+    SCOPED_LOCK(m_CaptureWriteLock);
+
+    m_PendingCaptureWrites.push_back(write);
+    m_PendingCaptureBytes += size;
+
+    if(!m_CaptureWriteThreadRunning)
+    {
+      // the previous thread has exited or is just about to, it's not joined to avoid blocking
+      if(m_CaptureWriteThread)
+        Threading::CloseThread(m_CaptureWriteThread);
+
+      m_CaptureWriteThreadRunning = true;
+      m_CaptureWriteThread = Threading::CreateThread([this]() { CaptureWriteThread(); });
+    }
+  }
+
+  // apply the memory limit. The capture we just queued is already in memory, but if we're over
+  // the limit wait for enough to be written before letting the application carry on.
+  const uint64_t limit = uint64_t(m_Options.backgroundWriteMemoryMB) * 1024 * 1024;
+
+  for(;;)
+  {
+    {
+      SCOPED_LOCK(m_CaptureWriteLock);
+      if(m_PendingCaptureBytes <= limit || m_PendingCaptureWrites.empty())
+        break;
+
+      m_CaptureWriteWaiters++;
+    }
+
+    m_CaptureWritten.Wait();
+
+    {
+      SCOPED_LOCK(m_CaptureWriteLock);
+      m_CaptureWriteWaiters--;
+    }
+  }
+}
+
+void RenderDoc::CaptureWriteThread()
+{
+  Threading::KeepModuleAlive();
+
+  for(;;)
+  {
+    PendingCaptureWrite *write = NULL;
+
+    {
+      SCOPED_LOCK(m_CaptureWriteLock);
+
+      if(m_PendingCaptureWrites.empty())
+      {
+        m_CaptureWriteThreadRunning = false;
+        break;
+      }
+
+      write = m_PendingCaptureWrites[0];
+    }
+
+    RDCFile *rdc = CreateRDC(write->path, write->driver, *write->fp);
+
+    if(rdc)
+    {
+      StreamWriter *w = rdc->WriteSection(write->props);
+
+      w->Write(write->frameData->GetData(), write->frameData->GetOffset());
+      w->Finish();
+
+      delete w;
+    }
+
+    if(rdc && write->blobs)
+      rdc->WriteBlobStore(*write->blobs, write->blobsVersion);
+
+    FinishCaptureWriting(rdc, write->frameNumber, write->path);
+
+    {
+      SCOPED_LOCK(m_CaptureWriteLock);
+
+      m_PendingCaptureBytes -= write->size;
+      m_PendingCaptureWrites.erase(m_PendingCaptureWrites.begin());
+
+      if(m_CaptureWriteWaiters > 0)
+        m_CaptureWritten.Signal(m_CaptureWriteWaiters);
+    }
+
+    delete write->frameData;
+    delete write->blobs;
+    delete write->fp;
+    delete write;
+  }
+
+  Threading::ReleaseModuleExitThread();
+}
+
 bool RenderDoc::HasReplayDriver(RDCDriver driver) const
 {
   // Image driver is handled specially and isn't registered in the map
@@ -1274,6 +1639,11 @@ void RenderDoc::SetCaptureFileTemplate(const char *pathtemplate)
 }
 
 void RenderDoc::FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber)
+{
+  FinishCaptureWriting(rdc, frameNumber, m_CurrentLogFile);
+}
+
+void RenderDoc::FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber, const string &path)
 {
   RenderDoc::Inst().SetProgress(CaptureProgress::FileWriting, 0.0f);
 
@@ -1324,19 +1694,28 @@ void RenderDoc::FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber)
       delete w;
     }
 
-    RDCLOG("Written to disk: %s", m_CurrentLogFile.c_str());
+    RDCLOG("Written to disk: %s", path.c_str());
+
+    CaptureData cap(path, Timing::GetUnixTimestamp(), rdc->GetDriver(), frameNumber);
+
+    bool streamComplete = rdc->IsWriteTeeComplete();
+
+    delete rdc;
+
+    // end any stream before the capture is listed, so a client receiving it has the whole file by
+    // the time it hears about the new capture.
+    EndCaptureStream(path, streamComplete);
 
-    CaptureData cap(m_CurrentLogFile, Timing::GetUnixTimestamp(), rdc->GetDriver(), frameNumber);
     {
       SCOPED_LOCK(m_CaptureLock);
       m_Captures.push_back(cap);
     }
-
-    delete rdc;
   }
   else
   {
     RDCLOG("Discarded capture, Frame %u", frameNumber);
+
+    EndCaptureStream(path, false);
   }
 
   RenderDoc::Inst().SetProgress(CaptureProgress::FileWriting, 1.0f);
@@ -26,6 +26,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <deque>
 #include <map>
 #include <set>
 #include <string>
@@ -233,6 +234,28 @@ struct CaptureData
   bool retrieved;
 };
 
+// a piece of a capture being streamed to the target control client while it's written. Each stream
+// is a Begin, any number of Data packets with bytes written at an offset in the file, then an End.
+struct CaptureStreamPacket
+{
+  enum Type
+  {
+    Begin,
+    Data,
+    End,
+  };
+
+  Type type = Begin;
+  uint32_t streamId = 0;
+  // the path of the capture on disk, for Begin and End
+  string path;
+  // for Data the offset the bytes were written at, for End the final size of the file
+  uint64_t offset = 0;
+  bytebuf data;
+  // for End, whether every write was streamed
+  bool success = false;
+};
+
 enum class LoadProgress
 {
   DebugManagerInit,
@@ -322,6 +345,8 @@ class IRemoteDriver;
 class IReplayDriver;
 
 class StreamReader;
+class StreamWriter;
+class BlobStore;
 class RDCFile;
 
 typedef ReplayStatus (*RemoteDriverProvider)(RDCFile *rdc, IRemoteDriver **driver);
@@ -437,6 +462,24 @@ public:
   RDCFile *CreateRDC(RDCDriver driver, uint32_t frameNum, const FramePixels &fp);
   void FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber);
 
+  // if this returns true, drivers should serialise the frame capture section into an in-memory
+  // StreamWriter and pass it to QueueCaptureWriting instead of calling CreateRDC and
+  // FinishCaptureWriting themselves.
+  bool IsBackgroundCaptureWriting() const { return m_Options.backgroundWriteMemoryMB > 0; }
+  // takes ownership of frameData, blobs and of fp's pixel data. The thumbnail encoding, compression
+  // and disk writes happen on a background thread, and the capture is added to the list of captures
+  // once it's complete. This only blocks if the data waiting to be written is over the limit.
+  // If any blobs are written, the frame capture's version is changed to blobsVersion.
+  void QueueCaptureWriting(RDCDriver driver, uint32_t frameNumber, FramePixels &fp,
+                           StreamWriter *frameData, BlobStore *blobs, uint64_t blobsVersion,
+                           const SectionProperties &props);
+
+  // while enabled, captures that begin writing are also streamed to the target control client as
+  // they're written. Disabling drops any streams in progress.
+  void SetCaptureStreaming(bool enabled);
+  // fetches the next piece of a streamed capture to send, returns false if nothing is waiting.
+  bool NextCaptureStreamPacket(CaptureStreamPacket &packet);
+
   void AddChildProcess(uint32_t pid, uint32_t ident)
   {
     SCOPED_LOCK(m_ChildLock);
@@ -620,6 +663,55 @@ private:
   Threading::CriticalSection m_CaptureLock;
   vector<CaptureData> m_Captures;
 
+  struct PendingCaptureWrite
+  {
+    RDCDriver driver;
+    uint32_t frameNumber;
+    string path;
+    FramePixels *fp;
+    StreamWriter *frameData;
+    BlobStore *blobs;
+    uint64_t blobsVersion;
+    uint64_t size;
+    SectionProperties props;
+  };
+
+  Threading::CriticalSection m_CaptureWriteLock;
+  vector<PendingCaptureWrite *> m_PendingCaptureWrites;
+  uint64_t m_PendingCaptureBytes = 0;
+  Threading::ThreadHandle m_CaptureWriteThread = 0;
+  bool m_CaptureWriteThreadRunning = false;
+  // signalled once for each thread waiting on the memory limit, every time a capture is written
+  Threading::Semaphore m_CaptureWritten;
+  uint32_t m_CaptureWriteWaiters = 0;
+
+  // the most streamed data that can be waiting to send before capture writing waits for it
+  static const uint64_t CaptureStreamMemoryLimit = 64 * 1024 * 1024;
+  // how long capture writing waits for a client to make progress before dropping its stream
+  static const uint32_t CaptureStreamStallTimeoutMS = 10000;
+
+  Threading::CriticalSection m_CaptureStreamLock;
+  bool m_CaptureStreaming = false;
+  uint32_t m_NextCaptureStreamID = 1;
+  // paths of the streams that have begun and not yet ended, by ID
+  map<uint32_t, string> m_CaptureStreams;
+  std::deque<CaptureStreamPacket> m_CaptureStreamPackets;
+  uint64_t m_CaptureStreamBytes = 0;
+  // signalled once for each thread waiting on the memory limit, whenever data is sent
+  Threading::Semaphore m_CaptureStreamDrained;
+  uint32_t m_CaptureStreamWaiters = 0;
+
+  uint32_t BeginCaptureStream(const string &path);
+  void StreamCaptureData(uint32_t streamId, uint64_t offset, const void *data, uint64_t length);
+  // must be called with m_CaptureStreamLock held
+  void DropCaptureStream(uint32_t streamId);
+  void EndCaptureStream(const string &path, bool success);
+
+  string GetNewCapturePath(uint32_t frameNum);
+  RDCFile *CreateRDC(const string &path, RDCDriver driver, const FramePixels &fp);
+  void FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber, const string &path);
+  void CaptureWriteThread();
+
   Threading::CriticalSection m_ChildLock;
   vector<pair<uint32_t, uint32_t> > m_Children;
 
@@ -694,7 +786,7 @@ private:
 
   PerformanceTimer m_Timer;
 
-  static void TargetControlServerThread(Network::Socket *sock);
+  static void TargetControlServerThread(Network::Socket *sock, Network::Socket *localSock);
   static void TargetControlClientThread(uint32_t version, Network::Socket *client);
 
   ICrashHandler *m_ExHandler;
@@ -185,6 +185,13 @@ public:
   const D3D12Pipe::State *GetD3D12PipelineState() { return NULL; }
   const GLPipe::State *GetGLPipelineState() { return NULL; }
   const VKPipe::State *GetVulkanPipelineState() { return NULL; }
+  void SetLazyDescriptorThreshold(uint32_t maxElements) {}
+  rdcarray<VKPipe::BindingElement> GetVulkanDescriptorBindings(bool compute, uint32_t set,
+                                                               uint32_t binding,
+                                                               uint32_t firstElement, uint32_t count)
+  {
+    return rdcarray<VKPipe::BindingElement>();
+  }
   void ReplayLog(uint32_t endEventID, ReplayLogType replayType) {}
   vector<uint32_t> GetPassEvents(uint32_t eventId) { return vector<uint32_t>(); }
   vector<EventUsage> GetUsage(ResourceId id) { return vector<EventUsage>(); }
@@ -23,11 +23,15 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include <algorithm>
 #include <sstream>
 #include <utility>
+#include "3rdparty/zstd/xxhash.h"
 #include "android/android.h"
 #include "api/replay/renderdoc_replay.h"
 #include "api/replay/version.h"
+#include "common/sha256.h"
+#include "common/timing.h"
 #include "core/core.h"
 #include "os/os_specific.h"
 #include "replay/replay_controller.h"
@@ -39,6 +43,20 @@
 static const uint32_t RemoteServerProtocolVersion =
     uint32_t(RENDERDOC_VERSION_MAJOR * 1000) | RENDERDOC_VERSION_MINOR;
 
+// size of the shared memory used for bulk data on local connections. Results larger than this fall
+// back to going through the socket.
+static const uint64_t RemoteServerSharedMemorySize = 128 * 1024 * 1024ULL;
+
+// default size budget for captures uploaded to the server, configurable with 'cachesize <MB>' in
+// remoteserver.conf
+static const uint64_t DefaultCaptureCacheSize = 16 * 1024 * 1024 * 1024ULL;
+
+// upper limit for 'maxsessions <count>' in remoteserver.conf
+static const uint32_t MaxRemoteSessions = 64;
+
+// exit code of a session process whose client asked for the whole server to shut down
+static const int SessionExitShutdownServer = 3;
+
 enum RemoteServerPacket
 {
   eRemoteServer_Noop = 1,
@@ -69,6 +87,8 @@ enum RemoteServerPacket
   eRemoteServer_GetSectionProperties,
   eRemoteServer_GetSectionContents,
   eRemoteServer_WriteSection,
+  eRemoteServer_SharedMemory,
+  eRemoteServer_CaptureChunk,
   eRemoteServer_RemoteServerCount,
 };
 
@@ -91,9 +111,463 @@ struct ClientThread
   bool killThread;
   bool killServer;
 
+  // size budget in bytes for the uploaded capture cache
+  uint64_t cacheSize = DefaultCaptureCacheSize;
+
+  // this session's slot in the shared session state
+  uint32_t slot = 0;
+
+  // sessions either run on a thread in the server, or in a forked process when there can be
+  // several at once
   Threading::ThreadHandle thread;
+  uint32_t pid = 0;
+};
+
+// state shared by every session on the server. When sessions run in their own processes this lives
+// in shared memory, so it's guarded by a spin lock that works across processes rather than a
+// CriticalSection. The lock records which slot holds it, so if a session dies holding it the
+// server can release it.
+struct SessionState
+{
+  // slot holding the lock plus one, or 0 if it's free
+  volatile int32_t lockOwner;
+
+  // budget in bytes for the memory open captures are estimated to need. 0 means no limit
+  uint64_t memoryBudget;
+
+  struct Slot
+  {
+    // memory reserved against the budget for this session's open capture
+    uint64_t memory;
+    // hash of the capture this session is uploading into the cache, or empty
+    char uploading[65];
+    // set by the server to ask the session to finish
+    volatile int32_t kill;
+  } slots[MaxRemoteSessions];
+};
+
+static SessionState localSessionState;
+static SessionState *sessionState = &localSessionState;
+
+struct SessionStateLock
+{
+  SessionStateLock(uint32_t slot) : owner(int32_t(slot + 1))
+  {
+    while(Atomic::CmpExch32(&sessionState->lockOwner, 0, owner) != 0)
+      Threading::Sleep(1);
+  }
+  ~SessionStateLock() { Atomic::CmpExch32(&sessionState->lockOwner, owner, 0); }
+  int32_t owner;
+};
+
+// the server itself takes the lock with the slot after the last session
+static const uint32_t ServerSlot = MaxRemoteSessions;
+
+// returns a session's slot to the server once it's finished, releasing anything it left behind if
+// its process died.
+static void ReleaseSessionSlot(uint32_t slot)
+{
+  Atomic::CmpExch32(&sessionState->lockOwner, int32_t(slot + 1), 0);
+
+  SessionStateLock lock(ServerSlot);
+
+  SessionState::Slot &s = sessionState->slots[slot];
+  s.memory = 0;
+  s.uploading[0] = 0;
+  s.kill = 0;
+}
+
+// captures are transferred in chunks, each with its own checksum, so that corruption is detected
+// and an interrupted transfer can resume from the last good chunk.
+static const uint64_t CaptureTransferChunkSize = 4 * 1024 * 1024;
+
+// whole files are identified by SHA-256 rather than XXH64, since the hash names the file in the
+// capture cache that's shared by every client of the server. XXH64 is only used to checksum
+// chunks in transit.
+static std::string HashFile(FILE *f, uint64_t length)
+{
+  SHA256 hash;
+
+  bytebuf buf;
+  buf.resize((size_t)RDCMIN(length, CaptureTransferChunkSize));
+
+  FileIO::fseek64(f, 0, SEEK_SET);
+
+  for(uint64_t offs = 0; offs < length;)
+  {
+    size_t len = (size_t)RDCMIN(length - offs, CaptureTransferChunkSize);
+
+    if(FileIO::fread(buf.data(), 1, len, f) != len)
+      break;
+
+    hash.Update(buf.data(), len);
+    offs += len;
+  }
+
+  return hash.Finish();
+}
+
+static uint64_t GetFileSize(FILE *f)
+{
+  FileIO::fseek64(f, 0, SEEK_END);
+  uint64_t ret = FileIO::ftell64(f);
+  FileIO::fseek64(f, 0, SEEK_SET);
+  return ret;
+}
+
+// sends the range [offset, size) of the file, which must be positioned at offset, as a series of
+// checksummed chunks.
+static void SendFileChunks(WriteSerialiser &writer, FILE *f, uint64_t offset, uint64_t size,
+                           RENDERDOC_ProgressCallback progress)
+{
+  bytebuf chunk;
+
+  for(uint64_t cur = offset; cur < size; cur += CaptureTransferChunkSize)
+  {
+    size_t len = (size_t)RDCMIN(size - cur, CaptureTransferChunkSize);
+
+    chunk.resize(len);
+
+    // if the file can't be read, send an empty chunk. The other side will stop accepting data at
+    // this point but we still send the expected number of chunks.
+    if(FileIO::fread(chunk.data(), 1, len, f) != len)
+      chunk.clear();
+
+    uint64_t checksum = XXH64(chunk.data(), chunk.size(), cur);
+
+    {
+      WRITE_DATA_SCOPE();
+      SCOPED_SERIALISE_CHUNK(eRemoteServer_CaptureChunk);
+      SERIALISE_ELEMENT(checksum);
+      SERIALISE_ELEMENT(chunk);
+    }
+
+    if(writer.IsErrored())
+      return;
+
+    if(progress)
+      progress(float(cur + len) / float(size));
+  }
+}
+
+// receives the chunks sent by SendFileChunks and writes them to the file, which must be positioned
+// at offset. Writing stops at the first chunk that fails its checksum, but the remaining chunks
+// are still consumed. If f is NULL nothing is written. Returns how far the file contains verified
+// data, which is size on success.
+static uint64_t ReceiveFileChunks(ReadSerialiser &reader, FILE *f, uint64_t offset, uint64_t size,
+                                  RENDERDOC_ProgressCallback progress)
+{
+  uint64_t verified = offset;
+  bool failed = (f == NULL);
+
+  bytebuf chunk;
+
+  for(uint64_t cur = offset; cur < size; cur += CaptureTransferChunkSize)
+  {
+    size_t len = (size_t)RDCMIN(size - cur, CaptureTransferChunkSize);
+
+    uint64_t checksum = 0;
+
+    {
+      READ_DATA_SCOPE();
+      RemoteServerPacket type = ser.ReadChunk<RemoteServerPacket>();
+
+      if(type != eRemoteServer_CaptureChunk)
+      {
+        RDCERR("Unexpected packet %d during capture transfer", type);
+        return verified;
+      }
+
+      SERIALISE_ELEMENT(checksum);
+      SERIALISE_ELEMENT(chunk);
+
+      ser.EndChunk();
+    }
+
+    if(reader.IsErrored())
+      return verified;
+
+    if(failed)
+      continue;
+
+    if(chunk.size() != len || XXH64(chunk.data(), len, cur) != checksum)
+    {
+      RDCERR("Capture chunk at %llu failed verification", cur);
+      failed = true;
+      continue;
+    }
+
+    if(FileIO::fwrite(chunk.data(), 1, len, f) != len)
+    {
+      RDCERR("Couldn't write capture chunk at %llu: %s", cur, FileIO::ErrorString().c_str());
+      failed = true;
+      continue;
+    }
+
+    verified = cur + len;
+
+    if(progress)
+      progress(float(verified) / float(size));
+  }
+
+  return verified;
+}
+
+// captures uploaded to the server are kept in a cache named by the hash of their contents, so
+// uploading the same capture again can be skipped. Incomplete uploads are kept as .partial files
+// so that a later upload of the same capture resumes where the last one stopped. Once the cache is
+// over its size budget the least recently used captures are deleted.
+struct CaptureCache
+{
+  static std::string GetFolder()
+  {
+    std::string path, dummy, dummy2;
+    FileIO::GetDefaultFiles("remotecopy", path, dummy, dummy2);
+    return dirname(path) + "/capturecache";
+  }
+
+  static std::string GetPath(const std::string &hash, bool partial)
+  {
+    return StringFormat::Fmt("%s/%s.%s", GetFolder().c_str(), hash.c_str(),
+                             partial ? "partial" : "rdc");
+  }
+
+  // the hash comes from the client and is used as a filename, so it must be exactly what
+  // HashFile produces
+  static bool IsValidHash(const std::string &hash)
+  {
+    if(hash.size() != 64)
+      return false;
+
+    for(char c : hash)
+      if(!(c >= '0' && c <= '9') && !(c >= 'a' && c <= 'f'))
+        return false;
+
+    return true;
+  }
+
+  // returns the path to the complete cached capture, or an empty string if there isn't one
+  static std::string Find(const std::string &hash, uint64_t size, uint32_t slot)
+  {
+    if(!IsValidHash(hash))
+      return std::string();
+
+    SessionStateLock lock(slot);
+
+    std::string path = GetPath(hash, false);
+
+    FILE *f = FileIO::fopen(path.c_str(), "rb");
+
+    if(f == NULL)
+      return std::string();
+
+    uint64_t cachedSize = GetFileSize(f);
+    FileIO::fclose(f);
+
+    if(cachedSize != size)
+      return std::string();
+
+    MarkUsed(hash);
+
+    return path;
+  }
+
+  // only one session at a time can upload into a given partial file. Returns false if another
+  // session is already uploading this capture, or the hash isn't valid.
+  static bool BeginUpload(const std::string &hash, uint32_t slot)
+  {
+    if(!IsValidHash(hash))
+      return false;
+
+    SessionStateLock lock(slot);
+
+    if(IsUploading(hash))
+      return false;
+
+    memcpy(sessionState->slots[slot].uploading, hash.c_str(), hash.size() + 1);
+    MarkUsed(hash);
+    return true;
+  }
+
+  static void EndUpload(const std::string &hash, uint32_t slot, uint64_t budget)
+  {
+    SessionStateLock lock(slot);
+
+    sessionState->slots[slot].uploading[0] = 0;
+
+    Evict(budget, hash);
+  }
+
+private:
+  static bool IsUploading(const std::string &hash)
+  {
+    for(const SessionState::Slot &s : sessionState->slots)
+      if(hash == s.uploading)
+        return true;
+
+    return false;
+  }
+
+  static void MarkUsed(const std::string &hash)
+  {
+    std::map<std::string, uint64_t> index = LoadIndex();
+    index[hash] = Timing::GetUnixTimestamp();
+    SaveIndex(index);
+  }
+
+  static void Evict(uint64_t budget, const std::string &keep)
+  {
+    std::string folder = GetFolder();
+
+    std::map<std::string, uint64_t> index = LoadIndex();
+
+    struct Entry
+    {
+      std::string path;
+      std::string hash;
+      uint64_t size;
+      uint64_t lastUse;
+
+      bool operator<(const Entry &o) const { return lastUse < o.lastUse; }
+    };
+
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+
+    for(const PathEntry &file : FileIO::GetFilesInDirectory(folder.c_str()))
+    {
+      std::string name = file.filename.c_str();
+
+      if(!endswith(name, ".rdc") && !endswith(name, ".partial"))
+        continue;
+
+      Entry e;
+      e.path = folder + "/" + name;
+      e.hash = name.substr(0, name.find('.'));
+      e.size = file.size;
+      e.lastUse = index.find(e.hash) != index.end() ? index[e.hash] : file.lastmod;
+
+      total += e.size;
+      entries.push_back(e);
+    }
+
+    std::sort(entries.begin(), entries.end());
+
+    for(const Entry &e : entries)
+    {
+      if(total <= budget)
+        break;
+
+      if(e.hash == keep || IsUploading(e.hash))
+        continue;
+
+      RDCLOG("Evicting cached capture %s (%llu bytes)", e.path.c_str(), e.size);
+
+      FileIO::Delete(e.path.c_str());
+      index.erase(e.hash);
+      total -= e.size;
+    }
+
+    SaveIndex(index);
+  }
+
+  // the index records when each capture was last used, by hash
+  static std::map<std::string, uint64_t> LoadIndex()
+  {
+    std::map<std::string, uint64_t> ret;
+
+    FILE *f = FileIO::fopen((GetFolder() + "/index").c_str(), "r");
+
+    while(f && !FileIO::feof(f))
+    {
+      std::string line = trim(FileIO::getline(f));
+
+      char hash[65] = {};
+      unsigned long long lastUse = 0;
+      if(sscanf(line.c_str(), "%64s %llu", hash, &lastUse) == 2)
+        ret[hash] = lastUse;
+    }
+
+    if(f)
+      FileIO::fclose(f);
+
+    return ret;
+  }
+
+  static void SaveIndex(const std::map<std::string, uint64_t> &index)
+  {
+    std::string path = GetFolder() + "/index";
+
+    FileIO::CreateParentDirectory(path);
+
+    FILE *f = FileIO::fopen(path.c_str(), "w");
+
+    if(f == NULL)
+      return;
+
+    for(auto it = index.begin(); it != index.end(); ++it)
+    {
+      std::string line = StringFormat::Fmt("%s %llu\n", it->first.c_str(), it->second);
+      FileIO::fwrite(line.c_str(), 1, line.size(), f);
+    }
+
+    FileIO::fclose(f);
+  }
 };
 
+// captures are opened against a budget for the memory they're estimated to need, shared by all
+// sessions. A capture that doesn't fit is refused with NetworkRemoteBusy.
+
+// We can't query what a replay will really use before creating its driver, so we estimate from
+// the capture: its uncompressed contents are held in memory and most of them are uploaded to the
+// GPU as initial contents, so count them twice.
+static uint64_t EstimateReplayMemory(RDCFile *rdc)
+{
+  uint64_t ret = 0;
+
+  for(int i = 0; i < rdc->NumSections(); i++)
+    ret += rdc->GetSectionProperties(i).uncompressedSize;
+
+  return ret * 2;
+}
+
+static uint64_t GetSessionMemoryUsed()
+{
+  uint64_t ret = 0;
+
+  for(const SessionState::Slot &s : sessionState->slots)
+    ret += s.memory;
+
+  return ret;
+}
+
+static bool ReserveSessionMemory(uint32_t slot, uint64_t bytes)
+{
+  SessionStateLock lock(slot);
+
+  uint64_t budget = sessionState->memoryBudget;
+  uint64_t used = GetSessionMemoryUsed();
+
+  if(budget > 0 && used + bytes > budget)
+  {
+    RDCLOG("Refusing capture needing ~%llu MB, %llu of %llu MB budget is in use",
+           bytes / (1024 * 1024), used / (1024 * 1024), budget / (1024 * 1024));
+    return false;
+  }
+
+  sessionState->slots[slot].memory += bytes;
+  return true;
+}
+
+static void ReleaseSessionMemory(uint32_t slot, uint64_t &bytes)
+{
+  SessionStateLock lock(slot);
+
+  uint64_t &reserved = sessionState->slots[slot].memory;
+  reserved -= RDCMIN(bytes, reserved);
+  bytes = 0;
+}
+
 static void InactiveRemoteClientThread(ClientThread *threadData)
 {
   uint32_t ip = threadData->socket->GetRemoteIP();
@@ -205,6 +679,8 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
   ReplayProxy *proxy = NULL;
   RDCFile *rdc = NULL;
   Callstack::StackResolver *resolver = NULL;
+  Network::SharedMemory *sharedMem = NULL;
+  uint64_t reservedMemory = 0;
 
   WriteSerialiser writer(new StreamWriter(client, Ownership::Nothing), Ownership::Stream);
   ReadSerialiser reader(new StreamReader(client, Ownership::Nothing), Ownership::Stream);
@@ -217,7 +693,7 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
     if(client && !client->Connected())
       break;
 
-    if(threadData->killThread)
+    if(threadData->killThread || sessionState->slots[threadData->slot].kill)
       break;
 
     // this will block until a packet comes in.
@@ -262,6 +738,34 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
         SERIALISE_ELEMENT(driverName);
       }
     }
+    else if(type == eRemoteServer_SharedMemory)
+    {
+      std::string name;
+      uint64_t size = 0;
+
+      {
+        READ_DATA_SCOPE();
+        SERIALISE_ELEMENT(name);
+        SERIALISE_ELEMENT(size);
+      }
+
+      reader.EndChunk();
+
+      // only map memory for clients that are really on this machine
+      if(client->IsLocal() && sharedMem == NULL)
+        sharedMem = Network::OpenSharedMemory(name.c_str(), size);
+
+      bool opened = (sharedMem != NULL);
+
+      if(opened)
+        RDCLOG("Using %llu bytes of shared memory for local connection", size);
+
+      {
+        WRITE_DATA_SCOPE();
+        SCOPED_SERIALISE_CHUNK(eRemoteServer_SharedMemory);
+        SERIALISE_ELEMENT(opened);
+      }
+    }
     else if(type == eRemoteServer_HomeDir)
     {
       reader.EndChunk();
@@ -296,53 +800,171 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
     else if(type == eRemoteServer_CopyCaptureFromRemote)
     {
       std::string path;
+      uint64_t localSize = 0;
+      std::string localHash;
 
       {
         READ_DATA_SCOPE();
         SERIALISE_ELEMENT(path);
+        SERIALISE_ELEMENT(localSize);
+        SERIALISE_ELEMENT(localHash);
       }
 
       reader.EndChunk();
 
+      FILE *f = FileIO::fopen(path.c_str(), "rb");
+
+      uint64_t size = f ? GetFileSize(f) : 0;
+      uint64_t resumeOffset = 0;
+
+      // if the client already has the start of this file, only send the rest
+      if(f && localSize > 0 && localSize <= size && HashFile(f, localSize) == localHash)
+      {
+        RDCLOG("Client already has %llu of %llu bytes of '%s'", localSize, size, path.c_str());
+        resumeOffset = localSize;
+      }
+
       {
         WRITE_DATA_SCOPE();
         SCOPED_SERIALISE_CHUNK(eRemoteServer_CopyCaptureFromRemote);
+        SERIALISE_ELEMENT(size);
+        SERIALISE_ELEMENT(resumeOffset);
+      }
 
-        StreamReader fileStream(FileIO::fopen(path.c_str(), "rb"));
-        ser.SerialiseStream(path, fileStream);
+      if(f)
+      {
+        FileIO::fseek64(f, resumeOffset, SEEK_SET);
+        SendFileChunks(writer, f, resumeOffset, size, RENDERDOC_ProgressCallback());
+        FileIO::fclose(f);
       }
     }
     else if(type == eRemoteServer_CopyCaptureToRemote)
     {
-      std::string path;
-      std::string dummy, dummy2;
-      FileIO::GetDefaultFiles("remotecopy", path, dummy, dummy2);
+      std::string hash;
+      uint64_t size = 0;
+
+      {
+        READ_DATA_SCOPE();
+        SERIALISE_ELEMENT(hash);
+        SERIALISE_ELEMENT(size);
+      }
 
-      RDCLOG("Copying file to local path '%s'.", path.c_str());
+      reader.EndChunk();
 
-      FileIO::CreateParentDirectory(path);
+      std::string path = CaptureCache::Find(hash, size, threadData->slot);
+      std::string receivePath;
+      bool cached = false;
+      uint64_t resumeOffset = 0;
+      FILE *f = NULL;
 
+      if(!path.empty())
       {
-        READ_DATA_SCOPE();
+        RDCLOG("Capture %s is already cached at '%s'.", hash.c_str(), path.c_str());
+        resumeOffset = size;
+      }
+      else if(CaptureCache::BeginUpload(hash, threadData->slot))
+      {
+        cached = true;
+        path = CaptureCache::GetPath(hash, false);
+        receivePath = CaptureCache::GetPath(hash, true);
 
-        StreamWriter streamWriter(FileIO::fopen(path.c_str(), "wb"), Ownership::Stream);
+        FileIO::CreateParentDirectory(receivePath);
 
-        ser.SerialiseStream(path.c_str(), streamWriter, NULL);
+        // resume from the whole chunks of a previous incomplete upload. Chunks are only written
+        // once verified so everything there is good.
+        f = FileIO::fopen(receivePath.c_str(), "r+b");
+        if(f)
+          resumeOffset = RDCMIN(GetFileSize(f), size);
+        else
+          f = FileIO::fopen(receivePath.c_str(), "wb");
+
+        resumeOffset -= resumeOffset % CaptureTransferChunkSize;
+
+        if(f)
+        {
+          FileIO::ftruncateat(f, resumeOffset);
+          FileIO::fseek64(f, resumeOffset, SEEK_SET);
+        }
+
+        if(resumeOffset > 0)
+          RDCLOG("Resuming upload of capture %s at %llu of %llu bytes", hash.c_str(), resumeOffset,
+                 size);
       }
+      else
+      {
+        // another session is uploading the same capture into the cache right now, or the hash
+        // can't be used as a cache name. Receive it into a temporary file instead.
+        std::string dummy, dummy2;
+        FileIO::GetDefaultFiles("remotecopy", receivePath, dummy, dummy2);
 
-      reader.EndChunk();
+        FileIO::CreateParentDirectory(receivePath);
+
+        f = FileIO::fopen(receivePath.c_str(), "wb");
+        path = receivePath;
+
+        tempFiles.push_back(path);
+      }
+
+      if(!receivePath.empty())
+        RDCLOG("Copying file to local path '%s'.", receivePath.c_str());
 
-      if(reader.IsErrored())
       {
-        FileIO::Delete(path.c_str());
+        WRITE_DATA_SCOPE();
+        SCOPED_SERIALISE_CHUNK(eRemoteServer_CopyCaptureToRemote);
+        SERIALISE_ELEMENT(resumeOffset);
+      }
 
-        RDCERR("Network error receiving file");
-        break;
+      uint64_t received = resumeOffset;
+
+      if(resumeOffset < size)
+      {
+        if(f == NULL)
+          RDCERR("Couldn't open '%s' to receive capture", receivePath.c_str());
+
+        received = ReceiveFileChunks(reader, f, resumeOffset, size, RENDERDOC_ProgressCallback());
       }
 
-      RDCLOG("File received.");
+      if(f)
+        FileIO::fclose(f);
 
-      tempFiles.push_back(path);
+      if(cached)
+      {
+        // the chunks have all been verified, but check the whole file matches its name before
+        // it goes into the cache.
+        if(received == size)
+        {
+          FILE *check = FileIO::fopen(receivePath.c_str(), "rb");
+          bool match = check && HashFile(check, size) == hash;
+          if(check)
+            FileIO::fclose(check);
+
+          if(match)
+          {
+            FileIO::Move(receivePath.c_str(), path.c_str(), true);
+          }
+          else
+          {
+            RDCERR("Received capture doesn't match its hash %s", hash.c_str());
+            FileIO::Delete(receivePath.c_str());
+            received = 0;
+          }
+        }
+
+        CaptureCache::EndUpload(hash, threadData->slot, threadData->cacheSize);
+      }
+
+      if(received != size)
+      {
+        RDCERR("Error receiving file, %llu of %llu bytes received", received, size);
+        path = "";
+      }
+      else
+      {
+        RDCLOG("File received.");
+      }
+
+      if(reader.IsErrored())
+        break;
 
       {
         WRITE_DATA_SCOPE();
@@ -413,13 +1035,19 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
       }
       else
       {
-        if(RenderDoc::Inst().HasRemoteDriver(rdc->GetDriver()))
+        uint64_t estimate = EstimateReplayMemory(rdc);
+
+        if(!ReserveSessionMemory(threadData->slot, estimate))
+        {
+          status = ReplayStatus::NetworkRemoteBusy;
+        }
+        else if(RenderDoc::Inst().HasRemoteDriver(rdc->GetDriver()))
         {
+          reservedMemory = estimate;
+
           bool kill = false;
           float progress = 0.0f;
 
-          RenderDoc::Inst().SetProgressCallback<LoadProgress>([&progress](float p) { progress = p; });
-
           Threading::ThreadHandle ticker = Threading::CreateThread([&writer, &kill, &progress]() {
             while(!kill)
             {
@@ -432,6 +1060,9 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
             }
           });
 
+          RenderDoc::Inst().SetProgressCallback<LoadProgress>(
+              [&progress](float p) { progress = p; });
+
           // if we have a replay driver, try to create it so we can display a local preview e.g.
           if(RenderDoc::Inst().HasReplayDriver(rdc->GetDriver()))
           {
@@ -470,16 +1101,22 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
           if(status == ReplayStatus::Succeeded && remoteDriver)
           {
             proxy = new ReplayProxy(reader, writer, remoteDriver, replayDriver, previewWindow);
+            proxy->SetSharedMemory(sharedMem);
           }
         }
         else
         {
           RDCERR("File needs driver for '%s' which isn't supported!", rdc->GetDriverName().c_str());
 
+          ReleaseSessionMemory(threadData->slot, estimate);
+
           status = ReplayStatus::APIUnsupported;
         }
       }
 
+      if(status != ReplayStatus::Succeeded)
+        ReleaseSessionMemory(threadData->slot, reservedMemory);
+
       {
         WRITE_DATA_SCOPE();
         SCOPED_SERIALISE_CHUNK(eRemoteServer_LogOpened);
@@ -734,6 +1371,8 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
 
       SAFE_DELETE(rdc);
       SAFE_DELETE(resolver);
+
+      ReleaseSessionMemory(threadData->slot, reservedMemory);
     }
     else if(type == eRemoteServer_ExecuteAndInject)
     {
@@ -789,6 +1428,9 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
   replayDriver = NULL;
   SAFE_DELETE(rdc);
   SAFE_DELETE(resolver);
+  SAFE_DELETE(sharedMem);
+
+  ReleaseSessionMemory(threadData->slot, reservedMemory);
 
   for(size_t i = 0; i < tempFiles.size(); i++)
   {
@@ -812,8 +1454,14 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
   if(sock == NULL)
     return;
 
+  // also listen on the local transport, used by clients on the same machine
+  Network::Socket *localSock = Network::CreateLocalServerSocket(port, 1);
+
   std::vector<std::pair<uint32_t, uint32_t> > listenRanges;
   bool allowExecution = true;
+  uint64_t cacheSize = DefaultCaptureCacheSize;
+  uint32_t maxSessions = 1;
+  uint64_t memoryBudget = 0;
 
   FILE *f = FileIO::fopen(FileIO::GetAppFolderFilename("remoteserver.conf").c_str(), "r");
 
@@ -853,6 +1501,40 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
 
       continue;
     }
+    else if(line.substr(0, sizeof("cachesize") - 1) == "cachesize")
+    {
+      uint64_t megabytes = 0;
+
+      if(sscanf(line.c_str() + sizeof("cachesize"), "%llu", (unsigned long long *)&megabytes) == 1)
+        cacheSize = megabytes * 1024 * 1024;
+      else
+        RDCLOG("Couldn't parse cache size from: %s", line.c_str() + sizeof("cachesize"));
+
+      continue;
+    }
+    else if(line.substr(0, sizeof("maxsessions") - 1) == "maxsessions")
+    {
+      uint32_t sessions = 0;
+
+      if(sscanf(line.c_str() + sizeof("maxsessions"), "%u", &sessions) == 1 && sessions > 0)
+        maxSessions = RDCMIN(sessions, MaxRemoteSessions);
+      else
+        RDCLOG("Couldn't parse session count from: %s", line.c_str() + sizeof("maxsessions"));
+
+      continue;
+    }
+    else if(line.substr(0, sizeof("memorybudget") - 1) == "memorybudget")
+    {
+      uint64_t megabytes = 0;
+
+      if(sscanf(line.c_str() + sizeof("memorybudget"), "%llu", (unsigned long long *)&megabytes) ==
+         1)
+        memoryBudget = megabytes * 1024 * 1024;
+      else
+        RDCLOG("Couldn't parse memory budget from: %s", line.c_str() + sizeof("memorybudget"));
+
+      continue;
+    }
 
     RDCLOG("Malformed line '%s'. See documentation for file format.", line.c_str());
   }
@@ -890,9 +1572,44 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
   else
     RDCLOG("Blocking execution commands");
 
+  RDCLOG("Caching up to %llu MB of uploaded captures in %s", cacheSize / (1024 * 1024),
+         CaptureCache::GetFolder().c_str());
+
+  // the replay drivers keep process-wide state, such as the current device used for marker
+  // regions, so two replays can't run side by side in one process. To serve several sessions at
+  // once each one is forked into its own process, with the state they share in shared memory.
+  Network::SharedMemory *sharedState = NULL;
+
+  if(maxSessions > 1)
+  {
+    if(Process::CanFork())
+      sharedState = Network::CreateSharedMemory(sizeof(SessionState));
+
+    if(sharedState)
+    {
+      // the sessions inherit the mapping when they're forked, nothing needs to open it by name
+      sharedState->Unlink();
+      sessionState = (SessionState *)sharedState->GetData();
+    }
+    else
+    {
+      RDCWARN("Can't run sessions in separate processes here, serving one session at a time");
+      maxSessions = 1;
+    }
+  }
+
+  memset((void *)sessionState, 0, sizeof(SessionState));
+  sessionState->memoryBudget = memoryBudget;
+
+  RDCLOG("Serving up to %u sessions at once", maxSessions);
+
+  if(memoryBudget > 0)
+    RDCLOG("Limiting open captures to an estimated %llu MB", memoryBudget / (1024 * 1024));
+
   RDCLOG("Replay host ready for requests...");
 
-  ClientThread *activeClientData = NULL;
+  // each active connection is a session with its own replay, up to maxSessions at once
+  std::vector<ClientThread *> actives;
 
   std::vector<ClientThread *> inactives;
 
@@ -900,8 +1617,8 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
   {
     Network::Socket *client = sock->AcceptClient(0);
 
-    if(activeClientData && activeClientData->killServer)
-      break;
+    if(client == NULL && localSock)
+      client = localSock->AcceptClient(0);
 
     // reap any dead inactive threads
     for(size_t i = 0; i < inactives.size(); i++)
@@ -916,14 +1633,51 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
       }
     }
 
-    // reap our active connection possibly
-    if(activeClientData && activeClientData->socket == NULL)
+    // reap our active connections possibly
+    bool killServer = false;
+
+    for(size_t i = 0; i < actives.size();)
     {
-      Threading::JoinThread(activeClientData->thread);
-      Threading::CloseThread(activeClientData->thread);
+      ClientThread *active = actives[i];
+
+      if(active->pid)
+      {
+        int exitCode = 0;
+
+        if(!Process::WaitForkedProcess(active->pid, false, exitCode))
+        {
+          i++;
+          continue;
+        }
+
+        active->killServer = (exitCode == SessionExitShutdownServer);
+
+        if(exitCode != 0 && !active->killServer)
+          RDCWARN("Session process %u exited with code %d", active->pid, exitCode);
+      }
+      else if(active->socket == NULL)
+      {
+        Threading::JoinThread(active->thread);
+        Threading::CloseThread(active->thread);
+      }
+      else
+      {
+        i++;
+        continue;
+      }
 
-      delete activeClientData;
-      activeClientData = NULL;
+      killServer |= active->killServer;
+
+      ReleaseSessionSlot(active->slot);
+
+      delete active;
+      actives.erase(actives.begin() + i);
+    }
+
+    if(killServer)
+    {
+      SAFE_DELETE(client);
+      break;
     }
 
     if(client == NULL)
@@ -931,9 +1685,7 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
       if(!sock->Connected())
       {
         RDCERR("Error in accept - shutting down server");
-
-        SAFE_DELETE(sock);
-        return;
+        break;
       }
 
       Threading::Sleep(5);
@@ -967,17 +1719,79 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
       continue;
     }
 
-    if(activeClientData == NULL)
+    bool accept = actives.size() < maxSessions;
+
+    // a new session couldn't open any capture while the memory budget is used up
+    if(accept && memoryBudget > 0)
+    {
+      SessionStateLock lock(ServerSlot);
+      accept = GetSessionMemoryUsed() < memoryBudget;
+
+      if(!accept)
+        RDCLOG("Memory budget is used up by open captures");
+    }
+
+    if(accept)
     {
-      activeClientData = new ClientThread();
+      ClientThread *activeClientData = new ClientThread();
       activeClientData->socket = client;
       activeClientData->allowExecution = allowExecution;
+      activeClientData->cacheSize = cacheSize;
 
-      activeClientData->thread = Threading::CreateThread([activeClientData, previewWindow]() {
-        ActiveRemoteClientThread(activeClientData, previewWindow);
-      });
+      // take the first slot no active session is using
+      std::vector<bool> usedSlots(maxSessions, false);
+      for(ClientThread *active : actives)
+        usedSlots[active->slot] = true;
+
+      while(usedSlots[activeClientData->slot])
+        activeClientData->slot++;
+
+      if(maxSessions > 1)
+      {
+        // any lock another thread holds when we fork stays locked forever in the session, so
+        // finish with refused connections first. They only last as long as the handshake.
+        for(ClientThread *inactive : inactives)
+        {
+          Threading::JoinThread(inactive->thread);
+          Threading::CloseThread(inactive->thread);
+          delete inactive;
+        }
+        inactives.clear();
+
+        activeClientData->pid = Process::ForkProcess([activeClientData, sock, localSock]() {
+          // the listening sockets still belong to the server
+          sock->ReleaseHandle();
+          if(localSock)
+            localSock->ReleaseHandle();
+
+          // there's no preview window in a session process, it can't reach the server's UI
+          ActiveRemoteClientThread(activeClientData, RENDERDOC_PreviewWindowCallback());
+
+          return activeClientData->killServer ? SessionExitShutdownServer : 0;
+        });
+
+        // the session process has its own handle to the connection now
+        if(activeClientData->pid)
+          client->ReleaseHandle();
+
+        SAFE_DELETE(activeClientData->socket);
+
+        if(activeClientData->pid == 0)
+        {
+          delete activeClientData;
+          continue;
+        }
+      }
+      else
+      {
+        activeClientData->thread = Threading::CreateThread([activeClientData, previewWindow]() {
+          ActiveRemoteClientThread(activeClientData, previewWindow);
+        });
+      }
+
+      actives.push_back(activeClientData);
 
-      RDCLOG("Making active connection");
+      RDCLOG("Making active connection (%u of %u sessions)", (uint32_t)actives.size(), maxSessions);
     }
     else
     {
@@ -994,14 +1808,23 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
     }
   }
 
-  if(activeClientData && activeClientData->socket != NULL)
-  {
-    activeClientData->killThread = true;
+  for(ClientThread *active : actives)
+    sessionState->slots[active->slot].kill = 1;
 
-    Threading::JoinThread(activeClientData->thread);
-    Threading::CloseThread(activeClientData->thread);
+  for(ClientThread *active : actives)
+  {
+    if(active->pid)
+    {
+      int exitCode = 0;
+      Process::WaitForkedProcess(active->pid, true, exitCode);
+    }
+    else
+    {
+      Threading::JoinThread(active->thread);
+      Threading::CloseThread(active->thread);
+    }
 
-    delete activeClientData;
+    delete active;
   }
 
   // shut down client threads
@@ -1012,7 +1835,11 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
     delete inactives[i];
   }
 
+  sessionState = &localSessionState;
+  SAFE_DELETE(sharedState);
+
   SAFE_DELETE(sock);
+  SAFE_DELETE(localSock);
 }
 
 struct RemoteServer : public IRemoteServer
@@ -1034,7 +1861,11 @@ public:
       m_Proxies.push_back(*it);
   }
   const std::string &hostname() const { return m_hostname; }
-  virtual ~RemoteServer() { SAFE_DELETE(m_Socket); }
+  virtual ~RemoteServer()
+  {
+    SAFE_DELETE(m_Socket);
+    SAFE_DELETE(m_SharedMemory);
+  }
   void ShutdownConnection()
   {
     ResetAndroidSettings();
@@ -1312,65 +2143,144 @@ public:
   {
     std::string path = remotepath;
 
+    // if there's already a file at the destination, e.g. from an earlier copy that was interrupted,
+    // send its hash so the server can tell us how much of it we can keep.
+    uint64_t localSize = 0;
+    std::string localHash;
+
+    FILE *f = FileIO::fopen(localpath, "rb");
+    if(f)
+    {
+      localSize = GetFileSize(f);
+      localHash = HashFile(f, localSize);
+      FileIO::fclose(f);
+    }
+
     {
       WRITE_DATA_SCOPE();
       SCOPED_SERIALISE_CHUNK(eRemoteServer_CopyCaptureFromRemote);
       SERIALISE_ELEMENT(path);
+      SERIALISE_ELEMENT(localSize);
+      SERIALISE_ELEMENT(localHash);
     }
 
+    uint64_t size = 0;
+    uint64_t resumeOffset = 0;
+
     {
       READ_DATA_SCOPE();
       RemoteServerPacket type = ser.ReadChunk<RemoteServerPacket>();
 
       if(type == eRemoteServer_CopyCaptureFromRemote)
       {
-        StreamWriter streamWriter(FileIO::fopen(localpath, "wb"), Ownership::Stream);
-
-        ser.SerialiseStream(localpath, streamWriter, progress);
-
-        if(ser.IsErrored())
-        {
-          RDCERR("Network error receiving file");
-          return;
-        }
+        SERIALISE_ELEMENT(size);
+        SERIALISE_ELEMENT(resumeOffset);
       }
       else
       {
         RDCERR("Unexpected response to capture copy request");
+        return;
       }
 
       ser.EndChunk();
     }
+
+    f = FileIO::fopen(localpath, resumeOffset > 0 ? "r+b" : "wb");
+
+    if(f)
+    {
+      FileIO::ftruncateat(f, resumeOffset);
+      FileIO::fseek64(f, resumeOffset, SEEK_SET);
+    }
+
+    uint64_t received = ReceiveFileChunks(reader, f, resumeOffset, size, progress);
+
+    if(f)
+      FileIO::fclose(f);
+
+    if(received != size)
+      RDCERR("Error receiving file, %llu of %llu bytes received", received, size);
+    else if(progress)
+      progress(1.0f);
   }
 
   rdcstr CopyCaptureToRemote(const char *filename, RENDERDOC_ProgressCallback progress)
   {
-    {
-      WRITE_DATA_SCOPE();
-      SCOPED_SERIALISE_CHUNK(eRemoteServer_CopyCaptureToRemote);
+    FILE *f = FileIO::fopen(filename, "rb");
 
-      StreamReader fileStream(FileIO::fopen(filename, "rb"));
-      ser.SerialiseStream(filename, fileStream, progress);
+    if(f == NULL)
+    {
+      RDCERR("Couldn't open '%s' to copy to remote", filename);
+      return "";
     }
 
+    uint64_t size = GetFileSize(f);
+    std::string hash = HashFile(f, size);
+
     std::string path;
 
+    // a failed upload leaves its verified chunks on the server, so retrying resumes from there
+    for(int attempt = 0; attempt < 3 && path.empty() && !writer.IsErrored(); attempt++)
     {
-      READ_DATA_SCOPE();
-      RemoteServerPacket type = ser.ReadChunk<RemoteServerPacket>();
+      {
+        WRITE_DATA_SCOPE();
+        SCOPED_SERIALISE_CHUNK(eRemoteServer_CopyCaptureToRemote);
+        SERIALISE_ELEMENT(hash);
+        SERIALISE_ELEMENT(size);
+      }
+
+      uint64_t resumeOffset = 0;
 
-      if(type == eRemoteServer_CopyCaptureToRemote)
       {
-        SERIALISE_ELEMENT(path);
+        READ_DATA_SCOPE();
+        RemoteServerPacket type = ser.ReadChunk<RemoteServerPacket>();
+
+        if(type == eRemoteServer_CopyCaptureToRemote)
+        {
+          SERIALISE_ELEMENT(resumeOffset);
+        }
+        else
+        {
+          RDCERR("Unexpected response to capture copy request");
+          break;
+        }
+
+        ser.EndChunk();
+      }
+
+      if(resumeOffset < size)
+      {
+        FileIO::fseek64(f, resumeOffset, SEEK_SET);
+        SendFileChunks(writer, f, resumeOffset, size, progress);
       }
       else
       {
-        RDCERR("Unexpected response to capture copy request");
+        RDCLOG("Remote server already has this capture, skipping upload.");
       }
 
-      ser.EndChunk();
+      {
+        READ_DATA_SCOPE();
+        RemoteServerPacket type = ser.ReadChunk<RemoteServerPacket>();
+
+        if(type == eRemoteServer_CopyCaptureToRemote)
+        {
+          SERIALISE_ELEMENT(path);
+        }
+        else
+        {
+          RDCERR("Unexpected response to capture copy request");
+          break;
+        }
+
+        ser.EndChunk();
+      }
     }
 
+    FileIO::fclose(f);
+
+    if(!path.empty() && progress)
+      progress(1.0f);
+
     return path;
   }
 
@@ -1407,6 +2317,8 @@ public:
     // appropriate supported proxy for the current platform.
     RDCDriver proxydrivertype = proxyid == ~0U ? RDCDriver::Unknown : m_Proxies[proxyid].first;
 
+    InitSharedMemory();
+
     {
       WRITE_DATA_SCOPE();
       SCOPED_SERIALISE_CHUNK(eRemoteServer_OpenLog);
@@ -1475,6 +2387,7 @@ public:
     ReplayController *rend = new ReplayController();
 
     ReplayProxy *proxy = new ReplayProxy(reader, writer, proxyDriver);
+    proxy->SetSharedMemory(m_SharedMemory);
     status = rend->SetDevice(proxy);
 
     if(status != ReplayStatus::Succeeded)
@@ -1494,6 +2407,57 @@ public:
     return ret;
   }
 
+  // on a local connection, set up memory shared with the server that bulk results can be returned
+  // through. This is only attempted once per connection.
+  void InitSharedMemory()
+  {
+    if(m_SharedMemoryTried || !m_Socket->IsLocal())
+      return;
+
+    m_SharedMemoryTried = true;
+
+    Network::SharedMemory *mem = Network::CreateSharedMemory(RemoteServerSharedMemorySize);
+
+    if(mem == NULL)
+      return;
+
+    {
+      std::string name = mem->GetName().c_str();
+      uint64_t size = mem->GetSize();
+
+      WRITE_DATA_SCOPE();
+      SCOPED_SERIALISE_CHUNK(eRemoteServer_SharedMemory);
+      SERIALISE_ELEMENT(name);
+      SERIALISE_ELEMENT(size);
+    }
+
+    bool opened = false;
+
+    {
+      READ_DATA_SCOPE();
+      RemoteServerPacket type = ser.ReadChunk<RemoteServerPacket>();
+
+      if(type == eRemoteServer_SharedMemory)
+      {
+        SERIALISE_ELEMENT(opened);
+      }
+      else
+      {
+        RDCERR("Unexpected response to shared memory request");
+      }
+
+      ser.EndChunk();
+    }
+
+    // both sides have it mapped now, or never will, so the name is no longer needed
+    mem->Unlink();
+
+    if(opened)
+      m_SharedMemory = mem;
+    else
+      SAFE_DELETE(mem);
+  }
+
   void ResetAndroidSettings()
   {
     if(Android::IsHostADB(m_hostname.c_str()))
@@ -1822,6 +2786,9 @@ private:
   ReadSerialiser reader;
   std::string m_hostname;
 
+  Network::SharedMemory *m_SharedMemory = NULL;
+  bool m_SharedMemoryTried = false;
+
   std::vector<std::pair<RDCDriver, std::string> > m_Proxies;
 };
 
@@ -58,6 +58,8 @@ std::string DoStringise(const ReplayProxyPacket &el)
     STRINGISE_ENUM_NAMED(eReplayProxy_GetTextureData, "GetTextureData");
 
     STRINGISE_ENUM_NAMED(eReplayProxy_SavePipelineState, "SavePipelineState");
+    STRINGISE_ENUM_NAMED(eReplayProxy_SetLazyDescriptorThreshold, "SetLazyDescriptorThreshold");
+    STRINGISE_ENUM_NAMED(eReplayProxy_GetVulkanDescriptorBindings, "GetVulkanDescriptorBindings");
     STRINGISE_ENUM_NAMED(eReplayProxy_GetUsage, "GetUsage");
     STRINGISE_ENUM_NAMED(eReplayProxy_GetLiveID, "GetLiveID");
     STRINGISE_ENUM_NAMED(eReplayProxy_GetFrameRecord, "GetFrameRecord");
@@ -792,17 +794,28 @@ void ReplayProxy::Proxied_GetBufferData(ParamSerialiser &paramser, ReturnSeriali
   // to this amount.
   uint64_t dataSize = retData.size() + 2 * retser.GetChunkAlignment();
 
+  // on a local connection the data goes through shared memory, if it fits, instead of being
+  // compressed through the socket.
+  bool shared = false;
+  if(retser.IsWriting())
+    shared = m_SharedMemory && retData.size() <= m_SharedMemory->GetSize();
+
   {
     ReturnSerialiser &ser = retser;
     PACKET_HEADER(packet);
     SERIALISE_ELEMENT(packet);
     SERIALISE_ELEMENT(dataSize);
+    SERIALISE_ELEMENT(shared);
   }
 
   char empty[128] = {};
 
+  if(shared)
+  {
+    SharedTransferBytes(retser, retData);
+  }
   // lz4 compress
-  if(retser.IsReading())
+  else if(retser.IsReading())
   {
     ReadSerialiser ser(new StreamReader(new LZ4Decompressor(retser.GetReader(), Ownership::Nothing),
                                         dataSize, Ownership::Stream),
@@ -869,17 +882,28 @@ void ReplayProxy::Proxied_GetTextureData(ParamSerialiser &paramser, ReturnSerial
   // to this amount.
   uint64_t dataSize = data.size() + 2 * retser.GetChunkAlignment();
 
+  // on a local connection the data goes through shared memory, if it fits, instead of being
+  // compressed through the socket.
+  bool shared = false;
+  if(retser.IsWriting())
+    shared = m_SharedMemory && data.size() <= m_SharedMemory->GetSize();
+
   {
     ReturnSerialiser &ser = retser;
     PACKET_HEADER(packet);
     SERIALISE_ELEMENT(packet);
     SERIALISE_ELEMENT(dataSize);
+    SERIALISE_ELEMENT(shared);
   }
 
   char empty[128] = {};
 
+  if(shared)
+  {
+    SharedTransferBytes(retser, data);
+  }
   // lz4 compress
-  if(retser.IsReading())
+  else if(retser.IsReading())
   {
     ReadSerialiser ser(new StreamReader(new LZ4Decompressor(retser.GetReader(), Ownership::Nothing),
                                         dataSize, Ownership::Stream),
@@ -1637,6 +1661,72 @@ void ReplayProxy::SavePipelineState()
   PROXY_FUNCTION(SavePipelineState);
 }
 
+template <typename ParamSerialiser, typename ReturnSerialiser>
+void ReplayProxy::Proxied_SetLazyDescriptorThreshold(ParamSerialiser &paramser,
+                                                     ReturnSerialiser &retser, uint32_t maxElements)
+{
+  const ReplayProxyPacket expectedPacket = eReplayProxy_SetLazyDescriptorThreshold;
+  ReplayProxyPacket packet = eReplayProxy_SetLazyDescriptorThreshold;
+
+  {
+    BEGIN_PARAMS();
+    SERIALISE_ELEMENT(maxElements);
+    END_PARAMS();
+  }
+
+  {
+    REMOTE_EXECUTION();
+    if(paramser.IsReading() && !paramser.IsErrored() && !m_IsErrored)
+      m_Remote->SetLazyDescriptorThreshold(maxElements);
+  }
+
+  SERIALISE_RETURN_VOID();
+}
+
+void ReplayProxy::SetLazyDescriptorThreshold(uint32_t maxElements)
+{
+  PROXY_FUNCTION(SetLazyDescriptorThreshold, maxElements);
+}
+
+template <typename ParamSerialiser, typename ReturnSerialiser>
+rdcarray<VKPipe::BindingElement> ReplayProxy::Proxied_GetVulkanDescriptorBindings(
+    ParamSerialiser &paramser, ReturnSerialiser &retser, bool compute, uint32_t set,
+    uint32_t binding, uint32_t firstElement, uint32_t count)
+{
+  const ReplayProxyPacket expectedPacket = eReplayProxy_GetVulkanDescriptorBindings;
+  ReplayProxyPacket packet = eReplayProxy_GetVulkanDescriptorBindings;
+  rdcarray<VKPipe::BindingElement> ret;
+
+  {
+    BEGIN_PARAMS();
+    SERIALISE_ELEMENT(compute);
+    SERIALISE_ELEMENT(set);
+    SERIALISE_ELEMENT(binding);
+    SERIALISE_ELEMENT(firstElement);
+    SERIALISE_ELEMENT(count);
+    END_PARAMS();
+  }
+
+  {
+    REMOTE_EXECUTION();
+    if(paramser.IsReading() && !paramser.IsErrored() && !m_IsErrored)
+      ret = m_Remote->GetVulkanDescriptorBindings(compute, set, binding, firstElement, count);
+  }
+
+  SERIALISE_RETURN(ret);
+
+  return ret;
+}
+
+rdcarray<VKPipe::BindingElement> ReplayProxy::GetVulkanDescriptorBindings(bool compute,
+                                                                          uint32_t set,
+                                                                          uint32_t binding,
+                                                                          uint32_t firstElement,
+                                                                          uint32_t count)
+{
+  PROXY_FUNCTION(GetVulkanDescriptorBindings, compute, set, binding, firstElement, count);
+}
+
 template <typename ParamSerialiser, typename ReturnSerialiser>
 void ReplayProxy::Proxied_ReplayLog(ParamSerialiser &paramser, ReturnSerialiser &retser,
                                     uint32_t endEventID, ReplayLogType replayType)
@@ -1985,6 +2075,35 @@ void ReplayProxy::DeltaTransferBytes(SerialiserType &xferser, bytebuf &reference
   }
 }
 
+template <typename SerialiserType>
+void ReplayProxy::SharedTransferBytes(SerialiserType &xferser, bytebuf &data)
+{
+  uint64_t sharedSize = data.size();
+
+  if(xferser.IsReading())
+  {
+    xferser.Serialise("sharedSize", sharedSize);
+
+    if(m_SharedMemory == NULL || sharedSize > m_SharedMemory->GetSize())
+    {
+      RDCERR("Received %llu bytes in shared memory, but none is available", sharedSize);
+      m_IsErrored = true;
+      data.clear();
+      return;
+    }
+
+    data.assign(m_SharedMemory->GetData(), (size_t)sharedSize);
+  }
+  else
+  {
+    // fill the memory before sending the size, since the other side reads it as soon as the size
+    // arrives. The next request can't be made until then, so the memory is free to overwrite.
+    memcpy(m_SharedMemory->GetData(), data.data(), data.size());
+
+    xferser.Serialise("sharedSize", sharedSize);
+  }
+}
+
 template <typename ParamSerialiser, typename ReturnSerialiser>
 void ReplayProxy::Proxied_CacheBufferData(ParamSerialiser &paramser, ReturnSerialiser &retser,
                                           ResourceId buff)
@@ -2576,6 +2695,10 @@ bool ReplayProxy::Tick(int type)
       break;
     }
     case eReplayProxy_SavePipelineState: SavePipelineState(); break;
+    case eReplayProxy_SetLazyDescriptorThreshold: SetLazyDescriptorThreshold(0); break;
+    case eReplayProxy_GetVulkanDescriptorBindings:
+      GetVulkanDescriptorBindings(false, 0, 0, 0, 0);
+      break;
     case eReplayProxy_GetUsage: GetUsage(ResourceId()); break;
     case eReplayProxy_GetLiveID: GetLiveID(ResourceId()); break;
     case eReplayProxy_GetFrameRecord: GetFrameRecord(); break;
@@ -65,6 +65,8 @@ enum ReplayProxyPacket
   eReplayProxy_GetTextureData,
 
   eReplayProxy_SavePipelineState,
+  eReplayProxy_SetLazyDescriptorThreshold,
+  eReplayProxy_GetVulkanDescriptorBindings,
   eReplayProxy_GetUsage,
   eReplayProxy_GetLiveID,
   eReplayProxy_GetFrameRecord,
@@ -161,6 +163,9 @@ public:
   void RemoteExecutionThreadEntry();
 
   bool IsRemoteProxy() { return !m_RemoteServer; }
+  // set on both sides when the connection is local and the shared memory has been opened by both
+  // processes. Not owned by the proxy.
+  void SetSharedMemory(Network::SharedMemory *mem) { m_SharedMemory = mem; }
   void Shutdown() { delete this; }
   ReplayStatus ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers)
   {
@@ -454,6 +459,10 @@ public:
   IMPLEMENT_FUNCTION_PROXIED(std::vector<DebugMessage>, GetDebugMessages);
 
   IMPLEMENT_FUNCTION_PROXIED(void, SavePipelineState);
+  IMPLEMENT_FUNCTION_PROXIED(void, SetLazyDescriptorThreshold, uint32_t maxElements);
+  IMPLEMENT_FUNCTION_PROXIED(rdcarray<VKPipe::BindingElement>, GetVulkanDescriptorBindings,
+                             bool compute, uint32_t set, uint32_t binding, uint32_t firstElement,
+                             uint32_t count);
   IMPLEMENT_FUNCTION_PROXIED(void, ReplayLog, uint32_t endEventID, ReplayLogType replayType);
 
   IMPLEMENT_FUNCTION_PROXIED(std::vector<uint32_t>, GetPassEvents, uint32_t eventId);
@@ -528,6 +537,11 @@ public:
   template <typename SerialiserType>
   void DeltaTransferBytes(SerialiserType &xferser, bytebuf &referenceData, bytebuf &newData);
 
+  // utility function to pass the contents of a byte array through shared memory, with only the
+  // size going through the serialiser. Only valid when m_SharedMemory is set and large enough.
+  template <typename SerialiserType>
+  void SharedTransferBytes(SerialiserType &xferser, bytebuf &data);
+
   void FileChanged() {}
   // will never be used
   ResourceId CreateProxyTexture(const TextureDescription &templateTex)
@@ -684,6 +698,9 @@ private:
 
   bool m_IsErrored = false;
 
+  // memory shared with the other side of a local connection for bulk data, or NULL
+  Network::SharedMemory *m_SharedMemory = NULL;
+
   FrameRecord m_FrameRecord;
   APIProperties m_APIProps;
   std::map<ResourceId, TextureDescription> m_TextureInfo;
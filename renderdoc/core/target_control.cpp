@@ -29,8 +29,9 @@
 #include "jpeg-compressor/jpgd.h"
 #include "os/os_specific.h"
 #include "serialise/serialiser.h"
+#include "strings/string_utils.h"
 
-static const uint32_t TargetControlProtocolVersion = 4;
+static const uint32_t TargetControlProtocolVersion = 5;
 
 static bool IsProtocolVersionSupported(const uint32_t protocolVersion)
 {
@@ -42,6 +43,10 @@ static bool IsProtocolVersionSupported(const uint32_t protocolVersion)
   if(protocolVersion == 3)
     return true;
 
+  // 4 -> 5 added streaming captures to the client while they're written
+  if(protocolVersion == 4)
+    return true;
+
   if(protocolVersion == TargetControlProtocolVersion)
     return true;
 
@@ -62,7 +67,11 @@ enum PacketType : uint32_t
   ePacket_NewChild,
   ePacket_CaptureProgress,
   ePacket_CycleActiveWindow,
-  ePacket_CapturableWindowCount
+  ePacket_CapturableWindowCount,
+  ePacket_StreamCaptures,
+  ePacket_CaptureStreamBegin,
+  ePacket_CaptureStreamData,
+  ePacket_CaptureStreamEnd,
 };
 
 DECLARE_REFLECTION_ENUM(PacketType);
@@ -85,6 +94,10 @@ std::string DoStringise(const PacketType &el)
     STRINGISE_ENUM_NAMED(ePacket_CaptureProgress, "Capture Progress");
     STRINGISE_ENUM_NAMED(ePacket_CycleActiveWindow, "Cycle Active Window");
     STRINGISE_ENUM_NAMED(ePacket_CapturableWindowCount, "Capturable Window Count");
+    STRINGISE_ENUM_NAMED(ePacket_StreamCaptures, "Stream Captures");
+    STRINGISE_ENUM_NAMED(ePacket_CaptureStreamBegin, "Capture Stream Begin");
+    STRINGISE_ENUM_NAMED(ePacket_CaptureStreamData, "Capture Stream Data");
+    STRINGISE_ENUM_NAMED(ePacket_CaptureStreamEnd, "Capture Stream End");
   }
   END_ENUM_STRINGISE();
 }
@@ -141,6 +154,10 @@ void RenderDoc::TargetControlClientThread(uint32_t version, Network::Socket *cli
   float prevCaptureProgress = captureProgress;
   uint32_t prevWindows = 0;
 
+  // captures which have been completely streamed to the client, and don't need to be kept
+  std::set<std::string> streamedPaths;
+  CaptureStreamPacket streamPacket;
+
   while(client)
   {
     if(RenderDoc::Inst().m_ControlClientThreadShutdown || (client && !client->Connected()))
@@ -159,6 +176,39 @@ void RenderDoc::TargetControlClientThread(uint32_t version, Network::Socket *cli
 
     uint32_t curWindows = RenderDoc::Inst().GetCapturableWindowCount();
 
+    // forward any captures being streamed. A stream ends before its capture is listed, so doing this
+    // after fetching the captures means the client always has the file before the new capture.
+    while(!writer.IsErrored() && RenderDoc::Inst().NextCaptureStreamPacket(streamPacket))
+    {
+      WRITE_DATA_SCOPE();
+
+      if(streamPacket.type == CaptureStreamPacket::Begin)
+      {
+        std::string path = FileIO::GetFullPathname(streamPacket.path);
+
+        SCOPED_SERIALISE_CHUNK(ePacket_CaptureStreamBegin);
+        SERIALISE_ELEMENT(streamPacket.streamId);
+        SERIALISE_ELEMENT(path);
+      }
+      else if(streamPacket.type == CaptureStreamPacket::Data)
+      {
+        SCOPED_SERIALISE_CHUNK(ePacket_CaptureStreamData);
+        SERIALISE_ELEMENT(streamPacket.streamId);
+        SERIALISE_ELEMENT(streamPacket.offset);
+        SERIALISE_ELEMENT(streamPacket.data);
+      }
+      else if(streamPacket.type == CaptureStreamPacket::End)
+      {
+        SCOPED_SERIALISE_CHUNK(ePacket_CaptureStreamEnd);
+        SERIALISE_ELEMENT(streamPacket.streamId);
+        SERIALISE_ELEMENT(streamPacket.offset);
+        SERIALISE_ELEMENT(streamPacket.success);
+
+        if(streamPacket.success)
+          streamedPaths.insert(streamPacket.path);
+      }
+    }
+
     if(curdrivers != drivers)
     {
       // find the first difference, either a new key or a key with a different value, and send it.
@@ -219,6 +269,10 @@ void RenderDoc::TargetControlClientThread(uint32_t version, Network::Socket *cli
         if(version >= 3)
           SERIALISE_ELEMENT(captures.back().driver);
       }
+
+      // the client already has a copy, so this can be deleted like a copied capture
+      if(streamedPaths.erase(captures.back().path))
+        RenderDoc::Inst().MarkCaptureRetrieved(idx);
     }
     else if(childprocs.size() != children.size())
     {
@@ -346,6 +400,17 @@ void RenderDoc::TargetControlClientThread(uint32_t version, Network::Socket *cli
       {
         RenderDoc::Inst().CycleActiveWindow();
       }
+      else if(type == ePacket_StreamCaptures)
+      {
+        bool enabled = false;
+
+        {
+          READ_DATA_SCOPE();
+          SERIALISE_ELEMENT(enabled);
+        }
+
+        RenderDoc::Inst().SetCaptureStreaming(enabled);
+      }
 
       reader.EndChunk();
 
@@ -356,6 +421,9 @@ void RenderDoc::TargetControlClientThread(uint32_t version, Network::Socket *cli
 
   RenderDoc::Inst().SetProgressCallback<CaptureProgress>(RENDERDOC_ProgressCallback());
 
+  // nothing to stream to any more, let capture writing carry on without us
+  RenderDoc::Inst().SetCaptureStreaming(false);
+
   // give up our connection
   {
     SCOPED_LOCK(RenderDoc::Inst().m_SingleClientLock);
@@ -365,7 +433,7 @@ void RenderDoc::TargetControlClientThread(uint32_t version, Network::Socket *cli
   Threading::ReleaseModuleExitThread();
 }
 
-void RenderDoc::TargetControlServerThread(Network::Socket *sock)
+void RenderDoc::TargetControlServerThread(Network::Socket *sock, Network::Socket *localSock)
 {
   Threading::KeepModuleAlive();
 
@@ -379,6 +447,10 @@ void RenderDoc::TargetControlServerThread(Network::Socket *sock)
   {
     Network::Socket *client = sock->AcceptClient(0);
 
+    // same-machine clients connect over the local transport if it's available
+    if(client == NULL && localSock)
+      client = localSock->AcceptClient(0);
+
     if(client == NULL)
     {
       if(!sock->Connected())
@@ -386,6 +458,7 @@ void RenderDoc::TargetControlServerThread(Network::Socket *sock)
         RDCERR("Error in accept - shutting down server");
 
         SAFE_DELETE(sock);
+        SAFE_DELETE(localSock);
         Threading::ReleaseModuleExitThread();
         return;
       }
@@ -483,6 +556,7 @@ void RenderDoc::TargetControlServerThread(Network::Socket *sock)
   clientThread = 0;
 
   SAFE_DELETE(sock);
+  SAFE_DELETE(localSock);
 
   Threading::ReleaseModuleExitThread();
 }
@@ -490,10 +564,12 @@ void RenderDoc::TargetControlServerThread(Network::Socket *sock)
 struct TargetControl : public ITargetControl
 {
 public:
-  TargetControl(Network::Socket *sock, std::string clientName, bool forceConnection)
+  TargetControl(Network::Socket *sock, std::string clientName, bool forceConnection,
+                bool sameMachine)
       : m_Socket(sock),
         reader(new StreamReader(sock, Ownership::Nothing), Ownership::Stream),
-        writer(new StreamWriter(sock, Ownership::Nothing), Ownership::Stream)
+        writer(new StreamWriter(sock, Ownership::Nothing), Ownership::Stream),
+        m_SameMachine(sameMachine)
   {
     std::vector<byte> payload;
 
@@ -565,7 +641,7 @@ public:
     }
   }
 
-  virtual ~TargetControl() {}
+  virtual ~TargetControl() { AbortCaptureStreams(); }
   bool Connected() { return m_Socket != NULL && m_Socket->Connected(); }
   void Shutdown()
   {
@@ -627,6 +703,34 @@ public:
       SAFE_DELETE(m_Socket);
   }
 
+  void SetCaptureStreaming(const char *localFolder)
+  {
+    // a target on this machine writes captures where we can already read them
+    if(m_SameMachine || m_Version < 5)
+      return;
+
+    std::string folder = localFolder ? localFolder : "";
+    bool enabled = !folder.empty();
+
+    {
+      WRITE_DATA_SCOPE();
+      SCOPED_SERIALISE_CHUNK(ePacket_StreamCaptures);
+
+      SERIALISE_ELEMENT(enabled);
+
+      if(ser.IsErrored())
+      {
+        SAFE_DELETE(m_Socket);
+        return;
+      }
+    }
+
+    m_StreamFolder = folder;
+
+    if(!enabled)
+      AbortCaptureStreams();
+  }
+
   void CycleActiveWindow()
   {
     if(m_Version < 4)
@@ -734,6 +838,14 @@ public:
       if(driver != RDCDriver::Unknown)
         msg.newCapture.api = ToStr(driver);
 
+      // if the capture was streamed to us, refer to our copy
+      auto streamed = m_StreamedCaptures.find(msg.newCapture.path);
+      if(streamed != m_StreamedCaptures.end())
+      {
+        msg.newCapture.path = streamed->second;
+        m_StreamedCaptures.erase(streamed);
+      }
+
       msg.newCapture.local = FileIO::exists(msg.newCapture.path.c_str());
 
       RDCLOG("Got a new capture: %d (time %llu) %d byte thumbnail", msg.newCapture.captureId,
@@ -825,6 +937,121 @@ public:
       reader.EndChunk();
       return msg;
     }
+    else if(type == ePacket_CaptureStreamBegin)
+    {
+      msg.type = TargetControlMessageType::Noop;
+
+      uint32_t streamId = 0;
+      std::string path;
+
+      {
+        READ_DATA_SCOPE();
+        SERIALISE_ELEMENT(streamId);
+        SERIALISE_ELEMENT(path);
+      }
+
+      reader.EndChunk();
+
+      // streaming may have been disabled while this was in flight
+      if(m_StreamFolder.empty())
+        return msg;
+
+      std::string name = removeFromEnd(basename(path), ".rdc");
+
+      // don't stomp on any other capture streamed into the same folder
+      std::string localpath = m_StreamFolder + "/" + name + ".rdc";
+      for(int altnum = 2; FileIO::exists(localpath.c_str()); altnum++)
+        localpath = StringFormat::Fmt("%s/%s_%d.rdc", m_StreamFolder.c_str(), name.c_str(), altnum);
+
+      CaptureStream &stream = m_CaptureStreams[streamId];
+      stream.remotePath = path;
+      stream.localPath = localpath;
+      stream.file = FileIO::fopen(localpath.c_str(), "wb");
+
+      if(stream.file == NULL)
+        RDCERR("Couldn't open %s to stream capture into, errno %d", localpath.c_str(), errno);
+
+      return msg;
+    }
+    else if(type == ePacket_CaptureStreamData)
+    {
+      msg.type = TargetControlMessageType::Noop;
+
+      uint32_t streamId = 0;
+      uint64_t offset = 0;
+      bytebuf data;
+
+      {
+        READ_DATA_SCOPE();
+        SERIALISE_ELEMENT(streamId);
+        SERIALISE_ELEMENT(offset);
+        SERIALISE_ELEMENT(data);
+      }
+
+      reader.EndChunk();
+
+      auto it = m_CaptureStreams.find(streamId);
+      if(it != m_CaptureStreams.end() && it->second.file)
+      {
+        FILE *f = it->second.file;
+
+        FileIO::fseek64(f, offset, SEEK_SET);
+        if(FileIO::fwrite(data.data(), 1, data.size(), f) != data.size())
+        {
+          RDCERR("Error writing streamed capture to %s, errno %d", it->second.localPath.c_str(),
+                 errno);
+          FileIO::fclose(f);
+          it->second.file = NULL;
+        }
+      }
+
+      return msg;
+    }
+    else if(type == ePacket_CaptureStreamEnd)
+    {
+      msg.type = TargetControlMessageType::Noop;
+
+      uint32_t streamId = 0;
+      uint64_t size = 0;
+      bool success = false;
+
+      {
+        READ_DATA_SCOPE();
+        SERIALISE_ELEMENT(streamId);
+        SERIALISE_ELEMENT(size);
+        SERIALISE_ELEMENT(success);
+      }
+
+      reader.EndChunk();
+
+      auto it = m_CaptureStreams.find(streamId);
+      if(it != m_CaptureStreams.end())
+      {
+        CaptureStream &stream = it->second;
+
+        if(stream.file && success)
+        {
+          // the file on the target may have been truncated after it was written
+          FileIO::ftruncateat(stream.file, size);
+          FileIO::fclose(stream.file);
+
+          RDCLOG("Streamed capture %s to %s", stream.remotePath.c_str(), stream.localPath.c_str());
+
+          m_StreamedCaptures[stream.remotePath] = stream.localPath;
+        }
+        else
+        {
+          // the capture will be listed as remote and can be copied as normal
+          if(stream.file)
+            FileIO::fclose(stream.file);
+          FileIO::Delete(stream.localPath.c_str());
+        }
+
+        m_CaptureStreams.erase(it);
+      }
+
+      return msg;
+    }
     else
     {
       RDCERR("Unexpected packed received: %d", type);
@@ -836,13 +1063,39 @@ public:
   }
 
 private:
+  void AbortCaptureStreams()
+  {
+    for(auto it = m_CaptureStreams.begin(); it != m_CaptureStreams.end(); ++it)
+    {
+      if(it->second.file)
+        FileIO::fclose(it->second.file);
+      FileIO::Delete(it->second.localPath.c_str());
+    }
+
+    m_CaptureStreams.clear();
+  }
+
   Network::Socket *m_Socket;
   WriteSerialiser writer;
   ReadSerialiser reader;
   std::string m_Target, m_API, m_BusyClient;
   uint32_t m_Version, m_PID;
+  bool m_SameMachine;
 
   std::map<uint32_t, std::string> m_CaptureCopies;
+
+  struct CaptureStream
+  {
+    std::string remotePath;
+    std::string localPath;
+    FILE *file = NULL;
+  };
+
+  // the folder streamed captures are written into, empty if streaming isn't enabled
+  std::string m_StreamFolder;
+  std::map<uint32_t, CaptureStream> m_CaptureStreams;
+  // captures that have finished streaming, from their path on the target to the local copy
+  std::map<std::string, std::string> m_StreamedCaptures;
 };
 
 extern "C" RENDERDOC_API ITargetControl *RENDERDOC_CC RENDERDOC_CreateTargetControl(
@@ -868,7 +1121,10 @@ extern "C" RENDERDOC_API ITargetControl *RENDERDOC_CC RENDERDOC_CreateTargetCont
   if(sock == NULL)
     return NULL;
 
-  TargetControl *remote = new TargetControl(sock, clientName, forceConnection != 0);
+  // an android device is reached through a forwarded port on localhost, but isn't this machine
+  bool sameMachine = !android && (s == "localhost" || s == "127.0.0.1");
+
+  TargetControl *remote = new TargetControl(sock, clientName, forceConnection != 0, sameMachine);
 
   if(remote->Connected())
     return remote;
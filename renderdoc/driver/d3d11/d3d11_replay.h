@@ -133,6 +133,13 @@ public:
   const D3D12Pipe::State *GetD3D12PipelineState() { return NULL; }
   const GLPipe::State *GetGLPipelineState() { return NULL; }
   const VKPipe::State *GetVulkanPipelineState() { return NULL; }
+  void SetLazyDescriptorThreshold(uint32_t maxElements) {}
+  rdcarray<VKPipe::BindingElement> GetVulkanDescriptorBindings(bool compute, uint32_t set,
+                                                               uint32_t binding,
+                                                               uint32_t firstElement, uint32_t count)
+  {
+    return rdcarray<VKPipe::BindingElement>();
+  }
   void FreeTargetResource(ResourceId id);
   void FreeCustomShader(ResourceId id);
 
@@ -397,7 +397,7 @@ bool WrappedOpenGL::Serialise_glShaderSource(SerialiserType &ser, GLuint shaderH
     {
       GL.glDeleteProgram(m_Shaders[liveId].prog);
       m_Shaders[liveId].prog = 0;
-      m_Shaders[liveId].spirv = SPVModule();
+      m_Shaders[liveId].spirv.Clear();
       m_Shaders[liveId].reflection = ShaderReflection();
     }
 
@@ -26,6 +26,7 @@
 #include "common/common.h"
 #include "maths/formatpacking.h"
 #include "replay/replay_driver.h"
+#include "serialise/serialiser.h"
 
 #undef min
 #undef max
@@ -261,3 +262,24 @@ const char *glslangGetProgramResourceName(glslang::TProgram *program,
 
   return fetchedName;
 }
+
+template <typename SerialiserType>
+void DoSerialise(SerialiserType &ser, SPIRVPatchData::InterfaceAccess &el)
+{
+  SERIALISE_MEMBER(ID);
+  SERIALISE_MEMBER(structID);
+  SERIALISE_MEMBER(accessChain);
+  SERIALISE_MEMBER(isMatrix);
+}
+
+INSTANTIATE_SERIALISE_TYPE(SPIRVPatchData::InterfaceAccess);
+
+template <typename SerialiserType>
+void DoSerialise(SerialiserType &ser, SPIRVPatchData &el)
+{
+  SERIALISE_MEMBER(inputs);
+  SERIALISE_MEMBER(outputs);
+  SERIALISE_MEMBER(outTopo);
+}
+
+INSTANTIATE_SERIALISE_TYPE(SPIRVPatchData);
@@ -31,6 +31,7 @@
 #include "3rdparty/glslang/SPIRV/spirv.hpp"
 #include "3rdparty/glslang/glslang/Include/ResourceLimits.h"
 #include "api/replay/renderdoc_replay.h"
+#include "common/threading.h"
 
 using std::string;
 using std::vector;
@@ -105,19 +106,38 @@ struct SPIRVPatchData
   Topology outTopo = Topology::Unknown;
 };
 
+DECLARE_REFLECTION_STRUCT(SPIRVPatchData::InterfaceAccess);
+DECLARE_REFLECTION_STRUCT(SPIRVPatchData);
+
 struct SPVModule
 {
   SPVModule();
   ~SPVModule();
 
+  // modules own their instructions, so can't be copied. Use Clear() to reset one.
+  SPVModule(const SPVModule &) = delete;
+  SPVModule &operator=(const SPVModule &) = delete;
+  void Clear();
+
   vector<uint32_t> spirv;
 
+  // read directly from the words by InitSPIRV, so available without a full parse
+  struct FlatEntryPoint
+  {
+    std::string name;
+    spv::ExecutionModel model;
+    uint32_t func;
+  };
+  vector<FlatEntryPoint> flatEntries;
+
   struct
   {
     uint8_t major, minor;
   } moduleVersion;
   uint32_t generator;
 
+  // everything from here down to structs is only filled out once EnsureParsed() is called, and
+  // is cleared again by ReleaseParse().
   spv::SourceLanguage sourceLang;
   uint32_t sourceVer;
 
@@ -140,19 +160,37 @@ struct SPVModule
   vector<SPVInstruction *> funcs;            // functions
   vector<SPVInstruction *> structs;          // struct types
 
+  // builds the full instruction graph from the words if it hasn't been already. This is done
+  // automatically by disassembly and reflection, and is safe to call from multiple threads.
+  void EnsureParsed() const;
+  // frees the instruction graph, keeping the words and entry points. It's rebuilt if it's needed
+  // again. Any instruction pointers from the module are invalid afterwards.
+  void ReleaseParse() const;
+
   SPVInstruction *GetByID(uint32_t id);
   string Disassemble(const string &entryPoint);
 
   std::vector<std::string> EntryPoints() const;
   ShaderStage StageForEntry(const string &entryPoint) const;
 
+  // not safe to call concurrently on the same module, since type names are generated lazily
   void MakeReflection(GraphicsAPI sourceAPI, ShaderStage stage, const string &entryPoint,
                       ShaderReflection &reflection, ShaderBindpointMapping &mapping,
                       SPIRVPatchData &patchData) const;
+
+private:
+  void ClearParsed();
+
+  mutable Threading::CriticalSection parseLock;
+  mutable bool parsed = false;
 };
 
 string CompileSPIRV(const SPIRVCompilationSettings &settings, const vector<string> &sources,
                     vector<uint32_t> &spirv);
+// reads the module header and entry points, but defers parsing the instructions until they're
+// needed.
+void InitSPIRV(const uint32_t *spirv, size_t spirvLength, SPVModule &module);
+// InitSPIRV followed by a full parse of the instructions.
 void ParseSPIRV(uint32_t *spirv, size_t spirvLength, SPVModule &module);
 
 static const uint32_t SpecializationConstantBindSet = 1234567;
@@ -2205,10 +2205,45 @@ SPVModule::SPVModule()
 }
 
 SPVModule::~SPVModule()
+{
+  Clear();
+}
+
+void SPVModule::Clear()
+{
+  SCOPED_LOCK(parseLock);
+
+  spirv.clear();
+  flatEntries.clear();
+  moduleVersion.major = moduleVersion.minor = 0;
+  generator = 0;
+
+  ClearParsed();
+}
+
+void SPVModule::ClearParsed()
 {
   for(size_t i = 0; i < operations.size(); i++)
     delete operations[i];
-  operations.clear();
+
+  // swap rather than clear, so the storage for the larger arrays is actually freed
+  vector<SPVInstruction *>().swap(operations);
+  vector<SPVInstruction *>().swap(ids);
+
+  sourceLang = spv::SourceLanguageUnknown;
+  sourceVer = 0;
+  cmdline.clear();
+  sourceFiles.clear();
+  extensions.clear();
+  capabilities.clear();
+  sourceexts.clear();
+  entries.clear();
+  globals.clear();
+  specConstants.clear();
+  funcs.clear();
+  structs.clear();
+
+  parsed = false;
 }
 
 SPVInstruction *SPVModule::GetByID(uint32_t id)
@@ -2256,6 +2291,8 @@ void FindFirstInstructionUse(SPVInstruction *op, SPVInstruction *search, SPVInst
 
 string SPVModule::Disassemble(const string &entryPoint)
 {
+  EnsureParsed();
+
   string retDisasm = "";
 
   // TODO filter to only functions/resources used by entryPoint
@@ -4031,20 +4068,19 @@ std::vector<std::string> SPVModule::EntryPoints() const
 {
   std::vector<std::string> ret;
 
-  for(SPVInstruction *inst : entries)
-    if(inst->entry)
-      ret.push_back(inst->entry->name);
+  for(const FlatEntryPoint &entry : flatEntries)
+    ret.push_back(entry.name);
 
   return ret;
 }
 
 ShaderStage SPVModule::StageForEntry(const string &entryPoint) const
 {
-  for(SPVInstruction *inst : entries)
+  for(const FlatEntryPoint &entry : flatEntries)
   {
-    if(inst->entry && inst->entry->name == entryPoint)
+    if(entry.name == entryPoint)
     {
-      switch(inst->entry->model)
+      switch(entry.model)
       {
         case spv::ExecutionModelVertex: return ShaderStage::Vertex;
         case spv::ExecutionModelTessellationControl: return ShaderStage::Tess_Control;
@@ -4065,6 +4101,8 @@ void SPVModule::MakeReflection(GraphicsAPI sourceAPI, ShaderStage stage, const s
                                ShaderReflection &reflection, ShaderBindpointMapping &mapping,
                                SPIRVPatchData &patchData) const
 {
+  EnsureParsed();
+
   vector<SigParameter> inputs;
   vector<SigParameter> outputs;
   vector<cblockpair> cblocks;
@@ -4815,11 +4853,15 @@ void SPVModule::MakeReflection(GraphicsAPI sourceAPI, ShaderStage stage, const s
   }
 }
 
-void ParseSPIRV(uint32_t *spirv, size_t spirvLength, SPVModule &module)
+static void ParseSPIRVInstructions(SPVModule &module);
+
+void InitSPIRV(const uint32_t *spirv, size_t spirvLength, SPVModule &module)
 {
-  if(spirv[0] != (uint32_t)spv::MagicNumber)
+  module.Clear();
+
+  if(spirvLength < 5 || spirv[0] != (uint32_t)spv::MagicNumber)
   {
-    RDCERR("Unrecognised SPIR-V magic number %08x", spirv[0]);
+    RDCERR("Unrecognised SPIR-V magic number %08x", spirvLength > 0 ? spirv[0] : 0);
     return;
   }
 
@@ -4840,6 +4882,77 @@ void ParseSPIRV(uint32_t *spirv, size_t spirvLength, SPVModule &module)
 
   module.generator = spirv[2];
 
+  // walk the words once to find the entry points, without allocating anything per instruction.
+  // Entry points are declared before any types or functions, so we can stop at the first of those.
+  size_t it = 5;
+  while(it < spirvLength)
+  {
+    uint16_t WordCount = spirv[it] >> spv::WordCountShift;
+    spv::Op opcode = spv::Op(spirv[it] & spv::OpCodeMask);
+
+    if(WordCount == 0 || it + WordCount > spirvLength)
+    {
+      RDCERR("Malformed SPIR-V instruction at word %zu", it);
+      break;
+    }
+
+    if(opcode == spv::OpEntryPoint && WordCount > 3)
+    {
+      SPVModule::FlatEntryPoint entry;
+      entry.model = spv::ExecutionModel(spirv[it + 1]);
+      entry.func = spirv[it + 2];
+
+      // the name is a nul-terminated literal string, but don't trust it to be terminated
+      const char *name = (const char *)&spirv[it + 3];
+      entry.name.assign(name, strnlen(name, (WordCount - 3) * sizeof(uint32_t)));
+
+      module.flatEntries.push_back(entry);
+    }
+    else if(opcode == spv::OpFunction || opcode == spv::OpTypeVoid ||
+            opcode == spv::OpTypeFunction)
+    {
+      break;
+    }
+
+    it += WordCount;
+  }
+}
+
+void ParseSPIRV(uint32_t *spirv, size_t spirvLength, SPVModule &module)
+{
+  InitSPIRV(spirv, spirvLength, module);
+  module.EnsureParsed();
+}
+
+void SPVModule::EnsureParsed() const
+{
+  SCOPED_LOCK(parseLock);
+
+  if(parsed || spirv.empty())
+    return;
+
+  parsed = true;
+
+  // the instruction graph is a cache of what's in the words, so it's safe to build from a const
+  // module as long as it's under the lock.
+  ParseSPIRVInstructions(const_cast<SPVModule &>(*this));
+}
+
+void SPVModule::ReleaseParse() const
+{
+  SCOPED_LOCK(parseLock);
+
+  if(!parsed)
+    return;
+
+  const_cast<SPVModule &>(*this).ClearParsed();
+}
+
+static void ParseSPIRVInstructions(SPVModule &module)
+{
+  const uint32_t *spirv = module.spirv.data();
+  const size_t spirvLength = module.spirv.size();
+
   bool isglslang = false;
 
   {
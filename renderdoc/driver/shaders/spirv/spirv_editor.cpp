@@ -1062,4 +1062,82 @@ void main() {
   }
 }
 
+TEST_CASE("Test SPIR-V module parse can be released and rebuilt", "[spirv]")
+{
+  InitSPIRVCompiler();
+  RenderDoc::Inst().RegisterShutdownFunction(&ShutdownSPIRVCompiler);
+
+  SPIRVCompilationSettings settings;
+  settings.entryPoint = "main";
+  settings.lang = SPIRVSourceLanguage::VulkanGLSL;
+  settings.stage = SPIRVShaderStage::Fragment;
+
+  std::vector<std::string> sources = {
+      R"(#version 450 core
+
+layout(binding = 0) uniform block {
+	vec4 tint;
+	float scale;
+};
+
+layout(binding = 1) uniform sampler2D tex;
+
+layout(location = 0) in vec2 uv;
+layout(location = 0) out vec4 col;
+
+void main() {
+  col = texture(tex, uv * scale) * tint;
+}
+)",
+  };
+
+  std::vector<uint32_t> spirv;
+  std::string errors = CompileSPIRV(settings, sources, spirv);
+
+  INFO("SPIR-V compilation" << errors);
+
+  REQUIRE(spirv.size() > 0);
+
+  SPVModule module;
+  InitSPIRV(spirv.data(), spirv.size(), module);
+
+  // entry points are available without parsing
+  CHECK(module.operations.empty());
+  CHECK(module.EntryPoints() == std::vector<std::string>({"main"}));
+
+  ShaderReflection refl;
+  ShaderBindpointMapping mapping;
+  SPIRVPatchData patchData;
+  module.MakeReflection(GraphicsAPI::Vulkan, ShaderStage::Pixel, "main", refl, mapping, patchData);
+
+  std::string disasm = module.Disassemble("main");
+
+  CHECK_FALSE(module.operations.empty());
+
+  module.ReleaseParse();
+
+  CHECK(module.operations.empty());
+  CHECK(module.ids.empty());
+  CHECK(module.EntryPoints() == std::vector<std::string>({"main"}));
+
+  // reflecting and disassembling again parses the module again, with the same results
+  ShaderReflection refl2;
+  ShaderBindpointMapping mapping2;
+  SPIRVPatchData patchData2;
+  module.MakeReflection(GraphicsAPI::Vulkan, ShaderStage::Pixel, "main", refl2, mapping2,
+                        patchData2);
+
+  CHECK(module.Disassemble("main") == disasm);
+
+  REQUIRE(refl2.constantBlocks.size() == refl.constantBlocks.size());
+  REQUIRE(refl2.constantBlocks.size() == 1);
+  CHECK(refl2.constantBlocks[0].name == refl.constantBlocks[0].name);
+  CHECK(refl2.constantBlocks[0].variables.size() == 2);
+  CHECK(refl2.constantBlocks[0].variables[0].name == refl.constantBlocks[0].variables[0].name);
+  CHECK(refl2.readOnlyResources.size() == refl.readOnlyResources.size());
+  CHECK(refl2.inputSignature.size() == refl.inputSignature.size());
+  CHECK(refl2.outputSignature.size() == refl.outputSignature.size());
+  CHECK(patchData2.outputs.size() == patchData.outputs.size());
+}
+
 #endif
\ No newline at end of file
@@ -267,6 +267,11 @@ bool VkInitParams::IsSupportedVersion(uint64_t ver)
   if(ver == CurrentVersion)
     return true;
 
+  // 0xF -> 0x10 - large byte buffers can be references into a blob store section. Only used when
+  // a capture has a blob store, otherwise it's identical to 0xF
+  if(ver == BlobStoreVersion)
+    return true;
+
   // 0xE -> 0xF - serialisation of VkPhysicalDeviceVulkanMemoryModelFeaturesKHR changed in vulkan
   // 1.1.99, adding a new field
   if(ver == 0xE)
@@ -315,6 +315,7 @@ enum class MemoryScope : uint8_t
   InitialContents,
   First = InitialContents,
   IndirectReadback,
+  PostVSCache,
   Count,
 };
 
@@ -339,6 +340,73 @@ struct MemoryAllocation
   MemoryType type = MemoryType::GPULocal;
   uint32_t memoryTypeIndex = 0;
   bool buffer = false;
+
+  // the pool in the scope and the range within that pool's allocator, used to free the allocation.
+  uint32_t pool = ~0U;
+  uint32_t range = ~0U;
+};
+
+// Two-level segregated fit allocator handing out ranges from a set of blocks. Free ranges are
+// bucketed first by power of two and then linearly within that power of two, with bitmasks of which
+// buckets are non-empty, so both allocating and freeing are O(1) regardless of how many ranges or
+// blocks there are. Freed ranges are merged with free neighbours in the same block immediately.
+class TLSFAllocator
+{
+public:
+  TLSFAllocator();
+
+  // adds a new block of the given size, returning its index
+  uint32_t AddBlock(VkDeviceSize size);
+
+  // returns the range index of a new allocation, or ~0U if there's no free range large enough. The
+  // block and offset of the allocation are returned in the out parameters.
+  uint32_t Allocate(VkDeviceSize size, VkDeviceSize alignment, uint32_t &block, VkDeviceSize &offs);
+
+  // frees a range returned from Allocate. Returns false if the range isn't allocated, or isn't at
+  // the given offset.
+  bool Free(uint32_t range, VkDeviceSize offs);
+
+  // returns the block an allocated range is in, or ~0U if the range isn't allocated.
+  uint32_t GetRangeBlock(uint32_t range) const;
+
+  uint32_t GetBlockCount() const { return m_BlockCount; }
+  VkDeviceSize GetAllocatedBytes() const { return m_AllocatedBytes; }
+
+private:
+  static const uint32_t SecondLevelBits = 4;
+  static const uint32_t SecondLevelCount = 1 << SecondLevelBits;
+  static const uint32_t FirstLevelCount = 64 - SecondLevelBits + 1;
+  static const uint32_t InvalidRange = ~0U;
+
+  struct Range
+  {
+    VkDeviceSize offs;
+    VkDeviceSize size;
+    uint32_t block;
+    bool free;
+    // neighbouring ranges in the same block, by address
+    uint32_t prevPhys, nextPhys;
+    // neighbouring ranges in the same free list bucket
+    uint32_t prevFree, nextFree;
+  };
+
+  static void GetBucket(VkDeviceSize size, uint32_t &fl, uint32_t &sl);
+  uint32_t FindFree(VkDeviceSize size);
+  bool Fits(uint32_t r, VkDeviceSize size, VkDeviceSize alignment) const;
+  uint32_t NewRange();
+  void ReleaseRange(uint32_t r);
+  void InsertFree(uint32_t r);
+  void RemoveFree(uint32_t r);
+
+  std::vector<Range> m_Ranges;
+  std::vector<uint32_t> m_UnusedRanges;
+
+  uint64_t m_FirstLevelMask = 0;
+  uint32_t m_SecondLevelMask[FirstLevelCount] = {};
+  uint32_t m_FreeHeads[FirstLevelCount][SecondLevelCount];
+
+  uint32_t m_BlockCount = 0;
+  VkDeviceSize m_AllocatedBytes = 0;
 };
 
 #define IMPLEMENT_FUNCTION_SERIALISED(ret, func, ...) \
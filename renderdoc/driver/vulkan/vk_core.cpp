@@ -1646,31 +1646,48 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
     }
   }
 
-  RDCFile *rdc =
-      RenderDoc::Inst().CreateRDC(RDCDriver::Vulkan, m_CapturedFrames.back().frameNumber, fp);
+  SectionProperties props;
 
-  StreamWriter *captureWriter = NULL;
+  // Compress with LZ4 so that it's fast
+  props.flags = SectionFlags::LZ4Compressed;
+  props.version = m_SectionVersion;
+  props.type = SectionType::FrameCapture;
 
-  if(rdc)
-  {
-    SectionProperties props;
+  const bool background = RenderDoc::Inst().IsBackgroundCaptureWriting();
 
-    // Compress with LZ4 so that it's fast
-    props.flags = SectionFlags::LZ4Compressed;
-    props.version = m_SectionVersion;
-    props.type = SectionType::FrameCapture;
+  RDCFile *rdc = NULL;
+  StreamWriter *captureWriter = NULL;
 
-    captureWriter = rdc->WriteSection(props);
+  if(background)
+  {
+    // serialise into memory, the file is created and written on the background writer thread
+    captureWriter = new StreamWriter(StreamWriter::DefaultScratchSize);
   }
   else
   {
-    captureWriter = new StreamWriter(StreamWriter::InvalidStream);
+    rdc = RenderDoc::Inst().CreateRDC(RDCDriver::Vulkan, m_CapturedFrames.back().frameNumber, fp);
+
+    if(rdc)
+      captureWriter = rdc->WriteSection(props);
+    else
+      captureWriter = new StreamWriter(StreamWriter::InvalidStream);
   }
 
+  // large buffers serialised here - mostly initial contents - are stored once by content and
+  // written to their own section after the frame capture.
+  BlobStore *blobs = new BlobStore;
+
+  // when writing directly to the file, keeping a copy of every unique buffer until the section can
+  // be written would double the memory those buffers use. Spill them to disk instead. Background
+  // writes keep the whole frame in memory regardless, and the copies replace the buffers there.
+  if(!background)
+    blobs->SpillToDisk();
+
   {
-    WriteSerialiser ser(captureWriter, Ownership::Stream);
+    WriteSerialiser ser(captureWriter, background ? Ownership::Nothing : Ownership::Stream);
 
     ser.SetChunkMetadataRecording(GetThreadSerialiser().GetChunkMetadataRecording());
+    ser.SetBlobStore(blobs);
 
     ser.SetUserData(GetResourceManager());
 
@@ -1684,29 +1701,17 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
 
     GetResourceManager()->InsertReferencedChunks(ser);
 
-    GetResourceManager()->InsertInitialContentsChunks(ser);
-
-    RDCDEBUG("Creating Capture Scope");
-
-    GetResourceManager()->Serialise_InitialContentsNeeded(ser);
-
-    {
-      SCOPED_SERIALISE_CHUNK(SystemChunk::CaptureScope, 16);
-
-      Serialise_CaptureScope(ser);
-    }
-
-    m_HeaderChunk->Write(ser);
-
     // don't need to lock access to m_CmdBufferRecords as we are no longer
     // in capframe (the transition is thread-protected) so nothing will be
     // pushed to the vector
 
-    {
-      RDCDEBUG("Flushing %u command buffer records to file serialiser",
-               (uint32_t)m_CmdBufferRecords.size());
+    std::map<int32_t, Chunk *> recordlist;
 
-      std::map<int32_t, Chunk *> recordlist;
+    // merge the frame's chunks from every command buffer record on a worker thread while the
+    // initial contents are serialised. This has to start after the referenced chunks are inserted,
+    // since Insert() skips any parent record that has already been written.
+    auto mergeRecords = [this, &recordlist]() {
+      RDCDEBUG("Merging %u command buffer records", (uint32_t)m_CmdBufferRecords.size());
 
       // ensure all command buffer records within the frame evne if recorded before, but
       // otherwise order must be preserved (vs. queue submits and desc set updates)
@@ -1719,6 +1724,34 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
       }
 
       m_FrameCaptureRecord->Insert(recordlist);
+    };
+
+    Threading::ThreadHandle mergeThread = Threading::CreateThread(mergeRecords);
+
+    // if no thread could be created, merge here instead
+    if(mergeThread == 0)
+      mergeRecords();
+
+    GetResourceManager()->InsertInitialContentsChunks(ser);
+
+    RDCDEBUG("Creating Capture Scope");
+
+    GetResourceManager()->Serialise_InitialContentsNeeded(ser);
+
+    {
+      SCOPED_SERIALISE_CHUNK(SystemChunk::CaptureScope, 16);
+
+      Serialise_CaptureScope(ser);
+    }
+
+    m_HeaderChunk->Write(ser);
+
+    {
+      if(mergeThread)
+      {
+        Threading::JoinThread(mergeThread);
+        Threading::CloseThread(mergeThread);
+      }
 
       RDCDEBUG("Flushing %u chunks to file serialiser from context record",
                (uint32_t)recordlist.size());
@@ -1737,7 +1770,22 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
     }
   }
 
-  RenderDoc::Inst().FinishCaptureWriting(rdc, m_CapturedFrames.back().frameNumber);
+  uint32_t frameNumber = m_CapturedFrames.back().frameNumber;
+
+  if(background)
+  {
+    RenderDoc::Inst().QueueCaptureWriting(RDCDriver::Vulkan, frameNumber, fp, captureWriter, blobs,
+                                          VkInitParams::BlobStoreVersion, props);
+  }
+  else
+  {
+    if(rdc)
+      rdc->WriteBlobStore(*blobs, VkInitParams::BlobStoreVersion);
+
+    SAFE_DELETE(blobs);
+
+    RenderDoc::Inst().FinishCaptureWriting(rdc, frameNumber);
+  }
 
   SAFE_DELETE(m_HeaderChunk);
 
@@ -1918,6 +1966,13 @@ ReplayStatus WrappedVulkan::ReadLogInitialisation(RDCFile *rdc, bool storeStruct
 
   uint64_t frameDataSize = 0;
 
+  // shader reflection is queued up while the pipelines are created, and done in parallel before
+  // anything is replayed. Results from previous loads are used where possible.
+  m_CreationInfo.m_DeferReflection = true;
+
+  if(!IsStructuredExporting(m_State))
+    m_CreationInfo.m_ReflectionCache.Load();
+
   for(;;)
   {
     PerformanceTimer timer;
@@ -1962,6 +2017,8 @@ ReplayStatus WrappedVulkan::ReadLogInitialisation(RDCFile *rdc, bool storeStruct
 
       m_FrameReader = new StreamReader(reader, frameDataSize);
 
+      m_CreationInfo.FlushPendingReflections();
+
       ReplayStatus status = ContextReplayLog(m_State, 0, 0, false);
 
       if(status != ReplayStatus::Succeeded)
@@ -1976,6 +2033,8 @@ ReplayStatus WrappedVulkan::ReadLogInitialisation(RDCFile *rdc, bool storeStruct
       break;
   }
 
+  m_CreationInfo.FlushPendingReflections();
+
 #if ENABLED(RDOC_DEVEL)
   for(auto it = chunkInfos.begin(); it != chunkInfos.end(); ++it)
   {
@@ -2884,8 +2943,80 @@ void WrappedVulkan::AddFrameTerminator(uint64_t queueMarkerTag)
   SubmitCmds();
 }
 
+bool WrappedVulkan::CanReplayForward(uint32_t fromEventID, uint32_t toEventID)
+{
+  if(toEventID <= fromEventID)
+    return false;
+
+  // both events must be in the primary command buffer that's currently partially replayed, and we
+  // don't handle being part-way through a secondary.
+  ResourceId partialParent = m_Partial[Primary].partialParent;
+
+  if(partialParent == ResourceId() || m_Partial[Secondary].partialParent != ResourceId())
+    return false;
+
+  const uint32_t baseEvent = m_Partial[Primary].baseEvent;
+
+  if(fromEventID < baseEvent || toEventID >= baseEvent + m_BakedCmdBufferInfo[partialParent].eventCount)
+    return false;
+
+  // transform feedback and conditional rendering are ended at the end of each partial replay, so
+  // they can't be carried on from one replay to the next.
+  if(!m_RenderState.xfbcounters.empty() || m_RenderState.IsConditionalRenderingEnabled())
+    return false;
+
+  // the partial replay restores whether a render pass is active when it finishes, and can't enter
+  // secondary command buffers, so none of the events we've already replayed or are about to replay
+  // can change either.
+  auto it = std::lower_bound(m_Events.begin(), m_Events.end(), APIEvent(),
+                             [fromEventID](const APIEvent &a, const APIEvent &) {
+                               return a.eventId < fromEventID;
+                             });
+
+  for(; it != m_Events.end() && it->eventId < toEventID; ++it)
+  {
+    if(it->chunkIndex >= m_StructuredFile->chunks.size())
+      return false;
+
+    switch((VulkanChunk)m_StructuredFile->chunks[it->chunkIndex]->metadata.chunkID)
+    {
+      case VulkanChunk::vkCmdBeginRenderPass:
+      case VulkanChunk::vkCmdNextSubpass:
+      case VulkanChunk::vkCmdEndRenderPass:
+      case VulkanChunk::vkCmdBeginRenderPass2KHR:
+      case VulkanChunk::vkCmdNextSubpass2KHR:
+      case VulkanChunk::vkCmdEndRenderPass2KHR:
+      case VulkanChunk::vkCmdExecuteCommands:
+      case VulkanChunk::vkCmdBeginTransformFeedbackEXT:
+      case VulkanChunk::vkCmdBeginConditionalRenderingEXT: return false;
+      default: break;
+    }
+  }
+
+  return true;
+}
+
 void WrappedVulkan::ReplayLog(uint32_t startEventID, uint32_t endEventID, ReplayLogType replayType)
 {
+  const bool fromStart = (startEventID == 0);
+
+  // any replay invalidates where we think the live state is, until we know otherwise below
+  const uint32_t replayedWithoutDraw = m_ReplayedWithoutDraw;
+  const uint32_t replayedEventID = m_ReplayedEventID;
+  ResetReplayPosition();
+
+  // if we're stepping forward from an event we've already replayed to, and nothing has touched the
+  // live state since, we only need to replay the events in between rather than the whole frame.
+  if(fromStart && replayType == eReplay_WithoutDraw && replayedEventID > 0 &&
+     CanReplayForward(replayedEventID, endEventID))
+  {
+    if(endEventID > replayedEventID + 1)
+      ReplayLog(replayedEventID + 1, endEventID, eReplay_WithoutDraw);
+
+    m_ReplayedWithoutDraw = endEventID;
+    return;
+  }
+
   bool partial = true;
 
   if(startEventID == 0 && (replayType == eReplay_WithoutDraw || replayType == eReplay_Full))
@@ -3034,6 +3165,11 @@ void WrappedVulkan::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
   }
 
   VkMarkerRegion::Set("!!!!RenderDoc Internal: Done replay");
+
+  if(fromStart && replayType == eReplay_WithoutDraw)
+    m_ReplayedWithoutDraw = endEventID;
+  else if(fromStart && replayType == eReplay_OnlyDraw && replayedWithoutDraw == endEventID)
+    m_ReplayedEventID = endEventID;
 }
 
 template <typename SerialiserType>
@@ -56,6 +56,9 @@ struct VkInitParams
 
   // check if a frame capture section version is supported
   static const uint64_t CurrentVersion = 0xF;
+  // captures that store large buffers in a blob store section are marked with this version, so
+  // that builds which can't resolve the references reject them.
+  static const uint64_t BlobStoreVersion = 0x10;
   static bool IsSupportedVersion(uint64_t ver);
 };
 
@@ -477,10 +480,21 @@ private:
 
   // Internal lumped/pooled memory allocations
 
-  // Each memory scope gets a separate vector of allocation objects. The vector contains the list of
-  // all 'base' allocations. The offset is used to indicate the current offset, and the size is the
-  // total size, thus the free space can be determined with size - offset.
-  std::vector<MemoryAllocation> m_MemoryBlocks[arraydim<MemoryScope>()];
+  // Each memory scope gets a separate list of pools. A pool holds all the memory blocks for one
+  // combination of memory type and buffer/image, so that we never need to worry about
+  // bufferImageGranularity between neighbouring sub-allocations. Ranges within the pool's blocks
+  // are handed out and recycled by its allocator.
+  struct MemoryPool
+  {
+    MemoryType type;
+    uint32_t memoryTypeIndex;
+    bool buffer;
+
+    // indexed by the block index from the allocator
+    std::vector<VkDeviceMemory> blocks;
+    TLSFAllocator ranges;
+  };
+  std::vector<MemoryPool> m_MemoryPools[arraydim<MemoryScope>()];
 
   // Per memory scope, the size of the next allocation. This allows us to balance number of memory
   // allocation objects with size by incrementally allocating larger blocks.
@@ -660,6 +674,16 @@ private:
   // so we just set this command buffer
   VkCommandBuffer m_OutsideCmdBuffer = VK_NULL_HANDLE;
 
+  // tracks where the last replay left the live state, so that stepping forward a few events
+  // within the same command buffer can replay just the events in between instead of going back to
+  // the start of the frame. m_ReplayedWithoutDraw is the event that a replay from the start up to
+  // (but not including) was last done, and m_ReplayedEventID is set once that event itself has been
+  // replayed with nothing else in between. Any other replay resets both to 0.
+  uint32_t m_ReplayedWithoutDraw = 0;
+  uint32_t m_ReplayedEventID = 0;
+
+  bool CanReplayForward(uint32_t fromEventID, uint32_t toEventID);
+
   // stores the currently re-recording command buffer for any original command buffer ID (not bake
   // ID). This allows a quick check to see if an original command should be recorded, and also to
   // fetch the command buffer to record into.
@@ -689,6 +713,9 @@ private:
     ResourceId layout;
     vector<DescriptorSetSlot *> currentBindings;
     bool push;
+    // incremented whenever currentBindings changes, so that anything derived from the contents can
+    // tell if it's still up to date.
+    uint64_t version = 0;
 
     void clear()
     {
@@ -904,6 +931,9 @@ public:
   }
   void Shutdown();
   void ReplayLog(uint32_t startEventID, uint32_t endEventID, ReplayLogType replayType);
+  // forget where the last replay left the live state, so the next replay starts from the beginning
+  // of the frame. Needed whenever something changes the live state outside of ReplayLog.
+  void ResetReplayPosition() { m_ReplayedWithoutDraw = m_ReplayedEventID = 0; }
   ReplayStatus ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers);
 
   SDFile &GetStructuredFile() { return *m_StructuredFile; }
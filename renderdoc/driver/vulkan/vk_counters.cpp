@@ -199,11 +199,125 @@ CounterDescription VulkanReplay::DescribeCounter(GPUCounter counterID)
   return desc;
 }
 
+// the pipeline statistics we query, in the order they're returned
+static const VkQueryPipelineStatisticFlags pipeStatsFlags =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_CONTROL_SHADER_PATCHES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+static const uint32_t pipeStatsCount = 11;
+
+void VulkanReplay::CounterQueries::Destroy(WrappedVulkan *driver)
+{
+  VkDevice dev = driver->GetDev();
+
+  if(timeStamp != VK_NULL_HANDLE)
+    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), timeStamp, NULL);
+  if(occlusion != VK_NULL_HANDLE)
+    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), occlusion, NULL);
+  if(pipeStats != VK_NULL_HANDLE)
+    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), pipeStats, NULL);
+
+  timeStamp = occlusion = pipeStats = VK_NULL_HANDLE;
+  size = 0;
+}
+
+struct VulkanGPUTimerCallback : public VulkanDrawcallCallback
+{
+  // if chained is true, another callback is registered and will forward to this one
+  VulkanGPUTimerCallback(WrappedVulkan *vk, VulkanReplay *rp, VkQueryPool tsqp, VkQueryPool occqp,
+                         VkQueryPool psqp, bool chained = false)
+      : m_pDriver(vk),
+        m_pReplay(rp),
+        m_TimeStampQueryPool(tsqp),
+        m_OcclusionQueryPool(occqp),
+        m_PipeStatsQueryPool(psqp),
+        m_Chained(chained)
+  {
+    if(!m_Chained)
+      m_pDriver->SetDrawcallCB(this);
+  }
+  ~VulkanGPUTimerCallback()
+  {
+    if(!m_Chained)
+      m_pDriver->SetDrawcallCB(NULL);
+  }
+  void PreDraw(uint32_t eid, VkCommandBuffer cmd) override
+  {
+    if(m_OcclusionQueryPool != VK_NULL_HANDLE)
+      ObjDisp(cmd)->CmdBeginQuery(Unwrap(cmd), m_OcclusionQueryPool, (uint32_t)m_Results.size(),
+                                  VK_QUERY_CONTROL_PRECISE_BIT);
+    if(m_PipeStatsQueryPool != VK_NULL_HANDLE)
+      ObjDisp(cmd)->CmdBeginQuery(Unwrap(cmd), m_PipeStatsQueryPool, (uint32_t)m_Results.size(), 0);
+    if(m_TimeStampQueryPool != VK_NULL_HANDLE)
+      ObjDisp(cmd)->CmdWriteTimestamp(Unwrap(cmd), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                      m_TimeStampQueryPool, (uint32_t)(m_Results.size() * 2 + 0));
+  }
+
+  bool PostDraw(uint32_t eid, VkCommandBuffer cmd) override
+  {
+    if(m_TimeStampQueryPool != VK_NULL_HANDLE)
+      ObjDisp(cmd)->CmdWriteTimestamp(Unwrap(cmd), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                      m_TimeStampQueryPool, (uint32_t)(m_Results.size() * 2 + 1));
+    if(m_OcclusionQueryPool != VK_NULL_HANDLE)
+      ObjDisp(cmd)->CmdEndQuery(Unwrap(cmd), m_OcclusionQueryPool, (uint32_t)m_Results.size());
+    if(m_PipeStatsQueryPool != VK_NULL_HANDLE)
+      ObjDisp(cmd)->CmdEndQuery(Unwrap(cmd), m_PipeStatsQueryPool, (uint32_t)m_Results.size());
+    m_Results.push_back(eid);
+    return false;
+  }
+
+  void PostRedraw(uint32_t eid, VkCommandBuffer cmd) override {}
+  // we don't need to distinguish, call the Draw functions
+  void PreDispatch(uint32_t eid, VkCommandBuffer cmd) override { PreDraw(eid, cmd); }
+  bool PostDispatch(uint32_t eid, VkCommandBuffer cmd) override { return PostDraw(eid, cmd); }
+  void PostRedispatch(uint32_t eid, VkCommandBuffer cmd) override { PostRedraw(eid, cmd); }
+  void PreMisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) override { PreDraw(eid, cmd); }
+  bool PostMisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) override
+  {
+    return PostDraw(eid, cmd);
+  }
+  void PostRemisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) override
+  {
+    PostRedraw(eid, cmd);
+  }
+  void AliasEvent(uint32_t primary, uint32_t alias) override
+  {
+    m_AliasEvents.push_back(std::make_pair(primary, alias));
+  }
+
+  void PreEndCommandBuffer(VkCommandBuffer cmd) override {}
+  WrappedVulkan *m_pDriver;
+  VulkanReplay *m_pReplay;
+  VkQueryPool m_TimeStampQueryPool;
+  VkQueryPool m_OcclusionQueryPool;
+  VkQueryPool m_PipeStatsQueryPool;
+  bool m_Chained;
+  vector<uint32_t> m_Results;
+  // events which are the 'same' from being the same command buffer resubmitted
+  // multiple times in the frame. We will only get the full callback when we're
+  // recording the command buffer, and will be given the first EID. After that
+  // we'll just be told which other EIDs alias this event.
+  vector<pair<uint32_t, uint32_t> > m_AliasEvents;
+};
+
 struct VulkanAMDDrawCallback : public VulkanDrawcallCallback
 {
   VulkanAMDDrawCallback(WrappedVulkan *dev, VulkanReplay *rp, uint32_t &sampleIndex,
-                        vector<uint32_t> &eventIDs)
-      : m_pDriver(dev), m_pReplay(rp), m_pSampleId(&sampleIndex), m_pEventIds(&eventIDs)
+                        vector<uint32_t> &eventIDs, VulkanGPUTimerCallback *queries)
+      : m_pDriver(dev),
+        m_pReplay(rp),
+        m_pSampleId(&sampleIndex),
+        m_pEventIds(&eventIDs),
+        m_pQueries(queries)
   {
     m_pDriver->SetDrawcallCB(this);
   }
@@ -222,6 +336,10 @@ struct VulkanAMDDrawCallback : public VulkanDrawcallCallback
       m_pReplay->GetAMDCounters()->BeginCommandList(realCmdBuffer);
     }
 
+    // any generic queries go outside the sample, so they don't affect it
+    if(m_pQueries)
+      m_pQueries->PreDraw(eid, cmd);
+
     m_pReplay->GetAMDCounters()->BeginSample(*m_pSampleId, realCmdBuffer);
 
     ++*m_pSampleId;
@@ -232,6 +350,10 @@ struct VulkanAMDDrawCallback : public VulkanDrawcallCallback
     VkCommandBuffer realCmdBuffer = Unwrap(cmd);
 
     m_pReplay->GetAMDCounters()->EndSample(realCmdBuffer);
+
+    if(m_pQueries)
+      m_pQueries->PostDraw(eid, cmd);
+
     return false;
   }
 
@@ -266,12 +388,16 @@ struct VulkanAMDDrawCallback : public VulkanDrawcallCallback
   void AliasEvent(uint32_t primary, uint32_t alias) override
   {
     m_AliasEvents.push_back(std::make_pair(primary, alias));
+
+    if(m_pQueries)
+      m_pQueries->AliasEvent(primary, alias);
   }
 
   uint32_t *m_pSampleId;
   WrappedVulkan *m_pDriver;
   VulkanReplay *m_pReplay;
   vector<uint32_t> *m_pEventIds;
+  VulkanGPUTimerCallback *m_pQueries;
   set<VkCommandBuffer> m_begunCommandBuffers;
   // events which are the 'same' from being the same command buffer resubmitted
   // multiple times in the frame. We will only get the full callback when we're
@@ -281,18 +407,23 @@ struct VulkanAMDDrawCallback : public VulkanDrawcallCallback
 };
 
 void VulkanReplay::FillTimersAMD(uint32_t *eventStartID, uint32_t *sampleIndex,
-                                 vector<uint32_t> *eventIDs)
+                                 vector<uint32_t> *eventIDs, VulkanGPUTimerCallback *queries)
 {
   uint32_t maxEID = m_pDriver->GetMaxEID();
 
-  m_pAMDDrawCallback = new VulkanAMDDrawCallback(m_pDriver, this, *sampleIndex, *eventIDs);
+  SAFE_DELETE(m_pAMDDrawCallback);
+  m_pAMDDrawCallback =
+      new VulkanAMDDrawCallback(m_pDriver, this, *sampleIndex, *eventIDs, queries);
 
   // replay the events to perform all the queries
   m_pDriver->ReplayLog(*eventStartID, maxEID, eReplay_Full);
 }
 
-vector<CounterResult> VulkanReplay::FetchCountersAMD(const vector<GPUCounter> &counters)
+vector<CounterResult> VulkanReplay::FetchCountersAMD(const vector<GPUCounter> &counters,
+                                                     VulkanGPUTimerCallback *queries, bool &replayed)
 {
+  replayed = false;
+
   GPA_vkContextOpenInfo context = {Unwrap(m_pDriver->GetInstance()),
                                    Unwrap(m_pDriver->GetPhysDev()), Unwrap(m_pDriver->GetDev())};
 
@@ -331,7 +462,10 @@ vector<CounterResult> VulkanReplay::FetchCountersAMD(const vector<GPUCounter> &c
 
     eventIDs.clear();
 
-    FillTimersAMD(&eventStartID, &sampleIndex, &eventIDs);
+    // generic queries only need to be made once, so they ride along with the first pass
+    FillTimersAMD(&eventStartID, &sampleIndex, &eventIDs, i == 0 ? queries : NULL);
+
+    replayed = true;
 
     m_pAMDCounters->EndPass();
   }
@@ -376,169 +510,62 @@ vector<CounterResult> VulkanReplay::FetchCountersAMD(const vector<GPUCounter> &c
   return ret;
 }
 
-struct VulkanGPUTimerCallback : public VulkanDrawcallCallback
+void VulkanReplay::PrepareCounterQueries(uint32_t maxEID, bool timeStamps, bool occlusion,
+                                         bool pipeStats)
 {
-  VulkanGPUTimerCallback(WrappedVulkan *vk, VulkanReplay *rp, VkQueryPool tsqp, VkQueryPool occqp,
-                         VkQueryPool psqp)
-      : m_pDriver(vk),
-        m_pReplay(rp),
-        m_TimeStampQueryPool(tsqp),
-        m_OcclusionQueryPool(occqp),
-        m_PipeStatsQueryPool(psqp)
-  {
-    m_pDriver->SetDrawcallCB(this);
-  }
-  ~VulkanGPUTimerCallback() { m_pDriver->SetDrawcallCB(NULL); }
-  void PreDraw(uint32_t eid, VkCommandBuffer cmd) override
-  {
-    if(m_OcclusionQueryPool != VK_NULL_HANDLE)
-      ObjDisp(cmd)->CmdBeginQuery(Unwrap(cmd), m_OcclusionQueryPool, (uint32_t)m_Results.size(),
-                                  VK_QUERY_CONTROL_PRECISE_BIT);
-    if(m_PipeStatsQueryPool != VK_NULL_HANDLE)
-      ObjDisp(cmd)->CmdBeginQuery(Unwrap(cmd), m_PipeStatsQueryPool, (uint32_t)m_Results.size(), 0);
-    ObjDisp(cmd)->CmdWriteTimestamp(Unwrap(cmd), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                    m_TimeStampQueryPool, (uint32_t)(m_Results.size() * 2 + 0));
-  }
-
-  bool PostDraw(uint32_t eid, VkCommandBuffer cmd) override
-  {
-    ObjDisp(cmd)->CmdWriteTimestamp(Unwrap(cmd), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                                    m_TimeStampQueryPool, (uint32_t)(m_Results.size() * 2 + 1));
-    if(m_OcclusionQueryPool != VK_NULL_HANDLE)
-      ObjDisp(cmd)->CmdEndQuery(Unwrap(cmd), m_OcclusionQueryPool, (uint32_t)m_Results.size());
-    if(m_PipeStatsQueryPool != VK_NULL_HANDLE)
-      ObjDisp(cmd)->CmdEndQuery(Unwrap(cmd), m_PipeStatsQueryPool, (uint32_t)m_Results.size());
-    m_Results.push_back(eid);
-    return false;
-  }
-
-  void PostRedraw(uint32_t eid, VkCommandBuffer cmd) override {}
-  // we don't need to distinguish, call the Draw functions
-  void PreDispatch(uint32_t eid, VkCommandBuffer cmd) override { PreDraw(eid, cmd); }
-  bool PostDispatch(uint32_t eid, VkCommandBuffer cmd) override { return PostDraw(eid, cmd); }
-  void PostRedispatch(uint32_t eid, VkCommandBuffer cmd) override { PostRedraw(eid, cmd); }
-  void PreMisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) override { PreDraw(eid, cmd); }
-  bool PostMisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) override
-  {
-    return PostDraw(eid, cmd);
-  }
-  void PostRemisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) override
-  {
-    PostRedraw(eid, cmd);
-  }
-  void AliasEvent(uint32_t primary, uint32_t alias) override
-  {
-    m_AliasEvents.push_back(std::make_pair(primary, alias));
-  }
-
-  void PreEndCommandBuffer(VkCommandBuffer cmd) override {}
-  WrappedVulkan *m_pDriver;
-  VulkanReplay *m_pReplay;
-  VkQueryPool m_TimeStampQueryPool;
-  VkQueryPool m_OcclusionQueryPool;
-  VkQueryPool m_PipeStatsQueryPool;
-  vector<uint32_t> m_Results;
-  // events which are the 'same' from being the same command buffer resubmitted
-  // multiple times in the frame. We will only get the full callback when we're
-  // recording the command buffer, and will be given the first EID. After that
-  // we'll just be told which other EIDs alias this event.
-  vector<pair<uint32_t, uint32_t> > m_AliasEvents;
-};
-
-vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &counters)
-{
-  uint32_t maxEID = m_pDriver->GetMaxEID();
-
-  vector<GPUCounter> vkCounters;
-  std::copy_if(counters.begin(), counters.end(), std::back_inserter(vkCounters),
-               [](const GPUCounter &c) { return IsGenericCounter(c); });
+  VkDevice dev = m_pDriver->GetDev();
+  VkResult vkr = VK_SUCCESS;
 
-  vector<CounterResult> ret;
+  CounterQueries &queries = m_CounterQueries;
 
-  if(m_pAMDCounters)
+  // the pools are kept between calls, and only recreated if this capture needs more queries than
+  // they have room for.
+  if(maxEID > queries.size)
   {
-    // Filter out the AMD counters
-    vector<GPUCounter> amdCounters;
-    std::copy_if(counters.begin(), counters.end(), std::back_inserter(amdCounters),
-                 [](const GPUCounter &c) { return IsAMDCounter(c); });
-
-    if(!amdCounters.empty())
-    {
-      ret = FetchCountersAMD(amdCounters);
-    }
+    queries.Destroy(m_pDriver);
+    queries.size = maxEID;
   }
 
-  if(vkCounters.empty())
+  if(timeStamps && queries.timeStamp == VK_NULL_HANDLE)
   {
-    return ret;
+    VkQueryPoolCreateInfo timeStampPoolCreateInfo = {
+        VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        NULL,
+        0,
+        VK_QUERY_TYPE_TIMESTAMP,
+        queries.size * 2,
+        0,
+    };
+
+    vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &timeStampPoolCreateInfo, NULL,
+                                        &queries.timeStamp);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
 
-  VkPhysicalDeviceFeatures availableFeatures = m_pDriver->GetDeviceFeatures();
-
-  VkDevice dev = m_pDriver->GetDev();
-
-  VkQueryPoolCreateInfo timeStampPoolCreateInfo = {
-      VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, NULL, 0, VK_QUERY_TYPE_TIMESTAMP, maxEID * 2, 0};
-
-  VkQueryPoolCreateInfo occlusionPoolCreateInfo = {
-      VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, NULL, 0, VK_QUERY_TYPE_OCCLUSION, maxEID, 0};
-
-  VkQueryPipelineStatisticFlags pipeStatsFlags =
-      VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_INVOCATIONS_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_PRIMITIVES_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_CONTROL_SHADER_PATCHES_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
-
-  VkQueryPoolCreateInfo pipeStatsPoolCreateInfo = {
-      VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, NULL,   0,
-      VK_QUERY_TYPE_PIPELINE_STATISTICS,        maxEID, pipeStatsFlags};
-
-  VkQueryPool timeStampPool;
-  VkResult vkr =
-      ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &timeStampPoolCreateInfo, NULL, &timeStampPool);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  bool occlNeeded = false;
-  bool statsNeeded = false;
-
-  for(size_t c = 0; c < vkCounters.size(); c++)
+  if(occlusion && queries.occlusion == VK_NULL_HANDLE)
   {
-    switch(vkCounters[c])
-    {
-      case GPUCounter::InputVerticesRead:
-      case GPUCounter::IAPrimitives:
-      case GPUCounter::GSPrimitives:
-      case GPUCounter::RasterizerInvocations:
-      case GPUCounter::RasterizedPrimitives:
-      case GPUCounter::VSInvocations:
-      case GPUCounter::TCSInvocations:
-      case GPUCounter::TESInvocations:
-      case GPUCounter::GSInvocations:
-      case GPUCounter::PSInvocations:
-      case GPUCounter::CSInvocations: statsNeeded = true; break;
-      case GPUCounter::SamplesPassed: occlNeeded = true; break;
-      default: break;
-    }
-  }
+    VkQueryPoolCreateInfo occlusionPoolCreateInfo = {
+        VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, NULL, 0, VK_QUERY_TYPE_OCCLUSION, queries.size, 0,
+    };
 
-  VkQueryPool occlusionPool = VK_NULL_HANDLE;
-  if(availableFeatures.occlusionQueryPrecise && occlNeeded)
-  {
-    vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &occlusionPoolCreateInfo, NULL, &occlusionPool);
+    vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &occlusionPoolCreateInfo, NULL,
+                                        &queries.occlusion);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
 
-  VkQueryPool pipeStatsPool = VK_NULL_HANDLE;
-  if(availableFeatures.pipelineStatisticsQuery && statsNeeded)
+  if(pipeStats && queries.pipeStats == VK_NULL_HANDLE)
   {
-    vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &pipeStatsPoolCreateInfo, NULL, &pipeStatsPool);
+    VkQueryPoolCreateInfo pipeStatsPoolCreateInfo = {
+        VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        NULL,
+        0,
+        VK_QUERY_TYPE_PIPELINE_STATISTICS,
+        queries.size,
+        pipeStatsFlags,
+    };
+
+    vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &pipeStatsPoolCreateInfo, NULL,
+                                        &queries.pipeStats);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
 
@@ -550,11 +577,13 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
   vkr = ObjDisp(dev)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), timeStampPool, 0, maxEID * 2);
-  if(occlusionPool != VK_NULL_HANDLE)
-    ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), occlusionPool, 0, maxEID);
-  if(pipeStatsPool != VK_NULL_HANDLE)
-    ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), pipeStatsPool, 0, maxEID);
+  // only reset the queries we'll be using
+  if(timeStamps)
+    ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), queries.timeStamp, 0, maxEID * 2);
+  if(occlusion)
+    ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), queries.occlusion, 0, maxEID);
+  if(pipeStats)
+    ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), queries.pipeStats, 0, maxEID);
 
   vkr = ObjDisp(dev)->EndCommandBuffer(Unwrap(cmd));
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
@@ -562,49 +591,53 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
 #if ENABLED(SINGLE_FLUSH_VALIDATE)
   m_pDriver->SubmitCmds();
 #endif
+}
 
-  VulkanGPUTimerCallback cb(m_pDriver, this, timeStampPool, occlusionPool, pipeStatsPool);
+void VulkanReplay::GetCounterQueryResults(const VulkanGPUTimerCallback &cb,
+                                          const vector<GPUCounter> &vkCounters,
+                                          vector<CounterResult> &ret)
+{
+  VkDevice dev = m_pDriver->GetDev();
+  VkResult vkr = VK_SUCCESS;
 
-  // replay the events to perform all the queries
-  m_pDriver->ReplayLog(0, maxEID, eReplay_Full);
+  if(cb.m_Results.empty())
+    return;
 
   vector<uint64_t> m_TimeStampData;
   m_TimeStampData.resize(cb.m_Results.size() * 2);
-
-  vkr = ObjDisp(dev)->GetQueryPoolResults(
-      Unwrap(dev), timeStampPool, 0, (uint32_t)m_TimeStampData.size(),
-      sizeof(uint64_t) * m_TimeStampData.size(), &m_TimeStampData[0], sizeof(uint64_t),
-      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), timeStampPool, NULL);
+  if(cb.m_TimeStampQueryPool != VK_NULL_HANDLE)
+  {
+    vkr = ObjDisp(dev)->GetQueryPoolResults(
+        Unwrap(dev), cb.m_TimeStampQueryPool, 0, (uint32_t)m_TimeStampData.size(),
+        sizeof(uint64_t) * m_TimeStampData.size(), &m_TimeStampData[0], sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  }
 
   vector<uint64_t> m_OcclusionData;
   m_OcclusionData.resize(cb.m_Results.size());
-  if(occlusionPool != VK_NULL_HANDLE)
+  if(cb.m_OcclusionQueryPool != VK_NULL_HANDLE)
   {
     vkr = ObjDisp(dev)->GetQueryPoolResults(
-        Unwrap(dev), occlusionPool, 0, (uint32_t)m_OcclusionData.size(),
+        Unwrap(dev), cb.m_OcclusionQueryPool, 0, (uint32_t)m_OcclusionData.size(),
         sizeof(uint64_t) * m_OcclusionData.size(), &m_OcclusionData[0], sizeof(uint64_t),
         VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), occlusionPool, NULL);
   }
 
   vector<uint64_t> m_PipeStatsData;
-  m_PipeStatsData.resize(cb.m_Results.size() * 11);
-  if(pipeStatsPool != VK_NULL_HANDLE)
+  m_PipeStatsData.resize(cb.m_Results.size() * pipeStatsCount);
+  if(cb.m_PipeStatsQueryPool != VK_NULL_HANDLE)
   {
     vkr = ObjDisp(dev)->GetQueryPoolResults(
-        Unwrap(dev), pipeStatsPool, 0, (uint32_t)cb.m_Results.size(),
-        sizeof(uint64_t) * m_PipeStatsData.size(), &m_PipeStatsData[0], sizeof(uint64_t) * 11,
-        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+        Unwrap(dev), cb.m_PipeStatsQueryPool, 0, (uint32_t)cb.m_Results.size(),
+        sizeof(uint64_t) * m_PipeStatsData.size(), &m_PipeStatsData[0],
+        sizeof(uint64_t) * pipeStatsCount, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), pipeStatsPool, NULL);
   }
 
+  size_t first = ret.size();
+
   for(size_t i = 0; i < cb.m_Results.size(); i++)
   {
     for(size_t c = 0; c < vkCounters.size(); c++)
@@ -614,6 +647,8 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
       result.eventId = cb.m_Results[i];
       result.counter = vkCounters[c];
 
+      const uint64_t *pipeStats = &m_PipeStatsData[i * pipeStatsCount];
+
       switch(vkCounters[c])
       {
         case GPUCounter::EventGPUDuration:
@@ -624,28 +659,27 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
                            / (1000.0 * 1000.0 * 1000.0);    // to seconds
         }
         break;
-        case GPUCounter::InputVerticesRead: result.value.u64 = m_PipeStatsData[i * 11 + 0]; break;
-        case GPUCounter::IAPrimitives: result.value.u64 = m_PipeStatsData[i * 11 + 1]; break;
-        case GPUCounter::GSPrimitives: result.value.u64 = m_PipeStatsData[i * 11 + 4]; break;
-        case GPUCounter::RasterizerInvocations:
-          result.value.u64 = m_PipeStatsData[i * 11 + 5];
-          break;
-        case GPUCounter::RasterizedPrimitives:
-          result.value.u64 = m_PipeStatsData[i * 11 + 6];
-          break;
+        case GPUCounter::InputVerticesRead: result.value.u64 = pipeStats[0]; break;
+        case GPUCounter::IAPrimitives: result.value.u64 = pipeStats[1]; break;
+        case GPUCounter::GSPrimitives: result.value.u64 = pipeStats[4]; break;
+        case GPUCounter::RasterizerInvocations: result.value.u64 = pipeStats[5]; break;
+        case GPUCounter::RasterizedPrimitives: result.value.u64 = pipeStats[6]; break;
         case GPUCounter::SamplesPassed: result.value.u64 = m_OcclusionData[i]; break;
-        case GPUCounter::VSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 2]; break;
-        case GPUCounter::TCSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 8]; break;
-        case GPUCounter::TESInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 9]; break;
-        case GPUCounter::GSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 3]; break;
-        case GPUCounter::PSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 9]; break;
-        case GPUCounter::CSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 10]; break;
+        case GPUCounter::VSInvocations: result.value.u64 = pipeStats[2]; break;
+        case GPUCounter::TCSInvocations: result.value.u64 = pipeStats[8]; break;
+        case GPUCounter::TESInvocations: result.value.u64 = pipeStats[9]; break;
+        case GPUCounter::GSInvocations: result.value.u64 = pipeStats[3]; break;
+        case GPUCounter::PSInvocations: result.value.u64 = pipeStats[7]; break;
+        case GPUCounter::CSInvocations: result.value.u64 = pipeStats[10]; break;
         default: break;
       }
       ret.push_back(result);
     }
   }
 
+  // only search the results added by this callback for the aliased events
+  size_t last = ret.size();
+
   for(size_t i = 0; i < cb.m_AliasEvents.size(); i++)
   {
     for(size_t c = 0; c < vkCounters.size(); c++)
@@ -655,8 +689,8 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
       search.eventId = cb.m_AliasEvents[i].first;
 
       // find the result we're aliasing
-      auto it = std::find(ret.begin(), ret.end(), search);
-      if(it != ret.end())
+      auto it = std::find(ret.begin() + first, ret.begin() + last, search);
+      if(it != ret.begin() + last)
       {
         // duplicate the result and append
         CounterResult aliased = *it;
@@ -670,6 +704,96 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
       }
     }
   }
+}
+
+vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &counters)
+{
+  uint32_t maxEID = m_pDriver->GetMaxEID();
+
+  vector<GPUCounter> vkCounters;
+  std::copy_if(counters.begin(), counters.end(), std::back_inserter(vkCounters),
+               [](const GPUCounter &c) { return IsGenericCounter(c); });
+
+  vector<GPUCounter> amdCounters;
+  if(m_pAMDCounters)
+  {
+    // Filter out the AMD counters
+    std::copy_if(counters.begin(), counters.end(), std::back_inserter(amdCounters),
+                 [](const GPUCounter &c) { return IsAMDCounter(c); });
+  }
+
+  vector<CounterResult> ret;
+
+  VkPhysicalDeviceFeatures availableFeatures = m_pDriver->GetDeviceFeatures();
+
+  bool timeStampsNeeded = false;
+  bool occlNeeded = false;
+  bool statsNeeded = false;
+
+  for(size_t c = 0; c < vkCounters.size(); c++)
+  {
+    switch(vkCounters[c])
+    {
+      case GPUCounter::EventGPUDuration: timeStampsNeeded = true; break;
+      case GPUCounter::InputVerticesRead:
+      case GPUCounter::IAPrimitives:
+      case GPUCounter::GSPrimitives:
+      case GPUCounter::RasterizerInvocations:
+      case GPUCounter::RasterizedPrimitives:
+      case GPUCounter::VSInvocations:
+      case GPUCounter::TCSInvocations:
+      case GPUCounter::TESInvocations:
+      case GPUCounter::GSInvocations:
+      case GPUCounter::PSInvocations:
+      case GPUCounter::CSInvocations: statsNeeded = true; break;
+      case GPUCounter::SamplesPassed: occlNeeded = true; break;
+      default: break;
+    }
+  }
+
+  occlNeeded = occlNeeded && availableFeatures.occlusionQueryPrecise;
+  statsNeeded = statsNeeded && availableFeatures.pipelineStatisticsQuery;
+
+  if(!vkCounters.empty())
+    PrepareCounterQueries(maxEID, timeStampsNeeded, occlNeeded, statsNeeded);
+
+  VulkanGPUTimerCallback cb(m_pDriver, this,
+                            timeStampsNeeded ? m_CounterQueries.timeStamp : VK_NULL_HANDLE,
+                            occlNeeded ? m_CounterQueries.occlusion : VK_NULL_HANDLE,
+                            statsNeeded ? m_CounterQueries.pipeStats : VK_NULL_HANDLE, true);
+
+  // Occlusion and pipeline statistics queries don't interfere with the AMD samples, so if there are
+  // AMD counters they're collected in the first AMD pass instead of needing a replay of their own.
+  // Timestamps would be skewed by the sampling, so those always get a clean replay.
+  bool separatePass = !vkCounters.empty();
+
+  if(!amdCounters.empty())
+  {
+    bool combined = separatePass && !timeStampsNeeded;
+    bool replayed = false;
+
+    ret = FetchCountersAMD(amdCounters, combined ? &cb : NULL, replayed);
+
+    // if the AMD counters couldn't be sampled nothing was replayed and the queries were never
+    // written, so they still need their own pass.
+    if(combined && replayed)
+      separatePass = false;
+  }
+
+  if(separatePass)
+  {
+    VulkanGPUTimerCallback standalone(m_pDriver, this, cb.m_TimeStampQueryPool,
+                                      cb.m_OcclusionQueryPool, cb.m_PipeStatsQueryPool);
+
+    // replay the events to perform all the queries
+    m_pDriver->ReplayLog(0, maxEID, eReplay_Full);
+
+    GetCounterQueryResults(standalone, vkCounters, ret);
+  }
+  else
+  {
+    GetCounterQueryResults(cb, vkCounters, ret);
+  }
 
   // sort so that the alias results appear in the right places
   std::sort(ret.begin(), ret.end());
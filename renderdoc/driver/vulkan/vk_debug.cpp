@@ -1633,6 +1633,8 @@ void VulkanReplay::DestroyResources()
   m_Histogram.Destroy(m_pDriver);
   m_PostVS.Destroy(m_pDriver);
 
+  m_CounterQueries.Destroy(m_pDriver);
+
   SAFE_DELETE(m_pAMDCounters);
 }
 
@@ -23,7 +23,12 @@
  ******************************************************************************/
 
 #include "vk_info.h"
+#include <algorithm>
 #include "3rdparty/glslang/SPIRV/spirv.hpp"
+#include "3rdparty/zstd/xxhash.h"
+#include "api/replay/version.h"
+#include "common/shader_cache.h"
+#include "strings/string_utils.h"
 
 VkDynamicState ConvertDynamicState(VulkanDynamicStateIndex idx)
 {
@@ -233,7 +238,7 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
 
     ShaderModule::Reflection &reflData = info.m_ShaderModule[id].m_Reflections[shad.entryPoint];
 
-    reflData.Init(resourceMan, id, info.m_ShaderModule[id].spirv, shad.entryPoint,
+    reflData.Init(resourceMan, info, id, info.m_ShaderModule[id].spirv, shad.entryPoint,
                   pCreateInfo->pStages[i].stage);
 
     if(pCreateInfo->pStages[i].pSpecializationInfo)
@@ -528,7 +533,7 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
 
     ShaderModule::Reflection &reflData = info.m_ShaderModule[id].m_Reflections[shad.entryPoint];
 
-    reflData.Init(resourceMan, id, info.m_ShaderModule[id].spirv, shad.entryPoint,
+    reflData.Init(resourceMan, info, id, info.m_ShaderModule[id].spirv, shad.entryPoint,
                   pCreateInfo->stage.stage);
 
     if(pCreateInfo->stage.pSpecializationInfo)
@@ -943,12 +948,15 @@ void VulkanCreationInfo::ShaderModule::Init(VulkanResourceManager *resourceMan,
   else
   {
     RDCASSERT(pCreateInfo->codeSize % sizeof(uint32_t) == 0);
-    ParseSPIRV((uint32_t *)pCreateInfo->pCode, pCreateInfo->codeSize / sizeof(uint32_t), spirv);
+    // only the entry points are read here, the instructions are parsed when the module is first
+    // reflected or disassembled.
+    InitSPIRV(pCreateInfo->pCode, pCreateInfo->codeSize / sizeof(uint32_t), spirv);
   }
 }
 
 void VulkanCreationInfo::ShaderModule::Reflection::Init(VulkanResourceManager *resourceMan,
-                                                        ResourceId id, const SPVModule &spv,
+                                                        VulkanCreationInfo &info, ResourceId id,
+                                                        const SPVModule &spv,
                                                         const std::string &entry,
                                                         VkShaderStageFlagBits stage)
 {
@@ -957,18 +965,305 @@ void VulkanCreationInfo::ShaderModule::Reflection::Init(VulkanResourceManager *r
     entryPoint = entry;
     stageIndex = StageIndex(stage);
 
+    if(info.m_DeferReflection)
+      info.m_PendingReflections.push_back(std::make_pair(&spv, this));
+    else
+      Reflect(info, spv);
+
+    refl.resourceId = resourceMan->GetOriginalID(id);
+  }
+}
+
+void VulkanCreationInfo::ShaderModule::Reflection::Reflect(VulkanCreationInfo &info,
+                                                           const SPVModule &spv)
+{
+  if(!info.m_ReflectionCache.Fetch(spv, *this))
+  {
     spv.MakeReflection(GraphicsAPI::Vulkan, ShaderStage(stageIndex), entryPoint, refl, mapping,
                        patchData);
 
-    refl.resourceId = resourceMan->GetOriginalID(id);
-    refl.entryPoint = entryPoint;
+    info.m_ReflectionCache.Store(spv, *this);
+  }
 
-    if(!spv.spirv.empty())
-    {
-      refl.encoding = ShaderEncoding::SPIRV;
-      refl.rawBytes.assign((byte *)spv.spirv.data(), spv.spirv.size() * sizeof(uint32_t));
-    }
+  refl.entryPoint = entryPoint;
+
+  if(!spv.spirv.empty())
+  {
+    refl.encoding = ShaderEncoding::SPIRV;
+    refl.rawBytes.assign((byte *)spv.spirv.data(), spv.spirv.size() * sizeof(uint32_t));
+  }
+}
+
+// the cache is invalidated by any change to the build, since reflection output can change with it
+static const uint32_t ReflectionCacheMagic = MAKE_FOURCC('V', 'K', 'R', 'C');
+static const uint32_t ReflectionCacheVersion = 1;
+
+struct ReflectionCacheCallbacks
+{
+  bool Create(uint32_t size, byte *data, bytebuf **ret) const
+  {
+    *ret = new bytebuf;
+    (*ret)->resize(size);
+    memcpy((*ret)->data(), data, size);
+    return true;
+  }
+
+  void Destroy(bytebuf *entry) const { delete entry; }
+  uint32_t GetSize(bytebuf *entry) const { return (uint32_t)entry->size(); }
+  const byte *GetData(bytebuf *entry) const { return entry->data(); }
+} ReflectionCacheCallbacks;
+
+// each entry is a uint64_t timestamp of when it was last used, followed by the serialised key and
+// reflection data. The key is hashed down for the map, and compared in full on lookup.
+struct ReflectionCacheKey
+{
+  uint64_t spirvHash;
+  uint64_t spirvLength;
+  uint32_t stageIndex;
+  std::string entryPoint;
+
+  ReflectionCacheKey(const SPVModule &spv, const VulkanCreationInfo::ShaderModule::Reflection &r)
+  {
+    spirvHash = XXH64(spv.spirv.data(), spv.spirv.size() * sizeof(uint32_t), 0);
+    spirvLength = spv.spirv.size();
+    stageIndex = r.stageIndex;
+    entryPoint = r.entryPoint;
+  }
+
+  uint32_t Hash() const
+  {
+    uint32_t hash = strhash(entryPoint.c_str(), uint32_t(spirvHash ^ (spirvHash >> 32)));
+    return hash ^ (stageIndex * 0x9e3779b9U);
+  }
+
+  template <typename SerialiserType>
+  void Serialise(SerialiserType &ser)
+  {
+    ser.Serialise("spirvHash", spirvHash);
+    ser.Serialise("spirvLength", spirvLength);
+    ser.Serialise("stageIndex", stageIndex);
+    ser.Serialise("entryPoint", entryPoint);
+  }
+};
+
+VulkanCreationInfo::ReflectionCache::~ReflectionCache()
+{
+  if(!m_Dirty)
+  {
+    for(auto it = m_Entries.begin(); it != m_Entries.end(); ++it)
+      ReflectionCacheCallbacks.Destroy(it->second);
+    return;
+  }
+
+  // trim the cache down to size, keeping the most recently used entries
+  std::vector<std::pair<uint64_t, uint32_t>> lastUsed;
+  uint64_t totalSize = 0;
+
+  for(auto it = m_Entries.begin(); it != m_Entries.end(); ++it)
+  {
+    uint64_t timestamp = 0;
+
+    // entries fetched this time record when in memory, so they're only written out if the cache
+    // changed for some other reason.
+    auto use = m_LastUse.find(it->first);
+    if(use != m_LastUse.end())
+      memcpy(it->second->data(), &use->second, sizeof(timestamp));
+
+    memcpy(&timestamp, it->second->data(), sizeof(timestamp));
+    lastUsed.push_back(std::make_pair(timestamp, it->first));
+    totalSize += it->second->size();
+  }
+
+  std::sort(lastUsed.begin(), lastUsed.end());
+
+  for(size_t i = 0; i < lastUsed.size() && totalSize > MaxSize; i++)
+  {
+    auto it = m_Entries.find(lastUsed[i].second);
+    totalSize -= it->second->size();
+    ReflectionCacheCallbacks.Destroy(it->second);
+    m_Entries.erase(it);
+  }
+
+  SaveShaderCache("vkreflection.cache", ReflectionCacheMagic,
+                  strhash(GitVersionHash, ReflectionCacheVersion), m_Entries,
+                  ReflectionCacheCallbacks);
+}
+
+void VulkanCreationInfo::ReflectionCache::Load()
+{
+  SCOPED_LOCK(m_Lock);
+
+  if(m_Enabled)
+    return;
+
+  m_Enabled = true;
+
+  bool success = LoadShaderCache("vkreflection.cache", ReflectionCacheMagic,
+                                 strhash(GitVersionHash, ReflectionCacheVersion), m_Entries,
+                                 ReflectionCacheCallbacks);
+
+  // if the cache was invalid start again from scratch
+  if(!success)
+  {
+    for(auto it = m_Entries.begin(); it != m_Entries.end(); ++it)
+      ReflectionCacheCallbacks.Destroy(it->second);
+    m_Entries.clear();
+  }
+}
+
+bool VulkanCreationInfo::ReflectionCache::Fetch(const SPVModule &spv,
+                                                ShaderModule::Reflection &reflData)
+{
+  if(!m_Enabled || spv.spirv.empty())
+    return false;
+
+  ReflectionCacheKey key(spv, reflData);
+  uint32_t hash = key.Hash();
+
+  // copy the entry out so that the lock isn't held while it's deserialised, since reflection is
+  // fetched from many threads at once while loading.
+  bytebuf entry;
+
+  {
+    SCOPED_LOCK(m_Lock);
+
+    auto it = m_Entries.find(hash);
+
+    if(it == m_Entries.end() || it->second->size() < sizeof(uint64_t))
+      return false;
+
+    entry = *it->second;
+  }
+
+  ReadSerialiser ser(new StreamReader(entry.data() + sizeof(uint64_t),
+                                      entry.size() - sizeof(uint64_t)),
+                     Ownership::Stream);
+
+  ReflectionCacheKey cachedKey = key;
+  cachedKey.Serialise(ser);
+
+  // a different shader with the same hash
+  if(ser.IsErrored() || cachedKey.spirvHash != key.spirvHash ||
+     cachedKey.spirvLength != key.spirvLength || cachedKey.stageIndex != key.stageIndex ||
+     cachedKey.entryPoint != key.entryPoint)
+    return false;
+
+  ShaderReflection refl;
+  ShaderBindpointMapping mapping;
+  SPIRVPatchData patchData;
+
+  ser.Serialise("refl", refl);
+  ser.Serialise("mapping", mapping);
+  ser.Serialise("patchData", patchData);
+
+  if(ser.IsErrored())
+    return false;
+
+  // the resource ID is per-capture, so isn't taken from the cache
+  refl.resourceId = reflData.refl.resourceId;
+
+  reflData.refl = refl;
+  reflData.mapping = mapping;
+  reflData.patchData = patchData;
+
+  {
+    SCOPED_LOCK(m_Lock);
+    m_LastUse[hash] = Timing::GetUnixTimestamp();
   }
+
+  return true;
+}
+
+void VulkanCreationInfo::ReflectionCache::Store(const SPVModule &spv,
+                                                const ShaderModule::Reflection &reflData)
+{
+  if(!m_Enabled || spv.spirv.empty())
+    return;
+
+  ReflectionCacheKey key(spv, reflData);
+
+  // the serialiser needs mutable references, and the raw bytes aren't stored since they're the
+  // SPIR-V that we already have.
+  ShaderReflection refl = reflData.refl;
+  refl.rawBytes.clear();
+  refl.resourceId = ResourceId();
+  ShaderBindpointMapping mapping = reflData.mapping;
+  SPIRVPatchData patchData = reflData.patchData;
+
+  WriteSerialiser ser(new StreamWriter(StreamWriter::DefaultScratchSize), Ownership::Stream);
+
+  uint64_t timestamp = Timing::GetUnixTimestamp();
+  ser.GetWriter()->Write(timestamp);
+
+  key.Serialise(ser);
+  ser.Serialise("refl", refl);
+  ser.Serialise("mapping", mapping);
+  ser.Serialise("patchData", patchData);
+
+  if(ser.IsErrored())
+    return;
+
+  bytebuf *entry = new bytebuf;
+  entry->assign(ser.GetWriter()->GetData(), (size_t)ser.GetWriter()->GetOffset());
+
+  SCOPED_LOCK(m_Lock);
+
+  uint32_t hash = key.Hash();
+
+  // the new entry's timestamp is the latest use
+  m_LastUse.erase(hash);
+
+  auto it = m_Entries.find(hash);
+  if(it != m_Entries.end())
+  {
+    ReflectionCacheCallbacks.Destroy(it->second);
+    it->second = entry;
+  }
+  else
+  {
+    m_Entries[hash] = entry;
+  }
+
+  m_Dirty = true;
+}
+
+void VulkanCreationInfo::FlushPendingReflections()
+{
+  // any pipelines created from now on are reflected immediately
+  m_DeferReflection = false;
+
+  if(m_PendingReflections.empty())
+    return;
+
+  // reflecting an entry point isn't read-only on its module - the parse and some type information
+  // like names are filled in lazily - so entry points in the same module are reflected together on
+  // one thread. Different modules are independent and reflected in parallel.
+  std::stable_sort(m_PendingReflections.begin(), m_PendingReflections.end(),
+                   [](const std::pair<const SPVModule *, ShaderModule::Reflection *> &a,
+                      const std::pair<const SPVModule *, ShaderModule::Reflection *> &b) {
+                     return a.first < b.first;
+                   });
+
+  // the start of each module's run of entry points, with a final entry for the end
+  std::vector<size_t> moduleStarts;
+  for(size_t i = 0; i < m_PendingReflections.size(); i++)
+    if(i == 0 || m_PendingReflections[i].first != m_PendingReflections[i - 1].first)
+      moduleStarts.push_back(i);
+  moduleStarts.push_back(m_PendingReflections.size());
+
+  Threading::ParallelFor((uint32_t)moduleStarts.size() - 1, [this, &moduleStarts](uint32_t m) {
+    for(size_t i = moduleStarts[m]; i < moduleStarts[m + 1]; i++)
+      m_PendingReflections[i].second->Reflect(*this, *m_PendingReflections[i].first);
+
+    // everything needed from the module has been extracted, so don't keep its instruction graph
+    // around - with every pipeline's shaders it would otherwise be the bulk of load-time memory.
+    // It's parsed again if the module is later disassembled or reflected.
+    m_PendingReflections[moduleStarts[m]].first->ReleaseParse();
+  });
+
+  RDCLOG("Reflected %u shader entry points", (uint32_t)m_PendingReflections.size());
+
+  m_PendingReflections.clear();
 }
 
 void VulkanCreationInfo::DescSetPool::Init(VulkanResourceManager *resourceMan,
@@ -469,13 +469,46 @@ struct VulkanCreationInfo
       ShaderBindpointMapping mapping;
       SPIRVPatchData patchData;
 
-      void Init(VulkanResourceManager *resourceMan, ResourceId id, const SPVModule &spv,
-                const std::string &entry, VkShaderStageFlagBits stage);
+      void Init(VulkanResourceManager *resourceMan, VulkanCreationInfo &info, ResourceId id,
+                const SPVModule &spv, const std::string &entry, VkShaderStageFlagBits stage);
+      void Reflect(VulkanCreationInfo &info, const SPVModule &spv);
     };
     map<string, Reflection> m_Reflections;
   };
   map<ResourceId, ShaderModule> m_ShaderModule;
 
+  // reflection results saved in the app folder, so that shaders seen in previous captures don't
+  // need to be parsed and reflected again. Only enabled when loading a capture for replay.
+  struct ReflectionCache
+  {
+    ~ReflectionCache();
+
+    void Load();
+    // returns true and fills out the reflection if it was found in the cache. Thread-safe.
+    bool Fetch(const SPVModule &spv, ShaderModule::Reflection &reflData);
+    // adds a new reflection result to the cache. Thread-safe.
+    void Store(const SPVModule &spv, const ShaderModule::Reflection &reflData);
+
+  private:
+    // the cache is trimmed to this size when it's saved, dropping the least recently used entries
+    static const uint64_t MaxSize = 64 * 1024 * 1024;
+
+    bool m_Enabled = false;
+    // only set when entries are added, so that just using the cache doesn't rewrite it
+    bool m_Dirty = false;
+    Threading::CriticalSection m_Lock;
+    std::map<uint32_t, bytebuf *> m_Entries;
+    // when entries were fetched this session, applied to their stored timestamps on save
+    std::map<uint32_t, uint64_t> m_LastUse;
+  } m_ReflectionCache;
+
+  // while loading a capture, reflection of each shader entry point is queued up here as pipelines
+  // are created, so that it can all be done in parallel by FlushPendingReflections before replay.
+  // Flushing also stops any further deferral.
+  bool m_DeferReflection = false;
+  std::vector<std::pair<const SPVModule *, ShaderModule::Reflection *>> m_PendingReflections;
+  void FlushPendingReflections();
+
   struct DescSetPool
   {
     void Init(VulkanResourceManager *resourceMan, VulkanCreationInfo &info,
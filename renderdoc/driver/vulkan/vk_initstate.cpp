@@ -1361,6 +1361,7 @@ void WrappedVulkan::Apply_InitialState(WrappedVkRes *live, VkInitialContents ini
     // need to blat over the current descriptor set contents, so these are available
     // when we want to fetch pipeline state
     vector<DescriptorSetSlot *> &bindings = m_DescriptorSetState[id].currentBindings;
+    m_DescriptorSetState[id].version++;
 
     for(uint32_t i = 0; i < initial.numDescriptors; i++)
     {
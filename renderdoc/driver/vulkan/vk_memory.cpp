@@ -175,6 +175,299 @@ void WrappedVulkan::RemapMemoryIndices(VkPhysicalDeviceMemoryProperties *memProp
   }
 }
 
+static uint32_t Log2Floor64(uint64_t value)
+{
+  uint32_t hi = uint32_t(value >> 32);
+  return hi ? 32 + Log2Floor(hi) : Log2Floor(uint32_t(value));
+}
+
+static uint32_t LowestBit(uint32_t value)
+{
+  return Log2Floor(value & (~value + 1));
+}
+
+static uint32_t LowestBit64(uint64_t value)
+{
+  return Log2Floor64(value & (~value + 1));
+}
+
+TLSFAllocator::TLSFAllocator()
+{
+  for(uint32_t fl = 0; fl < FirstLevelCount; fl++)
+    for(uint32_t sl = 0; sl < SecondLevelCount; sl++)
+      m_FreeHeads[fl][sl] = InvalidRange;
+}
+
+void TLSFAllocator::GetBucket(VkDeviceSize size, uint32_t &fl, uint32_t &sl)
+{
+  // small sizes each get their own bucket in the first level
+  if(size < SecondLevelCount)
+  {
+    fl = 0;
+    sl = (uint32_t)size;
+    return;
+  }
+
+  // otherwise the first level is the power of two, and the second level is the next few bits below
+  // the top bit.
+  uint32_t topBit = Log2Floor64(size);
+  fl = topBit - SecondLevelBits + 1;
+  sl = uint32_t(size >> (topBit - SecondLevelBits)) ^ SecondLevelCount;
+}
+
+uint32_t TLSFAllocator::FindFree(VkDeviceSize size)
+{
+  // round the size up to the next bucket so that any range we find will be large enough. Ranges in
+  // the bucket for size itself might be smaller.
+  if(size >= SecondLevelCount)
+    size += (VkDeviceSize(1) << (Log2Floor64(size) - SecondLevelBits)) - 1;
+
+  uint32_t fl = 0, sl = 0;
+  GetBucket(size, fl, sl);
+
+  uint32_t slMask = m_SecondLevelMask[fl] & (~0U << sl);
+
+  // nothing in this power of two, look for the next non-empty one
+  if(slMask == 0)
+  {
+    uint64_t flMask = m_FirstLevelMask & (~0ULL << (fl + 1));
+
+    if(flMask == 0)
+      return InvalidRange;
+
+    fl = LowestBit64(flMask);
+    slMask = m_SecondLevelMask[fl];
+  }
+
+  sl = LowestBit(slMask);
+
+  return m_FreeHeads[fl][sl];
+}
+
+bool TLSFAllocator::Fits(uint32_t r, VkDeviceSize size, VkDeviceSize alignment) const
+{
+  const Range &range = m_Ranges[r];
+  return AlignUp(range.offs, alignment) - range.offs + size <= range.size;
+}
+
+uint32_t TLSFAllocator::NewRange()
+{
+  if(!m_UnusedRanges.empty())
+  {
+    uint32_t ret = m_UnusedRanges.back();
+    m_UnusedRanges.pop_back();
+    return ret;
+  }
+
+  m_Ranges.push_back(Range());
+  return uint32_t(m_Ranges.size() - 1);
+}
+
+void TLSFAllocator::ReleaseRange(uint32_t r)
+{
+  m_Ranges[r].block = InvalidRange;
+  m_Ranges[r].free = false;
+  m_UnusedRanges.push_back(r);
+}
+
+void TLSFAllocator::InsertFree(uint32_t r)
+{
+  uint32_t fl = 0, sl = 0;
+  GetBucket(m_Ranges[r].size, fl, sl);
+
+  uint32_t head = m_FreeHeads[fl][sl];
+
+  m_Ranges[r].free = true;
+  m_Ranges[r].prevFree = InvalidRange;
+  m_Ranges[r].nextFree = head;
+
+  if(head != InvalidRange)
+    m_Ranges[head].prevFree = r;
+
+  m_FreeHeads[fl][sl] = r;
+  m_SecondLevelMask[fl] |= (1U << sl);
+  m_FirstLevelMask |= (1ULL << fl);
+}
+
+void TLSFAllocator::RemoveFree(uint32_t r)
+{
+  uint32_t fl = 0, sl = 0;
+  GetBucket(m_Ranges[r].size, fl, sl);
+
+  Range &range = m_Ranges[r];
+
+  if(range.prevFree != InvalidRange)
+    m_Ranges[range.prevFree].nextFree = range.nextFree;
+  else
+    m_FreeHeads[fl][sl] = range.nextFree;
+
+  if(range.nextFree != InvalidRange)
+    m_Ranges[range.nextFree].prevFree = range.prevFree;
+
+  range.free = false;
+  range.prevFree = range.nextFree = InvalidRange;
+
+  if(m_FreeHeads[fl][sl] == InvalidRange)
+  {
+    m_SecondLevelMask[fl] &= ~(1U << sl);
+    if(m_SecondLevelMask[fl] == 0)
+      m_FirstLevelMask &= ~(1ULL << fl);
+  }
+}
+
+uint32_t TLSFAllocator::AddBlock(VkDeviceSize size)
+{
+  uint32_t r = NewRange();
+
+  Range &range = m_Ranges[r];
+  range.offs = 0;
+  range.size = size;
+  range.block = m_BlockCount;
+  range.prevPhys = range.nextPhys = InvalidRange;
+
+  InsertFree(r);
+
+  return m_BlockCount++;
+}
+
+uint32_t TLSFAllocator::Allocate(VkDeviceSize size, VkDeviceSize alignment, uint32_t &block,
+                                 VkDeviceSize &offs)
+{
+  size = RDCMAX(size, (VkDeviceSize)1);
+  alignment = RDCMAX(alignment, (VkDeviceSize)1);
+
+  uint32_t r = FindFree(size);
+
+  // the range we found is big enough but might not be once it's aligned. If so look again with
+  // enough space that any range we find can be aligned.
+  if(r != InvalidRange && !Fits(r, size, alignment))
+    r = FindFree(size + alignment - 1);
+
+  // the searches above skip the bucket containing the size itself, since not every range in it is
+  // large enough. Check through it before giving up, so that e.g. an exactly sized block is used.
+  if(r == InvalidRange)
+  {
+    uint32_t fl = 0, sl = 0;
+    GetBucket(size, fl, sl);
+
+    for(r = m_FreeHeads[fl][sl]; r != InvalidRange; r = m_Ranges[r].nextFree)
+      if(Fits(r, size, alignment))
+        break;
+  }
+
+  if(r == InvalidRange)
+    return InvalidRange;
+
+  RemoveFree(r);
+
+  // split off any padding needed for alignment into its own free range. The previous range must be
+  // allocated, since neighbouring free ranges are always merged.
+  VkDeviceSize pad = AlignUp(m_Ranges[r].offs, alignment) - m_Ranges[r].offs;
+  if(pad > 0)
+  {
+    uint32_t front = NewRange();
+
+    Range &cur = m_Ranges[r];
+    Range &f = m_Ranges[front];
+
+    f.offs = cur.offs;
+    f.size = pad;
+    f.block = cur.block;
+    f.prevPhys = cur.prevPhys;
+    f.nextPhys = r;
+
+    if(cur.prevPhys != InvalidRange)
+      m_Ranges[cur.prevPhys].nextPhys = front;
+
+    cur.prevPhys = front;
+    cur.offs += pad;
+    cur.size -= pad;
+
+    InsertFree(front);
+  }
+
+  // similarly any remaining space after the allocation
+  if(m_Ranges[r].size > size)
+  {
+    uint32_t back = NewRange();
+
+    Range &cur = m_Ranges[r];
+    Range &b = m_Ranges[back];
+
+    b.offs = cur.offs + size;
+    b.size = cur.size - size;
+    b.block = cur.block;
+    b.prevPhys = r;
+    b.nextPhys = cur.nextPhys;
+
+    if(cur.nextPhys != InvalidRange)
+      m_Ranges[cur.nextPhys].prevPhys = back;
+
+    cur.nextPhys = back;
+    cur.size = size;
+
+    InsertFree(back);
+  }
+
+  m_AllocatedBytes += size;
+
+  block = m_Ranges[r].block;
+  offs = m_Ranges[r].offs;
+
+  return r;
+}
+
+uint32_t TLSFAllocator::GetRangeBlock(uint32_t r) const
+{
+  if(r >= m_Ranges.size() || m_Ranges[r].free)
+    return InvalidRange;
+
+  return m_Ranges[r].block;
+}
+
+bool TLSFAllocator::Free(uint32_t r, VkDeviceSize offs)
+{
+  if(GetRangeBlock(r) == InvalidRange || m_Ranges[r].offs != offs)
+    return false;
+
+  m_AllocatedBytes -= m_Ranges[r].size;
+
+  // merge with the previous range if it's free
+  uint32_t prev = m_Ranges[r].prevPhys;
+  if(prev != InvalidRange && m_Ranges[prev].free)
+  {
+    RemoveFree(prev);
+
+    m_Ranges[prev].size += m_Ranges[r].size;
+    m_Ranges[prev].nextPhys = m_Ranges[r].nextPhys;
+
+    if(m_Ranges[r].nextPhys != InvalidRange)
+      m_Ranges[m_Ranges[r].nextPhys].prevPhys = prev;
+
+    ReleaseRange(r);
+    r = prev;
+  }
+
+  // and with the next
+  uint32_t next = m_Ranges[r].nextPhys;
+  if(next != InvalidRange && m_Ranges[next].free)
+  {
+    RemoveFree(next);
+
+    m_Ranges[r].size += m_Ranges[next].size;
+    m_Ranges[r].nextPhys = m_Ranges[next].nextPhys;
+
+    if(m_Ranges[next].nextPhys != InvalidRange)
+      m_Ranges[m_Ranges[next].nextPhys].prevPhys = r;
+
+    ReleaseRange(next);
+  }
+
+  InsertFree(r);
+
+  return true;
+}
+
 MemoryAllocation WrappedVulkan::AllocateMemoryForResource(bool buffer, VkMemoryRequirements mrq,
                                                           MemoryScope scope, MemoryType type)
 {
@@ -188,69 +481,45 @@ MemoryAllocation WrappedVulkan::AllocateMemoryForResource(bool buffer, VkMemoryR
            mrq.alignment, mrq.memoryTypeBits, buffer ? "buffer" : "image", ToStr(type).c_str(),
            ToStr(scope).c_str());
 
-  std::vector<MemoryAllocation> &blockList = m_MemoryBlocks[(size_t)scope];
-
-  // first try to find a match
-  int i = 0;
-  for(MemoryAllocation &block : blockList)
+  switch(ret.type)
   {
-    RDCDEBUG(
-        "Considering block %d: memory type %u and type %s. Total size 0x%llx, current offset "
-        "0x%llx, last alloc was %s",
-        i, block.memoryTypeIndex, ToStr(block.type).c_str(), block.size, block.offs,
-        block.buffer ? "buffer" : "image");
-    i++;
-
-    // skip this block if it's not the memory type we want
-    if(ret.type != block.type || (mrq.memoryTypeBits & (1 << block.memoryTypeIndex)) == 0)
-    {
-      RDCDEBUG("block type %d or memory type %d is incompatible", block.type, block.memoryTypeIndex);
-      continue;
-    }
-
-    // offs is where we can put our next sub-allocation
-    VkDeviceSize offs = block.offs;
-
-    // if we are on a buffer/image, account for any alignment we might have to do
-    if(ret.buffer != block.buffer)
-      offs = AlignUp(offs, m_PhysicalDeviceData.props.limits.bufferImageGranularity);
-
-    // align as required by the resource
-    offs = AlignUp(offs, mrq.alignment);
-
-    if(offs > block.size)
-    {
-      RDCDEBUG("Next offset 0x%llx would be off the end of the memory (size 0x%llx).", offs,
-               block.size);
-      continue;
-    }
+    case MemoryType::Upload: ret.memoryTypeIndex = GetUploadMemoryIndex(mrq.memoryTypeBits); break;
+    case MemoryType::GPULocal:
+      ret.memoryTypeIndex = GetGPULocalMemoryIndex(mrq.memoryTypeBits);
+      break;
+    case MemoryType::Readback:
+      ret.memoryTypeIndex = GetReadbackMemoryIndex(mrq.memoryTypeBits);
+      break;
+  }
 
-    VkDeviceSize avail = block.size - offs;
+  std::vector<MemoryPool> &poolList = m_MemoryPools[(size_t)scope];
 
-    RDCDEBUG("At next offset 0x%llx, there's 0x%llx bytes available for 0x%llx bytes requested",
-             offs, avail, ret.size);
+  // find the pool for this memory type and resource kind. There are only ever a handful of these.
+  for(ret.pool = 0; ret.pool < poolList.size(); ret.pool++)
+  {
+    const MemoryPool &pool = poolList[ret.pool];
+    if(pool.type == type && pool.memoryTypeIndex == ret.memoryTypeIndex && pool.buffer == buffer)
+      break;
+  }
 
-    // if the allocation will fit, we've found our candidate.
-    if(ret.size <= avail)
-    {
-      // update the block offset and buffer/image bit
-      block.offs = offs + ret.size;
-      block.buffer = ret.buffer;
+  if(ret.pool == poolList.size())
+  {
+    RDCDEBUG("Creating new pool for memory type %u", ret.memoryTypeIndex);
 
-      // update our return value
-      ret.offs = offs;
-      ret.mem = block.mem;
+    poolList.push_back(MemoryPool());
+    poolList.back().type = type;
+    poolList.back().memoryTypeIndex = ret.memoryTypeIndex;
+    poolList.back().buffer = buffer;
+  }
 
-      RDCDEBUG("Allocating using this block: 0x%llx -> 0x%llx", ret.offs, block.offs);
+  MemoryPool &pool = poolList[ret.pool];
 
-      // stop searching
-      break;
-    }
-  }
+  uint32_t block = 0;
+  ret.range = pool.ranges.Allocate(ret.size, mrq.alignment, block, ret.offs);
 
-  if(ret.mem == VK_NULL_HANDLE)
+  if(ret.range == ~0U)
   {
-    RDCDEBUG("No available block found - allocating new block");
+    RDCDEBUG("No free range found in %u blocks - allocating new block", pool.ranges.GetBlockCount());
 
     VkDeviceSize &allocSize = m_MemoryBlockSize[(size_t)scope];
 
@@ -268,21 +537,8 @@ MemoryAllocation WrappedVulkan::AllocateMemoryForResource(bool buffer, VkMemoryR
         break;
     }
 
-    uint32_t memoryTypeIndex = 0;
-
-    switch(ret.type)
-    {
-      case MemoryType::Upload: memoryTypeIndex = GetUploadMemoryIndex(mrq.memoryTypeBits); break;
-      case MemoryType::GPULocal:
-        memoryTypeIndex = GetGPULocalMemoryIndex(mrq.memoryTypeBits);
-        break;
-      case MemoryType::Readback:
-        memoryTypeIndex = GetReadbackMemoryIndex(mrq.memoryTypeBits);
-        break;
-    }
-
     VkMemoryAllocateInfo info = {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, allocSize * 1024 * 1024, memoryTypeIndex,
+        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, allocSize * 1024 * 1024, ret.memoryTypeIndex,
     };
 
     if(ret.size > info.allocationSize)
@@ -302,32 +558,30 @@ MemoryAllocation WrappedVulkan::AllocateMemoryForResource(bool buffer, VkMemoryR
 
     RDCDEBUG("Creating new allocation of 0x%llx bytes", info.allocationSize);
 
-    MemoryAllocation chunk;
-    chunk.buffer = ret.buffer;
-    chunk.memoryTypeIndex = memoryTypeIndex;
-    chunk.scope = scope;
-    chunk.type = type;
-    chunk.size = info.allocationSize;
-
-    // the offset starts immediately after this allocation
-    chunk.offs = ret.size;
-
     VkDevice d = GetDev();
 
+    VkDeviceMemory mem = VK_NULL_HANDLE;
+
     // do the actual allocation
-    VkResult vkr = ObjDisp(d)->AllocateMemory(Unwrap(d), &info, NULL, &chunk.mem);
+    VkResult vkr = ObjDisp(d)->AllocateMemory(Unwrap(d), &info, NULL, &mem);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    GetResourceManager()->WrapResource(Unwrap(d), chunk.mem);
+    GetResourceManager()->WrapResource(Unwrap(d), mem);
 
-    // push the new chunk
-    blockList.push_back(chunk);
+    block = pool.ranges.AddBlock(info.allocationSize);
+    RDCASSERTEQUAL(block, pool.blocks.size());
+    pool.blocks.push_back(mem);
 
-    // return the first bytes in the new chunk
-    ret.offs = 0;
-    ret.mem = chunk.mem;
+    // the new block is guaranteed to fit the allocation, since a block starts at offset 0 which
+    // satisfies any alignment.
+    ret.range = pool.ranges.Allocate(ret.size, mrq.alignment, block, ret.offs);
+    RDCASSERT(ret.range != ~0U);
   }
 
+  ret.mem = pool.blocks[block];
+
+  RDCDEBUG("Allocated at 0x%llx in block %u", ret.offs, block);
+
   return ret;
 }
 
@@ -355,23 +609,209 @@ MemoryAllocation WrappedVulkan::AllocateMemoryForResource(VkBuffer buf, MemorySc
 
 void WrappedVulkan::FreeAllMemory(MemoryScope scope)
 {
-  std::vector<MemoryAllocation> &allocList = m_MemoryBlocks[(size_t)scope];
+  std::vector<MemoryPool> &poolList = m_MemoryPools[(size_t)scope];
 
-  if(allocList.empty())
+  if(poolList.empty())
     return;
 
   VkDevice d = GetDev();
 
-  for(MemoryAllocation alloc : allocList)
+  for(MemoryPool &pool : poolList)
   {
-    ObjDisp(d)->FreeMemory(Unwrap(d), Unwrap(alloc.mem), NULL);
-    GetResourceManager()->ReleaseWrappedResource(alloc.mem);
+    for(VkDeviceMemory mem : pool.blocks)
+    {
+      ObjDisp(d)->FreeMemory(Unwrap(d), Unwrap(mem), NULL);
+      GetResourceManager()->ReleaseWrappedResource(mem);
+    }
   }
 
-  allocList.clear();
+  poolList.clear();
 }
 
 void WrappedVulkan::FreeMemoryAllocation(MemoryAllocation alloc)
 {
-  // don't do anything at the moment, we only support freeing the whole scope at once.
+  if(alloc.mem == VK_NULL_HANDLE)
+    return;
+
+  std::vector<MemoryPool> &poolList = m_MemoryPools[(size_t)alloc.scope];
+
+  if(alloc.pool < poolList.size())
+  {
+    MemoryPool &pool = poolList[alloc.pool];
+
+    uint32_t block = pool.ranges.GetRangeBlock(alloc.range);
+
+    if(block < pool.blocks.size() && pool.blocks[block] == alloc.mem &&
+       pool.ranges.Free(alloc.range, alloc.offs))
+      return;
+  }
+
+  RDCERR("Freeing allocation at 0x%llx in %s that isn't currently allocated", alloc.offs,
+         ToStr(alloc.scope).c_str());
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#undef None
+
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Vulkan memory sub-allocator", "[vulkan]")
+{
+  TLSFAllocator alloc;
+
+  uint32_t block = ~0U;
+  VkDeviceSize offs = ~0ULL;
+
+  SECTION("Empty allocator")
+  {
+    CHECK(alloc.Allocate(16, 1, block, offs) == ~0U);
+    CHECK(alloc.GetBlockCount() == 0);
+  };
+
+  SECTION("Allocations are packed and aligned")
+  {
+    CHECK(alloc.AddBlock(1024) == 0);
+
+    uint32_t a = alloc.Allocate(100, 1, block, offs);
+    CHECK(a != ~0U);
+    CHECK(block == 0);
+    CHECK(offs == 0);
+
+    uint32_t b = alloc.Allocate(100, 256, block, offs);
+    CHECK(b != ~0U);
+    CHECK(offs == 256);
+
+    uint32_t c = alloc.Allocate(100, 1, block, offs);
+    CHECK(c != ~0U);
+    CHECK(offs >= 100);
+    CHECK(offs + 100 <= 256);
+
+    CHECK(alloc.GetAllocatedBytes() == 300);
+
+    // 1024 - 356 bytes remaining, but not 700
+    CHECK(alloc.Allocate(700, 1, block, offs) == ~0U);
+  };
+
+  SECTION("Freed ranges are merged and reused")
+  {
+    alloc.AddBlock(1024);
+
+    uint32_t ranges[4];
+    for(uint32_t i = 0; i < 4; i++)
+    {
+      ranges[i] = alloc.Allocate(256, 1, block, offs);
+      CHECK(ranges[i] != ~0U);
+      CHECK(offs == i * 256);
+    }
+
+    CHECK(alloc.Allocate(1, 1, block, offs) == ~0U);
+
+    // free in an order that needs merging in both directions
+    CHECK(alloc.Free(ranges[1], 256));
+    CHECK(alloc.Free(ranges[3], 768));
+    CHECK(alloc.Free(ranges[2], 512));
+
+    // freeing twice, or with the wrong offset, fails
+    CHECK_FALSE(alloc.Free(ranges[2], 512));
+    CHECK_FALSE(alloc.Free(ranges[0], 256));
+
+    uint32_t big = alloc.Allocate(768, 1, block, offs);
+    CHECK(big != ~0U);
+    CHECK(offs == 256);
+
+    CHECK(alloc.Free(ranges[0], 0));
+    CHECK(alloc.Free(big, 256));
+
+    CHECK(alloc.GetAllocatedBytes() == 0);
+
+    CHECK(alloc.Allocate(1024, 1, block, offs) != ~0U);
+    CHECK(offs == 0);
+  };
+
+  SECTION("Exactly sized blocks are used")
+  {
+    const VkDeviceSize sizes[] = {1000, 12345, 0x100001, 0x1ffffff};
+
+    for(VkDeviceSize size : sizes)
+    {
+      uint32_t newBlock = alloc.AddBlock(size);
+
+      CHECK(alloc.Allocate(size, 1, block, offs) != ~0U);
+      CHECK(block == newBlock);
+      CHECK(offs == 0);
+    }
+  };
+
+  SECTION("Randomised allocations never overlap")
+  {
+    const uint32_t numBlocks = 4;
+    const VkDeviceSize blockSize = 1024 * 1024;
+
+    for(uint32_t i = 0; i < numBlocks; i++)
+      alloc.AddBlock(blockSize);
+
+    struct Live
+    {
+      uint32_t range, block;
+      VkDeviceSize offs, size;
+    };
+
+    std::vector<Live> live;
+
+    uint32_t seed = 12345;
+    auto rand = [&seed]() {
+      seed = seed * 1103515245 + 12345;
+      return (seed >> 8) & 0xffff;
+    };
+
+    for(int iter = 0; iter < 5000; iter++)
+    {
+      if(live.empty() || (rand() % 3) != 0)
+      {
+        Live l;
+        l.size = 1 + rand() % 20000;
+        VkDeviceSize alignment = VkDeviceSize(1) << (rand() % 9);
+
+        l.range = alloc.Allocate(l.size, alignment, l.block, l.offs);
+
+        if(l.range == ~0U)
+          continue;
+
+        CHECK((l.offs % alignment) == 0);
+        CHECK(l.offs + l.size <= blockSize);
+
+        for(const Live &o : live)
+        {
+          if(o.block == l.block)
+          {
+            bool overlap = l.offs < o.offs + o.size && o.offs < l.offs + l.size;
+            CHECK_FALSE(overlap);
+          }
+        }
+
+        live.push_back(l);
+      }
+      else
+      {
+        size_t idx = rand() % live.size();
+        CHECK(alloc.Free(live[idx].range, live[idx].offs));
+        live.erase(live.begin() + idx);
+      }
+    }
+
+    for(const Live &l : live)
+      CHECK(alloc.Free(l.range, l.offs));
+
+    CHECK(alloc.GetAllocatedBytes() == 0);
+
+    // everything should have merged back into whole blocks
+    for(uint32_t i = 0; i < numBlocks; i++)
+    {
+      CHECK(alloc.Allocate(blockSize, 1, block, offs) != ~0U);
+      CHECK(offs == 0);
+    }
+  };
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
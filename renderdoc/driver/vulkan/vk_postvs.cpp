@@ -1276,22 +1276,94 @@ static void AddXFBAnnotations(const ShaderReflection &refl, const SPIRVPatchData
   }
 }
 
-void VulkanReplay::ClearPostVSCache()
+void VulkanReplay::FreePostVSData(VulkanPostVSData &data)
 {
   VkDevice dev = m_Device;
 
+  for(VulkanPostVSData::StageData *stage : {&data.vsout, &data.gsout})
+  {
+    if(stage->idxbuf != VK_NULL_HANDLE)
+    {
+      m_pDriver->vkDestroyBuffer(dev, stage->idxbuf, NULL);
+      m_pDriver->FreeMemoryAllocation(stage->idxbufmem);
+      m_PostVS.BytesUsed -= stage->idxbufmem.size;
+    }
+
+    if(stage->buf != VK_NULL_HANDLE)
+    {
+      m_pDriver->vkDestroyBuffer(dev, stage->buf, NULL);
+      m_pDriver->FreeMemoryAllocation(stage->bufmem);
+      m_PostVS.BytesUsed -= stage->bufmem.size;
+    }
+
+    stage->idxbuf = stage->buf = VK_NULL_HANDLE;
+    stage->idxbufmem = stage->bufmem = MemoryAllocation();
+  }
+}
+
+void VulkanReplay::EvictPostVSData()
+{
+  if(m_PostVS.BytesUsed <= m_PostVS.Budget)
+    return;
+
+  // gather everything that isn't in use by the current epoch, oldest first
+  std::vector<rdcpair<uint64_t, uint32_t>> candidates;
   for(auto it = m_PostVS.Data.begin(); it != m_PostVS.Data.end(); ++it)
+    if(it->second.lastUse != m_PostVS.Epoch)
+      candidates.push_back({it->second.lastUse, it->first});
+
+  if(candidates.empty())
+    return;
+
+  std::sort(candidates.begin(), candidates.end());
+
+  // the memory may be reused by the next fetch, so make sure nothing is still reading from it
+  m_pDriver->FlushQ();
+
+  for(const rdcpair<uint64_t, uint32_t> &c : candidates)
   {
-    if(it->second.vsout.idxbuf != VK_NULL_HANDLE)
+    if(m_PostVS.BytesUsed <= m_PostVS.Budget)
+      break;
+
+    uint32_t eventId = c.second;
+
+    FreePostVSData(m_PostVS.Data[eventId]);
+    m_PostVS.Data.erase(eventId);
+    m_PostVS.Evictions++;
+
+    // any events aliased to this one will need to be fetched again themselves
+    for(auto it = m_PostVS.Alias.begin(); it != m_PostVS.Alias.end();)
     {
-      m_pDriver->vkDestroyBuffer(dev, it->second.vsout.idxbuf, NULL);
-      m_pDriver->vkFreeMemory(dev, it->second.vsout.idxbufmem, NULL);
+      if(it->second == eventId)
+        it = m_PostVS.Alias.erase(it);
+      else
+        ++it;
     }
-    m_pDriver->vkDestroyBuffer(dev, it->second.vsout.buf, NULL);
-    m_pDriver->vkFreeMemory(dev, it->second.vsout.bufmem, NULL);
   }
 
+  RDCDEBUG("Post-transform cache is using %llu bytes after eviction, budget is %llu",
+           m_PostVS.BytesUsed, m_PostVS.Budget);
+}
+
+void VulkanReplay::ClearPostVSCache()
+{
+  if(m_PostVS.Hits + m_PostVS.Misses > 0)
+    RDCLOG("Post-transform cache: %llu hits, %llu misses, %llu evictions", m_PostVS.Hits,
+           m_PostVS.Misses, m_PostVS.Evictions);
+
+  for(auto it = m_PostVS.Data.begin(); it != m_PostVS.Data.end(); ++it)
+    FreePostVSData(it->second);
+
   m_PostVS.Data.clear();
+  m_PostVS.Alias.clear();
+
+  RDCASSERTEQUAL(m_PostVS.BytesUsed, 0);
+  m_PostVS.BytesUsed = 0;
+
+  m_PostVS.Hits = m_PostVS.Misses = m_PostVS.Evictions = 0;
+
+  // release all the memory blocks as well
+  m_pDriver->FreeAllMemory(MemoryScope::PostVSCache);
 }
 
 void VulkanReplay::FetchVSOut(uint32_t eventId)
@@ -1315,7 +1387,7 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
     // empty vertex output signature
     m_PostVS.Data[eventId].vsin.topo = pipeInfo.topology;
     m_PostVS.Data[eventId].vsout.buf = VK_NULL_HANDLE;
-    m_PostVS.Data[eventId].vsout.bufmem = VK_NULL_HANDLE;
+    m_PostVS.Data[eventId].vsout.bufmem = MemoryAllocation();
     m_PostVS.Data[eventId].vsout.instStride = 0;
     m_PostVS.Data[eventId].vsout.vertStride = 0;
     m_PostVS.Data[eventId].vsout.numViews = 1;
@@ -1324,7 +1396,7 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
     m_PostVS.Data[eventId].vsout.useIndices = false;
     m_PostVS.Data[eventId].vsout.hasPosOut = false;
     m_PostVS.Data[eventId].vsout.idxbuf = VK_NULL_HANDLE;
-    m_PostVS.Data[eventId].vsout.idxbufmem = VK_NULL_HANDLE;
+    m_PostVS.Data[eventId].vsout.idxbufmem = MemoryAllocation();
 
     m_PostVS.Data[eventId].vsout.topo = pipeInfo.topology;
 
@@ -1653,14 +1725,15 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
   }
 
   VkBuffer meshBuffer = VK_NULL_HANDLE, readbackBuffer = VK_NULL_HANDLE;
-  VkDeviceMemory meshMem = VK_NULL_HANDLE, readbackMem = VK_NULL_HANDLE;
+  MemoryAllocation meshMem;
+  VkDeviceMemory readbackMem = VK_NULL_HANDLE;
 
   VkBuffer uniqIdxBuf = VK_NULL_HANDLE;
   VkDeviceMemory uniqIdxBufMem = VK_NULL_HANDLE;
   VkBufferView uniqIdxBufView = VK_NULL_HANDLE;
 
   VkBuffer rebasedIdxBuf = VK_NULL_HANDLE;
-  VkDeviceMemory rebasedIdxBufMem = VK_NULL_HANDLE;
+  MemoryAllocation rebasedIdxBufMem;
 
   uint32_t numVerts = drawcall->numIndices;
   VkDeviceSize bufSize = 0;
@@ -1891,28 +1964,33 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
 
     m_pDriver->vkGetBufferMemoryRequirements(dev, rebasedIdxBuf, &mrq);
 
-    allocInfo.allocationSize = mrq.size;
-    allocInfo.memoryTypeIndex = m_pDriver->GetUploadMemoryIndex(mrq.memoryTypeBits);
+    // this buffer is cached, so it's sub-allocated from the post-transform cache's memory. We map
+    // and flush only our region, so it must be aligned to the non-coherent atom size.
+    mrq.alignment =
+        RDCMAX(mrq.alignment, m_pDriver->GetDeviceProps().limits.nonCoherentAtomSize);
 
-    vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &rebasedIdxBufMem);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    rebasedIdxBufMem = m_pDriver->AllocateMemoryForResource(true, mrq, MemoryScope::PostVSCache,
+                                                            MemoryType::Upload);
 
-    vkr = m_pDriver->vkBindBufferMemory(dev, rebasedIdxBuf, rebasedIdxBufMem, 0);
+    vkr = m_pDriver->vkBindBufferMemory(dev, rebasedIdxBuf, rebasedIdxBufMem.mem,
+                                        rebasedIdxBufMem.offs);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    vkr = m_pDriver->vkMapMemory(m_Device, rebasedIdxBufMem, 0, VK_WHOLE_SIZE, 0, (void **)&idxData);
+    vkr = m_pDriver->vkMapMemory(m_Device, rebasedIdxBufMem.mem, rebasedIdxBufMem.offs,
+                                 rebasedIdxBufMem.size, 0, (void **)&idxData);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     memcpy(idxData, idxdata.data(), idxdata.size());
 
     VkMappedMemoryRange rebasedRange = {
-        VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL, rebasedIdxBufMem, 0, VK_WHOLE_SIZE,
+        VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL, rebasedIdxBufMem.mem, rebasedIdxBufMem.offs,
+        rebasedIdxBufMem.size,
     };
 
     vkr = m_pDriver->vkFlushMappedMemoryRanges(m_Device, 1, &rebasedRange);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    m_pDriver->vkUnmapMemory(m_Device, rebasedIdxBufMem);
+    m_pDriver->vkUnmapMemory(m_Device, rebasedIdxBufMem.mem);
   }
 
   uint32_t bufStride = 0;
@@ -2352,23 +2430,19 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
     vkr = m_pDriver->vkCreateBuffer(dev, &bufInfo, NULL, &readbackBuffer);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    VkMemoryRequirements mrq = {0};
-    m_pDriver->vkGetBufferMemoryRequirements(dev, meshBuffer, &mrq);
-
-    VkMemoryAllocateInfo allocInfo = {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
-        m_pDriver->GetGPULocalMemoryIndex(mrq.memoryTypeBits),
-    };
+    meshMem = m_pDriver->AllocateMemoryForResource(meshBuffer, MemoryScope::PostVSCache,
+                                                   MemoryType::GPULocal);
 
-    vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &meshMem);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    vkr = m_pDriver->vkBindBufferMemory(dev, meshBuffer, meshMem, 0);
+    vkr = m_pDriver->vkBindBufferMemory(dev, meshBuffer, meshMem.mem, meshMem.offs);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
+    VkMemoryRequirements mrq = {0};
     m_pDriver->vkGetBufferMemoryRequirements(dev, readbackBuffer, &mrq);
 
-    allocInfo.memoryTypeIndex = m_pDriver->GetReadbackMemoryIndex(mrq.memoryTypeBits);
+    VkMemoryAllocateInfo allocInfo = {
+        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
+        m_pDriver->GetReadbackMemoryIndex(mrq.memoryTypeBits),
+    };
 
     vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &readbackMem);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
@@ -2666,7 +2740,7 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
   {
     // empty vertex output signature
     m_PostVS.Data[eventId].gsout.buf = VK_NULL_HANDLE;
-    m_PostVS.Data[eventId].gsout.bufmem = VK_NULL_HANDLE;
+    m_PostVS.Data[eventId].gsout.bufmem = MemoryAllocation();
     m_PostVS.Data[eventId].gsout.instStride = 0;
     m_PostVS.Data[eventId].gsout.vertStride = 0;
     m_PostVS.Data[eventId].gsout.numViews = 1;
@@ -2675,7 +2749,7 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
     m_PostVS.Data[eventId].gsout.useIndices = false;
     m_PostVS.Data[eventId].gsout.hasPosOut = false;
     m_PostVS.Data[eventId].gsout.idxbuf = VK_NULL_HANDLE;
-    m_PostVS.Data[eventId].gsout.idxbufmem = VK_NULL_HANDLE;
+    m_PostVS.Data[eventId].gsout.idxbufmem = MemoryAllocation();
     return;
   }
 
@@ -2792,7 +2866,7 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
   }
 
   VkBuffer meshBuffer = VK_NULL_HANDLE;
-  VkDeviceMemory meshMem = VK_NULL_HANDLE;
+  MemoryAllocation meshMem;
 
   // start with bare minimum size, which might be enough if no expansion happens
   VkDeviceSize bufferSize = 0;
@@ -2808,10 +2882,10 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
     if(meshBuffer != VK_NULL_HANDLE)
     {
       m_pDriver->vkDestroyBuffer(dev, meshBuffer, NULL);
-      m_pDriver->vkFreeMemory(dev, meshMem, NULL);
+      m_pDriver->FreeMemoryAllocation(meshMem);
 
       meshBuffer = VK_NULL_HANDLE;
-      meshMem = VK_NULL_HANDLE;
+      meshMem = MemoryAllocation();
     }
 
     VkBufferCreateInfo bufInfo = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
@@ -2826,18 +2900,10 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
     vkr = m_pDriver->vkCreateBuffer(dev, &bufInfo, NULL, &meshBuffer);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    VkMemoryRequirements mrq = {0};
-    m_pDriver->vkGetBufferMemoryRequirements(dev, meshBuffer, &mrq);
-
-    VkMemoryAllocateInfo allocInfo = {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
-        m_pDriver->GetGPULocalMemoryIndex(mrq.memoryTypeBits),
-    };
-
-    vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &meshMem);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    meshMem = m_pDriver->AllocateMemoryForResource(meshBuffer, MemoryScope::PostVSCache,
+                                                   MemoryType::GPULocal);
 
-    vkr = m_pDriver->vkBindBufferMemory(dev, meshBuffer, meshMem, 0);
+    vkr = m_pDriver->vkBindBufferMemory(dev, meshBuffer, meshMem.mem, meshMem.offs);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     VkCommandBuffer cmd = m_pDriver->GetNextCmd();
@@ -3101,7 +3167,7 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
   m_PostVS.Data[eventId].gsout.instData = instData;
 
   m_PostVS.Data[eventId].gsout.idxbuf = VK_NULL_HANDLE;
-  m_PostVS.Data[eventId].gsout.idxbufmem = VK_NULL_HANDLE;
+  m_PostVS.Data[eventId].gsout.idxbufmem = MemoryAllocation();
 
   m_PostVS.Data[eventId].gsout.hasPosOut = true;
 
@@ -3122,8 +3188,17 @@ void VulkanReplay::InitPostVSBuffers(uint32_t eventId)
   if(m_PostVS.Alias.find(eventId) != m_PostVS.Alias.end())
     eventId = m_PostVS.Alias[eventId];
 
-  if(m_PostVS.Data.find(eventId) != m_PostVS.Data.end())
+  // outside of a pass, each request for an event is a new use
+  if(!m_PostVS.PassActive)
+    m_PostVS.Epoch++;
+
+  auto it = m_PostVS.Data.find(eventId);
+  if(it != m_PostVS.Data.end())
+  {
+    it->second.lastUse = m_PostVS.Epoch;
+    m_PostVS.Hits++;
     return;
+  }
 
   const VulkanRenderState &state = m_pDriver->m_RenderState;
   VulkanCreationInfo &creationInfo = m_pDriver->m_CreationInfo;
@@ -3141,21 +3216,36 @@ void VulkanReplay::InitPostVSBuffers(uint32_t eventId)
   if(drawcall == NULL || drawcall->numIndices == 0 || drawcall->numInstances == 0)
     return;
 
+  m_PostVS.Misses++;
+
   VkMarkerRegion::Begin(StringFormat::Fmt("FetchVSOut for %u", eventId));
 
   FetchVSOut(eventId);
 
   VkMarkerRegion::End();
 
-  // if there's no tessellation or geometry shader active, bail out now
-  if(pipeInfo.shaders[2].module == ResourceId() && pipeInfo.shaders[3].module == ResourceId())
-    return;
+  // if there's a tessellation or geometry shader active, fetch its output too
+  if(pipeInfo.shaders[2].module != ResourceId() || pipeInfo.shaders[3].module != ResourceId())
+  {
+    VkMarkerRegion::Begin(StringFormat::Fmt("FetchTessGSOut for %u", eventId));
 
-  VkMarkerRegion::Begin(StringFormat::Fmt("FetchTessGSOut for %u", eventId));
+    FetchTessGSOut(eventId);
 
-  FetchTessGSOut(eventId);
+    VkMarkerRegion::End();
+  }
 
-  VkMarkerRegion::End();
+  it = m_PostVS.Data.find(eventId);
+  if(it != m_PostVS.Data.end())
+  {
+    VulkanPostVSData &data = it->second;
+
+    data.lastUse = m_PostVS.Epoch;
+
+    m_PostVS.BytesUsed += data.vsout.bufmem.size + data.vsout.idxbufmem.size +
+                          data.gsout.bufmem.size + data.gsout.idxbufmem.size;
+  }
+
+  EvictPostVSData();
 }
 
 struct VulkanInitPostVSCallback : public VulkanDrawcallCallback
@@ -3202,10 +3292,17 @@ void VulkanReplay::InitPostVSBuffers(const vector<uint32_t> &events)
 
   VulkanInitPostVSCallback cb(m_pDriver, events);
 
+  // all events in the pass share an epoch so that none of them are evicted to make room for
+  // another event in the same pass.
+  m_PostVS.Epoch++;
+  m_PostVS.PassActive = true;
+
   // now we replay the events, which are guaranteed (because we generated them in
   // GetPassEvents above) to come from the same command buffer, so the event IDs are
   // still locally continuous, even if we jump into replaying.
   m_pDriver->ReplayLog(events.front(), events.back(), eReplay_Full);
+
+  m_PostVS.PassActive = false;
 }
 
 MeshFormat VulkanReplay::GetPostVSBuffers(uint32_t eventId, uint32_t instID, uint32_t viewID,
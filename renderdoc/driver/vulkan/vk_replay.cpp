@@ -337,8 +337,8 @@ ShaderReflection *VulkanReplay::GetShader(ResourceId shader, ShaderEntryPoint en
     return NULL;
   }
 
-  shad->second.m_Reflections[entry.name].Init(GetResourceManager(), shader, shad->second.spirv,
-                                              entry.name,
+  shad->second.m_Reflections[entry.name].Init(GetResourceManager(), m_pDriver->m_CreationInfo,
+                                              shader, shad->second.spirv, entry.name,
                                               VkShaderStageFlagBits(1 << uint32_t(entry.stage)));
 
   return &shad->second.m_Reflections[entry.name].refl;
@@ -857,6 +857,222 @@ void VulkanReplay::SetDriverInformation(const VkPhysicalDeviceProperties &props)
   memcpy(m_DriverInfo.version, versionString.c_str(), versionString.size());
 }
 
+void VulkanReplay::FillBindingElement(VKPipe::BindingElement &el,
+                                      const DescSetLayout::Binding &layoutBind,
+                                      const DescriptorSetSlot *info, uint32_t a)
+{
+  VulkanCreationInfo &c = m_pDriver->m_CreationInfo;
+
+  VulkanResourceManager *rm = m_pDriver->GetResourceManager();
+
+  const bool dynamicOffset =
+      layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+      layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+
+  if(layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+     layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+  {
+    if(layoutBind.immutableSampler)
+    {
+      el.samplerResourceId = layoutBind.immutableSampler[a];
+      el.immutableSampler = true;
+    }
+    else if(info[a].imageInfo.sampler != VK_NULL_HANDLE)
+    {
+      el.samplerResourceId = GetResID(info[a].imageInfo.sampler);
+    }
+
+    if(el.samplerResourceId != ResourceId())
+    {
+      const VulkanCreationInfo::Sampler &sampl = c.m_Sampler[el.samplerResourceId];
+
+      ResourceId liveId = el.samplerResourceId;
+
+      el.samplerResourceId = rm->GetOriginalID(el.samplerResourceId);
+
+      // sampler info
+      el.filter = MakeFilter(sampl.minFilter, sampl.magFilter, sampl.mipmapMode,
+                             sampl.maxAnisotropy > 1.0f, sampl.compareEnable, sampl.reductionMode);
+      el.addressU = MakeAddressMode(sampl.address[0]);
+      el.addressV = MakeAddressMode(sampl.address[1]);
+      el.addressW = MakeAddressMode(sampl.address[2]);
+      el.mipBias = sampl.mipLodBias;
+      el.maxAnisotropy = sampl.maxAnisotropy;
+      el.compareFunction = MakeCompareFunc(sampl.compareOp);
+      el.minLOD = sampl.minLod;
+      el.maxLOD = sampl.maxLod;
+      MakeBorderColor(sampl.borderColor, (FloatVector *)el.borderColor);
+      el.unnormalized = sampl.unnormalizedCoordinates;
+
+      if(sampl.ycbcr != ResourceId())
+      {
+        const VulkanCreationInfo::YCbCrSampler &ycbcr = c.m_YCbCrSampler[sampl.ycbcr];
+        el.ycbcrSampler = rm->GetOriginalID(sampl.ycbcr);
+
+        el.ycbcrModel = ycbcr.ycbcrModel;
+        el.ycbcrRange = ycbcr.ycbcrRange;
+        memcpy(el.ycbcrSwizzle, ycbcr.swizzle, sizeof(TextureSwizzle) * 4);
+        el.xChromaOffset = ycbcr.xChromaOffset;
+        el.yChromaOffset = ycbcr.yChromaOffset;
+        el.chromaFilter = ycbcr.chromaFilter;
+        el.forceExplicitReconstruction = ycbcr.forceExplicitReconstruction;
+      }
+    }
+  }
+
+  if(layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
+     layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
+     layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT ||
+     layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+  {
+    VkImageView view = info[a].imageInfo.imageView;
+
+    if(view != VK_NULL_HANDLE)
+    {
+      ResourceId viewid = GetResID(view);
+
+      el.viewResourceId = rm->GetOriginalID(viewid);
+      el.resourceResourceId = rm->GetOriginalID(c.m_ImageView[viewid].image);
+      el.viewFormat = MakeResourceFormat(c.m_ImageView[viewid].format);
+
+      memcpy(el.swizzle, c.m_ImageView[viewid].swizzle,
+             sizeof(TextureSwizzle) * 4);
+      el.firstMip = c.m_ImageView[viewid].range.baseMipLevel;
+      el.firstSlice = c.m_ImageView[viewid].range.baseArrayLayer;
+      el.numMips = c.m_ImageView[viewid].range.levelCount;
+      el.numSlices = c.m_ImageView[viewid].range.layerCount;
+
+      // temporary hack, store image layout enum in byteOffset as it's not used for images
+      el.byteOffset = info[a].imageInfo.imageLayout;
+    }
+    else
+    {
+      el.viewResourceId = ResourceId();
+      el.resourceResourceId = ResourceId();
+      el.firstMip = 0;
+      el.firstSlice = 0;
+      el.numMips = 1;
+      el.numSlices = 1;
+    }
+  }
+  if(layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER ||
+     layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER)
+  {
+    VkBufferView view = info[a].texelBufferView;
+
+    if(view != VK_NULL_HANDLE)
+    {
+      ResourceId viewid = GetResID(view);
+
+      el.viewResourceId = rm->GetOriginalID(viewid);
+      el.resourceResourceId = rm->GetOriginalID(c.m_BufferView[viewid].buffer);
+      el.byteOffset = c.m_BufferView[viewid].offset;
+      el.viewFormat = MakeResourceFormat(c.m_BufferView[viewid].format);
+      if(dynamicOffset)
+      {
+        union
+        {
+          VkImageLayout l;
+          uint32_t u;
+        } offs;
+
+        RDCCOMPILE_ASSERT(sizeof(VkImageLayout) == sizeof(uint32_t),
+                          "VkImageLayout isn't 32-bit sized");
+
+        offs.l = info[a].imageInfo.imageLayout;
+
+        el.byteOffset += offs.u;
+      }
+      el.byteSize = c.m_BufferView[viewid].size;
+    }
+    else
+    {
+      el.viewResourceId = ResourceId();
+      el.resourceResourceId = ResourceId();
+      el.byteOffset = 0;
+      el.byteSize = 0;
+    }
+  }
+  if(layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
+     layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC ||
+     layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
+     layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+  {
+    el.viewResourceId = ResourceId();
+
+    if(info[a].bufferInfo.buffer != VK_NULL_HANDLE)
+      el.resourceResourceId = rm->GetOriginalID(GetResID(info[a].bufferInfo.buffer));
+
+    el.byteOffset = info[a].bufferInfo.offset;
+    if(dynamicOffset)
+    {
+      union
+      {
+        VkImageLayout l;
+        uint32_t u;
+      } offs;
+
+      RDCCOMPILE_ASSERT(sizeof(VkImageLayout) == sizeof(uint32_t),
+                        "VkImageLayout isn't 32-bit sized");
+
+      offs.l = info[a].imageInfo.imageLayout;
+
+      el.byteOffset += offs.u;
+    }
+
+    el.byteSize = info[a].bufferInfo.range;
+  }
+}
+
+void VulkanReplay::SetLazyDescriptorThreshold(uint32_t maxElements)
+{
+  if(m_LazyDescriptorThreshold == maxElements)
+    return;
+
+  m_LazyDescriptorThreshold = maxElements;
+
+  // anything we filled out previously was with the old threshold
+  m_DescSetCache[0].clear();
+  m_DescSetCache[1].clear();
+}
+
+rdcarray<VKPipe::BindingElement> VulkanReplay::GetVulkanDescriptorBindings(bool compute,
+                                                                           uint32_t set,
+                                                                           uint32_t binding,
+                                                                           uint32_t firstElement,
+                                                                           uint32_t count)
+{
+  rdcarray<VKPipe::BindingElement> ret;
+
+  const VulkanRenderState &state = m_pDriver->m_RenderState;
+
+  const vector<VulkanRenderState::Pipeline::DescriptorAndOffsets> &descSets =
+      compute ? state.compute.descSets : state.graphics.descSets;
+
+  if(set >= descSets.size())
+    return ret;
+
+  const WrappedVulkan::DescriptorSetInfo &setInfo =
+      m_pDriver->m_DescriptorSetState[descSets[set].descSet];
+
+  if(binding >= setInfo.currentBindings.size())
+    return ret;
+
+  const DescSetLayout::Binding &layoutBind =
+      m_pDriver->m_CreationInfo.m_DescSetLayout[setInfo.layout].bindings[binding];
+
+  if(firstElement >= layoutBind.descriptorCount)
+    return ret;
+
+  count = RDCMIN(count, layoutBind.descriptorCount - firstElement);
+
+  ret.resize(count);
+  for(uint32_t a = 0; a < count; a++)
+    FillBindingElement(ret[a], layoutBind, setInfo.currentBindings[binding], firstElement + a);
+
+  return ret;
+}
+
 void VulkanReplay::SavePipelineState()
 {
   const VulkanRenderState &state = m_pDriver->m_RenderState;
@@ -864,6 +1080,11 @@ void VulkanReplay::SavePipelineState()
 
   VulkanResourceManager *rm = m_pDriver->GetResourceManager();
 
+  // keep the previous descriptor sets around, so that any which haven't changed can be reused
+  rdcarray<VKPipe::DescriptorSet> prevDescSets[2];
+  prevDescSets[0].swap(m_VulkanPipelineState.graphics.descriptorSets);
+  prevDescSets[1].swap(m_VulkanPipelineState.compute.descriptorSets);
+
   m_VulkanPipelineState = VKPipe::State();
 
   m_VulkanPipelineState.pushconsts.resize(state.pushConstSize);
@@ -1344,12 +1565,31 @@ void VulkanReplay::SavePipelineState()
 
     for(size_t p = 0; p < ARRAY_COUNT(srcs); p++)
     {
+      m_DescSetCache[p].resize(srcs[p]->size());
+
       for(size_t i = 0; i < srcs[p]->size(); i++)
       {
         ResourceId src = (*srcs[p])[i].descSet;
         VKPipe::DescriptorSet &dst = (*dsts[p])[i];
 
-        ResourceId layoutId = m_pDriver->m_DescriptorSetState[src].layout;
+        const WrappedVulkan::DescriptorSetInfo &setInfo = m_pDriver->m_DescriptorSetState[src];
+
+        // if the same set is bound here as for the previous state and its contents haven't changed
+        // since, take the previous contents instead of building them all again.
+        DescriptorSetCache &cache = m_DescSetCache[p][i];
+        if(i < prevDescSets[p].size() && cache.set == src && cache.version == setInfo.version)
+        {
+          dst.layoutResourceId = prevDescSets[p][i].layoutResourceId;
+          dst.descriptorSetResourceId = prevDescSets[p][i].descriptorSetResourceId;
+          dst.pushDescriptor = prevDescSets[p][i].pushDescriptor;
+          dst.bindings.swap(prevDescSets[p][i].bindings);
+          continue;
+        }
+
+        cache.set = src;
+        cache.version = setInfo.version;
+
+        ResourceId layoutId = setInfo.layout;
 
         // push descriptors don't have a real descriptor set backing them
         if(c.m_DescSetLayout[layoutId].flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR)
@@ -1364,14 +1604,12 @@ void VulkanReplay::SavePipelineState()
         }
 
         dst.layoutResourceId = rm->GetOriginalID(layoutId);
-        dst.bindings.resize(m_pDriver->m_DescriptorSetState[src].currentBindings.size());
-        for(size_t b = 0; b < m_pDriver->m_DescriptorSetState[src].currentBindings.size(); b++)
+        dst.bindings.resize(setInfo.currentBindings.size());
+        for(size_t b = 0; b < setInfo.currentBindings.size(); b++)
         {
-          DescriptorSetSlot *info = m_pDriver->m_DescriptorSetState[src].currentBindings[b];
+          DescriptorSetSlot *info = setInfo.currentBindings[b];
           const DescSetLayout::Binding &layoutBind = c.m_DescSetLayout[layoutId].bindings[b];
 
-          bool dynamicOffset = false;
-
           dst.bindings[b].descriptorCount = layoutBind.descriptorCount;
           dst.bindings[b].stageFlags = (ShaderStageMask)layoutBind.stageFlags;
           switch(layoutBind.descriptorType)
@@ -1393,18 +1631,12 @@ void VulkanReplay::SavePipelineState()
               dst.bindings[b].type = BindType::ReadWriteTBuffer;
               break;
             case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-              dst.bindings[b].type = BindType::ConstantBuffer;
-              break;
-            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-              dst.bindings[b].type = BindType::ReadWriteBuffer;
-              break;
             case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
               dst.bindings[b].type = BindType::ConstantBuffer;
-              dynamicOffset = true;
               break;
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
             case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
               dst.bindings[b].type = BindType::ReadWriteBuffer;
-              dynamicOffset = true;
               break;
             case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
               dst.bindings[b].type = BindType::InputAttachment;
@@ -1412,170 +1644,14 @@ void VulkanReplay::SavePipelineState()
             default: dst.bindings[b].type = BindType::Unknown; RDCERR("Unexpected descriptor type");
           }
 
+          // in lazy mode, large arrays are left empty and fetched on demand with
+          // GetVulkanDescriptorBindings
+          if(m_LazyDescriptorThreshold > 0 && layoutBind.descriptorCount > m_LazyDescriptorThreshold)
+            continue;
+
           dst.bindings[b].binds.resize(layoutBind.descriptorCount);
           for(uint32_t a = 0; a < layoutBind.descriptorCount; a++)
-          {
-            if(layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
-               layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
-            {
-              if(layoutBind.immutableSampler)
-              {
-                dst.bindings[b].binds[a].samplerResourceId = layoutBind.immutableSampler[a];
-                dst.bindings[b].binds[a].immutableSampler = true;
-              }
-              else if(info[a].imageInfo.sampler != VK_NULL_HANDLE)
-              {
-                dst.bindings[b].binds[a].samplerResourceId = GetResID(info[a].imageInfo.sampler);
-              }
-
-              if(dst.bindings[b].binds[a].samplerResourceId != ResourceId())
-              {
-                VKPipe::BindingElement &el = dst.bindings[b].binds[a];
-                const VulkanCreationInfo::Sampler &sampl = c.m_Sampler[el.samplerResourceId];
-
-                ResourceId liveId = el.samplerResourceId;
-
-                el.samplerResourceId = rm->GetOriginalID(el.samplerResourceId);
-
-                // sampler info
-                el.filter = MakeFilter(sampl.minFilter, sampl.magFilter, sampl.mipmapMode,
-                                       sampl.maxAnisotropy > 1.0f, sampl.compareEnable,
-                                       sampl.reductionMode);
-                el.addressU = MakeAddressMode(sampl.address[0]);
-                el.addressV = MakeAddressMode(sampl.address[1]);
-                el.addressW = MakeAddressMode(sampl.address[2]);
-                el.mipBias = sampl.mipLodBias;
-                el.maxAnisotropy = sampl.maxAnisotropy;
-                el.compareFunction = MakeCompareFunc(sampl.compareOp);
-                el.minLOD = sampl.minLod;
-                el.maxLOD = sampl.maxLod;
-                MakeBorderColor(sampl.borderColor, (FloatVector *)el.borderColor);
-                el.unnormalized = sampl.unnormalizedCoordinates;
-
-                if(sampl.ycbcr != ResourceId())
-                {
-                  const VulkanCreationInfo::YCbCrSampler &ycbcr = c.m_YCbCrSampler[sampl.ycbcr];
-                  el.ycbcrSampler = rm->GetOriginalID(sampl.ycbcr);
-
-                  el.ycbcrModel = ycbcr.ycbcrModel;
-                  el.ycbcrRange = ycbcr.ycbcrRange;
-                  memcpy(el.ycbcrSwizzle, ycbcr.swizzle, sizeof(TextureSwizzle) * 4);
-                  el.xChromaOffset = ycbcr.xChromaOffset;
-                  el.yChromaOffset = ycbcr.yChromaOffset;
-                  el.chromaFilter = ycbcr.chromaFilter;
-                  el.forceExplicitReconstruction = ycbcr.forceExplicitReconstruction;
-                }
-              }
-            }
-
-            if(layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
-               layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
-               layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT ||
-               layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
-            {
-              VkImageView view = info[a].imageInfo.imageView;
-
-              if(view != VK_NULL_HANDLE)
-              {
-                ResourceId viewid = GetResID(view);
-
-                dst.bindings[b].binds[a].viewResourceId = rm->GetOriginalID(viewid);
-                dst.bindings[b].binds[a].resourceResourceId =
-                    rm->GetOriginalID(c.m_ImageView[viewid].image);
-                dst.bindings[b].binds[a].viewFormat =
-                    MakeResourceFormat(c.m_ImageView[viewid].format);
-
-                memcpy(dst.bindings[b].binds[a].swizzle, c.m_ImageView[viewid].swizzle,
-                       sizeof(TextureSwizzle) * 4);
-                dst.bindings[b].binds[a].firstMip = c.m_ImageView[viewid].range.baseMipLevel;
-                dst.bindings[b].binds[a].firstSlice = c.m_ImageView[viewid].range.baseArrayLayer;
-                dst.bindings[b].binds[a].numMips = c.m_ImageView[viewid].range.levelCount;
-                dst.bindings[b].binds[a].numSlices = c.m_ImageView[viewid].range.layerCount;
-
-                // temporary hack, store image layout enum in byteOffset as it's not used for images
-                dst.bindings[b].binds[a].byteOffset = info[a].imageInfo.imageLayout;
-              }
-              else
-              {
-                dst.bindings[b].binds[a].viewResourceId = ResourceId();
-                dst.bindings[b].binds[a].resourceResourceId = ResourceId();
-                dst.bindings[b].binds[a].firstMip = 0;
-                dst.bindings[b].binds[a].firstSlice = 0;
-                dst.bindings[b].binds[a].numMips = 1;
-                dst.bindings[b].binds[a].numSlices = 1;
-              }
-            }
-            if(layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER ||
-               layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER)
-            {
-              VkBufferView view = info[a].texelBufferView;
-
-              if(view != VK_NULL_HANDLE)
-              {
-                ResourceId viewid = GetResID(view);
-
-                dst.bindings[b].binds[a].viewResourceId = rm->GetOriginalID(viewid);
-                dst.bindings[b].binds[a].resourceResourceId =
-                    rm->GetOriginalID(c.m_BufferView[viewid].buffer);
-                dst.bindings[b].binds[a].byteOffset = c.m_BufferView[viewid].offset;
-                dst.bindings[b].binds[a].viewFormat =
-                    MakeResourceFormat(c.m_BufferView[viewid].format);
-                if(dynamicOffset)
-                {
-                  union
-                  {
-                    VkImageLayout l;
-                    uint32_t u;
-                  } offs;
-
-                  RDCCOMPILE_ASSERT(sizeof(VkImageLayout) == sizeof(uint32_t),
-                                    "VkImageLayout isn't 32-bit sized");
-
-                  offs.l = info[a].imageInfo.imageLayout;
-
-                  dst.bindings[b].binds[a].byteOffset += offs.u;
-                }
-                dst.bindings[b].binds[a].byteSize = c.m_BufferView[viewid].size;
-              }
-              else
-              {
-                dst.bindings[b].binds[a].viewResourceId = ResourceId();
-                dst.bindings[b].binds[a].resourceResourceId = ResourceId();
-                dst.bindings[b].binds[a].byteOffset = 0;
-                dst.bindings[b].binds[a].byteSize = 0;
-              }
-            }
-            if(layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
-               layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC ||
-               layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
-               layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
-            {
-              dst.bindings[b].binds[a].viewResourceId = ResourceId();
-
-              if(info[a].bufferInfo.buffer != VK_NULL_HANDLE)
-                dst.bindings[b].binds[a].resourceResourceId =
-                    rm->GetOriginalID(GetResID(info[a].bufferInfo.buffer));
-
-              dst.bindings[b].binds[a].byteOffset = info[a].bufferInfo.offset;
-              if(dynamicOffset)
-              {
-                union
-                {
-                  VkImageLayout l;
-                  uint32_t u;
-                } offs;
-
-                RDCCOMPILE_ASSERT(sizeof(VkImageLayout) == sizeof(uint32_t),
-                                  "VkImageLayout isn't 32-bit sized");
-
-                offs.l = info[a].imageInfo.imageLayout;
-
-                dst.bindings[b].binds[a].byteOffset += offs.u;
-              }
-
-              dst.bindings[b].binds[a].byteSize = info[a].bufferInfo.range;
-            }
-          }
+            FillBindingElement(dst.bindings[b].binds[a], layoutBind, info, a);
         }
       }
     }
@@ -3530,6 +3606,9 @@ void VulkanReplay::FreeTargetResource(ResourceId id)
 
 void VulkanReplay::ReplaceResource(ResourceId from, ResourceId to)
 {
+  // replayed state with the old resources can't be stepped forward from
+  m_pDriver->ResetReplayPosition();
+
   VkDevice dev = m_pDriver->GetDev();
 
   VulkanResourceManager *rm = m_pDriver->GetResourceManager();
@@ -3609,6 +3688,9 @@ void VulkanReplay::ReplaceResource(ResourceId from, ResourceId to)
 
 void VulkanReplay::RemoveReplacement(ResourceId id)
 {
+  // replayed state with the old resources can't be stepped forward from
+  m_pDriver->ResetReplayPosition();
+
   VkDevice dev = m_pDriver->GetDev();
 
   VulkanResourceManager *rm = m_pDriver->GetResourceManager();
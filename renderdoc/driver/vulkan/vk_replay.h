@@ -125,6 +125,7 @@ class WrappedVulkan;
 class VulkanDebugManager;
 class VulkanResourceManager;
 struct VulkanAMDDrawCallback;
+struct VulkanGPUTimerCallback;
 
 struct VulkanPostVSData
 {
@@ -137,7 +138,7 @@ struct VulkanPostVSData
   struct StageData
   {
     VkBuffer buf;
-    VkDeviceMemory bufmem;
+    MemoryAllocation bufmem;
     VkPrimitiveTopology topo;
 
     int32_t baseVertex;
@@ -153,7 +154,7 @@ struct VulkanPostVSData
 
     bool useIndices;
     VkBuffer idxbuf;
-    VkDeviceMemory idxbufmem;
+    MemoryAllocation idxbufmem;
     VkIndexType idxFmt;
 
     bool hasPosOut;
@@ -162,6 +163,9 @@ struct VulkanPostVSData
     float farPlane;
   } vsin, vsout, gsout;
 
+  // the post-transform cache epoch when this data was last used
+  uint64_t lastUse = 0;
+
   VulkanPostVSData()
   {
     RDCEraseEl(vsin);
@@ -224,6 +228,10 @@ public:
   const D3D12Pipe::State *GetD3D12PipelineState() { return NULL; }
   const GLPipe::State *GetGLPipelineState() { return NULL; }
   const VKPipe::State *GetVulkanPipelineState() { return &m_VulkanPipelineState; }
+  void SetLazyDescriptorThreshold(uint32_t maxElements);
+  rdcarray<VKPipe::BindingElement> GetVulkanDescriptorBindings(bool compute, uint32_t set,
+                                                               uint32_t binding,
+                                                               uint32_t firstElement, uint32_t count);
   void FreeTargetResource(ResourceId id);
 
   ReplayStatus ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers);
@@ -346,6 +354,8 @@ public:
 private:
   void FetchVSOut(uint32_t eventId);
   void FetchTessGSOut(uint32_t eventId);
+  void FreePostVSData(VulkanPostVSData &data);
+  void EvictPostVSData();
 
   bool RenderTextureInternal(TextureDisplay cfg, VkRenderPassBeginInfo rpbegin, int flags);
 
@@ -616,6 +626,19 @@ private:
 
     std::map<uint32_t, VulkanPostVSData> Data;
     std::map<uint32_t, uint32_t> Alias;
+
+    // the cache is bounded by the total size of the sub-allocations backing Data. Entries are given
+    // the current epoch whenever they're fetched or hit, and once we're over budget the least
+    // recently used entries are evicted. The epoch only advances once per pass when fetching
+    // several events together, so everything used by the current pass is kept resident.
+    VkDeviceSize Budget = 256 * 1024 * 1024;
+    VkDeviceSize BytesUsed = 0;
+    uint64_t Epoch = 0;
+    bool PassActive = false;
+
+    uint64_t Hits = 0;
+    uint64_t Misses = 0;
+    uint64_t Evictions = 0;
   } m_PostVS;
 
   std::vector<ResourceDescription> m_Resources;
@@ -623,14 +646,49 @@ private:
 
   VKPipe::State m_VulkanPipelineState;
 
+  // descriptor bindings with more array elements than this are left empty in the pipeline state,
+  // to be fetched on demand. 0 means everything is filled out.
+  uint32_t m_LazyDescriptorThreshold = 0;
+
+  // the descriptor set and its version that each descriptor set in the pipeline state was last
+  // filled from, for graphics and compute. Lets us reuse sets that haven't changed between events.
+  struct DescriptorSetCache
+  {
+    ResourceId set;
+    uint64_t version = ~0ULL;
+  };
+  std::vector<DescriptorSetCache> m_DescSetCache[2];
+
+  void FillBindingElement(VKPipe::BindingElement &el, const DescSetLayout::Binding &layoutBind,
+                          const DescriptorSetSlot *info, uint32_t a);
+
   DriverInformation m_DriverInfo;
 
   void CreateTexImageView(VkImage liveIm, const VulkanCreationInfo::Image &iminfo,
                           CompType typeHint, TextureDisplayViews &views);
 
-  void FillTimersAMD(uint32_t *eventStartID, uint32_t *sampleIndex, vector<uint32_t> *eventIDs);
+  void FillTimersAMD(uint32_t *eventStartID, uint32_t *sampleIndex, vector<uint32_t> *eventIDs,
+                     VulkanGPUTimerCallback *queries);
+
+  // replayed is set to whether the capture was replayed, and so whether queries were filled in.
+  vector<CounterResult> FetchCountersAMD(const vector<GPUCounter> &counters,
+                                         VulkanGPUTimerCallback *queries, bool &replayed);
+
+  void PrepareCounterQueries(uint32_t maxEID, bool timeStamps, bool occlusion, bool pipeStats);
+  void GetCounterQueryResults(const VulkanGPUTimerCallback &cb,
+                              const vector<GPUCounter> &vkCounters, vector<CounterResult> &ret);
+
+  // query pools for the generic counters, kept between FetchCounters calls and only recreated when
+  // a capture needs more queries than they hold.
+  struct CounterQueries
+  {
+    void Destroy(WrappedVulkan *driver);
 
-  vector<CounterResult> FetchCountersAMD(const vector<GPUCounter> &counters);
+    uint32_t size = 0;
+    VkQueryPool timeStamp = VK_NULL_HANDLE;
+    VkQueryPool occlusion = VK_NULL_HANDLE;
+    VkQueryPool pipeStats = VK_NULL_HANDLE;
+  } m_CounterQueries;
 
   AMDCounters *m_pAMDCounters = NULL;
   AMDRGPControl *m_RGP = NULL;
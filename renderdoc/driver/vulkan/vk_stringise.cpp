@@ -213,6 +213,7 @@ std::string DoStringise(const MemoryScope &el)
   {
     STRINGISE_ENUM_CLASS(InitialContents);
     STRINGISE_ENUM_CLASS(IndirectReadback);
+    STRINGISE_ENUM_CLASS(PostVSCache);
   }
   END_ENUM_STRINGISE()
 }
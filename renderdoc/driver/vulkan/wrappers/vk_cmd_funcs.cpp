@@ -2009,6 +2009,9 @@ bool WrappedVulkan::Serialise_vkCmdBindDescriptorSets(
               const DescSetLayout &layoutinfo =
                   m_CreationInfo.m_DescSetLayout[descSetLayouts[firstSet + i]];
 
+              if(layoutinfo.dynamicCount > 0)
+                m_DescriptorSetState[descId].version++;
+
               for(size_t b = 0; b < layoutinfo.bindings.size(); b++)
               {
                 // not dynamic, doesn't need an offset
@@ -3488,6 +3491,7 @@ void WrappedVulkan::ApplyPushDescriptorWrites(VkPipelineBindPoint pipelineBindPo
   }
 
   m_DescriptorSetState[setId].layout = descSetLayouts[set];
+  m_DescriptorSetState[setId].version++;
 
   // update our local tracking
   for(uint32_t i = 0; i < descriptorWriteCount; i++)
@@ -653,8 +653,9 @@ void WrappedVulkan::ReplayDescriptorSetWrite(VkDevice device, const VkWriteDescr
     ObjDisp(device)->UpdateDescriptorSets(Unwrap(device), 1, &unwrapped, 0, NULL);
 
     // update our local tracking
-    std::vector<DescriptorSetSlot *> &bindings =
-        m_DescriptorSetState[GetResID(writeDesc.dstSet)].currentBindings;
+    DescriptorSetInfo &setInfo = m_DescriptorSetState[GetResID(writeDesc.dstSet)];
+    std::vector<DescriptorSetSlot *> &bindings = setInfo.currentBindings;
+    setInfo.version++;
 
     {
       RDCASSERT(writeDesc.dstBinding < bindings.size());
@@ -735,6 +736,7 @@ void WrappedVulkan::ReplayDescriptorSetCopy(VkDevice device, const VkCopyDescrip
   // update our local tracking
   std::vector<DescriptorSetSlot *> &dstbindings = m_DescriptorSetState[dstSetId].currentBindings;
   std::vector<DescriptorSetSlot *> &srcbindings = m_DescriptorSetState[srcSetId].currentBindings;
+  m_DescriptorSetState[dstSetId].version++;
 
   {
     RDCASSERT(copyDesc.dstBinding < dstbindings.size());
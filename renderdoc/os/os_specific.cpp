@@ -25,6 +25,8 @@
 
 #include "os/os_specific.h"
 #include <stdarg.h>
+#include <algorithm>
+#include "common/threading.h"
 #include "strings/string_utils.h"
 
 using std::string;
@@ -198,6 +200,166 @@ string OSUtility::MakeMachineIdentString(uint64_t ident)
   return ret;
 }
 
+// ParallelFor hands work to a pool of worker threads shared between all calls, so that
+// back-to-back calls (e.g. one per decompression batch) don't create and destroy threads each time.
+// Workers that sit idle exit, so nothing is left running between bursts of work.
+struct ParallelForJob
+{
+  const std::function<void(uint32_t)> *func;
+  uint32_t count;
+  volatile int64_t next;
+
+  // the fields below are protected by the pool lock
+
+  // number of workers currently processing indices from this job
+  uint32_t users;
+  // set once the calling thread has run out of indices and is waiting on workers
+  bool finished;
+  Threading::Semaphore done;
+};
+
+struct ParallelForPool
+{
+  Threading::CriticalSection lock;
+  Threading::Semaphore wake;
+  std::vector<ParallelForJob *> jobs;
+  uint32_t numWorkers = 0;
+};
+
+static const uint32_t ParallelForIdleTimeoutMS = 2000;
+
+static ParallelForPool &GetParallelForPool()
+{
+  // deliberately leaked, exiting workers may still be touching it during shutdown
+  static ParallelForPool *pool = new ParallelForPool();
+  return *pool;
+}
+
+static void ProcessParallelForJob(ParallelForJob &job)
+{
+  // each thread pulls the next index off a shared counter, so uneven work per index still balances
+  // out across the threads.
+  for(;;)
+  {
+    int64_t idx = Atomic::Inc64(&job.next);
+    if(idx >= (int64_t)job.count)
+      break;
+    (*job.func)((uint32_t)idx);
+  }
+}
+
+static void ParallelForWorker()
+{
+  Threading::KeepModuleAlive();
+
+  ParallelForPool &pool = GetParallelForPool();
+
+  for(;;)
+  {
+    if(!pool.wake.Wait(ParallelForIdleTimeoutMS))
+    {
+      SCOPED_LOCK(pool.lock);
+      pool.numWorkers--;
+      break;
+    }
+
+    ParallelForJob *job = NULL;
+
+    {
+      SCOPED_LOCK(pool.lock);
+
+      for(ParallelForJob *j : pool.jobs)
+      {
+        if(j->next + 1 < (int64_t)j->count)
+        {
+          job = j;
+          job->users++;
+          break;
+        }
+      }
+    }
+
+    // the work this wakeup was for was already finished by other threads
+    if(!job)
+      continue;
+
+    ProcessParallelForJob(*job);
+
+    {
+      SCOPED_LOCK(pool.lock);
+      job->users--;
+      if(job->users == 0 && job->finished)
+        job->done.Signal();
+    }
+  }
+
+  Threading::ReleaseModuleExitThread();
+}
+
+void Threading::ParallelFor(uint32_t count, const std::function<void(uint32_t)> &func,
+                            uint32_t maxThreads)
+{
+  if(maxThreads == 0)
+    maxThreads = Threading::NumberOfCores();
+
+  uint32_t numThreads = RDCMIN(maxThreads, count);
+
+  // nothing to spread out, don't pay for any synchronisation
+  if(numThreads <= 1)
+  {
+    for(uint32_t i = 0; i < count; i++)
+      func(i);
+    return;
+  }
+
+  ParallelForJob job;
+  job.func = &func;
+  job.count = count;
+  job.next = -1;
+  job.users = 0;
+  job.finished = false;
+
+  ParallelForPool &pool = GetParallelForPool();
+
+  // the calling thread counts as one of the threads, and the pool never grows past the core count
+  uint32_t numWorkers = RDCMIN(numThreads - 1, Threading::NumberOfCores() - 1);
+
+  {
+    SCOPED_LOCK(pool.lock);
+
+    pool.jobs.push_back(&job);
+
+    while(pool.numWorkers < numWorkers)
+    {
+      Threading::ThreadHandle th = Threading::CreateThread(&ParallelForWorker);
+      if(!th)
+        break;
+      Threading::CloseThread(th);
+      pool.numWorkers++;
+    }
+  }
+
+  if(numWorkers > 0)
+    pool.wake.Signal(numWorkers);
+
+  // the calling thread does work too, and if no workers are available this processes everything.
+  ProcessParallelForJob(job);
+
+  bool wait = false;
+
+  {
+    SCOPED_LOCK(pool.lock);
+
+    pool.jobs.erase(std::find(pool.jobs.begin(), pool.jobs.end(), &job));
+    job.finished = true;
+    wait = job.users > 0;
+  }
+
+  // all indices have been claimed, wait for any workers still processing theirs
+  if(wait)
+    job.done.Wait();
+}
+
 #if ENABLED(ENABLE_UNIT_TESTS)
 
 #include "3rdparty/catch/catch.hpp"
@@ -570,6 +732,44 @@ TEST_CASE("Test OS-specific functions", "[osspecific]")
       lock.Unlock();
   };
 
+  SECTION("Parallel for")
+  {
+    CHECK(Threading::NumberOfCores() >= 1);
+
+    int values[totalCount] = {0};
+
+    // more threads than cores, to make sure indices are distributed without overlap regardless
+    Threading::ParallelFor(totalCount, [&values](uint32_t i) { values[i] += int(i) + 1; },
+                           numThreads);
+
+    for(int i = 0; i < totalCount; i++)
+      CHECK(values[i] == i + 1);
+
+    // a single thread must process everything inline, in order
+    std::vector<uint32_t> order;
+    Threading::ParallelFor(numValues, [&order](uint32_t i) { order.push_back(i); }, 1);
+
+    REQUIRE(order.size() == numValues);
+    for(uint32_t i = 0; i < numValues; i++)
+      CHECK(order[i] == i);
+
+    // repeated calls reuse the pool, and concurrent calls from several threads share it
+    volatile int32_t total = 0;
+    Threading::ParallelFor(
+        8,
+        [&total](uint32_t) {
+          for(uint32_t r = 0; r < 50; r++)
+            Threading::ParallelFor(100, [&total](uint32_t) { Atomic::Inc32(&total); });
+        },
+        8);
+    CHECK(total == 8 * 50 * 100);
+
+    // an empty range never calls the function
+    bool called = false;
+    Threading::ParallelFor(0, [&called](uint32_t) { called = true; });
+    CHECK_FALSE(called);
+  };
+
   SECTION("IP processing")
   {
     CHECK(Network::MakeIP(127, 0, 0, 1) == 0x7f000001);
@@ -80,6 +80,15 @@ void *LoadModule(const char *module);
 void *GetFunctionAddress(void *module, const char *function);
 uint32_t GetCurrentPID();
 
+// forking copies this process, including its memory and open handles. The copy runs func then
+// exits with its return value, without running exit handlers or static destructors. Returns the
+// copy's PID, or 0 if it couldn't be created. CanFork() is false on platforms without fork.
+bool CanFork();
+uint32_t ForkProcess(std::function<int()> func);
+// returns true if a process created by ForkProcess has exited, along with its exit code. If block
+// is true this waits for it to exit.
+bool WaitForkedProcess(uint32_t pid, bool block, int &exitCode);
+
 void Shutdown();
 };
 
@@ -132,6 +141,26 @@ public:
   data m_Data;
 };
 
+// a counting semaphore, for threads to sleep until there's work for them instead of polling
+template <class data>
+class SemaphoreTemplate
+{
+public:
+  SemaphoreTemplate();
+  ~SemaphoreTemplate();
+
+  // releases up to count waiting threads. Any not used up let later waits return immediately.
+  void Signal(uint32_t count = 1);
+  // returns false if the timeout elapsed before the semaphore was signalled
+  bool Wait(uint32_t timeoutMS = ~0U);
+
+  // no copying
+  SemaphoreTemplate &operator=(const SemaphoreTemplate &other) = delete;
+  SemaphoreTemplate(const SemaphoreTemplate &other) = delete;
+
+  data m_Data;
+};
+
 void Init();
 void Shutdown();
 uint64_t AllocateTLSSlot();
@@ -148,6 +177,15 @@ void JoinThread(ThreadHandle handle);
 void CloseThread(ThreadHandle handle);
 void Sleep(uint32_t milliseconds);
 
+// returns the number of logical processors available to this process, always at least 1
+uint32_t NumberOfCores();
+
+// calls func(i) for every i in [0, count), spread across a shared pool of worker threads up to the
+// number of cores. The workers persist between calls and exit after being idle for a while.
+// The calling thread participates and blocks until every index has been processed, so func must be
+// safe to call concurrently for different indices. With maxThreads == 0 the core count is used.
+void ParallelFor(uint32_t count, const std::function<void(uint32_t)> &func, uint32_t maxThreads = 0);
+
 // kind of windows specific, to handle this case:
 // http://blogs.msdn.com/b/oldnewthing/archive/2013/11/05/10463645.aspx
 void KeepModuleAlive();
@@ -163,6 +201,10 @@ public:
   ~Socket();
   void Shutdown();
 
+  // closes this process's handle without shutting the connection down, for when another process
+  // shares the socket and keeps using it
+  void ReleaseHandle();
+
   bool Connected() const;
 
   uint32_t GetTimeout() const { return timeoutMS; }
@@ -171,6 +213,10 @@ public:
 
   uint32_t GetRemoteIP() const;
 
+  // returns true if this socket is a same-machine connection made through the local transport
+  // rather than TCP
+  bool IsLocal() const;
+
   bool IsRecvDataWaiting();
 
   bool SendDataBlocking(const void *buf, uint32_t length);
@@ -185,6 +231,39 @@ private:
 Socket *CreateServerSocket(const char *addr, uint16_t port, int queuesize);
 Socket *CreateClientSocket(const char *host, uint16_t port, int timeoutMS);
 
+// the local transport listens alongside a TCP server socket on the same port, and is only reachable
+// from the same machine. Returns NULL on platforms that don't support it, in which case clients
+// fall back to TCP. CreateClientSocket tries it first automatically when connecting to localhost.
+Socket *CreateLocalServerSocket(uint16_t port, int queuesize);
+Socket *CreateLocalClientSocket(uint16_t port);
+
+// a block of memory mapped into two processes, used next to a local socket to move bulk payloads
+// without copying them through the socket. One side creates it with a unique name and passes the
+// name across, the other side opens it by name.
+class SharedMemory
+{
+public:
+  SharedMemory(const rdcstr &name, byte *data, uint64_t size) : name(name), data(data), size(size)
+  {
+  }
+  ~SharedMemory();
+
+  const rdcstr &GetName() const { return name; }
+  byte *GetData() const { return data; }
+  uint64_t GetSize() const { return size; }
+  // removes the name so no further processes can open it. The existing mappings stay valid, and
+  // the memory is freed when the last one is closed.
+  void Unlink();
+
+private:
+  rdcstr name;
+  byte *data;
+  uint64_t size;
+};
+
+SharedMemory *CreateSharedMemory(uint64_t size);
+SharedMemory *OpenSharedMemory(const char *name, uint64_t size);
+
 // ip is packed in HOST byte order
 inline uint32_t GetIPOctet(uint32_t ip, uint32_t octet)
 {
@@ -222,6 +301,7 @@ int64_t Inc64(volatile int64_t *i);
 int64_t Dec64(volatile int64_t *i);
 int64_t ExchAdd64(volatile int64_t *i, int64_t a);
 int32_t CmpExch32(volatile int32_t *dest, int32_t oldVal, int32_t newVal);
+int64_t CmpExch64(volatile int64_t *dest, int64_t oldVal, int64_t newVal);
 };
 
 namespace Callstack
@@ -38,4 +38,33 @@ Socket *CreateServerSocket(const char * /* bindaddr */, uint16_t port, int queue
 {
   return CreateAbstractServerSocket(port, queuesize);
 }
+
+// the local transport is only implemented on linux, clients will fall back to TCP
+Socket *CreateLocalServerSocket(uint16_t /* port */, int /* queuesize */)
+{
+  return NULL;
+}
+
+Socket *CreateLocalClientSocket(uint16_t /* port */)
+{
+  return NULL;
+}
+
+SharedMemory::~SharedMemory()
+{
+}
+
+void SharedMemory::Unlink()
+{
+}
+
+SharedMemory *CreateSharedMemory(uint64_t /* size */)
+{
+  return NULL;
+}
+
+SharedMemory *OpenSharedMemory(const char * /* name */, uint64_t /* size */)
+{
+  return NULL;
+}
 };
@@ -22,13 +22,21 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include "os/os_specific.h"
 #include "os/posix/posix_network.h"
+#include "strings/string_utils.h"
 
 namespace Network
 {
 uint32_t Socket::GetRemoteIP() const
 {
+  // the local transport can only be reached from this machine
+  if(IsLocal())
+    return MakeIP(127, 0, 0, 1);
+
   return GetIPFromTCPSocket((int)socket);
 }
 
@@ -36,4 +44,104 @@ Socket *CreateServerSocket(const char *bindaddr, uint16_t port, int queuesize)
 {
   return CreateTCPServerSocket(bindaddr, port, queuesize);
 }
+
+// the local transport uses abstract unix sockets, named distinctly from the ones android uses for
+// adb forwarding.
+static std::string LocalSocketName(uint16_t port)
+{
+  return StringFormat::Fmt("renderdoc_local_%u", (uint32_t)port);
+}
+
+Socket *CreateLocalServerSocket(uint16_t port, int queuesize)
+{
+  return CreateAbstractServerSocket(LocalSocketName(port).c_str(), queuesize);
+}
+
+Socket *CreateLocalClientSocket(uint16_t port)
+{
+  return CreateAbstractClientSocket(LocalSocketName(port).c_str());
+}
+
+SharedMemory::~SharedMemory()
+{
+  if(data)
+    munmap(data, (size_t)size);
+}
+
+void SharedMemory::Unlink()
+{
+  shm_unlink(name.c_str());
+}
+
+static SharedMemory *MapSharedMemory(int fd, const rdcstr &name, uint64_t size)
+{
+  void *data = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  // the mapping keeps the memory alive, we don't need the descriptor anymore
+  close(fd);
+
+  if(data == MAP_FAILED)
+  {
+    RDCWARN("Couldn't map shared memory %s", name.c_str());
+    return NULL;
+  }
+
+  return new SharedMemory(name, (byte *)data, size);
+}
+
+SharedMemory *CreateSharedMemory(uint64_t size)
+{
+  static int32_t counter = 0;
+
+  rdcstr name = StringFormat::Fmt("/renderdoc_%u_%d", (uint32_t)getpid(),
+                                  Atomic::Inc32(&counter)).c_str();
+
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+
+  if(fd == -1)
+  {
+    RDCWARN("Couldn't create shared memory %s", name.c_str());
+    return NULL;
+  }
+
+  // allocate the backing up front. With only ftruncate the file is sparse, and running out of
+  // space in /dev/shm would raise SIGBUS on first write instead of failing here.
+  if(posix_fallocate(fd, 0, (off_t)size) != 0)
+  {
+    RDCWARN("Couldn't allocate %llu bytes of shared memory", size);
+    close(fd);
+    shm_unlink(name.c_str());
+    return NULL;
+  }
+
+  SharedMemory *ret = MapSharedMemory(fd, name, size);
+
+  if(!ret)
+    shm_unlink(name.c_str());
+
+  return ret;
+}
+
+SharedMemory *OpenSharedMemory(const char *name, uint64_t size)
+{
+  int fd = shm_open(name, O_RDWR, 0600);
+
+  if(fd == -1)
+  {
+    RDCWARN("Couldn't open shared memory %s", name);
+    return NULL;
+  }
+
+  // make sure the other side actually allocated as much as it claims, so we can't fault reading
+  // past the end.
+  off_t len = lseek(fd, 0, SEEK_END);
+  if(len < 0 || (uint64_t)len < size)
+  {
+    RDCWARN("Shared memory %s is %lld bytes, expected %llu", name, (int64_t)len, size);
+    close(fd);
+    return NULL;
+  }
+
+  return MapSharedMemory(fd, name, size);
+}
 };
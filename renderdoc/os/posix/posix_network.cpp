@@ -95,11 +95,31 @@ void Socket::Shutdown()
   }
 }
 
+void Socket::ReleaseHandle()
+{
+  if(Connected())
+  {
+    close((int)socket);
+    socket = -1;
+  }
+}
+
 bool Socket::Connected() const
 {
   return (int)socket != -1;
 }
 
+bool Socket::IsLocal() const
+{
+  sockaddr_storage addr = {};
+  socklen_t len = sizeof(addr);
+
+  if(getsockname((int)socket, (sockaddr *)&addr, &len) != 0)
+    return false;
+
+  return addr.ss_family == AF_UNIX;
+}
+
 Socket *Socket::AcceptClient(uint32_t timeoutMilliseconds)
 {
   do
@@ -370,7 +390,25 @@ Socket *CreateAbstractServerSocket(uint16_t port, int queuesize)
 {
   char socketName[17] = {0};
   StringFormat::snprintf(socketName, 16, "renderdoc_%d", port);
-  int socketNameLength = strlen(socketName);
+  return CreateAbstractServerSocket(socketName, queuesize);
+}
+
+static socklen_t MakeAbstractAddress(const char *socketName, sockaddr_un &addr)
+{
+  int socketNameLength = (int)strlen(socketName);
+
+  RDCEraseEl(addr);
+
+  addr.sun_family = AF_UNIX;
+  // first char is '\0'
+  addr.sun_path[0] = '\0';
+  strncpy(addr.sun_path + 1, socketName, sizeof(addr.sun_path) - 2);
+
+  return socklen_t(offsetof(sockaddr_un, sun_path) + 1 + socketNameLength);
+}
+
+Socket *CreateAbstractServerSocket(const char *socketName, int queuesize)
+{
   int s = socket(AF_UNIX, SOCK_STREAM, 0);
 
   if(s == -1)
@@ -380,14 +418,9 @@ Socket *CreateAbstractServerSocket(uint16_t port, int queuesize)
   }
 
   sockaddr_un addr;
-  RDCEraseEl(addr);
+  socklen_t addrlen = MakeAbstractAddress(socketName, addr);
 
-  addr.sun_family = AF_UNIX;
-  // first char is '\0'
-  addr.sun_path[0] = '\0';
-  strncpy(addr.sun_path + 1, socketName, socketNameLength + 1);
-
-  int result = bind(s, (sockaddr *)&addr, offsetof(sockaddr_un, sun_path) + 1 + socketNameLength);
+  int result = bind(s, (sockaddr *)&addr, addrlen);
   if(result == -1)
   {
     RDCWARN("Failed to create abstract socket: %s", socketName);
@@ -410,8 +443,42 @@ Socket *CreateAbstractServerSocket(uint16_t port, int queuesize)
   return new Socket((ptrdiff_t)s);
 }
 
+Socket *CreateAbstractClientSocket(const char *socketName)
+{
+  int s = socket(AF_UNIX, SOCK_STREAM, 0);
+
+  if(s == -1)
+    return NULL;
+
+  // connecting to a unix socket never waits on the network - it either succeeds or fails
+  // immediately if nothing is listening - so unlike TCP we can connect blocking with no timeout.
+  sockaddr_un addr;
+  socklen_t addrlen = MakeAbstractAddress(socketName, addr);
+
+  int result = connect(s, (sockaddr *)&addr, addrlen);
+  if(result == -1)
+  {
+    RDCDEBUG("Failed to connect to %s: %s", socketName, errno_string(errno).c_str());
+    close(s);
+    return NULL;
+  }
+
+  int flags = fcntl(s, F_GETFL, 0);
+  fcntl(s, F_SETFL, flags | O_NONBLOCK);
+
+  return new Socket((ptrdiff_t)s);
+}
+
 Socket *CreateClientSocket(const char *host, uint16_t port, int timeoutMS)
 {
+  // prefer the local transport for same-machine connections, if the server is listening on it
+  if(!strcmp(host, "localhost") || !strcmp(host, "127.0.0.1"))
+  {
+    Socket *local = CreateLocalClientSocket(port);
+    if(local)
+      return local;
+  }
+
   char portstr[7] = {0};
   StringFormat::snprintf(portstr, 6, "%d", port);
 
@@ -28,5 +28,7 @@ namespace Network
 {
 uint32_t GetIPFromTCPSocket(int socket);
 Socket *CreateAbstractServerSocket(uint16_t port, int queuesize);
+Socket *CreateAbstractServerSocket(const char *socketName, int queuesize);
+Socket *CreateAbstractClientSocket(const char *socketName);
 Socket *CreateTCPServerSocket(const char *bindaddr, uint16_t port, int queuesize);
 }
@@ -865,6 +865,50 @@ uint32_t Process::GetCurrentPID()
   return (uint32_t)getpid();
 }
 
+bool Process::CanFork()
+{
+  return true;
+}
+
+uint32_t Process::ForkProcess(std::function<int()> func)
+{
+  pid_t pid = fork();
+
+  if(pid == 0)
+  {
+    // the parent's exit handlers and static destructors tear down state it still owns, such as
+    // the log file, so leave without running them.
+    _exit(func());
+  }
+
+  if(pid < 0)
+  {
+    RDCERR("Couldn't fork process: %d", errno);
+    return 0;
+  }
+
+  return (uint32_t)pid;
+}
+
+bool Process::WaitForkedProcess(uint32_t pid, bool block, int &exitCode)
+{
+  int status = 0;
+  pid_t ret = waitpid((pid_t)pid, &status, block ? 0 : WNOHANG);
+
+  if(ret == 0)
+    return false;
+
+  if(ret < 0)
+  {
+    RDCERR("Couldn't wait for process %u: %d", pid, errno);
+    exitCode = -1;
+    return true;
+  }
+
+  exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  return true;
+}
+
 void Process::Shutdown()
 {
   // delete all items in the freeChildren list
@@ -976,4 +1020,22 @@ TEST_CASE("Test PID Node list handling", "[osspecific]")
   CHECK(list1.head->next->next->next->next->next == f);
 };
 
+TEST_CASE("Test forked processes return their exit code", "[osspecific]")
+{
+  int value = 5;
+
+  uint32_t pid = Process::ForkProcess([&value]() {
+    // the copy has its own memory, this doesn't change the parent's value
+    value = 10;
+    return 42;
+  });
+
+  REQUIRE(pid != 0);
+
+  int exitCode = 0;
+  CHECK(Process::WaitForkedProcess(pid, true, exitCode));
+  CHECK(exitCode == 42);
+  CHECK(value == 5);
+};
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
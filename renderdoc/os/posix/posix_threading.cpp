@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include <errno.h>
 #include <time.h>
 #include <unistd.h>
 #include "os/os_specific.h"
@@ -69,6 +70,11 @@ int32_t CmpExch32(volatile int32_t *dest, int32_t oldVal, int32_t newVal)
 {
   return __sync_val_compare_and_swap(dest, oldVal, newVal);
 }
+
+int64_t CmpExch64(volatile int64_t *dest, int64_t oldVal, int64_t newVal)
+{
+  return __sync_val_compare_and_swap(dest, oldVal, newVal);
+}
 };
 
 namespace Threading
@@ -156,6 +162,79 @@ void RWLock::ReadUnlock()
   pthread_rwlock_unlock(&m_Data.rwlock);
 }
 
+template <>
+Semaphore::SemaphoreTemplate()
+{
+  pthread_mutex_init(&m_Data.lock, NULL);
+  pthread_cond_init(&m_Data.cond, NULL);
+  m_Data.count = 0;
+}
+
+template <>
+Semaphore::~SemaphoreTemplate()
+{
+  pthread_cond_destroy(&m_Data.cond);
+  pthread_mutex_destroy(&m_Data.lock);
+}
+
+template <>
+void Semaphore::Signal(uint32_t count)
+{
+  // signal while holding the lock, so a woken waiter can't destroy the semaphore before we're done
+  pthread_mutex_lock(&m_Data.lock);
+  m_Data.count += count;
+
+  if(count == 1)
+    pthread_cond_signal(&m_Data.cond);
+  else
+    pthread_cond_broadcast(&m_Data.cond);
+
+  pthread_mutex_unlock(&m_Data.lock);
+}
+
+template <>
+bool Semaphore::Wait(uint32_t timeoutMS)
+{
+  timespec deadline = {};
+
+  if(timeoutMS != ~0U)
+  {
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeoutMS / 1000;
+    deadline.tv_nsec += long(timeoutMS % 1000) * 1000000;
+    if(deadline.tv_nsec >= 1000000000)
+    {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000;
+    }
+  }
+
+  pthread_mutex_lock(&m_Data.lock);
+
+  while(m_Data.count == 0)
+  {
+    if(timeoutMS == ~0U)
+    {
+      pthread_cond_wait(&m_Data.cond, &m_Data.lock);
+    }
+    else if(pthread_cond_timedwait(&m_Data.cond, &m_Data.lock, &deadline) == ETIMEDOUT)
+    {
+      // the count might have been signalled right as we timed out
+      if(m_Data.count > 0)
+        break;
+
+      pthread_mutex_unlock(&m_Data.lock);
+      return false;
+    }
+  }
+
+  m_Data.count--;
+
+  pthread_mutex_unlock(&m_Data.lock);
+
+  return true;
+}
+
 struct ThreadInitData
 {
   std::function<void()> entryFunc;
@@ -298,4 +377,10 @@ void Sleep(uint32_t milliseconds)
 {
   usleep(milliseconds * 1000);
 }
+
+uint32_t NumberOfCores()
+{
+  long ret = sysconf(_SC_NPROCESSORS_ONLN);
+  return ret > 0 ? (uint32_t)ret : 1U;
+}
 };
@@ -100,11 +100,25 @@ void Socket::Shutdown()
   }
 }
 
+void Socket::ReleaseHandle()
+{
+  if(Connected())
+  {
+    closesocket((SOCKET)socket);
+    socket = -1;
+  }
+}
+
 bool Socket::Connected() const
 {
   return (SOCKET)socket != INVALID_SOCKET;
 }
 
+bool Socket::IsLocal() const
+{
+  return false;
+}
+
 uint32_t Socket::GetRemoteIP() const
 {
   sockaddr_in addr = {};
@@ -450,6 +464,35 @@ Socket *CreateClientSocket(const char *host, uint16_t port, int timeoutMS)
   return NULL;
 }
 
+// the local transport is only implemented on linux, clients will fall back to TCP
+Socket *CreateLocalServerSocket(uint16_t /* port */, int /* queuesize */)
+{
+  return NULL;
+}
+
+Socket *CreateLocalClientSocket(uint16_t /* port */)
+{
+  return NULL;
+}
+
+SharedMemory::~SharedMemory()
+{
+}
+
+void SharedMemory::Unlink()
+{
+}
+
+SharedMemory *CreateSharedMemory(uint64_t /* size */)
+{
+  return NULL;
+}
+
+SharedMemory *OpenSharedMemory(const char * /* name */, uint64_t /* size */)
+{
+  return NULL;
+}
+
 bool ParseIPRangeCIDR(const char *str, uint32_t &ip, uint32_t &mask)
 {
   uint32_t a = 0, b = 0, c = 0, d = 0, num = 0;
@@ -1637,6 +1637,23 @@ uint32_t Process::GetCurrentPID()
   return (uint32_t)GetCurrentProcessId();
 }
 
+bool Process::CanFork()
+{
+  return false;
+}
+
+uint32_t Process::ForkProcess(std::function<int()>)
+{
+  RDCERR("Forking isn't supported on windows");
+  return 0;
+}
+
+bool Process::WaitForkedProcess(uint32_t, bool, int &exitCode)
+{
+  exitCode = -1;
+  return true;
+}
+
 void Process::Shutdown()
 {
   // nothing to do
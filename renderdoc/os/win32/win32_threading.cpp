@@ -82,6 +82,11 @@ int32_t CmpExch32(volatile int32_t *dest, int32_t oldVal, int32_t newVal)
 {
   return (int32_t)InterlockedCompareExchange((volatile LONG *)dest, newVal, oldVal);
 }
+
+int64_t CmpExch64(volatile int64_t *dest, int64_t oldVal, int64_t newVal)
+{
+  return (int64_t)InterlockedCompareExchange64((volatile LONG64 *)dest, newVal, oldVal);
+}
 };
 
 namespace Threading
@@ -150,6 +155,27 @@ void RWLock::ReadUnlock()
   ReleaseSRWLockShared(&m_Data);
 }
 
+Semaphore::SemaphoreTemplate()
+{
+  m_Data = CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+}
+
+Semaphore::~SemaphoreTemplate()
+{
+  CloseHandle(m_Data);
+}
+
+void Semaphore::Signal(uint32_t count)
+{
+  ReleaseSemaphore(m_Data, (LONG)count, NULL);
+}
+
+bool Semaphore::Wait(uint32_t timeoutMS)
+{
+  DWORD timeout = timeoutMS == ~0U ? INFINITE : (DWORD)timeoutMS;
+  return WaitForSingleObject(m_Data, timeout) == WAIT_OBJECT_0;
+}
+
 struct ThreadInitData
 {
   std::function<void()> entryFunc;
@@ -298,4 +324,11 @@ void Sleep(uint32_t milliseconds)
 {
   ::Sleep((DWORD)milliseconds);
 }
+
+uint32_t NumberOfCores()
+{
+  SYSTEM_INFO info = {};
+  GetSystemInfo(&info);
+  return RDCMAX(1U, (uint32_t)info.dwNumberOfProcessors);
+}
 };
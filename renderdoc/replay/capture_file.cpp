@@ -29,6 +29,7 @@
 #include "replay/replay_controller.h"
 #include "serialise/rdcfile.h"
 #include "serialise/serialiser.h"
+#include "serialise/zstdio.h"
 #include "stb/stb_image.h"
 #include "stb/stb_image_resize.h"
 #include "stb/stb_image_write.h"
@@ -106,6 +107,248 @@ static RDCThumb convertThumb(FileType thumbType, uint32_t thumbWidth, uint32_t t
   return ret;
 }
 
+// decodes a JPG to 3-component RGB, shrinking it by the largest power-of-two factor (up to 8) that
+// keeps it at least as large as targetWidth x targetHeight. Scanlines are box-filtered into the
+// reduced image as they're decoded, so the full size image is never resident or resampled. The
+// returned buffer must be freed with free().
+static byte *DecodeJPGScaled(const byte *data, size_t len, uint32_t targetWidth,
+                             uint32_t targetHeight, uint32_t &width, uint32_t &height)
+{
+  jpgd::jpeg_decoder_mem_stream stream(data, (jpgd::uint)len);
+  jpgd::jpeg_decoder decoder(&stream);
+
+  if(decoder.get_error_code() != jpgd::JPGD_SUCCESS || decoder.begin_decoding() != jpgd::JPGD_SUCCESS)
+  {
+    RDCERR("Couldn't decode JPG thumbnail: %d", decoder.get_error_code());
+    return NULL;
+  }
+
+  const uint32_t srcWidth = (uint32_t)decoder.get_width();
+  const uint32_t srcHeight = (uint32_t)decoder.get_height();
+  const int srcBpp = decoder.get_bytes_per_pixel();
+
+  uint32_t factor = 1;
+  while(factor < 8 && srcWidth / (factor * 2) >= RDCMAX(1U, targetWidth) &&
+        srcHeight / (factor * 2) >= RDCMAX(1U, targetHeight))
+    factor *= 2;
+
+  width = RDCMAX(1U, srcWidth / factor);
+  height = RDCMAX(1U, srcHeight / factor);
+
+  byte *ret = (byte *)malloc(width * height * 3);
+
+  // one row of accumulated sums for the output row currently being built
+  std::vector<uint32_t> sums;
+  sums.resize(width * 3);
+
+  const uint32_t samplesPerPixel = factor * factor;
+
+  for(uint32_t y = 0; y < srcHeight; y++)
+  {
+    const void *scanline = NULL;
+    jpgd::uint scanlineLen = 0;
+
+    if(decoder.decode(&scanline, &scanlineLen) != jpgd::JPGD_SUCCESS)
+    {
+      RDCERR("Couldn't decode JPG thumbnail scanline %u: %d", y, decoder.get_error_code());
+      free(ret);
+      return NULL;
+    }
+
+    uint32_t outY = y / factor;
+
+    // any trailing rows/columns that don't make up a full block are dropped
+    if(outY >= height)
+      continue;
+
+    const byte *src = (const byte *)scanline;
+
+    for(uint32_t x = 0; x < width * factor; x++)
+    {
+      uint32_t *sum = &sums[(x / factor) * 3];
+
+      if(srcBpp == 1)
+      {
+        sum[0] += src[x];
+        sum[1] += src[x];
+        sum[2] += src[x];
+      }
+      else
+      {
+        sum[0] += src[x * srcBpp + 0];
+        sum[1] += src[x * srcBpp + 1];
+        sum[2] += src[x * srcBpp + 2];
+      }
+    }
+
+    if((y % factor) == factor - 1)
+    {
+      byte *dst = ret + outY * width * 3;
+      for(uint32_t i = 0; i < width * 3; i++)
+      {
+        dst[i] = byte(sums[i] / samplesPerPixel);
+        sums[i] = 0;
+      }
+    }
+  }
+
+  return ret;
+}
+
+static Thumbnail ConvertThumbnail(const RDCThumb &thumb, FileType type, uint32_t maxsize)
+{
+  Thumbnail ret;
+  ret.type = type;
+
+  const byte *thumbbuf = thumb.pixels;
+  size_t thumblen = thumb.len;
+  uint32_t thumbwidth = thumb.width, thumbheight = thumb.height;
+
+  if(thumbbuf == NULL)
+    return ret;
+
+  bytebuf buf;
+
+  // if the desired output is the format of stored thumbnail and either there's no max size or it's
+  // already satisfied, return the data directly
+  if(type == thumb.format && (maxsize == 0 || (maxsize > thumbwidth && maxsize > thumbheight)))
+  {
+    buf.assign(thumbbuf, thumblen);
+  }
+  else
+  {
+    // otherwise we need to decode, resample maybe, and re-encode
+
+    uint32_t clampedWidth = thumbwidth;
+    uint32_t clampedHeight = thumbheight;
+
+    if(maxsize != 0)
+    {
+      clampedWidth = RDCMIN(maxsize, thumbwidth);
+      clampedHeight = RDCMIN(maxsize, thumbheight);
+
+      if(clampedWidth != thumbwidth || clampedHeight != thumbheight)
+      {
+        // preserve aspect ratio, take the smallest scale factor and multiply both
+        float scaleX = float(clampedWidth) / float(thumbwidth);
+        float scaleY = float(clampedHeight) / float(thumbheight);
+
+        if(scaleX < scaleY)
+          clampedHeight = uint32_t(scaleX * thumbheight);
+        else if(scaleY < scaleX)
+          clampedWidth = uint32_t(scaleY * thumbwidth);
+      }
+    }
+
+    int w = (int)thumbwidth;
+    int h = (int)thumbheight;
+    int comp = 3;
+    const byte *thumbpixels = NULL;
+    byte *allocatedBuffer = NULL;
+    switch(thumb.format)
+    {
+      case FileType::JPG:
+      {
+        // decode straight to a reduced size where we can, so we only have to resample from there
+        uint32_t decodedWidth = 0, decodedHeight = 0;
+        allocatedBuffer = DecodeJPGScaled(thumbbuf, thumblen, clampedWidth, clampedHeight,
+                                          decodedWidth, decodedHeight);
+        if(allocatedBuffer == NULL)
+          return ret;
+        thumbpixels = allocatedBuffer;
+        thumbwidth = decodedWidth;
+        thumbheight = decodedHeight;
+        break;
+      }
+
+      case FileType::Raw: thumbpixels = thumbbuf; break;
+
+      default:
+        allocatedBuffer = stbi_load_from_memory(thumbbuf, (int)thumblen, &w, &h, &comp, 3);
+        if(allocatedBuffer == NULL)
+        {
+          RDCERR("Couldn't decode provided thumbnail");
+          return ret;
+        }
+        thumbpixels = allocatedBuffer;
+        break;
+    }
+
+    if(clampedWidth != thumbwidth || clampedHeight != thumbheight)
+    {
+      byte *resizedpixels = (byte *)malloc(3 * clampedWidth * clampedHeight);
+
+      stbir_resize_uint8_srgb(thumbpixels, thumbwidth, thumbheight, 0, resizedpixels, clampedWidth,
+                              clampedHeight, 0, 3, -1, 0);
+
+      free(allocatedBuffer);
+
+      allocatedBuffer = resizedpixels;
+      thumbpixels = resizedpixels;
+      thumbwidth = clampedWidth;
+      thumbheight = clampedHeight;
+    }
+
+    std::vector<byte> encodedBytes;
+
+    switch(type)
+    {
+      case FileType::Raw:
+      {
+        encodedBytes.assign(thumbpixels, thumbpixels + (thumbwidth * thumbheight * 3));
+        break;
+      }
+      case FileType::JPG:
+      {
+        int len = thumbwidth * thumbheight * 3;
+        encodedBytes.resize(len);
+        jpge::params p;
+        p.m_quality = 90;
+        jpge::compress_image_to_jpeg_file_in_memory(&encodedBytes[0], len, (int)thumbwidth,
+                                                    (int)thumbheight, 3, thumbpixels, p);
+        encodedBytes.resize(len);
+        break;
+      }
+      case FileType::PNG:
+      {
+        stbi_write_png_to_func(&writeToByteVector, &encodedBytes, (int)thumbwidth, (int)thumbheight,
+                               3, thumbpixels, 0);
+        break;
+      }
+      case FileType::TGA:
+      {
+        stbi_write_tga_to_func(&writeToByteVector, &encodedBytes, (int)thumbwidth, (int)thumbheight,
+                               3, thumbpixels);
+        break;
+      }
+      case FileType::BMP:
+      {
+        stbi_write_bmp_to_func(&writeToByteVector, &encodedBytes, (int)thumbwidth, (int)thumbheight,
+                               3, thumbpixels);
+        break;
+      }
+      default:
+      {
+        RDCERR("Unsupported file type %d in thumbnail fetch", type);
+        free(allocatedBuffer);
+        ret.width = 0;
+        ret.height = 0;
+        return ret;
+      }
+    }
+
+    buf = encodedBytes;
+
+    free(allocatedBuffer);
+  }
+
+  ret.data.swap(buf);
+  ret.width = thumbwidth;
+  ret.height = thumbheight;
+
+  return ret;
+}
+
 class CaptureFile : public ICaptureFile
 {
 public:
@@ -127,6 +370,14 @@ public:
   void SetMetadata(const char *driverName, uint64_t machineIdent, FileType thumbType,
                    uint32_t thumbWidth, uint32_t thumbHeight, const bytebuf &thumbData);
 
+  void SetConvertCompression(SectionFlags flags, int32_t compressionLevel,
+                             const bytebuf &compressionDictionary)
+  {
+    m_ConvertFlags = flags;
+    m_ConvertLevel = compressionLevel;
+    m_ConvertDictionary = compressionDictionary;
+  }
+
   ReplayStatus Convert(const char *filename, const char *filetype, const SDFile *file,
                        RENDERDOC_ProgressCallback progress);
 
@@ -183,6 +434,11 @@ private:
 
   SDFile m_StructuredData;
 
+  // how to compress the frame capture when converting to rdc
+  SectionFlags m_ConvertFlags = SectionFlags::ZstdCompressed;
+  int32_t m_ConvertLevel = 0;
+  bytebuf m_ConvertDictionary;
+
   std::string m_DriverName, m_Ident, m_ErrorString;
   ReplaySupport m_Support = ReplaySupport::Unsupported;
 };
@@ -461,6 +717,11 @@ ReplayStatus CaptureFile::Convert(const char *filename, const char *filetype, co
 
   bool success = true;
 
+  ZSTDSettings zstd;
+  zstd.level = m_ConvertLevel;
+  zstd.dictionary = m_ConvertDictionary.data();
+  zstd.dictionarySize = m_ConvertDictionary.size();
+
   // when we don't have a frame capture section, write it from the structured data.
   int frameCaptureIndex = m_RDC->SectionIndex(SectionType::FrameCapture);
 
@@ -473,12 +734,12 @@ ReplayStatus CaptureFile::Convert(const char *filename, const char *filetype, co
     }
 
     SectionProperties frameCapture;
-    frameCapture.flags = SectionFlags::ZstdCompressed;
+    frameCapture.flags = m_ConvertFlags;
     frameCapture.type = SectionType::FrameCapture;
     frameCapture.name = ToStr(frameCapture.type);
     frameCapture.version = file->version;
 
-    StreamWriter *writer = output.WriteSection(frameCapture);
+    StreamWriter *writer = output.WriteSection(frameCapture, &zstd);
 
     WriteSerialiser ser(writer, Ownership::Nothing);
 
@@ -492,11 +753,11 @@ ReplayStatus CaptureFile::Convert(const char *filename, const char *filetype, co
   }
   else
   {
-    // otherwise write it straight, but compress it to zstd
+    // otherwise write it straight, but compress it as requested
     SectionProperties props = m_RDC->GetSectionProperties(frameCaptureIndex);
-    props.flags = SectionFlags::ZstdCompressed;
+    props.flags = m_ConvertFlags;
 
-    StreamWriter *writer = output.WriteSection(props);
+    StreamWriter *writer = output.WriteSection(props, &zstd);
     StreamReader *reader = m_RDC->ReadSection(frameCaptureIndex);
 
     StreamTransfer(writer, reader, progress);
@@ -541,147 +802,14 @@ ReplayStatus CaptureFile::Convert(const char *filename, const char *filetype, co
 
 Thumbnail CaptureFile::GetThumbnail(FileType type, uint32_t maxsize)
 {
-  Thumbnail ret;
-  ret.type = type;
-
   if(m_RDC == NULL)
-    return ret;
-
-  const RDCThumb &thumb = m_RDC->GetThumbnail();
-
-  const byte *thumbbuf = thumb.pixels;
-  size_t thumblen = thumb.len;
-  uint32_t thumbwidth = thumb.width, thumbheight = thumb.height;
-
-  if(thumbbuf == NULL)
-    return ret;
-
-  bytebuf buf;
-
-  // if the desired output is the format of stored thumbnail and either there's no max size or it's
-  // already satisfied, return the data directly
-  if(type == thumb.format && (maxsize == 0 || (maxsize > thumbwidth && maxsize > thumbheight)))
-  {
-    buf.assign(thumbbuf, thumblen);
-  }
-  else
   {
-    // otherwise we need to decode, resample maybe, and re-encode
-
-    int w = (int)thumbwidth;
-    int h = (int)thumbheight;
-    int comp = 3;
-    const byte *thumbpixels = NULL;
-    byte *allocatedBuffer = NULL;
-    switch(thumb.format)
-    {
-      case FileType::JPG:
-        allocatedBuffer =
-            jpgd::decompress_jpeg_image_from_memory(thumbbuf, (int)thumblen, &w, &h, &comp, 3);
-        thumbpixels = allocatedBuffer;
-        break;
-
-      case FileType::Raw: thumbpixels = thumbbuf; break;
-
-      default:
-        allocatedBuffer = stbi_load_from_memory(thumbbuf, (int)thumblen, &w, &h, &comp, 3);
-        if(allocatedBuffer == NULL)
-        {
-          RDCERR("Couldn't decode provided thumbnail");
-          return ret;
-        }
-        thumbpixels = allocatedBuffer;
-        break;
-    }
-
-    if(maxsize != 0)
-    {
-      uint32_t clampedWidth = RDCMIN(maxsize, thumbwidth);
-      uint32_t clampedHeight = RDCMIN(maxsize, thumbheight);
-
-      if(clampedWidth != thumbwidth || clampedHeight != thumbheight)
-      {
-        // preserve aspect ratio, take the smallest scale factor and multiply both
-        float scaleX = float(clampedWidth) / float(thumbwidth);
-        float scaleY = float(clampedHeight) / float(thumbheight);
-
-        if(scaleX < scaleY)
-          clampedHeight = uint32_t(scaleX * thumbheight);
-        else if(scaleY < scaleX)
-          clampedWidth = uint32_t(scaleY * thumbwidth);
-
-        byte *resizedpixels = (byte *)malloc(3 * clampedWidth * clampedHeight);
-
-        stbir_resize_uint8_srgb(thumbpixels, thumbwidth, thumbheight, 0, resizedpixels,
-                                clampedWidth, clampedHeight, 0, 3, -1, 0);
-
-        free(allocatedBuffer);
-
-        allocatedBuffer = resizedpixels;
-        thumbpixels = resizedpixels;
-        thumbwidth = clampedWidth;
-        thumbheight = clampedHeight;
-      }
-    }
-
-    std::vector<byte> encodedBytes;
-
-    switch(type)
-    {
-      case FileType::Raw:
-      {
-        encodedBytes.assign(thumbpixels, thumbpixels + (thumbwidth * thumbheight * 3));
-        break;
-      }
-      case FileType::JPG:
-      {
-        int len = thumbwidth * thumbheight * 3;
-        encodedBytes.resize(len);
-        jpge::params p;
-        p.m_quality = 90;
-        jpge::compress_image_to_jpeg_file_in_memory(&encodedBytes[0], len, (int)thumbwidth,
-                                                    (int)thumbheight, 3, thumbpixels, p);
-        encodedBytes.resize(len);
-        break;
-      }
-      case FileType::PNG:
-      {
-        stbi_write_png_to_func(&writeToByteVector, &encodedBytes, (int)thumbwidth, (int)thumbheight,
-                               3, thumbpixels, 0);
-        break;
-      }
-      case FileType::TGA:
-      {
-        stbi_write_tga_to_func(&writeToByteVector, &encodedBytes, (int)thumbwidth, (int)thumbheight,
-                               3, thumbpixels);
-        break;
-      }
-      case FileType::BMP:
-      {
-        stbi_write_bmp_to_func(&writeToByteVector, &encodedBytes, (int)thumbwidth, (int)thumbheight,
-                               3, thumbpixels);
-        break;
-      }
-      default:
-      {
-        RDCERR("Unsupported file type %d in thumbnail fetch", type);
-        free(allocatedBuffer);
-        ret.width = 0;
-        ret.height = 0;
-        return ret;
-      }
-    }
-
-    buf = encodedBytes;
-
-    free(allocatedBuffer);
+    Thumbnail ret;
+    ret.type = type;
+    return ret;
   }
 
-  ret.data.swap(buf);
-  ret.width = thumbwidth;
-  ret.height = thumbheight;
-
-  return ret;
+  return ConvertThumbnail(m_RDC->GetThumbnail(), type, maxsize);
 }
 
 int CaptureFile::GetSectionCount()
@@ -827,3 +955,52 @@ extern "C" RENDERDOC_API ICaptureFile *RENDERDOC_CC RENDERDOC_OpenCaptureFile()
 {
   return new CaptureFile();
 }
+
+static Thumbnail GetCaptureThumbnail(const char *filename, FileType type, uint32_t maxsize)
+{
+  // the header always holds a JPG thumbnail, at the same size as any extended thumbnail. Unless
+  // the caller wants the thumbnail at full size in a lossless format, that's all we need so we can
+  // skip enumerating the sections entirely.
+  if(type == FileType::JPG || maxsize != 0)
+  {
+    RDCFile header;
+    header.OpenHeader(filename);
+
+    if(header.ErrorCode() != ContainerError::NoError)
+    {
+      Thumbnail ret;
+      ret.type = type;
+      return ret;
+    }
+
+    const RDCThumb &thumb = header.GetThumbnail();
+
+    if(type == FileType::JPG || maxsize < thumb.width || maxsize < thumb.height)
+      return ConvertThumbnail(thumb, type, maxsize);
+  }
+
+  RDCFile rdc;
+  rdc.Open(filename);
+
+  if(rdc.ErrorCode() != ContainerError::NoError)
+  {
+    Thumbnail ret;
+    ret.type = type;
+    return ret;
+  }
+
+  return ConvertThumbnail(rdc.GetThumbnail(), type, maxsize);
+}
+
+extern "C" RENDERDOC_API void RENDERDOC_CC
+RENDERDOC_GetCaptureThumbnails(const rdcarray<rdcstr> &filenames, FileType type, uint32_t maxsize,
+                               rdcarray<Thumbnail> &thumbnails)
+{
+  thumbnails.clear();
+  thumbnails.resize(filenames.size());
+
+  // each capture is independent, so spread them across all cores
+  Threading::ParallelFor((uint32_t)filenames.size(), [&](uint32_t i) {
+    thumbnails[i] = GetCaptureThumbnail(filenames[i].c_str(), type, maxsize);
+  });
+}
@@ -168,6 +168,224 @@ static void fileWriteFunc(void *context, void *data, int size)
   FileIO::fwrite(data, 1, size, (FILE *)context);
 }
 
+// images with fewer pixels than this are converted on the calling thread, as the conversion is
+// cheaper than spinning up workers.
+static const uint64_t ParallelConvertThreshold = 256 * 256;
+
+// rows are handed out to worker threads in batches of this many, to keep dispatch overhead low
+static const uint32_t ParallelConvertRowBatch = 16;
+
+// calls rowFunc for each row in [0, height), spreading the rows across threads for large images
+static void ConvertRows(uint32_t width, uint32_t height, const std::function<void(uint32_t)> &rowFunc)
+{
+  if(uint64_t(width) * uint64_t(height) < ParallelConvertThreshold)
+  {
+    for(uint32_t y = 0; y < height; y++)
+      rowFunc(y);
+    return;
+  }
+
+  uint32_t numBatches = (height + ParallelConvertRowBatch - 1) / ParallelConvertRowBatch;
+
+  Threading::ParallelFor(numBatches, [height, &rowFunc](uint32_t batch) {
+    uint32_t end = RDCMIN(height, (batch + 1) * ParallelConvertRowBatch);
+    for(uint32_t y = batch * ParallelConvertRowBatch; y < end; y++)
+      rowFunc(y);
+  });
+}
+
+// copies each of the equally sized slices in subdata into a larger combined image at the given grid
+// cell, then frees the slice. Rows are contiguous so they're copied whole.
+static void CombineSlicesToGrid(std::vector<byte *> &subdata, byte *combinedData,
+                                uint32_t combinedWidth, uint32_t sliceWidth, uint32_t sliceHeight,
+                                uint32_t pixelStride, const uint32_t *gridx, const uint32_t *gridy)
+{
+  const size_t rowBytes = sliceWidth * pixelStride;
+
+  auto copySlice = [&](uint32_t i) {
+    uint32_t yoffs = gridy[i] * sliceHeight;
+    uint32_t xoffs = gridx[i] * sliceWidth;
+
+    for(uint32_t y = 0; y < sliceHeight; y++)
+      memcpy(&combinedData[((y + yoffs) * combinedWidth + xoffs) * pixelStride],
+             &subdata[i][y * rowBytes], rowBytes);
+
+    delete[] subdata[i];
+  };
+
+  if(uint64_t(sliceWidth) * uint64_t(sliceHeight) * subdata.size() < ParallelConvertThreshold)
+  {
+    for(uint32_t i = 0; i < (uint32_t)subdata.size(); i++)
+      copySlice(i);
+  }
+  else
+  {
+    Threading::ParallelFor((uint32_t)subdata.size(), copySlice);
+  }
+}
+
+// splats one channel across the RGB channels of each pixel in a row, with alpha set to full
+template <typename CompType>
+static void ExtractChannelRow(CompType *row, uint32_t width, uint32_t compCount, uint32_t channel)
+{
+  const CompType max = CompType(~0U);
+
+  for(uint32_t x = 0; x < width; x++, row += compCount)
+  {
+    CompType val = row[channel];
+
+    switch(compCount)
+    {
+      case 4:
+        row[3] = max;
+      // deliberate fallthrough
+      case 3:
+        row[2] = val;
+      // deliberate fallthrough
+      case 2:
+        row[1] = val;
+      // deliberate fallthrough
+      case 1: row[0] = val; break;
+    }
+  }
+}
+
+// Row decoders used for writing HDR/EXR. Each one converts a row of 'width' source pixels into
+// RGBA floats. The decoder is picked once per image so the inner loops are tight and branch-free
+// per-component, letting the compiler vectorise the common cases.
+typedef void (*DecodeRowFunc)(const ResourceFormat &fmt, const byte *src, uint32_t pixStride,
+                              uint32_t width, FloatVector *dst);
+
+static void DecodeRowR10G10B10A2(const ResourceFormat &fmt, const byte *src, uint32_t pixStride,
+                                 uint32_t width, FloatVector *dst)
+{
+  const uint32_t *u32 = (const uint32_t *)src;
+
+  for(uint32_t x = 0; x < width; x++)
+  {
+    Vec4f vec = ConvertFromR10G10B10A2(u32[x]);
+    dst[x] = FloatVector(vec.x, vec.y, vec.z, vec.w);
+  }
+}
+
+static void DecodeRowR11G11B10(const ResourceFormat &fmt, const byte *src, uint32_t pixStride,
+                               uint32_t width, FloatVector *dst)
+{
+  const uint32_t *u32 = (const uint32_t *)src;
+
+  for(uint32_t x = 0; x < width; x++)
+  {
+    Vec3f vec = ConvertFromR11G11B10(u32[x]);
+    dst[x] = FloatVector(vec.x, vec.y, vec.z, 1.0f);
+  }
+}
+
+static void DecodeRowFloat32(const ResourceFormat &fmt, const byte *src, uint32_t pixStride,
+                             uint32_t width, FloatVector *dst)
+{
+  const uint32_t compCount = fmt.compCount;
+
+  for(uint32_t x = 0; x < width; x++, src += pixStride)
+  {
+    float *out = &dst[x].x;
+    out[0] = out[1] = out[2] = 0.0f;
+    out[3] = 1.0f;
+    memcpy(out, src, compCount * sizeof(float));
+  }
+}
+
+static void DecodeRowHalf(const ResourceFormat &fmt, const byte *src, uint32_t pixStride,
+                          uint32_t width, FloatVector *dst)
+{
+  const uint32_t compCount = fmt.compCount;
+
+  for(uint32_t x = 0; x < width; x++, src += pixStride)
+  {
+    const uint16_t *u16 = (const uint16_t *)src;
+    float *out = &dst[x].x;
+    out[0] = out[1] = out[2] = 0.0f;
+    out[3] = 1.0f;
+    for(uint32_t c = 0; c < compCount; c++)
+      out[c] = ConvertFromHalf(u16[c]);
+  }
+}
+
+static void DecodeRowUNorm8(const ResourceFormat &fmt, const byte *src, uint32_t pixStride,
+                            uint32_t width, FloatVector *dst)
+{
+  const uint32_t compCount = fmt.compCount;
+  const float scale = 1.0f / 255.0f;
+
+  // sRGB only applies to the colour channels, alpha is always linear
+  const uint32_t srgbCount = fmt.SRGBCorrected() ? RDCMIN(compCount, 3U) : 0;
+
+  for(uint32_t x = 0; x < width; x++, src += pixStride)
+  {
+    float *out = &dst[x].x;
+    out[0] = out[1] = out[2] = 0.0f;
+    out[3] = 1.0f;
+    for(uint32_t c = 0; c < srgbCount; c++)
+      out[c] = SRGB8_lookuptable[src[c]];
+    for(uint32_t c = srgbCount; c < compCount; c++)
+      out[c] = float(src[c]) * scale;
+  }
+}
+
+static void DecodeRowUNorm16(const ResourceFormat &fmt, const byte *src, uint32_t pixStride,
+                             uint32_t width, FloatVector *dst)
+{
+  const uint32_t compCount = fmt.compCount;
+  const float scale = 1.0f / 65535.0f;
+
+  for(uint32_t x = 0; x < width; x++, src += pixStride)
+  {
+    const uint16_t *u16 = (const uint16_t *)src;
+    float *out = &dst[x].x;
+    out[0] = out[1] = out[2] = 0.0f;
+    out[3] = 1.0f;
+    for(uint32_t c = 0; c < compCount; c++)
+      out[c] = float(u16[c]) * scale;
+  }
+}
+
+static void DecodeRowGeneric(const ResourceFormat &fmt, const byte *src, uint32_t pixStride,
+                             uint32_t width, FloatVector *dst)
+{
+  const uint32_t compCount = fmt.compCount;
+
+  for(uint32_t x = 0; x < width; x++, src += pixStride)
+  {
+    float *out = &dst[x].x;
+    out[0] = out[1] = out[2] = 0.0f;
+    out[3] = 1.0f;
+    for(uint32_t c = 0; c < compCount && c < 4; c++)
+      out[c] = ConvertComponent(fmt, src + fmt.compByteWidth * c);
+  }
+}
+
+static DecodeRowFunc GetRowDecoder(const ResourceFormat &fmt)
+{
+  if(fmt.type == ResourceFormatType::R10G10B10A2)
+    return &DecodeRowR10G10B10A2;
+  if(fmt.type == ResourceFormatType::R11G11B10)
+    return &DecodeRowR11G11B10;
+
+  if(fmt.compCount > 4)
+    return &DecodeRowGeneric;
+
+  if(fmt.compByteWidth == 4 && (fmt.compType == CompType::Float || fmt.compType == CompType::Depth))
+    return &DecodeRowFloat32;
+  if(fmt.compByteWidth == 2 && fmt.compType == CompType::Float)
+    return &DecodeRowHalf;
+  if(fmt.compByteWidth == 2 && (fmt.compType == CompType::UNorm || fmt.compType == CompType::Depth))
+    return &DecodeRowUNorm16;
+  if(fmt.compByteWidth == 1 &&
+     (fmt.compType == CompType::UNorm || fmt.compType == CompType::UNormSRGB))
+    return &DecodeRowUNorm8;
+
+  return &DecodeRowGeneric;
+}
+
 ReplayController::ReplayController()
 {
   m_ThreadID = Threading::GetCurrentID();
@@ -265,6 +483,23 @@ const PipeState &ReplayController::GetPipelineState()
   return m_PipeState;
 }
 
+void ReplayController::SetLazyDescriptorThreshold(uint32_t maxElements)
+{
+  CHECK_REPLAY_THREAD();
+
+  m_pDevice->SetLazyDescriptorThreshold(maxElements);
+
+  FetchPipelineState();
+}
+
+rdcarray<VKPipe::BindingElement> ReplayController::GetVulkanDescriptorBindings(
+    bool compute, uint32_t set, uint32_t binding, uint32_t firstElement, uint32_t count)
+{
+  CHECK_REPLAY_THREAD();
+
+  return m_pDevice->GetVulkanDescriptorBindings(compute, set, binding, firstElement, count);
+}
+
 rdcarray<rdcstr> ReplayController::GetDisassemblyTargets()
 {
   CHECK_REPLAY_THREAD();
@@ -1046,29 +1281,19 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
 
     memset(combinedData, 0, td.width * td.height * pixelStride);
 
+    std::vector<uint32_t> gridx, gridy;
+    gridx.resize(subdata.size());
+    gridy.resize(subdata.size());
+
     for(size_t i = 0; i < subdata.size(); i++)
     {
-      uint32_t gridx = (uint32_t)i % sd.slice.sliceGridWidth;
-      uint32_t gridy = (uint32_t)i / sd.slice.sliceGridWidth;
-
-      uint32_t yoffs = gridy * sliceHeight;
-      uint32_t xoffs = gridx * sliceWidth;
-
-      for(uint32_t y = 0; y < sliceHeight; y++)
-      {
-        for(uint32_t x = 0; x < sliceWidth; x++)
-        {
-          uint32_t *srcpix = (uint32_t *)&subdata[i][(y * sliceWidth + x) * pixelStride + 0];
-          uint32_t *dstpix =
-              (uint32_t *)&combinedData[((y + yoffs) * td.width + x + xoffs) * pixelStride + 0];
-
-          memcpy(dstpix, srcpix, pixelStride);
-        }
-      }
-
-      delete[] subdata[i];
+      gridx[i] = (uint32_t)i % sd.slice.sliceGridWidth;
+      gridy[i] = (uint32_t)i / sd.slice.sliceGridWidth;
     }
 
+    CombineSlicesToGrid(subdata, combinedData, td.width, sliceWidth, sliceHeight, pixelStride,
+                        gridx.data(), gridy.data());
+
     subdata.resize(1);
     subdata[0] = combinedData;
     rowPitch = td.width * 4;
@@ -1108,25 +1333,8 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
     uint32_t gridx[6] = {2, 0, 1, 1, 1, 3};
     uint32_t gridy[6] = {1, 1, 0, 2, 1, 1};
 
-    for(size_t i = 0; i < subdata.size(); i++)
-    {
-      uint32_t yoffs = gridy[i] * sliceHeight;
-      uint32_t xoffs = gridx[i] * sliceWidth;
-
-      for(uint32_t y = 0; y < sliceHeight; y++)
-      {
-        for(uint32_t x = 0; x < sliceWidth; x++)
-        {
-          uint32_t *srcpix = (uint32_t *)&subdata[i][(y * sliceWidth + x) * pixelStride + 0];
-          uint32_t *dstpix =
-              (uint32_t *)&combinedData[((y + yoffs) * td.width + x + xoffs) * pixelStride + 0];
-
-          memcpy(dstpix, srcpix, pixelStride);
-        }
-      }
-
-      delete[] subdata[i];
-    }
+    CombineSlicesToGrid(subdata, combinedData, td.width, sliceWidth, sliceHeight, pixelStride,
+                        gridx, gridy);
 
     subdata.resize(1);
     subdata[0] = combinedData;
@@ -1142,39 +1350,22 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
      (uint32_t)sd.channelExtract < td.format.compCount)
   {
     uint32_t pixelStride = td.format.compCount * td.format.compByteWidth;
-    uint32_t compWidth = td.format.compByteWidth;
     uint32_t compCount = td.format.compCount;
+    uint32_t channel = (uint32_t)sd.channelExtract;
+    uint32_t width = td.width;
+    byte *data = subdata[0];
 
-    uint32_t val = 0;
-    uint32_t max = ~0U;
-
-    for(uint32_t y = 0; y < td.height; y++)
+    if(td.format.compByteWidth == 1)
     {
-      for(uint32_t x = 0; x < td.width; x++)
-      {
-        memcpy(&val, &subdata[0][(y * td.width + x) * pixelStride + sd.channelExtract * compWidth],
-               td.format.compByteWidth);
-
-        switch(compCount)
-        {
-          case 4:
-            memcpy(&subdata[0][(y * td.width + x) * pixelStride + 3 * compWidth], &max,
-                   td.format.compByteWidth);
-          // deliberate fallthrough
-          case 3:
-            memcpy(&subdata[0][(y * td.width + x) * pixelStride + 2 * compWidth], &val,
-                   td.format.compByteWidth);
-          // deliberate fallthrough
-          case 2:
-            memcpy(&subdata[0][(y * td.width + x) * pixelStride + 1 * compWidth], &val,
-                   td.format.compByteWidth);
-          // deliberate fallthrough
-          case 1:
-            memcpy(&subdata[0][(y * td.width + x) * pixelStride + 0 * compWidth], &val,
-                   td.format.compByteWidth);
-            break;
-        }
-      }
+      ConvertRows(td.width, td.height, [=](uint32_t y) {
+        ExtractChannelRow((uint8_t *)&data[y * width * pixelStride], width, compCount, channel);
+      });
+    }
+    else
+    {
+      ConvertRows(td.width, td.height, [=](uint32_t y) {
+        ExtractChannelRow((uint32_t *)&data[y * width * pixelStride], width, compCount, channel);
+      });
     }
   }
 
@@ -1183,46 +1374,57 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
   {
     byte *nonalpha = new byte[td.width * td.height * 3];
 
-    for(uint32_t y = 0; y < td.height; y++)
-    {
-      for(uint32_t x = 0; x < td.width; x++)
-      {
-        byte r = subdata[0][(y * td.width + x) * 4 + 0];
-        byte g = subdata[0][(y * td.width + x) * 4 + 1];
-        byte b = subdata[0][(y * td.width + x) * 4 + 2];
-        byte a = subdata[0][(y * td.width + x) * 4 + 3];
+    // the blend colours are constant across the image, so gamma-correct them once up front
+    // rather than per-pixel. [0] is the solid/dark colour, [1] is the light checkerboard colour
+    Vec4f blendCol[2] = {
+        Vec4f(sd.alphaCol.x, sd.alphaCol.y, sd.alphaCol.z), Vec4f(),
+    };
 
-        if(sd.alpha != AlphaMapping::Discard)
-        {
-          Vec4f col = Vec4f(sd.alphaCol.x, sd.alphaCol.y, sd.alphaCol.z);
-          if(sd.alpha == AlphaMapping::BlendToCheckerboard)
-          {
-            bool lightSquare = ((x / 64) % 2) == ((y / 64) % 2);
-            col = lightSquare ? RenderDoc::Inst().LightCheckerboardColor()
-                              : RenderDoc::Inst().DarkCheckerboardColor();
-          }
+    if(sd.alpha == AlphaMapping::BlendToCheckerboard)
+    {
+      blendCol[0] = RenderDoc::Inst().DarkCheckerboardColor();
+      blendCol[1] = RenderDoc::Inst().LightCheckerboardColor();
+    }
 
-          col.x = powf(col.x, 1.0f / 2.2f);
-          col.y = powf(col.y, 1.0f / 2.2f);
-          col.z = powf(col.z, 1.0f / 2.2f);
+    for(int i = 0; i < 2; i++)
+    {
+      blendCol[i].x = powf(blendCol[i].x, 1.0f / 2.2f);
+      blendCol[i].y = powf(blendCol[i].y, 1.0f / 2.2f);
+      blendCol[i].z = powf(blendCol[i].z, 1.0f / 2.2f);
+    }
 
-          FloatVector pixel = FloatVector(float(r) / 255.0f, float(g) / 255.0f, float(b) / 255.0f,
-                                          float(a) / 255.0f);
+    const byte *rgba = subdata[0];
+    const uint32_t width = td.width;
+    const AlphaMapping alpha = sd.alpha;
 
-          pixel.x = pixel.x * pixel.w + col.x * (1.0f - pixel.w);
-          pixel.y = pixel.y * pixel.w + col.y * (1.0f - pixel.w);
-          pixel.z = pixel.z * pixel.w + col.z * (1.0f - pixel.w);
+    ConvertRows(td.width, td.height, [=, &blendCol](uint32_t y) {
+      const byte *src = &rgba[y * width * 4];
+      byte *dst = &nonalpha[y * width * 3];
 
-          r = byte(pixel.x * 255.0f);
-          g = byte(pixel.y * 255.0f);
-          b = byte(pixel.z * 255.0f);
+      if(alpha == AlphaMapping::Discard)
+      {
+        for(uint32_t x = 0; x < width; x++, src += 4, dst += 3)
+        {
+          dst[0] = src[0];
+          dst[1] = src[1];
+          dst[2] = src[2];
         }
+        return;
+      }
 
-        nonalpha[(y * td.width + x) * 3 + 0] = r;
-        nonalpha[(y * td.width + x) * 3 + 1] = g;
-        nonalpha[(y * td.width + x) * 3 + 2] = b;
+      for(uint32_t x = 0; x < width; x++, src += 4, dst += 3)
+      {
+        bool lightSquare = ((x / 64) % 2) == ((y / 64) % 2);
+        const Vec4f &col =
+            blendCol[alpha == AlphaMapping::BlendToCheckerboard && lightSquare ? 1 : 0];
+
+        float a = float(src[3]) / 255.0f;
+
+        dst[0] = byte((float(src[0]) / 255.0f * a + col.x * (1.0f - a)) * 255.0f);
+        dst[1] = byte((float(src[1]) / 255.0f * a + col.y * (1.0f - a)) * 255.0f);
+        dst[2] = byte((float(src[2]) / 255.0f * a + col.z * (1.0f - a)) * 255.0f);
       }
-    }
+    });
 
     delete[] subdata[0];
 
@@ -1238,22 +1440,22 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
   {
     byte *rg0 = new byte[td.width * td.height * 3];
 
-    for(uint32_t y = 0; y < td.height; y++)
-    {
-      for(uint32_t x = 0; x < td.width; x++)
-      {
-        byte r = subdata[0][(y * td.width + x) * 2 + 0];
-        byte g = subdata[0][(y * td.width + x) * 2 + 1];
+    const byte *rg = subdata[0];
+    const uint32_t width = td.width;
+    // if we're greyscaling the image, then keep the greyscale here.
+    const bool greyscale = sd.channelExtract >= 0;
 
-        rg0[(y * td.width + x) * 3 + 0] = r;
-        rg0[(y * td.width + x) * 3 + 1] = g;
-        rg0[(y * td.width + x) * 3 + 2] = 0;
+    ConvertRows(td.width, td.height, [=](uint32_t y) {
+      const byte *src = &rg[y * width * 2];
+      byte *dst = &rg0[y * width * 3];
 
-        // if we're greyscaling the image, then keep the greyscale here.
-        if(sd.channelExtract >= 0)
-          rg0[(y * td.width + x) * 3 + 2] = r;
+      for(uint32_t x = 0; x < width; x++, src += 2, dst += 3)
+      {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = greyscale ? src[0] : 0;
       }
-    }
+    });
 
     delete[] subdata[0];
 
@@ -1365,7 +1567,7 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
         abgr[3] = new float[td.width * td.height];
       }
 
-      byte *srcData = subdata[0];
+      const byte *srcData = subdata[0];
 
       ResourceFormat saveFmt = td.format;
       if(saveFmt.compType == CompType::Typeless)
@@ -1379,60 +1581,36 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
       if(saveFmt.compType == CompType::Depth && pixStride == 3)
         pixStride = 4;
 
-      for(uint32_t y = 0; y < td.height; y++)
-      {
-        for(uint32_t x = 0; x < td.width; x++)
-        {
-          float r = 0.0f;
-          float g = 0.0f;
-          float b = 0.0f;
-          float a = 1.0f;
-
-          if(saveFmt.type == ResourceFormatType::R10G10B10A2)
-          {
-            uint32_t *u32 = (uint32_t *)srcData;
-
-            Vec4f vec = ConvertFromR10G10B10A2(*u32);
+      // packed formats are always 4 bytes per pixel
+      if(saveFmt.type == ResourceFormatType::R10G10B10A2 ||
+         saveFmt.type == ResourceFormatType::R11G11B10)
+        pixStride = 4;
 
-            r = vec.x;
-            g = vec.y;
-            b = vec.z;
-            a = vec.w;
+      DecodeRowFunc decodeRow = GetRowDecoder(saveFmt);
 
-            srcData += 4;
-          }
-          else if(saveFmt.type == ResourceFormatType::R11G11B10)
-          {
-            uint32_t *u32 = (uint32_t *)srcData;
+      const uint32_t width = td.width;
+      const bool bgra = saveFmt.BGRAOrder();
+      const bool clampNegative = (sd.destType == FileType::HDR);
+      const int32_t channelExtract = sd.channelExtract;
 
-            Vec3f vec = ConvertFromR11G11B10(*u32);
+      ConvertRows(td.width, td.height, [&](uint32_t y) {
+        std::vector<FloatVector> row;
+        row.resize(width);
 
-            r = vec.x;
-            g = vec.y;
-            b = vec.z;
-            a = 1.0f;
+        decodeRow(saveFmt, srcData + size_t(y) * width * pixStride, pixStride, width, row.data());
 
-            srcData += 4;
-          }
-          else
-          {
-            if(saveFmt.compCount >= 1)
-              r = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 0);
-            if(saveFmt.compCount >= 2)
-              g = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 1);
-            if(saveFmt.compCount >= 3)
-              b = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 2);
-            if(saveFmt.compCount >= 4)
-              a = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 3);
-
-            srcData += pixStride;
-          }
+        for(uint32_t x = 0; x < width; x++)
+        {
+          float r = row[x].x;
+          float g = row[x].y;
+          float b = row[x].z;
+          float a = row[x].w;
 
-          if(saveFmt.BGRAOrder())
+          if(bgra)
             std::swap(r, b);
 
           // HDR can't represent negative values
-          if(sd.destType == FileType::HDR)
+          if(clampNegative)
           {
             r = RDCMAX(r, 0.0f);
             g = RDCMAX(g, 0.0f);
@@ -1440,22 +1618,22 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
             a = RDCMAX(a, 0.0f);
           }
 
-          if(sd.channelExtract == 0)
+          if(channelExtract == 0)
           {
             g = b = r;
             a = 1.0f;
           }
-          if(sd.channelExtract == 1)
+          if(channelExtract == 1)
           {
             r = b = g;
             a = 1.0f;
           }
-          if(sd.channelExtract == 2)
+          if(channelExtract == 2)
           {
             r = g = b;
             a = 1.0f;
           }
-          if(sd.channelExtract == 3)
+          if(channelExtract == 3)
           {
             r = g = b = a;
             a = 1.0f;
@@ -1463,20 +1641,20 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
 
           if(fldata)
           {
-            fldata[(y * td.width + x) * 4 + 0] = r;
-            fldata[(y * td.width + x) * 4 + 1] = g;
-            fldata[(y * td.width + x) * 4 + 2] = b;
-            fldata[(y * td.width + x) * 4 + 3] = a;
+            fldata[(y * width + x) * 4 + 0] = r;
+            fldata[(y * width + x) * 4 + 1] = g;
+            fldata[(y * width + x) * 4 + 2] = b;
+            fldata[(y * width + x) * 4 + 3] = a;
           }
           else
           {
-            abgr[0][(y * td.width + x)] = a;
-            abgr[1][(y * td.width + x)] = b;
-            abgr[2][(y * td.width + x)] = g;
-            abgr[3][(y * td.width + x)] = r;
+            abgr[0][(y * width + x)] = a;
+            abgr[1][(y * width + x)] = b;
+            abgr[2][(y * width + x)] = g;
+            abgr[3][(y * width + x)] = r;
           }
         }
-      }
+      });
 
       if(sd.destType == FileType::HDR)
       {
@@ -2126,3 +2304,57 @@ void ReplayController::FetchPipelineState()
   m_PipeState.SetStates(m_APIProps, m_D3D11PipelineState, m_D3D12PipelineState, m_GLPipelineState,
                         m_VulkanPipelineState);
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Check 8-bit row decoding", "[replay]")
+{
+  ResourceFormat fmt;
+  fmt.type = ResourceFormatType::Regular;
+  fmt.compByteWidth = 1;
+  fmt.compCount = 4;
+
+  byte src[256 * 4];
+  for(uint32_t i = 0; i < 256; i++)
+  {
+    src[i * 4 + 0] = byte(i);
+    src[i * 4 + 1] = byte(255 - i);
+    src[i * 4 + 2] = byte(i ^ 0x5a);
+    src[i * 4 + 3] = byte(i);
+  }
+
+  FloatVector out[256];
+
+  SECTION("UNorm")
+  {
+    fmt.compType = CompType::UNorm;
+
+    GetRowDecoder(fmt)(fmt, src, 4, 256, out);
+
+    for(uint32_t i = 0; i < 256; i++)
+    {
+      CHECK(out[i].x == Approx(float(src[i * 4 + 0]) / 255.0f));
+      CHECK(out[i].y == Approx(float(src[i * 4 + 1]) / 255.0f));
+      CHECK(out[i].z == Approx(float(src[i * 4 + 2]) / 255.0f));
+      CHECK(out[i].w == Approx(float(src[i * 4 + 3]) / 255.0f));
+    }
+  };
+
+  SECTION("sRGB")
+  {
+    fmt.compType = CompType::UNormSRGB;
+
+    GetRowDecoder(fmt)(fmt, src, 4, 256, out);
+
+    for(uint32_t i = 0; i < 256; i++)
+    {
+      CHECK(out[i].x == SRGB8_lookuptable[src[i * 4 + 0]]);
+      CHECK(out[i].y == SRGB8_lookuptable[src[i * 4 + 1]]);
+      CHECK(out[i].z == SRGB8_lookuptable[src[i * 4 + 2]]);
+      CHECK(out[i].w == Approx(float(src[i * 4 + 3]) / 255.0f));
+    }
+  };
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -116,6 +116,11 @@ public:
   virtual const D3D12Pipe::State *GetD3D12PipelineState() = 0;
   virtual const GLPipe::State *GetGLPipelineState() = 0;
   virtual const VKPipe::State *GetVulkanPipelineState() = 0;
+  virtual void SetLazyDescriptorThreshold(uint32_t maxElements) = 0;
+  virtual rdcarray<VKPipe::BindingElement> GetVulkanDescriptorBindings(bool compute, uint32_t set,
+                                                                       uint32_t binding,
+                                                                       uint32_t firstElement,
+                                                                       uint32_t count) = 0;
 
   virtual FrameRecord GetFrameRecord() = 0;
 
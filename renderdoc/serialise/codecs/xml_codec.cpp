@@ -317,7 +317,8 @@ static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, ui
   {
     const SectionProperties &props = file.GetSectionProperties(i);
 
-    if(props.type == SectionType::FrameCapture)
+    // blob references in the frame capture are expanded when it's exported
+    if(props.type == SectionType::FrameCapture || props.type == SectionType::BlobStore)
       continue;
 
     StreamReader *reader = file.ReadSection(i);
@@ -360,6 +361,8 @@ static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, ui
       xSection.append_attribute("lz4");
     if(props.flags & SectionFlags::ZstdCompressed)
       xSection.append_attribute("zstd");
+    if(props.flags & SectionFlags::ZstdLongWindow)
+      xSection.append_attribute("zstdlong");
 
     pugi::xml_node name = xSection.append_child("name");
     name.text() = props.name.c_str();
@@ -647,6 +650,8 @@ static ReplayStatus XML2Structured(const char *xml, const ThumbTypeAndData &thum
       props.flags |= SectionFlags::LZ4Compressed;
     if(xSection.attribute("zstd"))
       props.flags |= SectionFlags::ZstdCompressed;
+    if(xSection.attribute("zstdlong"))
+      props.flags |= SectionFlags::ZstdLongWindow;
 
     pugi::xml_node name = xSection.child("name");
     if(!name)
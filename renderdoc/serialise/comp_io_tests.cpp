@@ -190,4 +190,268 @@ TEST_CASE("Test ZSTD compression/decompression", "[streamio][zstd]")
   delete[] randomData;
 };
 
+TEST_CASE("Test ZSTD recompression", "[streamio][zstd]")
+{
+  // enough data to span several batches of blocks, with a partial block at the end
+  const uint64_t dataSize = 3 * 1024 * 1024 + 1234;
+
+  byte *data = new byte[dataSize];
+
+  for(uint64_t i = 0; i < dataSize; i++)
+    data[i] = (i % 7 == 0) ? (rand() & 0xff) : byte(i & 0xff);
+
+  StreamWriter buf(StreamWriter::DefaultScratchSize);
+
+  {
+    StreamWriter writer(new ZSTDCompressor(&buf, Ownership::Nothing), Ownership::Stream);
+
+    writer.Write(data, dataSize);
+    writer.Finish();
+
+    CHECK_FALSE(writer.IsErrored());
+  }
+
+  StreamWriter recompressed(StreamWriter::DefaultScratchSize);
+
+  {
+    ZSTDDecompressor decomp(new StreamReader(buf.GetData(), buf.GetOffset()), Ownership::Stream);
+    ZSTDCompressor comp(&recompressed, Ownership::Nothing);
+
+    CHECK(decomp.Recompress(&comp));
+  }
+
+  {
+    StreamReader reader(new ZSTDDecompressor(new StreamReader(recompressed.GetData(),
+                                                               recompressed.GetOffset()),
+                                              Ownership::Stream),
+                        dataSize, Ownership::Stream);
+
+    byte *readData = new byte[dataSize];
+
+    reader.Read(readData, dataSize);
+    CHECK_FALSE(memcmp(readData, data, (size_t)dataSize));
+
+    CHECK_FALSE(reader.IsErrored());
+    CHECK(reader.AtEnd());
+
+    delete[] readData;
+  }
+
+  delete[] data;
+};
+
+TEST_CASE("Test ZSTD compression settings", "[streamio][zstd]")
+{
+  // repetitive small records, similar to API chunks, spanning more than one long window block
+  const uint64_t dataSize = 17 * 1024 * 1024;
+
+  byte *data = new byte[dataSize];
+
+  for(uint64_t i = 0; i < dataSize; i++)
+    data[i] = (i % 64 < 8) ? byte((i / 64) & 0xff) : byte(i % 13);
+
+  // the dictionary is a sample of the records, as raw content
+  byte dictionary[4096];
+  memcpy(dictionary, data, sizeof(dictionary));
+
+  ZSTDSettings settings;
+
+  SECTION("Fast level") { settings.level = -5; }
+
+  SECTION("High level with long window")
+  {
+    settings.level = 12;
+    settings.longWindow = true;
+  }
+
+  SECTION("Dictionary")
+  {
+    settings.dictionary = dictionary;
+    settings.dictionarySize = sizeof(dictionary);
+  }
+
+  StreamWriter buf(StreamWriter::DefaultScratchSize);
+
+  {
+    StreamWriter writer(new ZSTDCompressor(&buf, Ownership::Nothing, settings), Ownership::Stream);
+
+    writer.Write(data, dataSize);
+    writer.Finish();
+
+    CHECK_FALSE(writer.IsErrored());
+  }
+
+  CHECK(buf.GetOffset() < dataSize / 4);
+
+  {
+    StreamReader reader(
+        new ZSTDDecompressor(new StreamReader(buf.GetData(), buf.GetOffset()), Ownership::Stream,
+                             settings.longWindow, settings.dictionarySize > 0),
+        dataSize, Ownership::Stream);
+
+    byte *readData = new byte[dataSize];
+
+    reader.Read(readData, dataSize);
+    CHECK_FALSE(memcmp(readData, data, (size_t)dataSize));
+
+    CHECK_FALSE(reader.IsErrored());
+    CHECK(reader.AtEnd());
+
+    delete[] readData;
+  }
+
+  delete[] data;
+};
+
+TEST_CASE("Test pipelined compression", "[streamio][lz4]")
+{
+  // enough data to fill several blocks and wrap around the in-flight queue, with an odd size so
+  // the last block is partial
+  const uint64_t dataSize =
+      PipelinedCompressor::BlockSize * (PipelinedCompressor::MaxBlocksInFlight * 2 + 1) + 12345;
+
+  byte *data = new byte[(size_t)dataSize];
+
+  for(uint64_t i = 0; i < dataSize; i++)
+    data[i] = (i % 3) ? byte(i & 0xff) : byte(rand() & 0xff);
+
+  StreamWriter reference(StreamWriter::DefaultScratchSize);
+  StreamWriter pipelined(StreamWriter::DefaultScratchSize);
+
+  {
+    StreamWriter writer(new LZ4Compressor(&reference, Ownership::Nothing), Ownership::Stream);
+
+    writer.Write(data, dataSize);
+    writer.Finish();
+
+    CHECK_FALSE(writer.IsErrored());
+  }
+
+  {
+    Compressor *comp = new LZ4Compressor(&pipelined, Ownership::Nothing);
+    StreamWriter writer(new PipelinedCompressor(comp, Ownership::Stream), Ownership::Stream);
+
+    // write in irregular pieces so block boundaries are crossed mid-write
+    uint64_t offs = 0;
+    uint64_t piece = 1;
+    while(offs < dataSize)
+    {
+      uint64_t size = RDCMIN(piece, dataSize - offs);
+      CHECK(writer.Write(data + offs, size));
+      offs += size;
+      piece = (piece * 7 + 13) % (3 * 1024 * 1024);
+    }
+
+    writer.Finish();
+
+    CHECK_FALSE(writer.IsErrored());
+    CHECK(writer.GetOffset() == dataSize);
+  }
+
+  // the compressor must have seen exactly the same stream
+  REQUIRE(pipelined.GetOffset() == reference.GetOffset());
+  CHECK_FALSE(memcmp(pipelined.GetData(), reference.GetData(), (size_t)reference.GetOffset()));
+
+  {
+    StreamReader reader(new LZ4Decompressor(new StreamReader(pipelined.GetData(),
+                                                             pipelined.GetOffset()),
+                                            Ownership::Stream),
+                        dataSize, Ownership::Stream);
+
+    byte *readData = new byte[(size_t)dataSize];
+
+    reader.Read(readData, dataSize);
+    CHECK_FALSE(memcmp(readData, data, (size_t)dataSize));
+
+    CHECK_FALSE(reader.IsErrored());
+    CHECK(reader.AtEnd());
+
+    delete[] readData;
+  }
+
+  delete[] data;
+};
+
+TEST_CASE("Test pipelined compression of small and interleaved streams", "[streamio][lz4]")
+{
+  const uint64_t dataSize = PipelinedCompressor::BlockSize * 3 + 777;
+
+  byte *data = new byte[(size_t)dataSize];
+
+  for(uint64_t i = 0; i < dataSize; i++)
+    data[i] = (i % 5) ? byte(i & 0xff) : byte(rand() & 0xff);
+
+  SECTION("Stream below the pipelining threshold")
+  {
+    const uint64_t smallSize = PipelinedCompressor::PipelineThreshold / 2;
+
+    StreamWriter reference(StreamWriter::DefaultScratchSize);
+    StreamWriter pipelined(StreamWriter::DefaultScratchSize);
+
+    {
+      StreamWriter writer(new LZ4Compressor(&reference, Ownership::Nothing), Ownership::Stream);
+      writer.Write(data, smallSize);
+      writer.Finish();
+    }
+
+    {
+      Compressor *comp = new LZ4Compressor(&pipelined, Ownership::Nothing);
+      StreamWriter writer(new PipelinedCompressor(comp, Ownership::Stream), Ownership::Stream);
+      writer.Write(data, smallSize);
+      writer.Finish();
+
+      CHECK_FALSE(writer.IsErrored());
+    }
+
+    REQUIRE(pipelined.GetOffset() == reference.GetOffset());
+    CHECK_FALSE(memcmp(pipelined.GetData(), reference.GetData(), (size_t)reference.GetOffset()));
+  };
+
+  SECTION("Interleaved streams share the worker")
+  {
+    StreamWriter reference(StreamWriter::DefaultScratchSize);
+
+    {
+      StreamWriter writer(new LZ4Compressor(&reference, Ownership::Nothing), Ownership::Stream);
+      writer.Write(data, dataSize);
+      writer.Finish();
+    }
+
+    StreamWriter pipelinedA(StreamWriter::DefaultScratchSize);
+    StreamWriter pipelinedB(StreamWriter::DefaultScratchSize);
+
+    {
+      StreamWriter writerA(
+          new PipelinedCompressor(new LZ4Compressor(&pipelinedA, Ownership::Nothing),
+                                  Ownership::Stream),
+          Ownership::Stream);
+      StreamWriter writerB(
+          new PipelinedCompressor(new LZ4Compressor(&pipelinedB, Ownership::Nothing),
+                                  Ownership::Stream),
+          Ownership::Stream);
+
+      const uint64_t piece = 300 * 1024;
+      for(uint64_t offs = 0; offs < dataSize; offs += piece)
+      {
+        uint64_t size = RDCMIN(piece, dataSize - offs);
+        CHECK(writerA.Write(data + offs, size));
+        CHECK(writerB.Write(data + offs, size));
+      }
+
+      writerA.Finish();
+      writerB.Finish();
+
+      CHECK_FALSE(writerA.IsErrored());
+      CHECK_FALSE(writerB.IsErrored());
+    }
+
+    REQUIRE(pipelinedA.GetOffset() == reference.GetOffset());
+    REQUIRE(pipelinedB.GetOffset() == reference.GetOffset());
+    CHECK_FALSE(memcmp(pipelinedA.GetData(), reference.GetData(), (size_t)reference.GetOffset()));
+    CHECK_FALSE(memcmp(pipelinedB.GetData(), reference.GetData(), (size_t)reference.GetOffset()));
+  };
+
+  delete[] data;
+};
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -29,6 +29,7 @@
 #include "api/replay/version.h"
 #include "common/dds_readwrite.h"
 #include "lz4io.h"
+#include "serialiser.h"
 #include "zstdio.h"
 
 // not provided by tinyexr, just do by hand
@@ -122,6 +123,10 @@ bool is_exr_file(FILE *f)
    }
  };
 
+ // A binary section with SectionType::Unknown and an empty name is free space,
+ // left behind when a section is replaced without moving the sections after
+ // it. Its contents are undefined and it should be skipped when reading.
+
  // remainder of the file is tightly packed/unaligned section structures.
  // The first section must always be the actual frame capture data in
  // binary form, other sections can follow in any order
@@ -221,6 +226,8 @@ struct BinarySectionHeader
 
 RDCFile::~RDCFile()
 {
+  SAFE_DELETE(m_Blobs);
+
   if(m_File)
     FileIO::fclose(m_File);
 
@@ -295,9 +302,38 @@ void RDCFile::Open(const std::vector<byte> &buffer)
   Init(reader);
 }
 
-void RDCFile::Init(StreamReader &reader)
+void RDCFile::OpenHeader(const char *path)
+{
+  if(path == NULL || path[0] == 0)
+  {
+    RETURNERROR(ContainerError::FileNotFound, "Invalid file path specified");
+  }
+
+  FILE *f = FileIO::fopen(path, "rb");
+  m_Filename = path;
+
+  if(!f)
+  {
+    RETURNERROR(ContainerError::FileNotFound, "Can't open capture file '%s' for read - errno %d",
+                path, errno);
+  }
+
+  FileIO::fseek64(f, 0, SEEK_END);
+  uint64_t fileSize = FileIO::ftell64(f);
+  FileIO::fseek64(f, 0, SEEK_SET);
+
+  {
+    StreamReader reader(f, fileSize, Ownership::Nothing);
+
+    ReadHeader(reader);
+  }
+
+  // we don't enumerate or read any sections, so there's no need to keep the file open
+  FileIO::fclose(f);
+}
+
+void RDCFile::ReadHeader(StreamReader &reader)
 {
-  RDCDEBUG("Opened capture file for read");
 
   // read the first part of the file header
   FileHeader header;
@@ -406,6 +442,18 @@ void RDCFile::Init(StreamReader &reader)
 
   reader.SkipBytes(header.headerLength - (uint32_t)reader.GetOffset());
 
+  m_HeaderLength = header.headerLength;
+}
+
+void RDCFile::Init(StreamReader &reader)
+{
+  RDCDEBUG("Opened capture file for read");
+
+  ReadHeader(reader);
+
+  if(m_Error != ContainerError::NoError)
+    return;
+
   while(!reader.AtEnd())
   {
     BinarySectionHeader sectionHeader = {0};
@@ -561,8 +609,12 @@ void RDCFile::Init(StreamReader &reader)
       loc.dataOffset = reader.GetOffset();
       loc.diskLength = sectionHeader.sectionCompressedLength;
 
-      m_Sections.push_back(props);
-      m_SectionLocations.push_back(loc);
+      // free sections are left behind when a section is replaced in-place, skip over them
+      if(props.type != SectionType::Unknown || !props.name.empty())
+      {
+        m_Sections.push_back(props);
+        m_SectionLocations.push_back(loc);
+      }
 
       reader.SkipBytes(loc.diskLength);
 
@@ -590,7 +642,7 @@ void RDCFile::Init(StreamReader &reader)
       ExtThumbnailHeader thumbHeader;
       if(thumbReader->Read(thumbHeader))
       {
-        thumbData = new byte[thumbHeader.len];
+        byte *thumbData = new byte[thumbHeader.len];
         bool succeeded = thumbReader->Read(thumbData, thumbHeader.len) && !thumbReader->IsErrored();
         if(succeeded && (uint32_t)thumbHeader.format < (uint32_t)FileType::Count)
         {
@@ -605,7 +657,6 @@ void RDCFile::Init(StreamReader &reader)
         {
           delete[] thumbData;
         }
-        thumbData = NULL;
       }
       delete thumbReader;
     }
@@ -726,7 +777,7 @@ void RDCFile::Create(const char *filename)
                         offsetof(CaptureMetaData, driverName) + meta.driverNameLength;
 
   {
-    StreamWriter writer(m_File, Ownership::Nothing);
+    StreamWriter &writer = *MakeFileWriter(0);
 
     writer.Write(header);
     writer.Write(&thumbHeader, offsetof(BinaryThumbnail, data));
@@ -739,12 +790,17 @@ void RDCFile::Create(const char *filename)
     writer.Write(m_DriverName.c_str(), meta.driverNameLength);
 
     delete[] jpgBuffer;
-    if(writer.IsErrored())
+    bool errored = writer.IsErrored();
+    delete &writer;
+
+    if(errored)
     {
       RETURNERROR(ContainerError::FileIO, "Error writing file header");
     }
   }
 
+  m_HeaderLength = header.headerLength;
+
   // re-open as read-only now.
   FileIO::fclose(m_File);
   m_File = FileIO::fopen(filename, "rb");
@@ -781,6 +837,40 @@ int RDCFile::SectionIndex(const char *name) const
 }
 
 StreamReader *RDCFile::ReadSection(int index) const
+{
+  StreamReader *reader = OpenSection(index);
+
+  if(m_Error != ContainerError::NoError || m_Sections[index].type != SectionType::FrameCapture)
+    return reader;
+
+  int blobIndex = SectionIndex(SectionType::BlobStore);
+
+  if(blobIndex >= 0)
+  {
+    // the store is only read when the first reference is found, which will be in the middle of
+    // reading the frame capture from the same file. Restore the file position afterwards so that
+    // reader can carry on where it was.
+    if(m_Blobs == NULL)
+    {
+      m_Blobs = new BlobStore([this, blobIndex]() {
+        uint64_t offs = m_File ? FileIO::ftell64(m_File) : 0;
+
+        StreamReader *blobReader = OpenSection(blobIndex);
+
+        if(m_File)
+          blobReader->AddCloseCallback([this, offs]() { FileIO::fseek64(m_File, offs, SEEK_SET); });
+
+        return blobReader;
+      });
+    }
+
+    reader->SetBlobStore(m_Blobs);
+  }
+
+  return reader;
+}
+
+StreamReader *RDCFile::OpenSection(int index) const
 {
   if(m_Error != ContainerError::NoError)
     return new StreamReader(StreamReader::InvalidStream);
@@ -811,15 +901,185 @@ StreamReader *RDCFile::ReadSection(int index) const
   }
   else if(props.flags & SectionFlags::ZstdCompressed)
   {
-    compReader = new StreamReader(new ZSTDDecompressor(fileReader, Ownership::Stream),
-                                  props.uncompressedSize, Ownership::Stream);
+    compReader = new StreamReader(
+        new ZSTDDecompressor(fileReader, Ownership::Stream,
+                             bool(props.flags & SectionFlags::ZstdLongWindow),
+                             bool(props.flags & SectionFlags::ZstdDictionary)),
+        props.uncompressedSize, Ownership::Stream);
   }
 
   // if we're compressing return that writer, otherwise return the file writer directly
   return compReader ? compReader : fileReader;
 }
 
-StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
+uint64_t RDCFile::LiveDataEnd() const
+{
+  // sections can never be placed over the header
+  uint64_t ret = m_HeaderLength;
+
+  for(const SectionLocation &loc : m_SectionLocations)
+    ret = RDCMAX(ret, loc.dataOffset + loc.diskLength);
+
+  return ret;
+}
+
+bool RDCFile::ReleaseSection(int index)
+{
+  const SectionLocation loc = m_SectionLocations[index];
+
+  // the free section header covers the whole of the old section, header and data.
+  const uint64_t headerLen = offsetof(BinarySectionHeader, name) + 1;
+  const uint64_t regionLen = loc.dataOffset + loc.diskLength - loc.headerOffset;
+
+  if(regionLen < headerLen)
+    return false;
+
+  BinarySectionHeader header = {// IsASCII
+                                '\0',
+                                // zero
+                                {0, 0, 0},
+                                // sectionType
+                                SectionType::Unknown,
+                                // sectionCompressedLength
+                                regionLen - headerLen,
+                                // sectionUncompressedLength
+                                regionLen - headerLen,
+                                // sectionVersion
+                                0,
+                                // sectionFlags
+                                SectionFlags::NoFlags,
+                                // sectionNameLength
+                                1};
+
+  FileIO::fseek64(m_File, loc.headerOffset, SEEK_SET);
+
+  size_t numWritten = FileIO::fwrite(&header, 1, offsetof(BinarySectionHeader, name), m_File);
+  numWritten += FileIO::fwrite("", 1, 1, m_File);
+
+  if(numWritten != headerLen)
+  {
+    RDCERR("Error writing free section header, errno %d", errno);
+    return false;
+  }
+
+  TeeWrite(loc.headerOffset, &header, offsetof(BinarySectionHeader, name));
+  TeeWrite(loc.headerOffset + offsetof(BinarySectionHeader, name), "", 1);
+
+  m_Sections.erase(m_Sections.begin() + index);
+  m_SectionLocations.erase(m_SectionLocations.begin() + index);
+
+  return true;
+}
+
+// passes writes straight through to a file writer, reporting each one to a write tee with the file
+// offset it lands at. It sits in the compressor slot of a StreamWriter only so it can wrap the file
+// writer, nothing is compressed.
+class FileWriteTee : public Compressor
+{
+public:
+  FileWriteTee(StreamWriter *write, uint64_t offset, const RDCWriteTee &tee)
+      : Compressor(write, Ownership::Stream), m_Offset(offset), m_Tee(tee)
+  {
+  }
+
+  bool Write(const void *data, uint64_t numBytes)
+  {
+    if(!m_Write->Write(data, numBytes))
+      return false;
+
+    m_Tee(m_Offset, data, numBytes);
+    m_Offset += numBytes;
+    return true;
+  }
+
+  bool Finish() { return m_Write->Finish(); }
+private:
+  uint64_t m_Offset;
+  RDCWriteTee m_Tee;
+};
+
+StreamWriter *RDCFile::MakeFileWriter(uint64_t offset)
+{
+  StreamWriter *fileWriter = new StreamWriter(m_File, Ownership::Nothing);
+
+  if(!m_WriteTee)
+    return fileWriter;
+
+  return new StreamWriter(new FileWriteTee(fileWriter, offset, m_WriteTee), Ownership::Stream);
+}
+
+void RDCFile::TeeWrite(uint64_t offset, const void *data, uint64_t length)
+{
+  if(m_WriteTee)
+    m_WriteTee(offset, data, length);
+}
+
+bool RDCFile::WriteBlobStore(const BlobStore &blobs, uint64_t frameCaptureVersion)
+{
+  if(blobs.NumBlobs() == 0)
+    return true;
+
+  int frameIndex = SectionIndex(SectionType::FrameCapture);
+
+  if(m_Error != ContainerError::NoError || frameIndex < 0)
+  {
+    RDCERR("Blob store must be written after the frame capture that refers to it");
+    return false;
+  }
+
+  // patch the frame capture's version in place. Nothing else in its header changes.
+  m_Sections[frameIndex].version = frameCaptureVersion;
+
+  if(m_File)
+  {
+    const uint64_t offset =
+        m_SectionLocations[frameIndex].headerOffset + offsetof(BinarySectionHeader, sectionVersion);
+
+    FileIO::fclose(m_File);
+    m_File = FileIO::fopen(m_Filename.c_str(), "r+b");
+
+    bool success = false;
+
+    if(m_File)
+    {
+      FileIO::fseek64(m_File, offset, SEEK_SET);
+      success =
+          FileIO::fwrite(&frameCaptureVersion, 1, sizeof(uint64_t), m_File) == sizeof(uint64_t);
+      FileIO::fclose(m_File);
+    }
+
+    m_File = FileIO::fopen(m_Filename.c_str(), "rb");
+
+    if(!success)
+    {
+      SETERROR(ContainerError::FileIO, "Error updating frame capture version, errno %d", errno);
+      return false;
+    }
+
+    TeeWrite(offset, &frameCaptureVersion, sizeof(uint64_t));
+  }
+
+  SectionProperties props;
+  props.flags = SectionFlags::LZ4Compressed;
+  props.type = SectionType::BlobStore;
+  props.version = 1;
+
+  StreamWriter *writer = WriteSection(props);
+
+  blobs.Write(*writer);
+  writer->Finish();
+
+  bool success = !writer->IsErrored();
+
+  delete writer;
+
+  RDCLOG("Wrote %u unique blobs of %llu bytes, saving %llu duplicate bytes",
+         (uint32_t)blobs.NumBlobs(), blobs.GetUniqueBytes(), blobs.GetDuplicateBytes());
+
+  return success;
+}
+
+StreamWriter *RDCFile::WriteSection(const SectionProperties &props, const ZSTDSettings *zstd)
 {
   if(m_Error != ContainerError::NoError)
     return new StreamWriter(StreamWriter::InvalidStream);
@@ -886,12 +1146,30 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
     return new StreamWriter(StreamWriter::InvalidStream);
   }
 
+  ZSTDSettings settings;
+  if(zstd)
+    settings = *zstd;
+
+  // the zstd flags describe how the data was written, so make sure they match what we'll do. In
+  // particular the dictionary flag is only set if we have a dictionary to store.
+  SectionFlags flags = props.flags;
+
+  if((flags & SectionFlags::ZstdCompressed) && settings.dictionarySize > 0)
+    flags |= SectionFlags::ZstdDictionary;
+  else
+    flags &= ~SectionFlags::ZstdDictionary;
+
+  if(!(flags & SectionFlags::ZstdCompressed))
+    flags &= ~SectionFlags::ZstdLongWindow;
+
   // For handling a section that does exist, it depends on the section type:
   // - For frame capture, then we just write to a new file since we want it
   //   to be first. Once the writing is done, copy across any other sections
   //   after it.
-  // - For non-frame capture, we remove the existing section and move up any
-  //   sections that were after it. Then just return a new writer that appends
+  // - For non-frame capture, we release the existing section's space by
+  //   turning it into a free section, leaving any sections after it where they
+  //   are. Then just return a new writer that appends after the last live
+  //   section, reusing any free space at the end of the file.
 
   // we store this callback here so that we can execute it after any post-section-writing header
   // fixups. We need to be able to fixup any pre-existing sections that got shifted around.
@@ -935,6 +1213,14 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
 
         std::string tempFilename = FileIO::GetTempFolderFilename() + "capture_rewrite.rdc";
 
+        // the file is rebuilt elsewhere and moved over the top, which a write tee can't follow.
+        if(m_WriteTee)
+        {
+          RDCWARN("Rewriting frame capture section, dropping write tee");
+          m_WriteTee = RDCWriteTee();
+          m_WriteTeeLost = true;
+        }
+
         // create the file, this will overwrite m_File with the new file and file header using the
         // existing loaded metadata
         Create(tempFilename.c_str());
@@ -1003,10 +1289,10 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
     }
     else
     {
-      // we're writing some section after the frame capture. We'll do this in-place by reading the
-      // other sections out to memory (assuming that they are mostly small, and even if they are
-      // somewhat large, it's still much better to leave the frame capture (which should dominate
-      // file size) on disk where it is.
+      // we're writing some section after the frame capture. Rather than moving any of the sections
+      // that follow it, we release the old section's space in-place and append the new section to
+      // the end of the file. Only the header of the old section is touched, so replacing a small
+      // section doesn't cost anything proportional to the size of the other sections.
       int index = SectionIndex(type);
 
       if(index < 0)
@@ -1014,72 +1300,59 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
 
       RDCASSERT(index >= 0);
 
-      std::vector<bytebuf> origSectionData;
-      std::vector<uint64_t> origHeaderSizes;
-
-      uint64_t overwriteLocation = m_SectionLocations[index].headerOffset;
-      uint64_t oldLength = m_SectionLocations[index].diskLength;
-
-      // erase the target section. The others will be moved up to match
-      m_Sections.erase(m_Sections.begin() + index);
-      m_SectionLocations.erase(m_SectionLocations.begin() + index);
+      if(!ReleaseSection(index))
+      {
+        // the old section is too small to hold a free-space header (only possible with a tiny
+        // hand-written ASCII section). Fall back to moving up the subsequent sections in memory.
+        std::vector<bytebuf> origSectionData;
+        std::vector<uint64_t> origHeaderSizes;
 
-      origSectionData.reserve(NumSections() - index);
-      origHeaderSizes.reserve(NumSections() - index);
+        uint64_t overwriteLocation = m_SectionLocations[index].headerOffset;
 
-      // go through all subsequent sections after this one in the file, read them into memory.
-      // this could be optimised since we're going to write them back out below, we could do this
-      // just with an in-memory window large enough.
-      for(int i = index; i < NumSections(); i++)
-      {
-        const SectionLocation &loc = m_SectionLocations[i];
+        // erase the target section. The others will be moved up to match
+        m_Sections.erase(m_Sections.begin() + index);
+        m_SectionLocations.erase(m_SectionLocations.begin() + index);
 
-        FileIO::fseek64(m_File, loc.headerOffset, SEEK_SET);
+        origSectionData.reserve(NumSections() - index);
+        origHeaderSizes.reserve(NumSections() - index);
 
-        uint64_t headerLen = loc.dataOffset - loc.headerOffset;
+        // go through all subsequent sections after this one in the file, read them into memory.
+        for(int i = index; i < NumSections(); i++)
+        {
+          const SectionLocation &loc = m_SectionLocations[i];
 
-        // read header and data together
-        StreamReader reader(m_File, headerLen + loc.diskLength, Ownership::Nothing);
+          FileIO::fseek64(m_File, loc.headerOffset, SEEK_SET);
 
-        origHeaderSizes.push_back(headerLen);
-        origSectionData.push_back(bytebuf());
+          uint64_t headerLen = loc.dataOffset - loc.headerOffset;
 
-        bytebuf &data = origSectionData.back();
-        data.resize((size_t)reader.GetSize());
-        reader.Read(data.data(), data.size());
-      }
+          // read header and data together
+          StreamReader reader(m_File, headerLen + loc.diskLength, Ownership::Nothing);
 
-      // we write the sections now over where the old section used to be, so the newly written
-      // section is last in the file. This means if the same section is updated over and over, it
-      // doesn't require moving any sections once it's already at the end.
+          origHeaderSizes.push_back(headerLen);
+          origSectionData.push_back(bytebuf());
 
-      // seek to write to where the removed section started
-      FileIO::fseek64(m_File, overwriteLocation, SEEK_SET);
+          bytebuf &data = origSectionData.back();
+          data.resize((size_t)reader.GetSize());
+          reader.Read(data.data(), data.size());
+        }
 
-      // write the old sections
-      for(size_t i = 0; i < origSectionData.size(); i++)
-      {
-        // update the offsets to where they are in the new file
-        m_SectionLocations[index + i].headerOffset = FileIO::ftell64(m_File);
-        m_SectionLocations[index + i].dataOffset =
-            m_SectionLocations[index + i].headerOffset + origHeaderSizes[i];
-
-        // write the data
-        StreamWriter writer(m_File, Ownership::Nothing);
-        writer.Write(origSectionData[i].data(), origSectionData[i].size());
-      }
+        // seek to write to where the removed section started
+        FileIO::fseek64(m_File, overwriteLocation, SEEK_SET);
 
-      // after writing, we need to be sure to fixup the size (in case we wrote less data).
-      modifySectionCallback = [this, oldLength]() {
-        if(oldLength > m_SectionLocations.back().diskLength)
+        // write the old sections
+        for(size_t i = 0; i < origSectionData.size(); i++)
         {
-          FileIO::ftruncateat(
-              m_File, m_SectionLocations.back().dataOffset + m_SectionLocations.back().diskLength);
+          // update the offsets to where they are in the new file
+          m_SectionLocations[index + i].headerOffset = FileIO::ftell64(m_File);
+          m_SectionLocations[index + i].dataOffset =
+              m_SectionLocations[index + i].headerOffset + origHeaderSizes[i];
+
+          // write the data
+          StreamWriter *writer = MakeFileWriter(m_SectionLocations[index + i].headerOffset);
+          writer->Write(origSectionData[i].data(), origSectionData[i].size());
+          delete writer;
         }
-      };
-
-      // fall through - we now write to m_File with the new section wherever we left off after the
-      // moved sections.
+      }
     }
   }
   else
@@ -1088,6 +1361,33 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
     FileIO::fseek64(m_File, 0, SEEK_END);
   }
 
+  if(type != SectionType::FrameCapture && name != ToStr(SectionType::FrameCapture))
+  {
+    // append after the last live section. Anything beyond that is free space - either the
+    // section we just released, or ones released earlier - so it can be overwritten. This means
+    // if the same section is updated over and over, it stays at the end and the file doesn't
+    // grow.
+    uint64_t appendOffset = LiveDataEnd();
+
+    FileIO::fseek64(m_File, 0, SEEK_END);
+    uint64_t oldFileEnd = FileIO::ftell64(m_File);
+
+    FileIO::fseek64(m_File, appendOffset, SEEK_SET);
+
+    // after writing, we need to be sure to fixup the size (in case we wrote less data than the
+    // free space we wrote over).
+    if(oldFileEnd > appendOffset)
+    {
+      modifySectionCallback = [this, oldFileEnd]() {
+        uint64_t newEnd = LiveDataEnd();
+        if(oldFileEnd > newEnd)
+          FileIO::ftruncateat(m_File, newEnd);
+      };
+    }
+
+    // fall through - we now write to m_File with the new section at the end of the live data.
+  }
+
   uint64_t headerOffset = FileIO::ftell64(m_File);
 
   size_t numWritten;
@@ -1106,7 +1406,7 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
                                 // sectionVersion
                                 props.version,
                                 // sectionFlags
-                                props.flags,
+                                flags,
                                 // sectionNameLength
                                 uint32_t(name.length() + 1)};
 
@@ -1120,28 +1420,41 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
     return new StreamWriter(StreamWriter::InvalidStream);
   }
 
+  TeeWrite(headerOffset, &header, offsetof(BinarySectionHeader, name));
+  TeeWrite(headerOffset + offsetof(BinarySectionHeader, name), name.c_str(), name.size() + 1);
+
   // create a writer for writing to disk. It shouldn't close the file
-  StreamWriter *fileWriter = new StreamWriter(m_File, Ownership::Nothing);
+  StreamWriter *fileWriter = MakeFileWriter(FileIO::ftell64(m_File));
 
   StreamWriter *compWriter = NULL;
 
+  Compressor *compressor = NULL;
+
   if(props.flags & SectionFlags::LZ4Compressed)
   {
-    // the user will delete the compressed writer, and then it will delete the compressor and the
-    // file writer
-    compWriter =
-        new StreamWriter(new LZ4Compressor(fileWriter, Ownership::Stream), Ownership::Stream);
+    compressor = new LZ4Compressor(fileWriter, Ownership::Stream);
   }
   else if(props.flags & SectionFlags::ZstdCompressed)
   {
-    compWriter =
-        new StreamWriter(new ZSTDCompressor(fileWriter, Ownership::Stream), Ownership::Stream);
+    settings.longWindow = bool(flags & SectionFlags::ZstdLongWindow);
+
+    compressor = new ZSTDCompressor(fileWriter, Ownership::Stream, settings);
+  }
+
+  if(compressor)
+  {
+    // the user will delete the compressed writer, and then it will delete the compressors and the
+    // file writer. For larger sections compression and the disk writes happen on a worker thread so
+    // they overlap with the caller serialising the section contents.
+    compWriter = new StreamWriter(new PipelinedCompressor(compressor, Ownership::Stream),
+                                  Ownership::Stream);
   }
 
   uint64_t dataOffset = FileIO::ftell64(m_File);
 
   m_CurrentWritingProps = props;
   m_CurrentWritingProps.name = name;
+  m_CurrentWritingProps.flags = flags;
 
   // register a destroy callback to tidy up the section at the end
   fileWriter->AddCloseCallback([this, type, name, headerOffset, dataOffset, fileWriter, compWriter]() {
@@ -1182,6 +1495,11 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
       RETURNERROR(ContainerError::FileIO, "Error applying fixup to section header, errno %d", errno);
     }
 
+    TeeWrite(headerOffset + offsetof(BinarySectionHeader, sectionCompressedLength),
+             &compressedLength, sizeof(uint64_t));
+    TeeWrite(headerOffset + offsetof(BinarySectionHeader, sectionUncompressedLength),
+             &uncompressedLength, sizeof(uint64_t));
+
     FileIO::fflush(m_File);
   });
 
@@ -1217,3 +1535,131 @@ FILE *RDCFile::StealImageFileHandle(std::string &filename)
   m_File = NULL;
   return ret;
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Test RDC write tee mirrors the file", "[rdcfile]")
+{
+  std::string filename = FileIO::GetTempFolderFilename() + "rdcfile_tee_test.rdc";
+
+  bytebuf mirror;
+  RDCWriteTee tee = [&mirror](uint64_t offset, const void *data, uint64_t length) {
+    if(mirror.size() < offset + length)
+      mirror.resize((size_t)(offset + length));
+    memcpy(mirror.data() + offset, data, (size_t)length);
+  };
+
+  std::vector<byte> frameData(1024 * 1024);
+  for(size_t i = 0; i < frameData.size(); i++)
+    frameData[i] = byte((i * 7) ^ (i >> 9));
+
+  RDCFile *rdc = new RDCFile;
+  rdc->SetData(RDCDriver::Unknown, "Test", 0, NULL);
+  rdc->SetWriteTee(tee);
+  rdc->Create(filename.c_str());
+
+  bool created = rdc->ErrorCode() == ContainerError::NoError;
+  REQUIRE(created);
+
+  SectionProperties props;
+  props.type = SectionType::FrameCapture;
+  props.flags = SectionFlags::LZ4Compressed;
+  props.version = 1;
+
+  StreamWriter *w = rdc->WriteSection(props);
+  w->Write(frameData.data(), frameData.size());
+  w->Finish();
+  delete w;
+
+  // write a section then replace it with a smaller one, so its space is released and the file is
+  // truncated.
+  props.type = SectionType::ResolveDatabase;
+  props.flags = SectionFlags::NoFlags;
+
+  w = rdc->WriteSection(props);
+  w->Write(frameData.data(), 4096);
+  delete w;
+
+  w = rdc->WriteSection(props);
+  w->Write(frameData.data(), 1024);
+  delete w;
+
+  CHECK(rdc->IsWriteTeeComplete());
+
+  delete rdc;
+
+  FILE *f = FileIO::fopen(filename.c_str(), "rb");
+  REQUIRE(f);
+
+  FileIO::fseek64(f, 0, SEEK_END);
+  uint64_t size = FileIO::ftell64(f);
+  FileIO::fseek64(f, 0, SEEK_SET);
+
+  bytebuf contents;
+  contents.resize((size_t)size);
+  FileIO::fread(contents.data(), 1, contents.size(), f);
+  FileIO::fclose(f);
+
+  FileIO::Delete(filename.c_str());
+
+  REQUIRE(mirror.size() >= size);
+  mirror.resize((size_t)size);
+
+  CHECK(mirror == contents);
+};
+
+TEST_CASE("Test RDC blob store marks the frame capture version", "[rdcfile][blobs]")
+{
+  std::string filename = FileIO::GetTempFolderFilename() + "rdcfile_blobs_test.rdc";
+
+  std::vector<byte> blob((size_t)BlobStore::MinimumSize);
+  for(size_t i = 0; i < blob.size(); i++)
+    blob[i] = byte(i * 3);
+
+  RDCFile *rdc = new RDCFile;
+  rdc->SetData(RDCDriver::Unknown, "Test", 0, NULL);
+  rdc->Create(filename.c_str());
+
+  bool created = rdc->ErrorCode() == ContainerError::NoError;
+  REQUIRE(created);
+
+  SectionProperties props;
+  props.type = SectionType::FrameCapture;
+  props.flags = SectionFlags::LZ4Compressed;
+  props.version = 5;
+
+  StreamWriter *w = rdc->WriteSection(props);
+  w->Write(blob.data(), 1024);
+  w->Finish();
+  delete w;
+
+  // an empty store doesn't change anything
+  BlobStore empty;
+  CHECK(rdc->WriteBlobStore(empty, 6));
+  CHECK(rdc->SectionIndex(SectionType::BlobStore) < 0);
+  CHECK(rdc->GetSectionProperties(0).version == 5);
+
+  BlobStore blobs;
+  blobs.Add(blob.data(), blob.size());
+  CHECK(rdc->WriteBlobStore(blobs, 6));
+
+  delete rdc;
+
+  rdc = new RDCFile;
+  rdc->Open(filename.c_str());
+
+  bool opened = rdc->ErrorCode() == ContainerError::NoError;
+  REQUIRE(opened);
+
+  int frameIndex = rdc->SectionIndex(SectionType::FrameCapture);
+  REQUIRE(frameIndex >= 0);
+  CHECK(rdc->GetSectionProperties(frameIndex).version == 6);
+  CHECK(rdc->SectionIndex(SectionType::BlobStore) >= 0);
+
+  delete rdc;
+
+  FileIO::Delete(filename.c_str());
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
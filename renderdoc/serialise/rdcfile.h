@@ -38,6 +38,11 @@ enum class ContainerError
 
 extern const char *SectionTypeNames[];
 
+struct ZSTDSettings;
+
+// called with each range of bytes written to an RDCFile on disk, at the offset it was written to.
+typedef std::function<void(uint64_t offset, const void *data, uint64_t length)> RDCWriteTee;
+
 struct RDCThumb
 {
   const byte *pixels = NULL;
@@ -73,6 +78,11 @@ public:
   void Open(const char *filename);
   void Open(const std::vector<byte> &buffer);
 
+  // reads only the file header - containing the driver, machine ident and primary thumbnail. No
+  // sections are enumerated so none can be read, but this is much cheaper than a full Open() when
+  // only the metadata is needed.
+  void OpenHeader(const char *filename);
+
   bool CopyFileTo(const char *filename);
 
   // Sets the parameters of an RDCFile in memory.
@@ -82,6 +92,14 @@ public:
   // creates a new file with current properties, file will be overwritten if it already exists
   void Create(const char *filename);
 
+  // reports every write made to the file from now on to the tee, so it can be mirrored elsewhere
+  // while the file is being written. Set before Create() to include the file header. Truncation
+  // isn't reported, the final size of the file must be taken once it's complete. If the file is
+  // modified in a way that can't be reported the tee is dropped and IsWriteTeeComplete() returns
+  // false.
+  void SetWriteTee(RDCWriteTee tee) { m_WriteTee = tee; }
+  bool IsWriteTeeComplete() const { return !m_WriteTeeLost; }
+
   ContainerError ErrorCode() const { return m_Error; }
   std::string ErrorString() const { return m_ErrorString; }
   RDCDriver GetDriver() const { return m_Driver; }
@@ -93,7 +111,13 @@ public:
   int NumSections() const { return int(m_Sections.size()); }
   const SectionProperties &GetSectionProperties(int index) const { return m_Sections[index]; }
   StreamReader *ReadSection(int index) const;
-  StreamWriter *WriteSection(const SectionProperties &props);
+  // zstd optionally controls how the section is compressed when it has SectionFlags::ZstdCompressed,
+  // otherwise the defaults are used.
+  StreamWriter *WriteSection(const SectionProperties &props, const ZSTDSettings *zstd = NULL);
+  // writes the blob store section that a frame capture written with this store refers to, and sets
+  // the frame capture's section version to frameCaptureVersion. That must be a version older builds
+  // reject, since they can't resolve the references. Does nothing if the store is empty.
+  bool WriteBlobStore(const BlobStore &blobs, uint64_t frameCaptureVersion);
 
   // Only valid if GetDriver returns RDCDriver::Image, passes over the underlying FILE * for use
   // loading the image directly, since the RDC container isn't there to read from a section.
@@ -101,6 +125,21 @@ public:
 
 private:
   void Init(StreamReader &reader);
+  void ReadHeader(StreamReader &reader);
+
+  // opens a section's data without attaching the blob store
+  StreamReader *OpenSection(int index) const;
+
+  // turns an on-disk section into free space without moving anything after it. Returns false if the
+  // section is too small to hold a free section header.
+  bool ReleaseSection(int index);
+  // the file offset just past the last section that isn't free space, or the end of the header if
+  // there are no live sections.
+  uint64_t LiveDataEnd() const;
+
+  // returns a writer to m_File at its current position, offset, which reports to the write tee
+  StreamWriter *MakeFileWriter(uint64_t offset);
+  void TeeWrite(uint64_t offset, const void *data, uint64_t length);
 
   FILE *m_File = NULL;
   std::string m_Filename;
@@ -108,6 +147,9 @@ private:
 
   SectionProperties m_CurrentWritingProps;
 
+  // the length of the file header, thumbnail and metadata at the start of the file
+  uint64_t m_HeaderLength = 0;
+
   uint32_t m_SerVer = 0;
 
   RDCDriver m_Driver = RDCDriver::Unknown;
@@ -118,6 +160,9 @@ private:
   ContainerError m_Error = ContainerError::NoError;
   std::string m_ErrorString;
 
+  RDCWriteTee m_WriteTee;
+  bool m_WriteTeeLost = false;
+
   struct SectionLocation
   {
     uint64_t headerOffset;
@@ -128,4 +173,7 @@ private:
   std::vector<SectionProperties> m_Sections;
   std::vector<SectionLocation> m_SectionLocations;
   std::vector<std::vector<byte>> m_MemorySections;
+
+  // created on first use for the frame capture section, if the file has a blob store section
+  mutable BlobStore *m_Blobs = NULL;
 };
@@ -0,0 +1,641 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "api/replay/renderdoc_replay.h"
+#include "common/timing.h"
+#include "strings/string_utils.h"
+#include "lz4io.h"
+#include "rdcfile.h"
+#include "serialiser.h"
+#include "zstdio.h"
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+// These benchmarks measure the throughput of the serialisation stack for the kind of data that
+// makes up a capture, so that regressions in capture and load cost can be tracked over time. Each
+// benchmark reports the bytes processed, the number of chunks, the time taken and how many buffer
+// allocations were made. For raw stream benchmarks a 'chunk' is one fixed-size Read() call.
+
+namespace
+{
+struct BenchmarkResult
+{
+  std::string name;
+  uint64_t bytes = 0;
+  uint64_t chunks = 0;
+  uint64_t allocs = 0;
+  double milliseconds = 0.0;
+};
+
+// measures the time and allocations made during its lifetime, into the given result
+struct BenchmarkScope
+{
+  BenchmarkScope(BenchmarkResult &res) : m_Result(res), m_Allocs(GetAlignedBufferAllocCount()) {}
+  ~BenchmarkScope()
+  {
+    m_Result.milliseconds = m_Timer.GetMilliseconds();
+    m_Result.allocs = GetAlignedBufferAllocCount() - m_Allocs;
+  }
+
+private:
+  BenchmarkResult &m_Result;
+  uint64_t m_Allocs;
+  PerformanceTimer m_Timer;
+};
+
+enum BenchChunk
+{
+  BenchChunk_Draw = 1,
+  BenchChunk_Descriptors,
+  BenchChunk_Buffer,
+};
+
+static const uint32_t DescriptorCount = 32;
+static const uint64_t BufferChunkSize = 64 * 1024;
+static const uint32_t StreamReadSize = 4096;
+
+struct BenchData
+{
+  BenchData()
+  {
+    for(uint32_t i = 0; i < DescriptorCount; i++)
+    {
+      handles[i] = 0x1000000ULL + i * 0x40;
+      offsets[i] = i * 256;
+    }
+
+    // half of the buffer is a smooth ramp and half is noise, to roughly match the compression ratio
+    // of real resource contents.
+    buffer = AllocAlignedBuffer(BufferChunkSize);
+    uint32_t seed = 0x1234567;
+    for(uint64_t i = 0; i < BufferChunkSize; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      buffer[i] = (i & 0x100) ? byte(seed >> 16) : byte(i >> 4);
+    }
+  }
+  ~BenchData() { FreeAlignedBuffer(buffer); }
+  uint64_t handles[DescriptorCount];
+  uint32_t offsets[DescriptorCount];
+  byte *buffer;
+};
+
+template <typename SerialiserType>
+void SerialiseDraw(SerialiserType &ser)
+{
+  SERIALISE_ELEMENT_LOCAL(commandBuffer, uint64_t(0x12340000));
+  SERIALISE_ELEMENT_LOCAL(vertexCount, 36U);
+  SERIALISE_ELEMENT_LOCAL(instanceCount, 1U);
+  SERIALISE_ELEMENT_LOCAL(firstVertex, 0U);
+  SERIALISE_ELEMENT_LOCAL(firstInstance, 0U);
+}
+
+template <typename SerialiserType>
+void SerialiseDescriptors(SerialiserType &ser, BenchData &data)
+{
+  uint64_t *handles = ser.IsWriting() ? data.handles : NULL;
+  uint32_t *offsets = ser.IsWriting() ? data.offsets : NULL;
+
+  SERIALISE_ELEMENT_LOCAL(descriptorSet, uint64_t(0x56780000));
+  SERIALISE_ELEMENT_LOCAL(count, DescriptorCount);
+  SERIALISE_ELEMENT_ARRAY(handles, count);
+  SERIALISE_ELEMENT_ARRAY(offsets, count);
+}
+
+template <typename SerialiserType>
+void SerialiseBuffer(SerialiserType &ser, BenchData &data)
+{
+  byte *contents = ser.IsWriting() ? data.buffer : NULL;
+
+  SERIALISE_ELEMENT_LOCAL(buffer, uint64_t(0x9abc0000));
+  SERIALISE_ELEMENT_LOCAL(offset, uint64_t(0));
+  SERIALISE_ELEMENT_LOCAL(size, BufferChunkSize);
+  ser.Serialise("contents", contents, size, SerialiserFlags::AllocateMemory);
+
+  if(ser.IsReading())
+    FreeAlignedBuffer(contents);
+}
+
+template <typename SerialiserType>
+void SerialiseChunk(SerialiserType &ser, BenchChunk chunk, BenchData &data)
+{
+  if(chunk == BenchChunk_Draw)
+    SerialiseDraw(ser);
+  else if(chunk == BenchChunk_Descriptors)
+    SerialiseDescriptors(ser, data);
+  else if(chunk == BenchChunk_Buffer)
+    SerialiseBuffer(ser, data);
+}
+
+// a mix approximating a frame capture: mostly small command chunks, with periodic descriptor
+// updates and resource uploads.
+BenchChunk MixedChunk(uint64_t i)
+{
+  if(i % 256 == 255)
+    return BenchChunk_Buffer;
+  if(i % 16 == 15)
+    return BenchChunk_Descriptors;
+  return BenchChunk_Draw;
+}
+
+void WriteChunks(StreamWriter *writer, BenchData &data, uint64_t numChunks, BenchChunk chunk)
+{
+  WriteSerialiser ser(writer, Ownership::Nothing);
+
+  for(uint64_t i = 0; i < numChunks; i++)
+  {
+    BenchChunk c = chunk == BenchChunk(0) ? MixedChunk(i) : chunk;
+
+    SCOPED_SERIALISE_CHUNK(c);
+    SerialiseChunk(ser, c, data);
+  }
+}
+
+void ReadChunks(StreamReader *reader, BenchData &data, bool structured)
+{
+  ReadSerialiser ser(reader, Ownership::Nothing);
+
+  if(structured)
+    ser.ConfigureStructuredExport([](uint32_t) -> std::string { return "BenchChunk"; }, true);
+
+  while(!reader->AtEnd())
+  {
+    BenchChunk c = ser.ReadChunk<BenchChunk>();
+
+    SerialiseChunk(ser, c, data);
+
+    ser.EndChunk();
+
+    if(ser.IsErrored())
+      break;
+  }
+}
+
+typedef std::function<void(BenchmarkResult &)> BenchmarkFunction;
+
+class BenchmarkRunner
+{
+public:
+  BenchmarkRunner(const std::string &filter, uint32_t repeats) : m_Filter(filter), m_Repeats(repeats)
+  {
+  }
+
+  bool Enabled(const std::string &name) const
+  {
+    return m_Filter.empty() || name.find(m_Filter) != std::string::npos;
+  }
+
+  // runs the benchmark the requested number of times and keeps the fastest run, which is the most
+  // stable number to compare between builds.
+  void Run(const std::string &name, BenchmarkFunction func)
+  {
+    if(!Enabled(name))
+      return;
+
+    BenchmarkResult best;
+
+    for(uint32_t i = 0; i < m_Repeats; i++)
+    {
+      BenchmarkResult res;
+      func(res);
+
+      if(i == 0 || res.milliseconds < best.milliseconds)
+        best = res;
+    }
+
+    best.name = name;
+
+    RDCLOG("Benchmark %s: %.2f MB/s", name.c_str(), MBPerSecond(best));
+
+    m_Results.push_back(best);
+  }
+
+  std::string MakeJSON() const
+  {
+    std::string json = "{\n  \"benchmarks\": [\n";
+
+    for(size_t i = 0; i < m_Results.size(); i++)
+    {
+      const BenchmarkResult &res = m_Results[i];
+
+      json += StringFormat::Fmt(
+          R"(    {
+      "name": "%s",
+      "bytes": %llu,
+      "chunks": %llu,
+      "milliseconds": %.3f,
+      "MBps": %.3f,
+      "allocs": %llu,
+      "allocsPerChunk": %.4f
+    })",
+          res.name.c_str(), res.bytes, res.chunks, res.milliseconds, MBPerSecond(res), res.allocs,
+          res.chunks ? double(res.allocs) / double(res.chunks) : 0.0);
+
+      if(i + 1 < m_Results.size())
+        json += ",";
+
+      json += "\n";
+    }
+
+    json += "  ]\n}\n";
+
+    return json;
+  }
+
+private:
+  static double MBPerSecond(const BenchmarkResult &res)
+  {
+    if(res.milliseconds <= 0.0)
+      return 0.0;
+
+    return (double(res.bytes) / (1024.0 * 1024.0)) / (res.milliseconds / 1000.0);
+  }
+
+  std::string m_Filter;
+  uint32_t m_Repeats;
+  std::vector<BenchmarkResult> m_Results;
+};
+
+struct ChunkShape
+{
+  const char *name;
+  BenchChunk chunk;
+  uint64_t count;
+};
+
+// chunk counts are picked so that each run takes a measurable amount of time in a development
+// build without dragging out the whole suite. A chunk type of 0 means the mixed stream.
+static const ChunkShape shapes[] = {
+    {"draw", BenchChunk_Draw, 200000},
+    {"descriptors", BenchChunk_Descriptors, 50000},
+    {"buffer", BenchChunk_Buffer, 512},
+    {"mixed", BenchChunk(0), 100000},
+};
+
+void SerialiserBenchmarks(BenchmarkRunner &runner, BenchData &data)
+{
+  for(const ChunkShape &shape : shapes)
+  {
+    runner.Run(StringFormat::Fmt("serialiser/write/%s", shape.name), [&](BenchmarkResult &res) {
+      StreamWriter writer(StreamWriter::DefaultScratchSize);
+
+      {
+        BenchmarkScope scope(res);
+        WriteChunks(&writer, data, shape.count, shape.chunk);
+      }
+
+      res.bytes = writer.GetOffset();
+      res.chunks = shape.count;
+    });
+
+    std::string readName = StringFormat::Fmt("serialiser/read/%s", shape.name);
+    std::string structuredName = StringFormat::Fmt("serialiser/read_structured/%s", shape.name);
+
+    if(!runner.Enabled(readName) && !runner.Enabled(structuredName))
+      continue;
+
+    StreamWriter stream(StreamWriter::DefaultScratchSize);
+    WriteChunks(&stream, data, shape.count, shape.chunk);
+
+    for(bool structured : {false, true})
+    {
+      runner.Run(structured ? structuredName : readName, [&](BenchmarkResult &res) {
+        StreamReader reader(stream.GetData(), stream.GetOffset());
+
+        {
+          BenchmarkScope scope(res);
+          ReadChunks(&reader, data, structured);
+        }
+
+        res.bytes = stream.GetOffset();
+        res.chunks = shape.count;
+      });
+    }
+  }
+}
+
+void CompressionBenchmarks(BenchmarkRunner &runner, BenchData &data, StreamWriter &stream,
+                           uint64_t numChunks)
+{
+  const uint64_t size = stream.GetOffset();
+
+  for(bool zstd : {false, true})
+  {
+    const char *name = zstd ? "zstd" : "lz4";
+
+    StreamWriter compressed(StreamWriter::DefaultScratchSize);
+
+    runner.Run(StringFormat::Fmt("compress/%s", name), [&](BenchmarkResult &res) {
+      compressed.Rewind();
+
+      {
+        BenchmarkScope scope(res);
+
+        Compressor *comp = NULL;
+        if(zstd)
+          comp = new ZSTDCompressor(&compressed, Ownership::Nothing);
+        else
+          comp = new LZ4Compressor(&compressed, Ownership::Nothing);
+
+        StreamWriter writer(comp, Ownership::Stream);
+        writer.Write(stream.GetData(), size);
+        writer.Finish();
+      }
+
+      res.bytes = size;
+      res.chunks = numChunks;
+    });
+
+    std::string decompName = StringFormat::Fmt("decompress/%s", name);
+
+    if(!runner.Enabled(decompName))
+      continue;
+
+    // make sure we have compressed data even if the compression benchmark was filtered out
+    if(compressed.GetOffset() == 0)
+    {
+      Compressor *comp = NULL;
+      if(zstd)
+        comp = new ZSTDCompressor(&compressed, Ownership::Nothing);
+      else
+        comp = new LZ4Compressor(&compressed, Ownership::Nothing);
+
+      StreamWriter writer(comp, Ownership::Stream);
+      writer.Write(stream.GetData(), size);
+      writer.Finish();
+    }
+
+    runner.Run(decompName, [&](BenchmarkResult &res) {
+      {
+        BenchmarkScope scope(res);
+
+        StreamReader *compReader = new StreamReader(compressed.GetData(), compressed.GetOffset());
+
+        Decompressor *decomp = NULL;
+        if(zstd)
+          decomp = new ZSTDDecompressor(compReader, Ownership::Stream);
+        else
+          decomp = new LZ4Decompressor(compReader, Ownership::Stream);
+
+        StreamReader reader(decomp, size, Ownership::Stream);
+        ReadChunks(&reader, data, false);
+      }
+
+      res.bytes = size;
+      res.chunks = numChunks;
+    });
+  }
+}
+
+void ReadStream(StreamReader &reader, uint64_t size)
+{
+  byte block[StreamReadSize];
+
+  for(uint64_t offs = 0; offs < size && !reader.IsErrored(); offs += StreamReadSize)
+    reader.Read(block, RDCMIN(size - offs, (uint64_t)StreamReadSize));
+}
+
+void StreamBenchmarks(BenchmarkRunner &runner, StreamWriter &stream)
+{
+  const uint64_t size = stream.GetOffset();
+  const uint64_t numReads = (size + StreamReadSize - 1) / StreamReadSize;
+
+  runner.Run("streamreader/memory", [&](BenchmarkResult &res) {
+    {
+      BenchmarkScope scope(res);
+      StreamReader reader(stream.GetData(), size);
+      ReadStream(reader, size);
+    }
+
+    res.bytes = size;
+    res.chunks = numReads;
+  });
+
+  if(runner.Enabled("streamreader/file"))
+  {
+    std::string filename = FileIO::GetTempFolderFilename() + "renderdoc_benchmark_stream.bin";
+
+    FileIO::dump(filename.c_str(), stream.GetData(), (size_t)size);
+
+    runner.Run("streamreader/file", [&](BenchmarkResult &res) {
+      {
+        BenchmarkScope scope(res);
+        StreamReader reader(FileIO::fopen(filename.c_str(), "rb"));
+        ReadStream(reader, size);
+      }
+
+      res.bytes = size;
+      res.chunks = numReads;
+    });
+
+    FileIO::Delete(filename.c_str());
+  }
+
+  if(runner.Enabled("streamreader/socket"))
+  {
+    uint16_t port = 8235;
+    Network::Socket *server = NULL;
+
+    for(uint16_t probe = 0; probe < 20 && server == NULL; probe++)
+      server = Network::CreateServerSocket("localhost", port++, 1);
+
+    Network::Socket *sender = server ? Network::CreateClientSocket("localhost", port - 1, 10) : NULL;
+    Network::Socket *receiver = sender ? server->AcceptClient(250) : NULL;
+
+    if(receiver)
+    {
+      runner.Run("streamreader/socket", [&](BenchmarkResult &res) {
+        {
+          BenchmarkScope scope(res);
+
+          // the sender must run on its own thread as both sides block
+          Threading::ThreadHandle sendThread = Threading::CreateThread([&]() {
+            const uint32_t blockSize = 64 * 1024;
+            for(uint64_t offs = 0; offs < size; offs += blockSize)
+              sender->SendDataBlocking(stream.GetData() + offs,
+                                       (uint32_t)RDCMIN(size - offs, (uint64_t)blockSize));
+          });
+
+          StreamReader reader(receiver, Ownership::Nothing);
+          ReadStream(reader, size);
+
+          Threading::JoinThread(sendThread);
+          Threading::CloseThread(sendThread);
+        }
+
+        res.bytes = size;
+        res.chunks = numReads;
+      });
+    }
+    else
+    {
+      RDCERR("Couldn't set up loopback sockets for socket benchmark");
+    }
+
+    SAFE_DELETE(receiver);
+    SAFE_DELETE(sender);
+    SAFE_DELETE(server);
+  }
+}
+
+void RDCFileBenchmarks(BenchmarkRunner &runner, BenchData &data, StreamWriter &stream,
+                       uint64_t numChunks)
+{
+  const uint64_t size = stream.GetOffset();
+
+  struct
+  {
+    const char *name;
+    SectionFlags flags;
+  } variants[] = {
+      {"uncompressed", SectionFlags::NoFlags},
+      {"lz4", SectionFlags::LZ4Compressed},
+      {"zstd", SectionFlags::ZstdCompressed},
+  };
+
+  std::string filename = FileIO::GetTempFolderFilename() + "renderdoc_benchmark.rdc";
+
+  for(const auto &v : variants)
+  {
+    std::string writeName = StringFormat::Fmt("rdcfile/write_section/%s", v.name);
+    std::string readName = StringFormat::Fmt("rdcfile/read_section/%s", v.name);
+
+    if(!runner.Enabled(writeName) && !runner.Enabled(readName))
+      continue;
+
+    BenchmarkFunction writeFunc = [&](BenchmarkResult &res) {
+      {
+        BenchmarkScope scope(res);
+
+        RDCFile rdc;
+        rdc.SetData(RDCDriver::Unknown, "Benchmark", 0, NULL);
+        rdc.Create(filename.c_str());
+
+        SectionProperties props;
+        props.type = SectionType::FrameCapture;
+        props.flags = v.flags;
+        props.version = 1;
+
+        StreamWriter *writer = rdc.WriteSection(props);
+        writer->Write(stream.GetData(), size);
+        writer->Finish();
+        delete writer;
+      }
+
+      res.bytes = size;
+      res.chunks = numChunks;
+    };
+
+    // reading needs the file to exist even if the write benchmark was filtered out
+    BenchmarkResult dummy;
+    if(runner.Enabled(writeName))
+      runner.Run(writeName, writeFunc);
+    else
+      writeFunc(dummy);
+
+    runner.Run(readName, [&](BenchmarkResult &res) {
+      {
+        BenchmarkScope scope(res);
+
+        RDCFile rdc;
+        rdc.Open(filename.c_str());
+
+        int idx = rdc.SectionIndex(SectionType::FrameCapture);
+
+        StreamReader *reader = idx >= 0 ? rdc.ReadSection(idx) : NULL;
+        if(reader)
+          ReadChunks(reader, data, false);
+        delete reader;
+      }
+
+      res.bytes = size;
+      res.chunks = numChunks;
+    });
+  }
+
+  FileIO::Delete(filename.c_str());
+}
+
+}    // anonymous namespace
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
+
+extern "C" RENDERDOC_API int RENDERDOC_CC RENDERDOC_RunBenchmarks(const rdcarray<rdcstr> &args)
+{
+#if ENABLED(ENABLE_UNIT_TESTS)
+  std::string filter;
+  std::string outFile;
+  uint32_t repeats = 3;
+
+  for(size_t i = 0; i < args.size(); i++)
+  {
+    if((args[i] == "-o" || args[i] == "--out") && i + 1 < args.size())
+      outFile = args[++i].c_str();
+    else if((args[i] == "-r" || args[i] == "--repeat") && i + 1 < args.size())
+      repeats = RDCMAX(1U, (uint32_t)atoi(args[++i].c_str()));
+    else
+      filter = args[i].c_str();
+  }
+
+  BenchmarkRunner runner(filter, repeats);
+  BenchData data;
+
+  SerialiserBenchmarks(runner, data);
+
+  // the remaining benchmarks all process the same mixed stream of chunks
+  const ChunkShape &mixed = shapes[ARRAY_COUNT(shapes) - 1];
+
+  StreamWriter stream(StreamWriter::DefaultScratchSize);
+  WriteChunks(&stream, data, mixed.count, mixed.chunk);
+
+  CompressionBenchmarks(runner, data, stream, mixed.count);
+  StreamBenchmarks(runner, stream);
+  RDCFileBenchmarks(runner, data, stream, mixed.count);
+
+  std::string json = runner.MakeJSON();
+
+  if(outFile.empty())
+  {
+    OSUtility::WriteOutput(OSUtility::Output_StdOut, json.c_str());
+  }
+  else
+  {
+    FILE *f = FileIO::fopen(outFile.c_str(), "wb");
+
+    if(!f)
+    {
+      RDCERR("Couldn't open '%s' to write benchmark results", outFile.c_str());
+      return 1;
+    }
+
+    FileIO::fwrite(json.c_str(), 1, json.size(), f);
+    FileIO::fclose(f);
+  }
+
+  return 0;
+#else
+  RDCERR("Benchmarks are not available in this build");
+  return 1;
+#endif
+}
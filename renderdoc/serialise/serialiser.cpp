@@ -29,6 +29,8 @@
 #include "core/core.h"
 #include "strings/string_utils.h"
 
+#include "3rdparty/zstd/xxhash.h"
+
 #if !defined(RELEASE)
 
 int64_t Chunk::m_LiveChunks = 0;
@@ -36,6 +38,239 @@ int64_t Chunk::m_TotalMem = 0;
 
 #endif
 
+/////////////////////////////////////////////////////////////
+// Blob store functions
+
+// spilled blobs are read back in pieces this size when comparing and writing them
+static const uint64_t SpillChunkSize = 1024 * 1024;
+
+BlobStore::~BlobStore()
+{
+  for(bytebuf *b : m_Blobs)
+    delete b;
+
+  if(m_SpillFile)
+  {
+    FileIO::fclose(m_SpillFile);
+    FileIO::Delete(m_SpillPath.c_str());
+  }
+}
+
+bool BlobStore::SpillToDisk()
+{
+  if(m_SpillFile)
+    return true;
+
+  static int32_t spillCounter = 0;
+
+  m_SpillPath = FileIO::GetTempFolderFilename() +
+                StringFormat::Fmt("renderdoc_blobs_%u_%d.bin", Process::GetCurrentPID(),
+                                  Atomic::Inc32(&spillCounter));
+
+  m_SpillFile = FileIO::fopen(m_SpillPath.c_str(), "w+b");
+
+  if(m_SpillFile == NULL)
+  {
+    RDCWARN("Couldn't create blob spill file '%s', keeping blobs in memory", m_SpillPath.c_str());
+    return false;
+  }
+
+  // blobs already added stay in memory
+  for(bytebuf *b : m_Blobs)
+    m_Spilled.push_back({0, b->size()});
+
+  return true;
+}
+
+bool BlobStore::SpilledEquals(uint64_t index, const byte *data, uint64_t size) const
+{
+  const SpilledBlob &spilled = m_Spilled[(size_t)index];
+
+  if(spilled.size != size)
+    return false;
+
+  bytebuf buf;
+  buf.resize((size_t)RDCMIN(size, SpillChunkSize));
+
+  FileIO::fseek64(m_SpillFile, spilled.offset, SEEK_SET);
+
+  bool ret = true;
+
+  for(uint64_t offs = 0; ret && offs < size;)
+  {
+    size_t len = (size_t)RDCMIN(size - offs, SpillChunkSize);
+
+    ret = FileIO::fread(buf.data(), 1, len, m_SpillFile) == len &&
+          !memcmp(buf.data(), data + offs, len);
+
+    offs += len;
+  }
+
+  FileIO::fseek64(m_SpillFile, m_SpillSize, SEEK_SET);
+
+  return ret;
+}
+
+uint64_t BlobStore::Add(const byte *data, uint64_t size)
+{
+  uint64_t hash = XXH64(data, (size_t)size, size);
+
+  std::vector<uint64_t> &candidates = m_Lookup[hash];
+
+  // compare contents so a hash collision can't corrupt the capture
+  for(uint64_t idx : candidates)
+  {
+    const bytebuf *b = m_Blobs[(size_t)idx];
+
+    bool equal = b ? b->size() == size && !memcmp(b->data(), data, (size_t)size)
+                   : SpilledEquals(idx, data, size);
+
+    if(equal)
+    {
+      m_DuplicateBytes += size;
+      return idx;
+    }
+  }
+
+  uint64_t idx = m_Blobs.size();
+
+  if(m_SpillFile && FileIO::fwrite(data, 1, (size_t)size, m_SpillFile) == size)
+  {
+    m_Blobs.push_back(NULL);
+    m_Spilled.push_back({m_SpillSize, size});
+    m_SpillSize += size;
+  }
+  else
+  {
+    // if writing to the spill file failed, anything partially written is overwritten by the next
+    // blob that is spilled
+    if(m_SpillFile)
+    {
+      RDCWARN("Couldn't write %llu byte blob to spill file, keeping it in memory", size);
+      FileIO::fseek64(m_SpillFile, m_SpillSize, SEEK_SET);
+      m_Spilled.push_back({0, size});
+    }
+
+    bytebuf *blob = new bytebuf;
+    blob->resize((size_t)size);
+    memcpy(blob->data(), data, (size_t)size);
+
+    m_Blobs.push_back(blob);
+  }
+
+  candidates.push_back(idx);
+
+  m_UniqueBytes += size;
+
+  return idx;
+}
+
+const bytebuf *BlobStore::Get(uint64_t index)
+{
+  if(!Load())
+    return NULL;
+
+  if(index >= m_Blobs.size())
+    return NULL;
+
+  return m_Blobs[(size_t)index];
+}
+
+void BlobStore::Write(StreamWriter &writer) const
+{
+  uint64_t count = m_Blobs.size();
+  writer.Write(count);
+
+  bytebuf buf;
+
+  if(m_SpillFile)
+  {
+    FileIO::fflush(m_SpillFile);
+    buf.resize((size_t)RDCMIN(m_SpillSize, SpillChunkSize));
+  }
+
+  for(size_t i = 0; i < m_Blobs.size(); i++)
+  {
+    const bytebuf *b = m_Blobs[i];
+
+    if(b)
+    {
+      uint64_t size = b->size();
+      writer.Write(size);
+      writer.Write(b->data(), size);
+      continue;
+    }
+
+    // copy spilled blobs through in chunks, so they're never all in memory at once
+    const SpilledBlob &spilled = m_Spilled[i];
+    writer.Write(spilled.size);
+
+    FileIO::fseek64(m_SpillFile, spilled.offset, SEEK_SET);
+
+    for(uint64_t offs = 0; offs < spilled.size;)
+    {
+      size_t len = (size_t)RDCMIN(spilled.size - offs, SpillChunkSize);
+
+      // keep the section the right size even if the read fails, so it can still be parsed
+      if(FileIO::fread(buf.data(), 1, len, m_SpillFile) != len)
+      {
+        RDCERR("Failed to read back spilled blob %u", (uint32_t)i);
+        memset(buf.data(), 0, len);
+      }
+
+      writer.Write(buf.data(), len);
+      offs += len;
+    }
+  }
+
+  if(m_SpillFile)
+    FileIO::fseek64(m_SpillFile, m_SpillSize, SEEK_SET);
+}
+
+bool BlobStore::Load()
+{
+  SCOPED_LOCK(m_LoadLock);
+
+  if(m_Loaded || !m_Source)
+    return true;
+
+  m_Loaded = true;
+
+  StreamReader *reader = m_Source();
+
+  if(!reader)
+    return false;
+
+  uint64_t count = 0;
+  reader->Read(count);
+
+  for(uint64_t i = 0; i < count && !reader->IsErrored(); i++)
+  {
+    uint64_t size = 0;
+    reader->Read(size);
+
+    if(size > reader->GetSize() - reader->GetOffset())
+    {
+      RDCERR("Invalid blob %llu of %llu bytes in blob store", i, size);
+      break;
+    }
+
+    bytebuf *blob = new bytebuf;
+    blob->resize((size_t)size);
+    reader->Read(blob->data(), size);
+    m_Blobs.push_back(blob);
+  }
+
+  bool success = !reader->IsErrored() && m_Blobs.size() == count;
+
+  if(!success)
+    RDCERR("Failed to read blob store, read %u of %llu blobs", (uint32_t)m_Blobs.size(), count);
+
+  delete reader;
+
+  return success;
+}
+
 /////////////////////////////////////////////////////////////
 // Read Serialiser functions
 
@@ -25,6 +25,7 @@
 #pragma once
 
 #include <list>
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -82,6 +83,73 @@ enum class SerialiserMode
 
 struct CompressedFileIO;
 
+// Stores large byte buffers by content, so that identical buffers - such as cleared textures,
+// duplicated meshes or zero-filled buffers in initial contents - are only written once. A write
+// serialiser with a store attached writes a reference in place of any buffer at least MinimumSize
+// bytes long, and the store is then written to its own section. When reading, the store comes from
+// the StreamReader (see RDCFile::ReadSection), and references are expanded transparently.
+class BlobStore
+{
+public:
+  // buffers smaller than this are always written inline
+  static const uint64_t MinimumSize = 64 * 1024;
+
+  // set in a serialised byte size when a blob index follows instead of the data
+  static const uint64_t ReferenceBit = 0x8000000000000000ULL;
+
+  BlobStore() = default;
+  // the section is only read the first time a blob is needed
+  BlobStore(std::function<StreamReader *()> source) : m_Source(source) {}
+  ~BlobStore();
+
+  // no copies
+  BlobStore(const BlobStore &other) = delete;
+  BlobStore &operator=(const BlobStore &other) = delete;
+
+  // blobs added after this are written to a temporary file instead of being copied in memory, for
+  // when the data they came from is still in memory anyway. Returns false if the file couldn't be
+  // created, in which case they're still copied.
+  bool SpillToDisk();
+
+  // returns the index of the blob with these contents, adding a copy if it's new.
+  uint64_t Add(const byte *data, uint64_t size);
+  // returns NULL if the index is invalid, or the store couldn't be read.
+  const bytebuf *Get(uint64_t index);
+
+  void Write(StreamWriter &writer) const;
+
+  size_t NumBlobs() const { return m_Blobs.size(); }
+  uint64_t GetUniqueBytes() const { return m_UniqueBytes; }
+  uint64_t GetDuplicateBytes() const { return m_DuplicateBytes; }
+private:
+  bool Load();
+  bool SpilledEquals(uint64_t index, const byte *data, uint64_t size) const;
+
+  // NULL for blobs that have been spilled to disk
+  std::vector<bytebuf *> m_Blobs;
+
+  // once spilling, where each blob is in the spill file
+  struct SpilledBlob
+  {
+    uint64_t offset;
+    uint64_t size;
+  };
+  std::vector<SpilledBlob> m_Spilled;
+  FILE *m_SpillFile = NULL;
+  std::string m_SpillPath;
+  uint64_t m_SpillSize = 0;
+
+  // hash to the indices of the blobs with that hash, only used when writing
+  std::map<uint64_t, std::vector<uint64_t>> m_Lookup;
+
+  uint64_t m_UniqueBytes = 0;
+  uint64_t m_DuplicateBytes = 0;
+
+  std::function<StreamReader *()> m_Source;
+  Threading::CriticalSection m_LoadLock;
+  bool m_Loaded = false;
+};
+
 template <SerialiserMode sertype>
 class Serialiser
 {
@@ -138,6 +206,9 @@ public:
   // support seeking to fixup lengths, while also not requiring conservative length estimates
   // up-front
   void SetStreamingMode(bool stream) { m_DataStreaming = stream; }
+  // write any large byte buffers to this store instead of inline. Only for writing, when reading
+  // the store is taken from the stream.
+  void SetBlobStore(BlobStore *blobs) { m_Blobs = blobs; }
   SDFile &GetStructuredFile() { return *m_StructuredFile; }
   void WriteStructuredFile(const SDFile &file, RENDERDOC_ProgressCallback progress);
   void SetDrawChunk() { m_DrawChunk = true; }
@@ -227,15 +298,60 @@ public:
     if(IsWriting() && el == NULL)
       byteSize = 0;
 
+    // large buffers are written once to the blob store if there is one, and referenced by index
+    const bytebuf *blob = NULL;
+    uint64_t blobIndex = ~0ULL;
+
+    if(IsWriting() && m_Blobs && !m_DataStreaming && byteSize >= BlobStore::MinimumSize)
+      blobIndex = m_Blobs->Add(el, byteSize);
+
     {
       m_InternalElement = true;
-      DoSerialise(*this, byteSize);
+
+      uint64_t encodedSize = byteSize;
+      if(blobIndex != ~0ULL)
+        encodedSize |= BlobStore::ReferenceBit;
+
+      DoSerialise(*this, encodedSize);
+
+      // references are only decoded when the stream has a blob store to resolve them against, which
+      // is only attached for captures whose version marks them as using one.
+      if(IsReading() && m_Read->GetBlobStore())
+      {
+        byteSize = encodedSize & ~BlobStore::ReferenceBit;
+        if(encodedSize & BlobStore::ReferenceBit)
+          blobIndex = 0;
+      }
+      else if(IsReading())
+      {
+        byteSize = encodedSize;
+      }
+
+      if(blobIndex != ~0ULL)
+        DoSerialise(*this, blobIndex);
+
       m_InternalElement = false;
     }
 
     if(IsReading())
     {
-      VerifyArraySize(byteSize);
+      if(blobIndex != ~0ULL)
+      {
+        BlobStore *blobs = m_Read->GetBlobStore();
+        blob = blobs ? blobs->Get(blobIndex) : NULL;
+
+        if(blob == NULL || blob->size() != byteSize)
+        {
+          RDCERR("Reading invalid blob reference %llu of %llu bytes", blobIndex, byteSize);
+          SetInvalidStream();
+          byteSize = 0;
+          blob = NULL;
+        }
+      }
+      else
+      {
+        VerifyArraySize(byteSize);
+      }
     }
 
     if(ExportStructure())
@@ -265,10 +381,14 @@ public:
         // ensure byte alignment
         m_Write->AlignTo<ChunkAlignment>();
 
-        if(el)
-          m_Write->Write(el, byteSize);
-        else
-          RDCASSERT(byteSize == 0);
+        // if the buffer went to the blob store, the reference is all we need
+        if(blobIndex == ~0ULL)
+        {
+          if(el)
+            m_Write->Write(el, byteSize);
+          else
+            RDCASSERT(byteSize == 0);
+        }
       }
       else if(IsReading())
       {
@@ -299,7 +419,15 @@ public:
         }
 #endif
 
-        m_Read->Read(el, byteSize);
+        if(blob)
+        {
+          if(el)
+            memcpy(el, blob->data(), (size_t)byteSize);
+        }
+        else
+        {
+          m_Read->Read(el, byteSize);
+        }
       }
     }
 
@@ -1565,19 +1693,24 @@ private:
       RDCERR("Reading invalid array or byte buffer - %llu larger than total stream size %llu.",
              count, size);
 
-      // if we owned the previous stream, delete it
-      if(m_Ownership == Ownership::Stream)
-        delete m_Read;
-
-      // replace our stream with an invalid one so all subsequent reads fail
-      m_Read = new StreamReader(StreamReader::InvalidStream);
-      m_Ownership = Ownership::Stream;
+      SetInvalidStream();
 
       // set the count to 0
       count = 0;
     }
   }
 
+  void SetInvalidStream()
+  {
+    // if we owned the previous stream, delete it
+    if(m_Ownership == Ownership::Stream)
+      delete m_Read;
+
+    // replace our stream with an invalid one so all subsequent reads fail
+    m_Read = new StreamReader(StreamReader::InvalidStream);
+    m_Ownership = Ownership::Stream;
+  }
+
   void *m_pUserData = NULL;
   uint64_t m_Version = 0;
 
@@ -1588,6 +1721,9 @@ private:
 
   Ownership m_Ownership;
 
+  // See SetBlobStore
+  BlobStore *m_Blobs = NULL;
+
   // See SetStreamingMode
   bool m_DataStreaming = false;
   bool m_DrawChunk = false;
@@ -720,6 +720,158 @@ TEST_CASE("Verify multiple chunks can be merged", "[serialiser][chunks]")
   delete buf;
 };
 
+TEST_CASE("Verify large buffers are deduplicated with a blob store", "[serialiser][blobs]")
+{
+  const uint64_t largeSize = BlobStore::MinimumSize * 4;
+
+  std::vector<byte> zeroes(largeSize, 0);
+  std::vector<byte> pattern(largeSize);
+  for(size_t i = 0; i < pattern.size(); i++)
+    pattern[i] = byte(i * 7);
+
+  std::vector<byte> small(128, 0xcc);
+
+  std::vector<byte *> buffers = {zeroes.data(), pattern.data(), zeroes.data(), small.data(),
+                                 pattern.data(), zeroes.data()};
+  std::vector<uint64_t> sizes = {largeSize, largeSize, largeSize, small.size(), largeSize,
+                                 largeSize};
+
+  StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
+  StreamWriter *blobBuf = new StreamWriter(StreamWriter::DefaultScratchSize);
+
+  {
+    BlobStore blobs;
+
+    WriteSerialiser ser(buf, Ownership::Nothing);
+
+    ser.SetBlobStore(&blobs);
+
+    for(size_t i = 0; i < buffers.size(); i++)
+    {
+      SCOPED_SERIALISE_CHUNK(5);
+
+      byte *data = buffers[i];
+      ser.Serialise("data", data, sizes[i]);
+    }
+
+    REQUIRE_FALSE(ser.IsErrored());
+
+    CHECK(blobs.NumBlobs() == 2);
+    CHECK(blobs.GetUniqueBytes() == largeSize * 2);
+    CHECK(blobs.GetDuplicateBytes() == largeSize * 3);
+
+    // only the small buffer should be written inline
+    CHECK(buf->GetOffset() < 1024);
+
+    blobs.Write(*blobBuf);
+  }
+
+  {
+    bool loaded = false;
+
+    BlobStore blobs([blobBuf, &loaded]() {
+      loaded = true;
+      return new StreamReader(blobBuf->GetData(), blobBuf->GetOffset());
+    });
+
+    StreamReader *reader = new StreamReader(buf->GetData(), buf->GetOffset());
+    reader->SetBlobStore(&blobs);
+
+    ReadSerialiser ser(reader, Ownership::Stream);
+
+    // the store isn't read until it's needed
+    CHECK_FALSE(loaded);
+
+    for(size_t i = 0; i < buffers.size(); i++)
+    {
+      uint32_t chunkID = ser.ReadChunk<uint32_t>();
+      CHECK(chunkID == 5);
+
+      byte *data = NULL;
+      ser.Serialise("data", data, 0, SerialiserFlags::AllocateMemory);
+
+      REQUIRE_FALSE(ser.IsErrored());
+      REQUIRE(data);
+      CHECK(memcmp(data, buffers[i], (size_t)sizes[i]) == 0);
+
+      FreeAlignedBuffer(data);
+
+      ser.EndChunk();
+    }
+
+    CHECK(loaded);
+    CHECK(ser.GetReader()->AtEnd());
+  }
+
+  // a reference without a store is an error, not a crash
+  {
+    ReadSerialiser ser(new StreamReader(buf->GetData(), buf->GetOffset()), Ownership::Stream);
+
+    ser.ReadChunk<uint32_t>();
+
+    byte *data = NULL;
+    ser.Serialise("data", data, 0, SerialiserFlags::AllocateMemory);
+
+    CHECK(ser.IsErrored());
+    CHECK(data == NULL);
+  }
+
+  delete buf;
+  delete blobBuf;
+};
+
+TEST_CASE("Verify spilled blob stores write the same data", "[serialiser][blobs]")
+{
+  // bigger than the spill file is read back in, so that's done in several pieces
+  const uint64_t largeSize = 3 * 1024 * 1024 + 17;
+
+  std::vector<byte> zeroes(BlobStore::MinimumSize, 0);
+  std::vector<byte> pattern(largeSize);
+  for(size_t i = 0; i < pattern.size(); i++)
+    pattern[i] = byte(i * 7);
+
+  // the same as pattern, except in the last byte
+  std::vector<byte> nearPattern = pattern;
+  nearPattern.back()++;
+
+  std::vector<std::vector<byte> *> buffers = {&zeroes,  &pattern, &zeroes,     &nearPattern,
+                                              &pattern, &zeroes,  &nearPattern};
+
+  StreamWriter memory(StreamWriter::DefaultScratchSize);
+  StreamWriter spilled(StreamWriter::DefaultScratchSize);
+
+  {
+    BlobStore blobs;
+
+    for(std::vector<byte> *b : buffers)
+      blobs.Add(b->data(), b->size());
+
+    blobs.Write(memory);
+  }
+
+  {
+    BlobStore blobs;
+
+    // the first blob is added before spilling, so stays in memory
+    std::vector<uint64_t> indices;
+    indices.push_back(blobs.Add(buffers[0]->data(), buffers[0]->size()));
+
+    REQUIRE(blobs.SpillToDisk());
+
+    for(size_t i = 1; i < buffers.size(); i++)
+      indices.push_back(blobs.Add(buffers[i]->data(), buffers[i]->size()));
+
+    CHECK(indices == std::vector<uint64_t>({0, 1, 0, 2, 1, 0, 2}));
+    CHECK(blobs.NumBlobs() == 3);
+    CHECK(blobs.GetUniqueBytes() == zeroes.size() + largeSize * 2);
+
+    blobs.Write(spilled);
+  }
+
+  REQUIRE(memory.GetOffset() == spilled.GetOffset());
+  CHECK(memcmp(memory.GetData(), spilled.GetData(), (size_t)memory.GetOffset()) == 0);
+};
+
 TEST_CASE("Read/write container types", "[serialiser][structured]")
 {
   StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
@@ -1419,6 +1571,81 @@ std::string DoStringise(const TestBitfield &el)
   END_BITFIELD_STRINGISE();
 }
 
+TEST_CASE("Querying structured files", "[serialiser][structured]")
+{
+  ResourceId buf = ResourceIDGen::GetNewUniqueID();
+  ResourceId tex = ResourceIDGen::GetNewUniqueID();
+
+  SDFile file;
+
+  auto addChunk = [&file](const char *name, std::vector<SDObject *> params) {
+    SDChunk *chunk = new SDChunk(name);
+    for(SDObject *o : params)
+      chunk->data.children.push_back(o);
+    file.chunks.push_back(chunk);
+  };
+
+  SDObject *bufs = makeSDArray("pBuffers");
+  bufs->data.children.push_back(makeSDResourceId("$el", buf));
+  bufs->data.children.push_back(makeSDResourceId("$el", buf));
+
+  SDObject *region = makeSDStruct("region", "Region");
+  region->data.children.push_back(makeSDUInt32("width", 256));
+  region->data.children.push_back(makeSDFloat("scale", 0.5f));
+
+  addChunk("Create", {makeSDResourceId("buffer", buf)});
+  addChunk("Create", {makeSDResourceId("texture", tex)});
+  addChunk("Draw", {makeSDUInt32("vertexCount", 3), makeSDString("marker", "first")});
+  addChunk("Bind", {bufs});
+  addChunk("Draw", {makeSDUInt32("vertexCount", 6), makeSDString("marker", "")});
+  addChunk("Copy", {makeSDResourceId("src", buf), makeSDResourceId("dst", tex), region});
+
+  CHECK(file.FindChunks("Create") == rdcarray<uint32_t>({0, 1}));
+  CHECK(file.FindChunks("Draw") == rdcarray<uint32_t>({2, 4}));
+  CHECK(file.FindChunks("Missing").empty());
+  CHECK(file.FindChunks("").empty());
+
+  // each chunk is listed once even if it references a resource more than once
+  CHECK(file.FindChunksReferencing(buf) == rdcarray<uint32_t>({0, 3, 5}));
+  CHECK(file.FindChunksReferencing(tex) == rdcarray<uint32_t>({1, 5}));
+  CHECK(file.FindChunksReferencing(ResourceId()).empty());
+
+  {
+    SDObject *six = makeSDInt64("", 6);
+    CHECK(file.FindChunksWithValue("Draw", "vertexCount", six) == rdcarray<uint32_t>({4}));
+    delete six;
+
+    SDObject *str = makeSDString("", "first");
+    CHECK(file.FindChunksWithValue("Draw", "marker", str) == rdcarray<uint32_t>({2}));
+    delete str;
+
+    SDObject *width = makeSDUInt32("", 256);
+    CHECK(file.FindChunksWithValue("Copy", "region.width", width) == rdcarray<uint32_t>({5}));
+    CHECK(file.FindChunksWithValue("Copy", "region.height", width).empty());
+    delete width;
+
+    SDObject *scale = makeSDFloat("", 0.5f);
+    CHECK(file.FindChunksWithValue("Copy", "region.scale", scale) == rdcarray<uint32_t>({5}));
+    delete scale;
+
+    SDObject *id = makeSDResourceId("", buf);
+    CHECK(file.FindChunksWithValue("Bind", "pBuffers.1", id) == rdcarray<uint32_t>({3}));
+    CHECK(file.FindChunksWithValue("Bind", "pBuffers.2", id).empty());
+    delete id;
+  }
+
+  CHECK(file.FilterChunks([](const SDChunk *c) { return c->NumChildren() > 1; }) ==
+        rdcarray<uint32_t>({2, 4, 5}));
+  CHECK(file.FilterChunks([](const SDChunk *c) { return c->NumChildren() > 1; }, "Draw") ==
+        rdcarray<uint32_t>({2, 4}));
+
+  // the index is only updated when invalidated
+  addChunk("Draw", {});
+  CHECK(file.FindChunks("Draw") == rdcarray<uint32_t>({2, 4}));
+  file.InvalidateIndex();
+  CHECK(file.FindChunks("Draw") == rdcarray<uint32_t>({2, 4, 6}));
+};
+
 TEST_CASE("Test stringification works as expected", "[tostr]")
 {
   SECTION("Enum classes")
@@ -24,6 +24,8 @@
 
 #include "streamio.h"
 #include <errno.h>
+#include <deque>
+#include "common/threading.h"
 #include "common/timing.h"
 
 Compressor::~Compressor()
@@ -38,6 +40,223 @@ Decompressor::~Decompressor()
     delete m_Read;
 }
 
+// the worker thread shared by all pipelined compressors. It's started on demand and exits after
+// it's been idle for a while, so nothing is left running between captures.
+struct PipelineWorker
+{
+  Threading::CriticalSection lock;
+  Threading::Semaphore wake;
+  std::deque<std::pair<PipelinedCompressor *, uint32_t>> queue;
+  bool running = false;
+
+  static const uint32_t IdleTimeoutMS = 2000;
+
+  void Submit(PipelinedCompressor *comp, uint32_t idx)
+  {
+    {
+      SCOPED_LOCK(lock);
+
+      queue.push_back(std::make_pair(comp, idx));
+
+      if(!running)
+      {
+        Threading::ThreadHandle th = Threading::CreateThread([this]() { ThreadEntry(); });
+
+        if(th == 0)
+        {
+          // no worker, so compress this block on the calling thread.
+          queue.pop_back();
+          comp->ConsumeBlock(idx);
+          return;
+        }
+
+        Threading::CloseThread(th);
+        running = true;
+      }
+    }
+
+    wake.Signal();
+  }
+
+  void ThreadEntry()
+  {
+    Threading::KeepModuleAlive();
+
+    for(;;)
+    {
+      bool woken = wake.Wait(IdleTimeoutMS);
+
+      for(;;)
+      {
+        std::pair<PipelinedCompressor *, uint32_t> block;
+
+        {
+          SCOPED_LOCK(lock);
+
+          if(queue.empty())
+          {
+            if(!woken)
+              running = false;
+            break;
+          }
+
+          block = queue.front();
+          queue.pop_front();
+        }
+
+        block.first->ConsumeBlock(block.second);
+      }
+
+      // we were idle and the queue was empty, so running is now false and any new block will start
+      // a new worker.
+      if(!woken)
+        break;
+    }
+
+    Threading::ReleaseModuleExitThread();
+  }
+};
+
+static PipelineWorker &GetPipelineWorker()
+{
+  // deliberately leaked, the worker thread may still be exiting during shutdown
+  static PipelineWorker *worker = new PipelineWorker();
+  return *worker;
+}
+
+PipelinedCompressor::PipelinedCompressor(Compressor *compressor, Ownership own)
+    : Compressor(NULL, Ownership::Nothing), m_Compressor(compressor), m_CompressorOwnership(own)
+{
+}
+
+PipelinedCompressor::~PipelinedCompressor()
+{
+  // if we weren't finished, make sure the worker is done with our blocks before we free anything
+  WaitForBlocks(0);
+
+  for(uint32_t i = 0; i < MaxBlocksInFlight; i++)
+    FreeAlignedBuffer(m_Blocks[i]);
+
+  if(m_CompressorOwnership == Ownership::Stream)
+    delete m_Compressor;
+}
+
+bool PipelinedCompressor::Write(const void *data, uint64_t numBytes)
+{
+  const byte *src = (const byte *)data;
+
+  // write straight through until there's enough data to be worth pipelining
+  if(m_DirectBytes < PipelineThreshold)
+  {
+    uint64_t chunkSize = RDCMIN(PipelineThreshold - m_DirectBytes, numBytes);
+
+    if(!m_Compressor->Write(src, chunkSize))
+    {
+      SCOPED_LOCK(m_Lock);
+      m_HasError = true;
+      return false;
+    }
+
+    m_DirectBytes += chunkSize;
+    numBytes -= chunkSize;
+    src += chunkSize;
+  }
+
+  while(numBytes > 0)
+  {
+    {
+      SCOPED_LOCK(m_Lock);
+      if(m_HasError)
+        return false;
+    }
+
+    byte *&block = m_Blocks[m_Submitted % MaxBlocksInFlight];
+
+    if(block == NULL)
+      block = AllocAlignedBuffer(BlockSize);
+
+    uint64_t chunkSize = RDCMIN(BlockSize - m_Fill, numBytes);
+
+    memcpy(block + m_Fill, src, (size_t)chunkSize);
+
+    m_Fill += chunkSize;
+    numBytes -= chunkSize;
+    src += chunkSize;
+
+    if(m_Fill == BlockSize)
+      SubmitBlock();
+  }
+
+  return true;
+}
+
+bool PipelinedCompressor::Finish()
+{
+  if(m_Fill > 0)
+    SubmitBlock();
+
+  WaitForBlocks(0);
+
+  if(m_HasError)
+    return false;
+
+  return m_Compressor->Finish();
+}
+
+void PipelinedCompressor::SubmitBlock()
+{
+  uint32_t idx = 0;
+
+  {
+    SCOPED_LOCK(m_Lock);
+    idx = m_Submitted % MaxBlocksInFlight;
+    m_BlockSizes[idx] = m_Fill;
+    m_Submitted++;
+  }
+
+  m_Fill = 0;
+
+  GetPipelineWorker().Submit(this, idx);
+
+  // wait until the block we'll fill next has been consumed by the worker
+  WaitForBlocks(MaxBlocksInFlight - 1);
+}
+
+void PipelinedCompressor::WaitForBlocks(uint32_t maxInFlight)
+{
+  for(;;)
+  {
+    {
+      SCOPED_LOCK(m_Lock);
+      if(m_Submitted - m_Consumed <= maxInFlight)
+        return;
+    }
+
+    m_BlockConsumed.Wait();
+  }
+}
+
+void PipelinedCompressor::ConsumeBlock(uint32_t idx)
+{
+  bool success = true;
+
+  // once there's been an error, the remaining blocks are just skipped
+  {
+    SCOPED_LOCK(m_Lock);
+    success = !m_HasError;
+  }
+
+  if(success)
+    success = m_Compressor->Write(m_Blocks[idx], m_BlockSizes[idx]);
+
+  // signal while holding the lock, so the compressor can't be destroyed until we're done with it
+  SCOPED_LOCK(m_Lock);
+  m_Consumed++;
+  if(!success)
+    m_HasError = true;
+  m_BlockConsumed.Signal();
+}
+
 static const uint64_t initialBufferSize = 64 * 1024;
 const byte StreamWriter::empty[128] = {};
 
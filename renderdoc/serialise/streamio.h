@@ -37,6 +37,7 @@ enum class Ownership
 
 class StreamWriter;
 class StreamReader;
+class BlobStore;
 
 typedef std::function<void()> StreamCloseCallback;
 
@@ -66,6 +67,59 @@ protected:
   Ownership m_Ownership;
 };
 
+// wraps another compressor and runs it on a worker thread. Writes are gathered into fixed-size
+// blocks which are handed over as they fill, so compression and the underlying I/O overlap with
+// whatever is producing the data. At most MaxBlocksInFlight blocks are queued before Write()
+// waits for the worker to catch up. The wrapped compressor sees exactly the same byte stream.
+//
+// The first PipelineThreshold bytes are written straight through on the calling thread, so small
+// streams never allocate blocks or involve the worker. A single worker thread is shared between all
+// pipelined compressors, processing blocks in the order they're submitted.
+class PipelinedCompressor : public Compressor
+{
+public:
+  PipelinedCompressor(Compressor *compressor, Ownership own);
+  ~PipelinedCompressor();
+
+  bool Write(const void *data, uint64_t numBytes);
+  bool Finish();
+
+  static const uint64_t BlockSize = 1024 * 1024;
+  static const uint32_t MaxBlocksInFlight = 8;
+  static const uint64_t PipelineThreshold = BlockSize;
+
+private:
+  friend struct PipelineWorker;
+
+  void SubmitBlock();
+  // waits until at most maxInFlight submitted blocks haven't been consumed by the worker
+  void WaitForBlocks(uint32_t maxInFlight);
+  // called on the worker thread
+  void ConsumeBlock(uint32_t idx);
+
+  Compressor *m_Compressor;
+  Ownership m_CompressorOwnership;
+
+  // how many bytes were written straight through before pipelining started
+  uint64_t m_DirectBytes = 0;
+
+  // allocated as they're first needed
+  byte *m_Blocks[MaxBlocksInFlight] = {};
+  uint64_t m_BlockSizes[MaxBlocksInFlight] = {};
+
+  // the offset into the block currently being filled, m_Blocks[m_Submitted % MaxBlocksInFlight]
+  uint64_t m_Fill = 0;
+
+  // signalled by the worker each time it consumes a block
+  Threading::Semaphore m_BlockConsumed;
+
+  // protects the counters below, which are shared with the worker thread
+  Threading::CriticalSection m_Lock;
+  uint32_t m_Submitted = 0;
+  uint32_t m_Consumed = 0;
+  bool m_HasError = false;
+};
+
 class StreamReader
 {
 public:
@@ -197,6 +251,9 @@ public:
   }
 
   void AddCloseCallback(StreamCloseCallback callback) { m_Callbacks.push_back(callback); }
+  // the store that any blob references in this stream refer to, see BlobStore
+  void SetBlobStore(BlobStore *blobs) { m_Blobs = blobs; }
+  BlobStore *GetBlobStore() const { return m_Blobs; }
 private:
   inline uint64_t Available()
   {
@@ -246,6 +303,9 @@ private:
 
   // callbacks that will be invoked when this stream is being destroyed
   std::vector<StreamCloseCallback> m_Callbacks;
+
+  // not owned, see SetBlobStore
+  BlobStore *m_Blobs = NULL;
 };
 
 class StreamWriter
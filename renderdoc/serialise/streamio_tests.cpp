@@ -308,4 +308,86 @@ TEST_CASE("Test stream I/O operations over the network", "[streamio][network]")
   delete server;
 };
 
+TEST_CASE("Test stream I/O operations over the local transport", "[streamio][network]")
+{
+  uint16_t port = 8255;
+  Network::Socket *server = NULL;
+
+  for(uint16_t probe = 0; probe < 20; probe++)
+  {
+    server = Network::CreateLocalServerSocket(port, 2);
+
+    if(server)
+      break;
+
+    port++;
+  }
+
+  // not all platforms support the local transport
+  if(server == NULL)
+    return;
+
+  // connecting to localhost should pick the local transport over TCP
+  Network::Socket *sender = Network::CreateClientSocket("localhost", port, 10);
+
+  REQUIRE(sender);
+  CHECK(sender->IsLocal());
+
+  Network::Socket *receiver = server->AcceptClient(250);
+
+  REQUIRE(receiver);
+  CHECK(receiver->IsLocal());
+  CHECK(receiver->GetRemoteIP() == Network::MakeIP(127, 0, 0, 1));
+
+  SECTION("Send/receive through shared memory")
+  {
+    Network::SharedMemory *created = Network::CreateSharedMemory(4096);
+
+    REQUIRE(created);
+
+    StreamWriter writer(sender, Ownership::Nothing);
+    StreamReader reader(receiver, Ownership::Nothing);
+
+    memset(created->GetData(), 0xcc, 4096);
+
+    uint32_t receivedValue = 0;
+
+    Threading::ThreadHandle recvThread =
+        Threading::CreateThread([&reader, &receivedValue]() { reader.Read(receivedValue); });
+
+    writer.Write(uint32_t(4096));
+    writer.Flush();
+
+    Threading::JoinThread(recvThread);
+    Threading::CloseThread(recvThread);
+
+    REQUIRE(receivedValue == 4096);
+
+    Network::SharedMemory *opened =
+        Network::OpenSharedMemory(created->GetName().c_str(), receivedValue);
+
+    REQUIRE(opened);
+
+    created->Unlink();
+
+    CHECK(opened->GetData()[0] == 0xcc);
+    CHECK(opened->GetData()[4095] == 0xcc);
+
+    opened->GetData()[100] = 0x12;
+    CHECK(created->GetData()[100] == 0x12);
+
+    // once unlinked it can't be opened again, but the existing mappings are still valid
+    Network::SharedMemory *reopened =
+        Network::OpenSharedMemory(created->GetName().c_str(), receivedValue);
+    CHECK(reopened == NULL);
+
+    delete opened;
+    delete created;
+  };
+
+  delete sender;
+  delete receiver;
+  delete server;
+};
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
\ No newline at end of file
@@ -24,23 +24,67 @@
 
 #define ZSTD_STATIC_LINKING_ONLY
 #include "zstdio.h"
+#include "os/os_specific.h"
 
 static const uint64_t zstdBlockSize = 128 * 1024;
-static const uint64_t compressBlockSize = ZSTD_compressBound(zstdBlockSize);
+static const int zstdDefaultLevel = 7;
 
-ZSTDCompressor::ZSTDCompressor(StreamWriter *write, Ownership own) : Compressor(write, own)
+// long window streams use much larger blocks so that there's something for long distance matching
+// to find. Blocks are still independent so they can be decompressed in parallel.
+static const uint64_t zstdLongBlockSize = 16 * 1024 * 1024;
+static const unsigned zstdLongWindowLog = 24;
+
+// sanity limit on the size of a stored dictionary
+static const uint32_t zstdMaxDictionarySize = 16 * 1024 * 1024;
+
+ZSTDCompressor::ZSTDCompressor(StreamWriter *write, Ownership own, const ZSTDSettings &settings)
+    : Compressor(write, own)
 {
-  m_Page = AllocAlignedBuffer(zstdBlockSize);
-  m_CompressBuffer = AllocAlignedBuffer(compressBlockSize);
+  m_BlockSize = settings.longWindow ? zstdLongBlockSize : zstdBlockSize;
+  m_CompressBlockSize = ZSTD_compressBound(m_BlockSize);
+
+  m_Page = AllocAlignedBuffer(m_BlockSize);
+  m_CompressBuffer = AllocAlignedBuffer(m_CompressBlockSize);
 
   m_PageOffset = 0;
 
-  m_Stream = ZSTD_createCStream();
+  m_Stream = ZSTD_createCCtx();
+
+  // parameters must all be set before any dictionary is loaded
+  int level = settings.level == 0 ? zstdDefaultLevel : settings.level;
+  size_t err = ZSTD_CCtx_setParameter(m_Stream, ZSTD_p_compressionLevel, (unsigned)level);
+
+  if(settings.longWindow && !ZSTD_isError(err))
+  {
+    err = ZSTD_CCtx_setParameter(m_Stream, ZSTD_p_windowLog, zstdLongWindowLog);
+    if(!ZSTD_isError(err))
+      err = ZSTD_CCtx_setParameter(m_Stream, ZSTD_p_enableLongDistanceMatching, 1);
+  }
+
+  if(settings.dictionarySize > 0 && !ZSTD_isError(err))
+  {
+    err = ZSTD_CCtx_loadDictionary(m_Stream, settings.dictionary, (size_t)settings.dictionarySize);
+
+    // the dictionary is needed to decompress, so store it at the start of the stream
+    if(!ZSTD_isError(err))
+    {
+      m_Write->Write((uint32_t)settings.dictionarySize);
+      m_Write->Write(settings.dictionary, settings.dictionarySize);
+    }
+  }
+
+  if(ZSTD_isError(err))
+  {
+    RDCERR("Error configuring compression: %s", ZSTD_getErrorName(err));
+    FreeAlignedBuffer(m_Page);
+    FreeAlignedBuffer(m_CompressBuffer);
+    m_Page = m_CompressBuffer = NULL;
+  }
 }
 
 ZSTDCompressor::~ZSTDCompressor()
 {
-  ZSTD_freeCStream(m_Stream);
+  ZSTD_freeCCtx(m_Stream);
 
   FreeAlignedBuffer(m_Page);
   FreeAlignedBuffer(m_CompressBuffer);
@@ -59,7 +103,7 @@ bool ZSTDCompressor::Write(const void *data, uint64_t numBytes)
   // The only difference is that the lz4 streaming compression assumes a history of 64kb, where
   // here we use a larger block size but no history must be maintained.
 
-  if(m_PageOffset + numBytes <= zstdBlockSize)
+  if(m_PageOffset + numBytes <= m_BlockSize)
   {
     // simplest path, no page wrapping/spanning at all
     memcpy(m_Page + m_PageOffset, data, (size_t)numBytes);
@@ -73,7 +117,7 @@ bool ZSTDCompressor::Write(const void *data, uint64_t numBytes)
 
     // copy whatever will fit on this page
     {
-      uint64_t firstBytes = zstdBlockSize - m_PageOffset;
+      uint64_t firstBytes = m_BlockSize - m_PageOffset;
       memcpy(m_Page + m_PageOffset, src, (size_t)firstBytes);
 
       m_PageOffset += firstBytes;
@@ -92,7 +136,7 @@ bool ZSTDCompressor::Write(const void *data, uint64_t numBytes)
         return success;
 
       // how many bytes can we copy in this page?
-      uint64_t partialBytes = RDCMIN(zstdBlockSize, numBytes);
+      uint64_t partialBytes = RDCMIN(m_BlockSize, numBytes);
       memcpy(m_Page, src, (size_t)partialBytes);
 
       // advance the source pointer, dest offset, and remove the bytes we read
@@ -122,7 +166,7 @@ bool ZSTDCompressor::FlushPage()
     return false;
 
   ZSTD_inBuffer in = {m_Page, (size_t)m_PageOffset, 0};
-  ZSTD_outBuffer out = {m_CompressBuffer, ZSTD_CStreamOutSize(), 0};
+  ZSTD_outBuffer out = {m_CompressBuffer, (size_t)m_CompressBlockSize, 0};
 
   bool success = true;
 
@@ -145,26 +189,18 @@ bool ZSTDCompressor::FlushPage()
 
 bool ZSTDCompressor::CompressZSTDFrame(ZSTD_inBuffer &in, ZSTD_outBuffer &out)
 {
-  size_t err = ZSTD_initCStream(m_Stream, 7);
-
-  if(ZSTD_isError(err))
-  {
-    RDCERR("Error compressing: %s", ZSTD_getErrorName(err));
-    FreeAlignedBuffer(m_Page);
-    FreeAlignedBuffer(m_CompressBuffer);
-    m_Page = m_CompressBuffer = NULL;
-    return false;
-  }
+  // the output buffer is large enough for the worst case, so keep going until the whole page is
+  // consumed and the frame has been ended.
+  size_t err = 0;
 
-  // keep calling compressStream until everything is consumed
-  while(in.pos < in.size)
+  do
   {
     size_t inpos = in.pos;
     size_t outpos = out.pos;
 
-    err = ZSTD_compressStream(m_Stream, &out, &in);
+    err = ZSTD_compress_generic(m_Stream, &out, &in, ZSTD_e_end);
 
-    if(ZSTD_isError(err) || (inpos == in.pos && outpos == out.pos))
+    if(ZSTD_isError(err) || (err != 0 && inpos == in.pos && outpos == out.pos))
     {
       if(ZSTD_isError(err))
         RDCERR("Error compressing: %s", ZSTD_getErrorName(err));
@@ -175,40 +211,66 @@ bool ZSTDCompressor::CompressZSTDFrame(ZSTD_inBuffer &in, ZSTD_outBuffer &out)
       m_Page = m_CompressBuffer = NULL;
       return false;
     }
-  }
-
-  err = ZSTD_endStream(m_Stream, &out);
-
-  if(ZSTD_isError(err) || err != 0)
-  {
-    if(ZSTD_isError(err))
-      RDCERR("Error compressing: %s", ZSTD_getErrorName(err));
-    else
-      RDCERR("Error compressing, couldn't end stream");
-    FreeAlignedBuffer(m_Page);
-    FreeAlignedBuffer(m_CompressBuffer);
-    m_Page = m_CompressBuffer = NULL;
-    return false;
-  }
+  } while(err != 0);
 
   return true;
 }
 
-ZSTDDecompressor::ZSTDDecompressor(StreamReader *read, Ownership own) : Decompressor(read, own)
+ZSTDDecompressor::ZSTDDecompressor(StreamReader *read, Ownership own, bool longWindow,
+                                   bool dictionary)
+    : Decompressor(read, own)
 {
-  m_Page = AllocAlignedBuffer(zstdBlockSize);
-  m_CompressBuffer = AllocAlignedBuffer(compressBlockSize);
+  m_BlockSize = longWindow ? zstdLongBlockSize : zstdBlockSize;
+  m_CompressBlockSize = ZSTD_compressBound(m_BlockSize);
+
+  // each block is an independent zstd frame, so we can decompress several at once. We decompress
+  // up to a few blocks per core at a time which keeps every core busy while only buffering a few MB.
+  // Long window blocks are much larger, so only buffer one per core up to a small limit.
+  if(longWindow)
+    m_MaxBatchBlocks = RDCMIN(Threading::NumberOfCores(), 4U);
+  else
+    m_MaxBatchBlocks = Threading::NumberOfCores() * 4;
 
+  m_Batch = AllocAlignedBuffer(m_BlockSize * m_MaxBatchBlocks);
+  m_CompressBuffer = AllocAlignedBuffer(m_CompressBlockSize * m_MaxBatchBlocks);
+
+  m_Page = m_Batch;
   m_PageOffset = 0;
   m_PageLength = 0;
 
-  m_Stream = ZSTD_createDStream();
+  m_Blocks.resize(m_MaxBatchBlocks);
+
+  m_Dictionary = NULL;
+
+  if(dictionary)
+  {
+    uint32_t dictSize = 0;
+    m_Read->Read(dictSize);
+
+    if(dictSize == 0 || dictSize > zstdMaxDictionarySize || m_Read->IsErrored())
+    {
+      RDCERR("Invalid dictionary size %u", dictSize);
+      FreeAlignedBuffer(m_Batch);
+      FreeAlignedBuffer(m_CompressBuffer);
+      m_Batch = m_Page = m_CompressBuffer = NULL;
+      return;
+    }
+
+    byte *dict = AllocAlignedBuffer(dictSize);
+    m_Read->Read(dict, dictSize);
+
+    m_Dictionary = ZSTD_createDDict(dict, dictSize);
+
+    FreeAlignedBuffer(dict);
+  }
 }
 
 ZSTDDecompressor::~ZSTDDecompressor()
 {
-  ZSTD_freeDStream(m_Stream);
-  FreeAlignedBuffer(m_Page);
+  for(BatchBlock &block : m_Blocks)
+    ZSTD_freeDCtx(block.context);
+  ZSTD_freeDDict(m_Dictionary);
+  FreeAlignedBuffer(m_Batch);
   FreeAlignedBuffer(m_CompressBuffer);
 }
 
@@ -216,7 +278,7 @@ bool ZSTDDecompressor::Recompress(Compressor *comp)
 {
   bool success = true;
 
-  while(success && !m_Read->AtEnd())
+  while(success && (m_BatchIndex + 1 < m_BatchCount || !m_Read->AtEnd()))
   {
     success &= FillPage();
     if(success)
@@ -288,58 +350,101 @@ bool ZSTDDecompressor::Read(void *data, uint64_t numBytes)
 
 bool ZSTDDecompressor::FillPage()
 {
-  uint32_t compSize = 0;
-
-  bool success = true;
-
-  success &= m_Read->Read(compSize);
-  success &= m_Read->Read(m_CompressBuffer, compSize);
+  // if we encountered a stream error this will be NULL
+  if(!m_CompressBuffer)
+    return false;
 
-  if(!success)
+  // move onto the next block that's already been decompressed, if there is one
+  if(m_BatchIndex + 1 < m_BatchCount)
   {
-    FreeAlignedBuffer(m_Page);
-    FreeAlignedBuffer(m_CompressBuffer);
-    m_Page = m_CompressBuffer = NULL;
-    return false;
+    m_BatchIndex++;
   }
-
-  size_t err = ZSTD_initDStream(m_Stream);
-
-  if(ZSTD_isError(err))
+  else
   {
-    RDCERR("Error decompressing: %s", ZSTD_getErrorName(err));
-    FreeAlignedBuffer(m_Page);
-    FreeAlignedBuffer(m_CompressBuffer);
-    m_Page = m_CompressBuffer = NULL;
-    return false;
+    if(!DecompressBatch())
+    {
+      FreeAlignedBuffer(m_Batch);
+      FreeAlignedBuffer(m_CompressBuffer);
+      m_Batch = m_Page = m_CompressBuffer = NULL;
+      m_BatchIndex = m_BatchCount = 0;
+      return false;
+    }
+
+    m_BatchIndex = 0;
   }
 
-  ZSTD_inBuffer in = {m_CompressBuffer, compSize, 0};
-  ZSTD_outBuffer out = {m_Page, zstdBlockSize, 0};
+  m_Page = m_Batch + m_BlockSize * m_BatchIndex;
+  m_PageOffset = 0;
+  m_PageLength = m_Blocks[m_BatchIndex].uncompressedSize;
+
+  return true;
+}
 
-  // keep calling compressStream until everything is consumed
-  while(in.pos < in.size)
+bool ZSTDDecompressor::DecompressBatch()
+{
+  // ramp up the batch size, so that readers which only look at the start of a stream don't pay to
+  // decompress blocks they'll never read.
+  uint32_t batchSize = RDCMIN(m_MaxBatchBlocks, RDCMAX(1U, m_BatchCount * 2));
+
+  // first pass, walk the size-prefixed blocks serially and read in the compressed data
+  m_BatchCount = 0;
+
+  do
   {
-    size_t inpos = in.pos;
-    size_t outpos = out.pos;
+    BatchBlock &block = m_Blocks[m_BatchCount];
+
+    uint32_t compSize = 0;
+
+    bool success = true;
 
-    err = ZSTD_decompressStream(m_Stream, &out, &in);
+    success &= m_Read->Read(compSize);
 
-    if(ZSTD_isError(err) || (inpos == in.pos && outpos == out.pos))
+    if(compSize > m_CompressBlockSize)
     {
-      if(ZSTD_isError(err))
-        RDCERR("Error decompressing: %s", ZSTD_getErrorName(err));
-      else
-        RDCERR("Error decompressing, no progress made");
-      FreeAlignedBuffer(m_Page);
-      FreeAlignedBuffer(m_CompressBuffer);
-      m_Page = m_CompressBuffer = NULL;
+      RDCERR("Invalid compressed block size %u", compSize);
       return false;
     }
-  }
 
-  m_PageOffset = 0;
-  m_PageLength = out.pos;
+    block.compressedData = m_CompressBuffer + m_CompressBlockSize * m_BatchCount;
+    block.compressedSize = compSize;
+    block.uncompressedSize = 0;
 
-  return success;
+    success &= m_Read->Read(block.compressedData, compSize);
+
+    if(!success)
+      return false;
+
+    m_BatchCount++;
+  } while(m_BatchCount < batchSize && !m_Read->AtEnd());
+
+  // second pass, decompress all blocks in parallel into their own page of the batch
+  volatile int32_t errors = 0;
+
+  Threading::ParallelFor(m_BatchCount, [this, &errors](uint32_t i) {
+    BatchBlock &block = m_Blocks[i];
+
+    if(block.context == NULL)
+      block.context = ZSTD_createDCtx();
+
+    byte *dst = m_Batch + m_BlockSize * i;
+    size_t ret = 0;
+
+    if(m_Dictionary)
+      ret = ZSTD_decompress_usingDDict(block.context, dst, (size_t)m_BlockSize, block.compressedData,
+                                       block.compressedSize, m_Dictionary);
+    else
+      ret = ZSTD_decompressDCtx(block.context, dst, (size_t)m_BlockSize, block.compressedData,
+                                block.compressedSize);
+
+    if(ZSTD_isError(ret))
+    {
+      RDCERR("Error decompressing: %s", ZSTD_getErrorName(ret));
+      Atomic::Inc32(&errors);
+      return;
+    }
+
+    block.uncompressedSize = ret;
+  });
+
+  return errors == 0;
 }
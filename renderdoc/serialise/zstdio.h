@@ -27,10 +27,26 @@
 #include "zstd/zstd.h"
 #include "streamio.h"
 
+// controls how a zstd stream is compressed. The defaults give fast compression that is suitable
+// while capturing.
+struct ZSTDSettings
+{
+  // the compression level, or 0 for the default. Negative levels are faster with a lower ratio.
+  int level = 0;
+  // compress in much larger blocks with long distance matching, for a better ratio on large streams
+  // at the cost of speed and memory. This is intended for archival, and decompression must be told
+  // that the stream was compressed this way.
+  bool longWindow = false;
+  // an optional dictionary to compress against, such as one trained on typical chunk data. It is
+  // stored at the start of the stream, so it doesn't need to be kept around to decompress.
+  const byte *dictionary = NULL;
+  uint64_t dictionarySize = 0;
+};
+
 class ZSTDCompressor : public Compressor
 {
 public:
-  ZSTDCompressor(StreamWriter *write, Ownership own);
+  ZSTDCompressor(StreamWriter *write, Ownership own, const ZSTDSettings &settings = ZSTDSettings());
   ~ZSTDCompressor();
 
   bool Write(const void *data, uint64_t numBytes);
@@ -44,14 +60,17 @@ private:
   byte *m_Page;
   byte *m_CompressBuffer;
   uint64_t m_PageOffset;
+  uint64_t m_BlockSize;
+  uint64_t m_CompressBlockSize;
 
-  ZSTD_CStream *m_Stream;
+  ZSTD_CCtx *m_Stream;
 };
 
 class ZSTDDecompressor : public Decompressor
 {
 public:
-  ZSTDDecompressor(StreamReader *read, Ownership own);
+  ZSTDDecompressor(StreamReader *read, Ownership own, bool longWindow = false,
+                   bool dictionary = false);
   ~ZSTDDecompressor();
 
   bool Recompress(Compressor *comp);
@@ -59,11 +78,30 @@ public:
 
 private:
   bool FillPage();
+  bool DecompressBatch();
+
+  struct BatchBlock
+  {
+    ZSTD_DCtx *context = NULL;
+    byte *compressedData = NULL;
+    uint32_t compressedSize = 0;
+    uint64_t uncompressedSize = 0;
+  };
+
+  // a batch of consecutive blocks, decompressed together. m_Page points into this at the block
+  // currently being read from
+  byte *m_Batch;
+  std::vector<BatchBlock> m_Blocks;
+  uint32_t m_MaxBatchBlocks;
+  uint32_t m_BatchCount = 0;
+  uint32_t m_BatchIndex = 0;
+
+  ZSTD_DDict *m_Dictionary;
 
   byte *m_Page;
   byte *m_CompressBuffer;
   uint64_t m_PageOffset;
   uint64_t m_PageLength;
-
-  ZSTD_DStream *m_Stream;
+  uint64_t m_BlockSize;
+  uint64_t m_CompressBlockSize;
 };
@@ -214,7 +214,7 @@ struct ThumbCommand : public Command
   ThumbCommand(const GlobalEnvironment &env) : Command(env) {}
   virtual void AddOptions(cmdline::parser &parser)
   {
-    parser.set_footer("<filename.rdc>");
+    parser.set_footer("<filename.rdc> [<filename2.rdc> ...]");
     parser.add<string>("out", 'o', "The output filename to save the file to", true, "filename.jpg");
     parser.add<string>("format", 'f',
                        "The format of the output file. If empty, detected from filename", false, "",
@@ -222,6 +222,9 @@ struct ThumbCommand : public Command
     parser.add<uint32_t>(
         "max-size", 's',
         "The maximum dimension of the thumbnail. Default is 0, which is unlimited.", false, 0);
+    parser.add("batch", 'b',
+               "Extract thumbnails from every capture listed. --out is then the output directory "
+               "and each thumbnail is named after its capture.");
   }
   virtual const char *Description() { return "Saves a capture's embedded thumbnail to disk."; }
   virtual bool IsInternalOnly() { return false; }
@@ -237,9 +240,20 @@ struct ThumbCommand : public Command
       return 0;
     }
 
-    string filename = rest[0];
+    bool batch = parser.exist("batch");
 
-    rest.erase(rest.begin());
+    rdcarray<rdcstr> filenames;
+
+    if(batch)
+    {
+      filenames = convertArgs(rest);
+      rest.clear();
+    }
+    else
+    {
+      filenames.push_back(rest[0]);
+      rest.erase(rest.begin());
+    }
 
     RENDERDOC_InitGlobalEnv(m_Env, convertArgs(rest));
 
@@ -263,7 +277,7 @@ struct ThumbCommand : public Command
     {
       type = FileType::BMP;
     }
-    else
+    else if(!batch)
     {
       const char *dot = strrchr(outfile.c_str(), '.');
 
@@ -280,38 +294,50 @@ struct ThumbCommand : public Command
                   << std::endl;
     }
 
-    bytebuf buf;
+    rdcarray<Thumbnail> thumbs;
+    RENDERDOC_GetCaptureThumbnails(filenames, type, maxsize, thumbs);
 
-    ICaptureFile *file = RENDERDOC_OpenCaptureFile();
-    ReplayStatus st = file->OpenFile(filename.c_str(), "rdc", NULL);
-    if(st == ReplayStatus::Succeeded)
+    for(size_t i = 0; i < filenames.size(); i++)
     {
-      buf = file->GetThumbnail(type, maxsize).data;
-    }
-    else
-    {
-      std::cerr << "Couldn't open '" << filename << "': " << ToStr(st) << std::endl;
-    }
-    file->Shutdown();
+      string filename = filenames[i];
+      string dest = outfile;
 
-    if(buf.empty())
-    {
-      std::cerr << "Couldn't fetch the thumbnail in '" << filename << "'" << std::endl;
-    }
-    else
-    {
-      FILE *f = fopen(outfile.c_str(), "wb");
+      if(batch)
+      {
+        // name the output after the capture, minus any directory and extension
+        string basename = filename;
+
+        size_t sep = basename.find_last_of("/\\");
+        if(sep != string::npos)
+          basename = basename.substr(sep + 1);
+
+        size_t dot = basename.find_last_of('.');
+        if(dot != string::npos)
+          basename = basename.substr(0, dot);
+
+        dest = outfile + "/" + basename + "." + (format.empty() ? string("jpg") : format);
+      }
+
+      const bytebuf &buf = thumbs[i].data;
+
+      if(buf.empty())
+      {
+        std::cerr << "Couldn't fetch the thumbnail in '" << filename << "'" << std::endl;
+        continue;
+      }
+
+      FILE *f = fopen(dest.c_str(), "wb");
 
       if(!f)
       {
-        std::cerr << "Couldn't open destination file '" << outfile << "'" << std::endl;
+        std::cerr << "Couldn't open destination file '" << dest << "'" << std::endl;
       }
       else
       {
         fwrite(buf.data(), 1, buf.size(), f);
         fclose(f);
 
-        std::cout << "Wrote thumbnail from '" << filename << "' to '" << outfile << "'." << std::endl;
+        std::cout << "Wrote thumbnail from '" << filename << "' to '" << dest << "'." << std::endl;
       }
     }
 
@@ -678,6 +704,17 @@ struct ConvertCommand : public Command
     parser.add<string>("convert-format", 'c', "The format of the output file.", false, "",
                        formats_reader());
     parser.add("list-formats", '\0', "Print a list of target formats.");
+    parser.add<string>("compression", '\0',
+                       "How to compress the frame capture when converting to rdc.", false, "zstd",
+                       cmdline::oneof<string>("zstd", "lz4", "none"));
+    parser.add<int>("level", '\0', "The zstd compression level, or 0 for the default.", false, 0,
+                    cmdline::range(-100, 22));
+    parser.add("long", '\0',
+               "Compress with zstd in large blocks with long distance matching, for archiving. "
+               "Captures written this way need a newer build of RenderDoc to open.");
+    parser.add<string>("dictionary", '\0',
+                       "A zstd dictionary to compress against, e.g. trained with 'zstd --train'.",
+                       false);
     parser.stop_at_rest(true);
   }
   virtual const char *Description() { return "Convert between capture formats."; }
@@ -779,6 +816,55 @@ struct ConvertCommand : public Command
       return 1;
     }
 
+    SectionFlags compression = SectionFlags::NoFlags;
+    int compressionLevel = 0;
+    bytebuf compressionDictionary;
+
+    std::string compressionType = parser.get<string>("compression");
+
+    if(compressionType == "zstd")
+    {
+      compression = SectionFlags::ZstdCompressed;
+      compressionLevel = parser.get<int>("level");
+
+      if(parser.exist("long"))
+        compression |= SectionFlags::ZstdLongWindow;
+
+      std::string dictfile = parser.get<string>("dictionary");
+
+      if(!dictfile.empty())
+      {
+        FILE *f = fopen(dictfile.c_str(), "rb");
+
+        if(!f)
+        {
+          std::cerr << "Couldn't open dictionary file '" << dictfile << "'" << std::endl;
+          return 1;
+        }
+
+        fseek(f, 0, SEEK_END);
+        long len = ftell(f);
+        fseek(f, 0, SEEK_SET);
+
+        compressionDictionary.resize(len > 0 ? (size_t)len : 0);
+        size_t read = fread(compressionDictionary.data(), 1, compressionDictionary.size(), f);
+
+        fclose(f);
+
+        if(len <= 0 || read != (size_t)len)
+        {
+          std::cerr << "I/O error reading dictionary from '" << dictfile << "'" << std::endl;
+          return 1;
+        }
+      }
+    }
+    else if(compressionType == "lz4")
+    {
+      compression = SectionFlags::LZ4Compressed;
+    }
+
+    file->SetConvertCompression(compression, compressionLevel, compressionDictionary);
+
     st = file->Convert(outfile.c_str(), outfmt.c_str(), NULL, NULL);
 
     if(st != ReplayStatus::Succeeded)
@@ -800,11 +886,14 @@ struct TestCommand : public Command
   virtual void AddOptions(cmdline::parser &parser)
   {
     parser.add<string>("type", 't', "The type of test to run.", true, "",
-                       cmdline::oneof<string>("unit"));
+                       cmdline::oneof<string>("unit", "bench"));
     parser.add("help", '\0', "print this message");
     parser.stop_at_rest(true);
   }
-  virtual const char *Description() { return "Run internal tests such as unit tests."; }
+  virtual const char *Description()
+  {
+    return "Run internal tests such as unit tests, or serialisation benchmarks.";
+  }
   virtual bool IsInternalOnly() { return false; }
   virtual bool IsCaptureCommand() { return false; }
   virtual int Execute(cmdline::parser &parser, const CaptureOptions &)
@@ -813,6 +902,8 @@ struct TestCommand : public Command
 
     if(parser.get<string>("type") == "unit")
       return RENDERDOC_RunUnitTests("renderdoccmd test --type unit", convertArgs(rest));
+    else if(parser.get<string>("type") == "bench")
+      return RENDERDOC_RunBenchmarks(convertArgs(rest));
 
     return 1;
   }
@@ -1256,6 +1347,10 @@ int renderdoccmd(const GlobalEnvironment &env, std::vector<std::string> &argv)
               "Capturing Option: Include all live resources, not just those used by a frame.");
       cmd.add("opt-capture-all-cmd-lists", 0,
               "Capturing Option: In D3D11, record all command lists from application start.");
+      cmd.add<int>("opt-background-write-mb", 0,
+                   "Capturing Option: Write captures on a background thread, buffering up to this "
+                   "many megabytes of capture data in memory.",
+                   false, 0, cmdline::range(0, 1024 * 1024));
     }
 
     cmd.parse_check(argv, true);
@@ -1287,6 +1382,7 @@ int renderdoccmd(const GlobalEnvironment &env, std::vector<std::string> &argv)
         opts.captureAllCmdLists = true;
 
       opts.delayForDebugger = (uint32_t)cmd.get<int>("opt-delay-for-debugger");
+      opts.backgroundWriteMemoryMB = (uint32_t)cmd.get<int>("opt-background-write-mb");
     }
 
     if(cmd.exist("help"))